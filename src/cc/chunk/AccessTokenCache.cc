@@ -0,0 +1,251 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file AccessTokenCache.cc
+// \brief Chunk server cache of signature verified access tokens.
+//
+//----------------------------------------------------------------------------
+
+#include "AccessTokenCache.h"
+
+#include "qcdio/QCDLList.h"
+#include "qcdio/qcdebug.h"
+#include "qcdio/qcstutils.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace KFS
+{
+
+using std::max;
+using std::make_pair;
+
+class AccessTokenCache::Entry
+{
+public:
+    typedef QCDLList<Entry, 0> List;
+
+    Entry(
+        const DelegationToken&  inToken,
+        const CryptoKeys::Key&  inKey,
+        const char*             inSessionKeyPtr,
+        int                     inSessionKeyLen)
+        : mToken(inToken),
+          mKey(inKey),
+          mSessionKey(),
+          mTableIt()
+    {
+        if (inSessionKeyPtr && 0 < inSessionKeyLen) {
+            mSessionKey.assign(inSessionKeyPtr, inSessionKeyLen);
+        }
+        List::Init(*this);
+    }
+    ~Entry()
+    {
+        if (! mSessionKey.empty()) {
+            memset(&mSessionKey[0], 0, mSessionKey.size());
+        }
+    }
+    DelegationToken       mToken;
+    CryptoKeys::Key const mKey;
+    string                mSessionKey;
+    Table::iterator       mTableIt;
+private:
+    Entry* mPrevPtr[1];
+    Entry* mNextPtr[1];
+
+    friend class QCDLListOp<Entry, 0>;
+private:
+    Entry(
+        const Entry& inEntry);
+    Entry& operator=(
+        const Entry& inEntry);
+};
+
+AccessTokenCache::AccessTokenCache()
+    : mMutex(),
+      mMaxEntryCount(0),
+      mTable(),
+      mCounters()
+{
+    Entry::List::Init(mLru);
+    mCounters.Clear();
+}
+
+AccessTokenCache::~AccessTokenCache()
+{
+    AccessTokenCache::Clear();
+}
+
+    void
+AccessTokenCache::SetParameters(
+    int inMaxEntryCount)
+{
+    QCStMutexLocker theLock(mMutex);
+    mMaxEntryCount = inMaxEntryCount;
+    Shrink(mMaxEntryCount);
+}
+
+    /* static */ void
+AccessTokenCache::MakeKey(
+    const char*  inTokenPtr,
+    int          inTokenLen,
+    kfsChunkId_t inChunkId,
+    int64_t      inSubjectId,
+    string&      outKey)
+{
+    outKey.reserve(inTokenLen + sizeof(inChunkId) + sizeof(inSubjectId));
+    outKey.assign(inTokenPtr, inTokenLen);
+    outKey.append(reinterpret_cast<const char*>(&inChunkId),
+        sizeof(inChunkId));
+    outKey.append(reinterpret_cast<const char*>(&inSubjectId),
+        sizeof(inSubjectId));
+}
+
+    bool
+AccessTokenCache::Get(
+    const char*       inTokenPtr,
+    int               inTokenLen,
+    kfsChunkId_t      inChunkId,
+    int64_t           inSubjectId,
+    int64_t           inTimeNowSec,
+    const CryptoKeys& inKeys,
+    DelegationToken&  outToken,
+    string*           outSessionKeyPtr)
+{
+    if (mMaxEntryCount <= 0 || ! inTokenPtr || inTokenLen <= 0) {
+        return false;
+    }
+    string theKey;
+    MakeKey(inTokenPtr, inTokenLen, inChunkId, inSubjectId, theKey);
+    QCStMutexLocker theLock(mMutex);
+    Table::iterator const theIt = mTable.find(theKey);
+    if (theIt == mTable.end()) {
+        mCounters.mMissCount++;
+        return false;
+    }
+    Entry& theEntry = *theIt->second;
+    const DelegationToken& theToken = theEntry.mToken;
+    if (theToken.GetIssuedTime() + theToken.GetValidForSec() <
+            inTimeNowSec) {
+        mCounters.mExpiredCount++;
+        mCounters.mMissCount++;
+        Delete(theIt);
+        return false;
+    }
+    CryptoKeys::Key theCurKey;
+    if (! inKeys.Find(theToken.GetKeyId(), theCurKey) ||
+            ! (theCurKey == theEntry.mKey)) {
+        mCounters.mInvalidateCount++;
+        mCounters.mMissCount++;
+        Delete(theIt);
+        return false;
+    }
+    if (outSessionKeyPtr) {
+        if (theEntry.mSessionKey.empty()) {
+            mCounters.mMissCount++;
+            return false;
+        }
+        *outSessionKeyPtr = theEntry.mSessionKey;
+    }
+    outToken = theToken;
+    Entry::List::PushBack(mLru, theEntry);
+    mCounters.mHitCount++;
+    return true;
+}
+
+    void
+AccessTokenCache::Put(
+    const char*            inTokenPtr,
+    int                    inTokenLen,
+    kfsChunkId_t           inChunkId,
+    int64_t                inSubjectId,
+    const DelegationToken& inToken,
+    const CryptoKeys&      inKeys,
+    const char*            inSessionKeyPtr,
+    int                    inSessionKeyLen)
+{
+    if (mMaxEntryCount <= 0 || ! inTokenPtr || inTokenLen <= 0) {
+        return;
+    }
+    CryptoKeys::Key theCurKey;
+    if (! inKeys.Find(inToken.GetKeyId(), theCurKey)) {
+        return;
+    }
+    string theKey;
+    MakeKey(inTokenPtr, inTokenLen, inChunkId, inSubjectId, theKey);
+    QCStMutexLocker theLock(mMutex);
+    Table::iterator theIt = mTable.find(theKey);
+    if (theIt != mTable.end()) {
+        Delete(theIt);
+    }
+    Shrink(mMaxEntryCount - 1);
+    Entry& theEntry = *(new Entry(
+        inToken, theCurKey, inSessionKeyPtr, inSessionKeyLen));
+    theEntry.mTableIt = mTable.insert(make_pair(theKey, &theEntry)).first;
+    Entry::List::PushBack(mLru, theEntry);
+    mCounters.mInsertCount++;
+    mCounters.mEntryCount++;
+}
+
+    void
+AccessTokenCache::Delete(
+    Table::iterator inIt)
+{
+    Entry* const theEntryPtr = inIt->second;
+    QCASSERT(theEntryPtr && theEntryPtr->mTableIt == inIt);
+    Entry::List::Remove(mLru, *theEntryPtr);
+    mTable.erase(inIt);
+    delete theEntryPtr;
+    mCounters.mEntryCount--;
+}
+
+    void
+AccessTokenCache::Shrink(
+    int inMaxEntryCount)
+{
+    while (max(Counters::Counter(0), Counters::Counter(inMaxEntryCount)) < mCounters.mEntryCount) {
+        Entry* const theEntryPtr = Entry::List::Front(mLru);
+        QCASSERT(theEntryPtr);
+        Delete(theEntryPtr->mTableIt);
+        mCounters.mEvictCount++;
+    }
+}
+
+    void
+AccessTokenCache::Clear()
+{
+    QCStMutexLocker theLock(mMutex);
+    Shrink(0);
+    QCASSERT(mTable.empty() && Entry::List::IsEmpty(mLru));
+}
+
+    void
+AccessTokenCache::GetCounters(
+    AccessTokenCache::Counters& outCounters) const
+{
+    QCStMutexLocker theLock(mMutex);
+    outCounters = mCounters;
+}
+
+} // namespace KFS
@@ -0,0 +1,148 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file AccessTokenCache.h
+// \brief Chunk server cache of signature verified access tokens.
+//
+// The cache is keyed by the token string and the token subject: chunk id and
+// write or lease id for chunk access tokens, and -1 for the connection
+// delegation tokens. Each entry keeps the parsed token, the key that the token
+// signature was verified with, and, with delegation tokens, the session key.
+// An entry is used only while the token is valid, and while the key with the
+// token key id is present and identical to the key used to verify the token,
+// therefore key rotation and removal invalidate the corresponding entries.
+// The least recently used entries are evicted when the cache is full.
+// The cache is thread safe, as the tokens are verified by the client threads.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_ACCESS_TOKEN_CACHE_H
+#define CHUNK_ACCESS_TOKEN_CACHE_H
+
+#include "common/kfstypes.h"
+#include "common/StdAllocator.h"
+#include "kfsio/CryptoKeys.h"
+#include "kfsio/DelegationToken.h"
+#include "qcdio/QCMutex.h"
+
+#include <map>
+#include <string>
+
+namespace KFS
+{
+
+using std::map;
+using std::string;
+using std::less;
+
+class AccessTokenCache
+{
+public:
+    struct Counters
+    {
+        typedef int64_t Counter;
+
+        Counter mHitCount;
+        Counter mMissCount;
+        Counter mInsertCount;
+        Counter mEvictCount;
+        Counter mExpiredCount;
+        Counter mInvalidateCount;
+        Counter mEntryCount;
+
+        void Clear()
+        {
+            mHitCount        = 0;
+            mMissCount       = 0;
+            mInsertCount     = 0;
+            mEvictCount      = 0;
+            mExpiredCount    = 0;
+            mInvalidateCount = 0;
+            mEntryCount      = 0;
+        }
+    };
+
+    AccessTokenCache();
+    ~AccessTokenCache();
+    void SetParameters(
+        int inMaxEntryCount);
+    bool IsEnabled() const
+        { return (0 < mMaxEntryCount); }
+    // Returns true, and sets the token, and the session key if requested, if
+    // the token with the same subject was verified earlier, is not expired,
+    // and the key the token was verified with has not changed.
+    bool Get(
+        const char*       inTokenPtr,
+        int               inTokenLen,
+        kfsChunkId_t      inChunkId,
+        int64_t           inSubjectId,
+        int64_t           inTimeNowSec,
+        const CryptoKeys& inKeys,
+        DelegationToken&  outToken,
+        string*           outSessionKeyPtr = 0);
+    // Adds verified token.
+    void Put(
+        const char*            inTokenPtr,
+        int                    inTokenLen,
+        kfsChunkId_t           inChunkId,
+        int64_t                inSubjectId,
+        const DelegationToken& inToken,
+        const CryptoKeys&      inKeys,
+        const char*            inSessionKeyPtr = 0,
+        int                    inSessionKeyLen = 0);
+    void Clear();
+    void GetCounters(
+        Counters& outCounters) const;
+private:
+    class Entry;
+    typedef map<
+        string,
+        Entry*,
+        less<string>,
+        StdFastAllocator<std::pair<const string, Entry*> >
+    > Table;
+
+    mutable QCMutex mMutex;
+    int             mMaxEntryCount;
+    Table           mTable;
+    Entry*          mLru[1];
+    Counters        mCounters;
+
+    static void MakeKey(
+        const char*  inTokenPtr,
+        int          inTokenLen,
+        kfsChunkId_t inChunkId,
+        int64_t      inSubjectId,
+        string&      outKey);
+    void Delete(
+        Table::iterator inIt);
+    void Shrink(
+        int inMaxEntryCount);
+private:
+    AccessTokenCache(
+        const AccessTokenCache& inCache);
+    AccessTokenCache& operator=(
+        const AccessTokenCache& inCache);
+};
+
+} // namespace KFS
+
+#endif /* CHUNK_ACCESS_TOKEN_CACHE_H */
@@ -118,6 +118,22 @@ and instructs all participants to converge replicas to the selected state.
 Then meta server updates list of chunk servers hosting the chunk based on the
 "Make Chunk Stable" RPC reply status.
 
+Group commit.
+
+With group commit enabled (chunkServer.recAppender.groupCommitMaxInFlight > 0)
+the master does not forward each client append individually. The appends
+received while the configured number of "group" replications are in flight are
+coalesced into a single internally generated append. The group append carries
+the data and the combined checksum of all records, and the list of records:
+client sequence number, length, and write ids of all chain participants of
+each record. Slaves update the state of each record's write id exactly the same
+way as with individual appends, thus the status recovery described above works
+unchanged. Once the group append is acknowledged, the master commits and
+acknowledges each client append individually, in the order the appends were
+received. The group append "window" is therefore self clocked by the
+replication round trip time, and bounded by the configured max number of
+records and bytes. All chain participants must support group appends.
+
 */
 
 #include "AtomicRecordAppender.h"
@@ -186,14 +202,18 @@ RecordAppendOp::RecordAppendOp(kfsSeq_t s)
       origClnt(0),
       origSeq(s),
       replicationStartTime(0),
-      devBufMgr(0)
+      devBufMgr(0),
+      groupRecordCount(0),
+      groupRecords(),
+      groupNext(0)
 {
     AppendReplicationList::Init(*this);
 }
 
 RecordAppendOp::~RecordAppendOp()
 {
-    assert(! origClnt && ! QCDLListOp<RecordAppendOp>::IsInList(*this));
+    assert(! origClnt && ! groupNext &&
+        ! QCDLListOp<RecordAppendOp>::IsInList(*this));
 }
 
 /* virtual */ ostream&
@@ -211,7 +231,8 @@ RecordAppendOp::ShowSelf(ostream& os) const
         " servers: "          << servers <<
         " checksum: "         << checksum <<
         " client-seq: "       << clientSeq <<
-        " master-committed: " << masterCommittedOffset
+        " master-committed: " << masterCommittedOffset <<
+        " group: "            << groupRecordCount
     ;
 }
 
@@ -443,6 +464,13 @@ private:
     QCMutex* const          mMutex;
     RecordAppendOp*         mPendingSubmitQueue;
     int                     mFlushStartByteCount;
+    // Group commit: the records waiting for the group replications in
+    // flight to complete, and the number of group replications in flight.
+    RecordAppendOp*         mGroupCommitHead;
+    RecordAppendOp*         mGroupCommitTail;
+    int                     mGroupCommitRecordCount;
+    int                     mGroupCommitBytes;
+    int                     mGroupCommitInFlight;
     RecordAppendOp*         mReplicationList[1];
     AtomicRecordAppender*   mPrevPtr[1];
     AtomicRecordAppender*   mNextPtr[1];
@@ -521,6 +549,105 @@ private:
         { return (mReplicationPos == 0); }
     void Relock(ClientThread& cliThread);
     void RunPendingSubmitQueue();
+    void AddToGroupCommit(RecordAppendOp& op);
+    void SendGroupCommit();
+    void GroupCommitDone(RecordAppendOp* op);
+    int  GroupAppendBegin(RecordAppendOp& op, bool applyFlag, string& msg);
+    bool GroupAppendCommit(RecordAppendOp& op);
+    int GetGroupCommitMaxInFlight() const
+    {
+        // Pending group must be sent even if group commit was turned off.
+        const int ret = gAtomicRecordAppendManager.GetGroupCommitMaxInFlight();
+        return ((ret <= 0 && mGroupCommitHead) ? 1 : ret);
+    }
+    int GetGroupCommitMaxRecords() const
+    {
+        // Keep group records header well below max rpc header length.
+        const int kMaxHeaderLength = MAX_RPC_HEADER_LEN / 2;
+        const int kMaxIntLength    = 22;
+        return min(gAtomicRecordAppendManager.GetGroupCommitMaxRecords(),
+            max(1, kMaxHeaderLength /
+                ((2 + (int)mNumServers) * kMaxIntLength)));
+    }
+    template<typename VP>
+    static bool ParseGroupRecord(
+        const char*& ptr,
+        const char*  end,
+        uint32_t     numServers,
+        int          pos,
+        kfsSeq_t&    seq,
+        int64_t&     len,
+        int64_t&     writeId)
+    {
+        if (! VP::Parse(ptr, end - ptr, seq) ||
+                ! VP::Parse(ptr, end - ptr, len) || len < 0) {
+            return false;
+        }
+        for (uint32_t i = 0; i < numServers; i++) {
+            int64_t wid;
+            if (! VP::Parse(ptr, end - ptr, wid)) {
+                return false;
+            }
+            if ((int)i == pos) {
+                writeId = wid;
+            }
+        }
+        return true;
+    }
+    bool ParseGroupRecord(
+        const RecordAppendOp& op,
+        const char*&          ptr,
+        kfsSeq_t&             seq,
+        int64_t&              len,
+        int64_t&              writeId) const
+    {
+        const char* const end = op.groupRecords.data() + op.groupRecords.size();
+        return (op.shortRpcFormatFlag ?
+            ParseGroupRecord<HexIntParser>(
+                ptr, end, mNumServers, mReplicationPos, seq, len, writeId) :
+            ParseGroupRecord<DecIntParser>(
+                ptr, end, mNumServers, mReplicationPos, seq, len, writeId)
+        );
+    }
+    static bool AppendGroupRecord(
+        RecordAppendOp&       groupOp,
+        const RecordAppendOp& op)
+    {
+        // Convert write ids into the group op rpc format.
+        string& rec = groupOp.groupRecords;
+        if (! rec.empty()) {
+            rec += ' ';
+        }
+        AppendInt(rec, op.clientSeq, groupOp.shortRpcFormatFlag) += ' ';
+        AppendInt(rec, op.numBytes,  groupOp.shortRpcFormatFlag);
+        const char*       ptr = op.servers.data();
+        const char* const end = ptr + op.servers.size();
+        for (uint32_t i = 0; i < op.numServers; i++) {
+            // Host Port
+            for (int k = 0; k < 2; k++) {
+                while (ptr < end && (*ptr & 0xFF) <= ' ') {
+                    ++ptr;
+                }
+                while (ptr < end && ' ' < (*ptr & 0xFF)) {
+                    ++ptr;
+                }
+            }
+            int64_t writeId = -1;
+            if (! (op.shortRpcFormatFlag ?
+                    HexIntParser::Parse(ptr, end - ptr, writeId) :
+                    DecIntParser::Parse(ptr, end - ptr, writeId))) {
+                return false;
+            }
+            AppendInt(rec += ' ', writeId, groupOp.shortRpcFormatFlag);
+        }
+        return true;
+    }
+    template<typename T>
+    static string& AppendInt(string& str, T val, bool hexFlag)
+    {
+        return (hexFlag ?
+            AppendHexIntToString(str, val) : AppendDecIntToString(str, val));
+    }
     bool IsMasterAck(const RecordAppendOp& op) const
     {
         return (
@@ -776,7 +903,12 @@ AtomicRecordAppender::AtomicRecordAppender(
       mPeer(peer),
       mMutex(mutex),
       mPendingSubmitQueue(0),
-      mFlushStartByteCount(-1)
+      mFlushStartByteCount(-1),
+      mGroupCommitHead(0),
+      mGroupCommitTail(0),
+      mGroupCommitRecordCount(0),
+      mGroupCommitBytes(0),
+      mGroupCommitInFlight(0)
 {
     assert(
         chunkSize >= 0 &&
@@ -802,6 +934,8 @@ AtomicRecordAppender::~AtomicRecordAppender()
     if (mState != kStatePendingDelete ||
             mIoOpsInFlight != 0 ||
             mReplicationsInFlight != 0 ||
+            mGroupCommitHead ||
+            mGroupCommitInFlight != 0 ||
             ! mWriteIdState.empty() ||
             ! AppendReplicationList::IsEmpty(mReplicationList) ||
             gChunkManager.IsWriteAppenderOwns(mChunkId, mChunkVersion)) {
@@ -1394,6 +1528,9 @@ AtomicRecordAppender::AppendBegin(
     } else if (! IsMaster() && op->fileOffset < 0) {
         status = kErrParameters;
         msg    = "protocol error: offset not specified for slave";
+    } else if (IsMaster() && op->groupRecordCount != 0) {
+        status = kErrParameters;
+        msg    = "protocol error: group append sent to master";
     } else if (mNumServers != op->numServers) {
         status = kErrParameters;
         msg    = "invalid replication factor";
@@ -1417,7 +1554,11 @@ AtomicRecordAppender::AppendBegin(
 
     // Check if it is master 0 ack: no payload just commit offset.
     const bool masterAckflag = status == 0 && IsMasterAck(*op);
-    WriteIdState::iterator const widIt = (masterAckflag || status != 0) ?
+    // Group append from master: write ids are in the group records.
+    const bool groupFlag     = status == 0 && ! masterAckflag &&
+        0 < op->groupRecordCount;
+    WriteIdState::iterator const widIt =
+        (masterAckflag || groupFlag || status != 0) ?
         mWriteIdState.end() : mWriteIdState.find(op->writeId);
     if (masterAckflag) {
         if (IsMaster()) {
@@ -1431,7 +1572,17 @@ AtomicRecordAppender::AppendBegin(
             UpdateMasterCommittedOffset(op->masterCommittedOffset);
         }
     } else if (status == 0) {
-        if (widIt == mWriteIdState.end()) {
+        if (groupFlag) {
+            if (op->fileOffset != mNextOffset) {
+                // Out of order replication.
+                msg    = "invalid group append offset";
+                status = kErrParameters;
+                SetState(kStateReplicationFailed);
+            } else {
+                UpdateMasterCommittedOffset(op->masterCommittedOffset);
+                status = GroupAppendBegin(*op, false, msg);
+            }
+        } else if (widIt == mWriteIdState.end()) {
             status = kErrParameters;
             msg    = "invalid write id";
         } else {
@@ -1595,12 +1746,17 @@ AtomicRecordAppender::AppendBegin(
         // Write id table is updated only in the case when execution is
         // committed. Otherwise the op is discarded, and treated like
         // it was never received.
-        assert(widIt != mWriteIdState.end() && widIt->second.mStatus == 0);
-        WIdState& ws = widIt->second;
-        ws.mStatus = kErrStatusInProgress;
-        ws.mLength = op->numBytes;
-        ws.mOffset = op->fileOffset;
-        ws.mSeq    = op->clientSeq;
+        if (groupFlag) {
+            GroupAppendBegin(*op, true, msg);
+        } else {
+            assert(widIt != mWriteIdState.end() &&
+                widIt->second.mStatus == 0);
+            WIdState& ws = widIt->second;
+            ws.mStatus = kErrStatusInProgress;
+            ws.mLength = op->numBytes;
+            ws.mOffset = op->fileOffset;
+            ws.mSeq    = op->clientSeq;
+        }
 
         // Move blocks into the internal buffer.
         // The main reason to do this now, and not to wait for the replication
@@ -1693,6 +1849,8 @@ AtomicRecordAppender::RunPendingSubmitQueue()
         }
     }
     mPendingSubmitQueue = 0;
+    const bool groupCommitFlag = IsMaster() && 0 < GetGroupCommitMaxInFlight();
+    bool       groupAddedFlag  = false;
     for (; ;) {
         if (mReplicationsInFlight <= 0 || mState == kStateNone) {
             FatalError("AtomicRecordAppender::RunPendingSubmitQueue:"
@@ -1703,10 +1861,14 @@ AtomicRecordAppender::RunPendingSubmitQueue()
         next = &AppendReplicationList::GetNext(cur);
         const bool statusOkFlag = 0 == cur.status;
         const bool enqueueFlag  = cur.origClnt && kStateOpen == mState;
+        // Commit acks are only sent with no replications in flight, and
+        // therefore with no group pending.
+        const bool groupFlag    = enqueueFlag && groupCommitFlag &&
+            cur.origClnt != this;
         // Ensure that state is still open after re-locking.
         if (enqueueFlag) {
             assert(statusOkFlag);
-            if (IsMaster()) {
+            if (IsMaster() && ! groupFlag) {
                 cur.masterCommittedOffset = mNextCommitOffset;
                 mCommitOffsetAckSent = mNextCommitOffset;
             }
@@ -1750,7 +1912,12 @@ AtomicRecordAppender::RunPendingSubmitQueue()
         KFS_LOG_EOM;
         if (enqueueFlag) {
             mFirstFwdOpFlag = false;
-            mPeer->Enqueue(&cur);
+            if (groupFlag) {
+                groupAddedFlag = true;
+                AddToGroupCommit(cur);
+            } else {
+                mPeer->Enqueue(&cur);
+            }
         } else {
             OpDone(&cur);
         }
@@ -1758,6 +1925,138 @@ AtomicRecordAppender::RunPendingSubmitQueue()
             break;
         }
     }
+    // Group members are in flight, and prevent appender deletion by OpDone().
+    if (groupAddedFlag && mGroupCommitHead &&
+            mGroupCommitInFlight < GetGroupCommitMaxInFlight()) {
+        SendGroupCommit();
+    }
+}
+
+void
+AtomicRecordAppender::AddToGroupCommit(RecordAppendOp& op)
+{
+    assert(IsMaster() && op.origClnt && ! op.groupNext);
+    if (mGroupCommitTail) {
+        mGroupCommitTail->groupNext = &op;
+    } else {
+        mGroupCommitHead = &op;
+    }
+    mGroupCommitTail = &op;
+    mGroupCommitRecordCount++;
+    mGroupCommitBytes += (int)op.numBytes;
+    if (GetGroupCommitMaxRecords() <= mGroupCommitRecordCount ||
+            gAtomicRecordAppendManager.GetGroupCommitMaxBytes() <=
+                mGroupCommitBytes) {
+        SendGroupCommit();
+    }
+}
+
+void
+AtomicRecordAppender::SendGroupCommit()
+{
+    RecordAppendOp* next = mGroupCommitHead;
+    if (! next) {
+        return;
+    }
+    const int recordCount = mGroupCommitRecordCount;
+    const int byteCount   = mGroupCommitBytes;
+    mGroupCommitHead        = 0;
+    mGroupCommitTail        = 0;
+    mGroupCommitRecordCount = 0;
+    mGroupCommitBytes       = 0;
+    if (kStateOpen != mState || ! mPeer) {
+        // The last OpDone() might delete this.
+        while (next) {
+            RecordAppendOp& cur = *next;
+            next = cur.groupNext;
+            cur.groupNext = 0;
+            cur.status    = kErrStatusInProgress;
+            cur.statusMsg = "no longer open for append";
+            OpDone(&cur);
+        }
+        return;
+    }
+    // Use write offset as seq. # for debugging, the same as commit ack.
+    RecordAppendOp* const op = new RecordAppendOp(next->fileOffset);
+    op->clnt                      = this;
+    op->chunkId                   = mChunkId;
+    op->chunkVersion              = mChunkVersion;
+    op->numServers                = mNumServers;
+    op->servers                   = mCommitAckServers;
+    op->initialShortRpcFormatFlag = mCommitAckServersShortRpcFmtFlag;
+    op->shortRpcFormatFlag        = op->initialShortRpcFormatFlag;
+    op->fileOffset                = next->fileOffset;
+    op->numBytes                  = byteCount;
+    op->checksum                  = next->checksum;
+    op->groupRecordCount          = recordCount;
+    op->groupNext                 = next;
+    op->masterCommittedOffset     = mNextCommitOffset;
+    mCommitOffsetAckSent          = mNextCommitOffset;
+    for (RecordAppendOp* cur = next; cur; cur = cur->groupNext) {
+        if (cur != next && 0 < cur->numBytes) {
+            op->checksum = ChecksumBlocksCombine(
+                op->checksum, cur->checksum, cur->numBytes);
+        }
+        if (! AppendGroupRecord(*op, *cur)) {
+            WAPPEND_LOG_STREAM_FATAL <<
+                "group commit: invalid servers: " << cur->Show() <<
+            KFS_LOG_EOM;
+            FatalError();
+        }
+        // Data is only needed for forwarding, the appender's write buffer
+        // has its own copy.
+        op->dataBuf.Move(&cur->dataBuf, (int)cur->numBytes);
+        if (cur->syncReplicationAccess.chunkServerAccess) {
+            op->syncReplicationAccess.chunkServerAccess =
+                cur->syncReplicationAccess.chunkServerAccess;
+        }
+    }
+    mGroupCommitInFlight++;
+    Cntrs().mGroupCommitCount++;
+    Cntrs().mGroupCommitRecordCount += recordCount;
+    WAPPEND_LOG_STREAM_DEBUG <<
+        "group commit:"
+        " in flight: " << mGroupCommitInFlight <<
+        " " << op->Show() <<
+    KFS_LOG_EOM;
+    mPeer->Enqueue(op);
+}
+
+void
+AtomicRecordAppender::GroupCommitDone(RecordAppendOp* op)
+{
+    assert(IsMaster() && 0 < mGroupCommitInFlight && op->groupNext);
+    mGroupCommitInFlight--;
+    RecordAppendOp* next      = op->groupNext;
+    const int       status    = op->status;
+    const string    statusMsg = op->statusMsg;
+    WAPPEND_LOG_STREAM(status == 0 ?
+            MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelERROR) <<
+        "group commit done:"
+        " in flight: " << mGroupCommitInFlight <<
+        " status: "    << status <<
+        " "            << statusMsg <<
+        " " << op->Show() <<
+    KFS_LOG_EOM;
+    op->groupNext = 0;
+    delete op;
+    // Pending group records are accounted as replications in flight, and
+    // prevent the appender deletion by the group members OpDone() below.
+    const bool pendingFlag = mGroupCommitHead != 0;
+    while (next) {
+        RecordAppendOp& cur = *next;
+        next = cur.groupNext;
+        cur.groupNext = 0;
+        cur.status    = status;
+        if (status != 0) {
+            cur.statusMsg = statusMsg;
+        }
+        OpDone(&cur);
+    }
+    if (pendingFlag && (mState != kStateOpen ||
+            mGroupCommitInFlight < GetGroupCommitMaxInFlight())) {
+        SendGroupCommit();
+    }
 }
 
 int
@@ -1781,6 +2080,10 @@ AtomicRecordAppender::GetNextReplicationTimeout() const
 void
 AtomicRecordAppender::OpDone(RecordAppendOp* op)
 {
+    if (op->clnt == this && 0 < op->groupRecordCount && IsMaster()) {
+        GroupCommitDone(op);
+        return;
+    }
     assert(
         mReplicationsInFlight > 0 &&
         AppendReplicationList::IsInList(mReplicationList, *op)
@@ -1869,6 +2172,34 @@ AtomicRecordAppender::AppendCommit(RecordAppendOp* op)
     // into into read only between AppendBegin and AppendCommit, as it should
     // transition into "in progress" in the AppendBegin, and stay "in progress"
     // at least until here.
+    if (0 < op->groupRecordCount) {
+        if (op->fileOffset != mNextCommitOffset ||
+                op->chunkId != mChunkId ||
+                op->chunkVersion != mChunkVersion ||
+                IsMaster() ||
+                ! GroupAppendCommit(*op)) {
+            WAPPEND_LOG_STREAM_FATAL <<
+                "commit: out of order or invalid group op" <<
+                " chunk: "        << mChunkId <<
+                " chunkVersion: " << mChunkVersion <<
+                " offset: "       << mNextCommitOffset <<
+                " nextOffset: "   << mNextOffset <<
+                " " << op->Show() <<
+            KFS_LOG_EOM;
+            FatalError();
+            return;
+        }
+        op->status = 0;
+        mNextCommitOffset += op->numBytes;
+        WAPPEND_LOG_STREAM_DEBUG <<
+            "commit: group:"
+            " offset: next: " << mNextOffset <<
+            " commit: "       << mNextCommitOffset <<
+            " master: "       << mMasterCommittedOffset <<
+            " " << op->Show() <<
+        KFS_LOG_EOM;
+        return;
+    }
     // If the op is internally generated 0 ack verify that it has no payload.
     WriteIdState::iterator const widIt = op->clnt == this ?
         mWriteIdState.end() : mWriteIdState.find(op->writeId);
@@ -1929,6 +2260,83 @@ AtomicRecordAppender::AppendCommit(RecordAppendOp* op)
     KFS_LOG_EOM;
 }
 
+int
+AtomicRecordAppender::GroupAppendBegin(
+    RecordAppendOp& op, bool applyFlag, string& msg)
+{
+    // Validate all group records first, then update the write ids state, in
+    // order to leave the state unchanged if the op is discarded.
+    const char* ptr    = op.groupRecords.data();
+    int64_t     offset = op.fileOffset;
+    for (int i = 0; i < op.groupRecordCount; i++) {
+        kfsSeq_t seq     = -1;
+        int64_t  len     = -1;
+        int64_t  writeId = -1;
+        if (! ParseGroupRecord(op, ptr, seq, len, writeId)) {
+            msg = "invalid group record";
+            return kErrParameters;
+        }
+        WriteIdState::iterator const widIt = mWriteIdState.find(writeId);
+        if (widIt == mWriteIdState.end()) {
+            msg = "invalid group record write id";
+            return kErrParameters;
+        }
+        WIdState& ws = widIt->second;
+        if (applyFlag) {
+            assert(ws.mStatus == 0);
+            ws.mStatus = kErrStatusInProgress;
+            ws.mLength = (size_t)len;
+            ws.mOffset = offset;
+            ws.mSeq    = seq;
+        } else {
+            if (ws.mStatus == kErrStatusInProgress &&
+                    mMasterCommittedOffset >=
+                        ws.mOffset + int64_t(ws.mLength)) {
+                ws.mStatus = 0; // Master committed.
+            }
+            if (ws.mReadOnlyFlag) {
+                msg = "no appends allowed with group record write id";
+                return kErrWidReadOnly;
+            }
+            if (ws.mStatus != 0) {
+                msg = ws.mStatus == kErrStatusInProgress ?
+                    "group record write id has operation in flight" :
+                    "invalid group record write id: previous append failed";
+                return kErrParameters;
+            }
+        }
+        offset += len;
+    }
+    if (offset != op.fileOffset + int64_t(op.numBytes)) {
+        msg = "group records length mismatch";
+        return kErrParameters;
+    }
+    return 0;
+}
+
+bool
+AtomicRecordAppender::GroupAppendCommit(RecordAppendOp& op)
+{
+    const char* ptr = op.groupRecords.data();
+    for (int i = 0; i < op.groupRecordCount; i++) {
+        kfsSeq_t seq     = -1;
+        int64_t  len     = -1;
+        int64_t  writeId = -1;
+        if (! ParseGroupRecord(op, ptr, seq, len, writeId)) {
+            return false;
+        }
+        WriteIdState::iterator const widIt = mWriteIdState.find(writeId);
+        if (widIt == mWriteIdState.end() ||
+                widIt->second.mStatus != kErrStatusInProgress ||
+                widIt->second.mSeq != seq) {
+            return false;
+        }
+        mAppendCommitCount++;
+        widIt->second.mAppendCount++;
+    }
+    return true;
+}
+
 void
 AtomicRecordAppender::GetOpStatus(GetRecordAppendOpStatus* op)
 {
@@ -3120,6 +3528,9 @@ AtomicRecordAppendManager::AtomicRecordAppendManager()
       mAppendDropLockMinSize((4 << 10) - 1),
       mCloseMinChunkSize(
         (chunkOff_t)CHUNKSIZE - (chunkOff_t)CHECKSUM_BLOCKSIZE),
+      mGroupCommitMaxInFlight(0),
+      mGroupCommitMaxBytes(1 << 20),
+      mGroupCommitMaxRecords(128),
       mMutexesCount(-1),
       mCurMutexIdx(0),
       mMutexes(0),
@@ -3172,6 +3583,14 @@ AtomicRecordAppendManager::SetParameters(const Properties& props)
         "chunkServer.recAppender.dropLockMinSize",    mAppendDropLockMinSize));
     mCloseMinChunkSize  = max((chunkOff_t)CHECKSUM_BLOCKSIZE, props.getValue(
         "chunkServer.recAppender.closeMinChunkSize",  mCloseMinChunkSize));
+    mGroupCommitMaxInFlight = props.getValue(
+        "chunkServer.recAppender.groupCommitMaxInFlight",
+        mGroupCommitMaxInFlight);
+    mGroupCommitMaxBytes    = max(1, props.getValue(
+        "chunkServer.recAppender.groupCommitMaxBytes", mGroupCommitMaxBytes));
+    mGroupCommitMaxRecords  = max(1, props.getValue(
+        "chunkServer.recAppender.groupCommitMaxRecords",
+        mGroupCommitMaxRecords));
     mTotalBuffersBytes       = 0;
     if (! mAppenders.IsEmpty()) {
         UpdateAppenderFlushLimit();
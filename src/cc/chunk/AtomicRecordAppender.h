@@ -79,6 +79,8 @@ public:
         Counter mLostChunkCount;
         Counter mPendingByteCount;
         Counter mLowOnBuffersFlushCount;
+        Counter mGroupCommitCount;
+        Counter mGroupCommitRecordCount;
 
         void Clear()
         {
@@ -114,6 +116,8 @@ public:
             mLostChunkCount = 0;
             mPendingByteCount = 0;
             mLowOnBuffersFlushCount = 0;
+            mGroupCommitCount = 0;
+            mGroupCommitRecordCount = 0;
         }
     };
     void SetParameters(const Properties& props);
@@ -144,6 +148,12 @@ public:
         { return mCloseOutOfSpaceSec; }
     chunkOff_t GetCloseMinChunkSize() const
         { return mCloseMinChunkSize; }
+    int GetGroupCommitMaxInFlight() const
+        { return mGroupCommitMaxInFlight; }
+    int GetGroupCommitMaxBytes() const
+        { return mGroupCommitMaxBytes; }
+    int GetGroupCommitMaxRecords() const
+        { return mGroupCommitMaxRecords; }
     bool IsChunkStable(kfsChunkId_t chunkId) const;
     /// For record appends, (1) clients will reserve space in a chunk and
     /// then write and (2) clients can release their reserved space.
@@ -231,6 +241,9 @@ private:
     int                   mRecursionCount;
     int                   mAppendDropLockMinSize;
     chunkOff_t            mCloseMinChunkSize;
+    int                   mGroupCommitMaxInFlight;
+    int                   mGroupCommitMaxBytes;
+    int                   mGroupCommitMaxRecords;
     int                   mMutexesCount;
     int                   mCurMutexIdx;
     QCMutex*              mMutexes;
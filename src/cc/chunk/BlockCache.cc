@@ -0,0 +1,340 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file BlockCache.cc
+// \brief Chunk server in memory 2Q cache of checksum verified chunk blocks.
+//
+//----------------------------------------------------------------------------
+
+#include "BlockCache.h"
+
+#include "kfsio/checksum.h"
+#include "qcdio/QCDLList.h"
+#include "qcdio/qcdebug.h"
+
+#include <algorithm>
+
+namespace KFS
+{
+
+using std::max;
+using std::min;
+
+class BlockCache::Entry
+{
+public:
+    typedef QCDLList<Entry, 0>   List;
+    typedef QCDLListOp<Entry, 1> ChunkRing;
+
+    Entry(
+        const BlockKey& inKey)
+        : mKey(inKey),
+          mChunkVersion(-1),
+          mChecksum(0),
+          mListType(kListIn),
+          mData()
+    {
+        List::Init(*this);
+        ChunkRing::Init(*this);
+    }
+    const BlockKey mKey;
+    kfsSeq_t       mChunkVersion;
+    uint32_t       mChecksum;
+    ListType       mListType;
+    IOBuffer       mData;
+private:
+    Entry* mPrevPtr[2];
+    Entry* mNextPtr[2];
+
+    friend class QCDLListOp<Entry, 0>;
+    friend class QCDLListOp<Entry, 1>;
+private:
+    Entry(
+        const Entry& inEntry);
+    Entry& operator=(
+        const Entry& inEntry);
+};
+
+BlockCache::BlockCache()
+    : mMaxBytes(0),
+      mInMaxBytes(0),
+      mGhostMaxCount(0),
+      mByteCount(0),
+      mInByteCount(0),
+      mBlockTable(),
+      mChunkTable(),
+      mCounters()
+{
+    mCounters.Clear();
+    for (int i = 0; i < kListCount; i++) {
+        mListCounts[i] = 0;
+        Entry::List::Init(mLists[i]);
+    }
+}
+
+BlockCache::~BlockCache()
+{
+    BlockCache::Clear();
+}
+
+    void
+BlockCache::SetParameters(
+    int64_t inMaxBytes,
+    double  inInRatio)
+{
+    const int64_t kBlockSize = (int64_t)CHECKSUM_BLOCKSIZE;
+    mMaxBytes      = max(int64_t(0), inMaxBytes);
+    mInMaxBytes    = (int64_t)(mMaxBytes * min(1., max(0., inInRatio)));
+    // The ghost fifo holds keys of the half of the cache size worth of blocks,
+    // as recommended in the original 2Q paper.
+    mGhostMaxCount = mMaxBytes / kBlockSize / 2;
+    Reclaim(mMaxBytes);
+    if (mMaxBytes <= 0) {
+        Clear();
+    }
+}
+
+    bool
+BlockCache::Get(
+    kfsChunkId_t      inChunkId,
+    kfsSeq_t          inChunkVersion,
+    int               inStartBlock,
+    int               inBlockCount,
+    IOBuffer&         outBuf,
+    vector<uint32_t>& outChecksums)
+{
+    if (mByteCount <= 0 || inBlockCount <= 0) {
+        if (IsEnabled()) {
+            mCounters.mMissCount++;
+        }
+        return false;
+    }
+    const int theEnd = inStartBlock + inBlockCount;
+    for (int i = inStartBlock; i < theEnd; i++) {
+        Entry** const thePtr = mBlockTable.Find(BlockKey(inChunkId, i));
+        if (! thePtr || (*thePtr)->mListType == kListGhost ||
+                (*thePtr)->mChunkVersion != inChunkVersion) {
+            mCounters.mMissCount++;
+            return false;
+        }
+    }
+    for (int i = inStartBlock; i < theEnd; i++) {
+        Entry& theEntry = **mBlockTable.Find(BlockKey(inChunkId, i));
+        outBuf.Copy(&theEntry.mData, theEntry.mData.BytesConsumable());
+        outChecksums.push_back(theEntry.mChecksum);
+        mCounters.mHitByteCount += theEntry.mData.BytesConsumable();
+        if (theEntry.mListType == kListMain) {
+            Entry::List::Remove(mLists[kListMain], theEntry);
+            Entry::List::PushFront(mLists[kListMain], theEntry);
+        }
+        // 2Q does not change the "in" fifo order on hit, in order to keep
+        // correlated references from promoting the block.
+    }
+    mCounters.mHitCount++;
+    mCounters.mHitBlockCount += inBlockCount;
+    return true;
+}
+
+    void
+BlockCache::Put(
+    kfsChunkId_t inChunkId,
+    kfsSeq_t     inChunkVersion,
+    int          inBlock,
+    IOBuffer&    ioBuf,
+    uint32_t     inChecksum)
+{
+    if (! IsEnabled() || ioBuf.IsEmpty()) {
+        return;
+    }
+    const BlockKey theKey(inChunkId, inBlock);
+    bool           theInsertedFlag = false;
+    Entry** const  thePtr          =
+        mBlockTable.Insert(theKey, (Entry*)0, theInsertedFlag);
+    Entry*         theEntryPtr;
+    ListType       theListType     = kListIn;
+    if (theInsertedFlag) {
+        theEntryPtr = new Entry(theKey);
+        *thePtr = theEntryPtr;
+        bool          theChunkInsertedFlag = false;
+        Entry** const theChunkPtr = mChunkTable.Insert(
+            inChunkId, theEntryPtr, theChunkInsertedFlag);
+        if (! theChunkInsertedFlag) {
+            Entry::ChunkRing::Insert(*theEntryPtr, **theChunkPtr);
+        }
+    } else {
+        theEntryPtr = *thePtr;
+        if (theEntryPtr->mListType == kListGhost) {
+            mCounters.mGhostHitCount++;
+            theListType = kListMain;
+        } else if (theEntryPtr->mChunkVersion == inChunkVersion) {
+            return;
+        }
+        // Ghost hit or stale chunk version.
+        Unlink(*theEntryPtr);
+        theEntryPtr->mData.Clear();
+    }
+    theEntryPtr->mChunkVersion = inChunkVersion;
+    theEntryPtr->mChecksum     = inChecksum;
+    theEntryPtr->mData.Move(&ioBuf);
+    Link(*theEntryPtr, theListType);
+    mCounters.mInsertCount++;
+    Reclaim(mMaxBytes);
+}
+
+    void
+BlockCache::Invalidate(
+    kfsChunkId_t inChunkId)
+{
+    Entry** const thePtr = mChunkTable.Find(inChunkId);
+    if (! thePtr) {
+        return;
+    }
+    Entry& theHead = **thePtr;
+    while (Entry::ChunkRing::IsInList(theHead)) {
+        Delete(Entry::ChunkRing::GetNext(theHead));
+        mCounters.mInvalidateCount++;
+    }
+    Delete(theHead);
+    mCounters.mInvalidateCount++;
+}
+
+    void
+BlockCache::Shrink(
+    int64_t inTargetByteCount)
+{
+    Reclaim(max(int64_t(0), inTargetByteCount));
+}
+
+    void
+BlockCache::Clear()
+{
+    for (int i = 0; i < kListCount; i++) {
+        Entry* thePtr;
+        while ((thePtr = Entry::List::Front(mLists[i]))) {
+            Delete(*thePtr);
+        }
+    }
+    QCASSERT(
+        mBlockTable.IsEmpty() && mChunkTable.IsEmpty() &&
+        mByteCount == 0 && mInByteCount == 0
+    );
+}
+
+    void
+BlockCache::GetCounters(
+    BlockCache::Counters& outCounters) const
+{
+    outCounters = mCounters;
+    outCounters.mBlockCount =
+        mListCounts[kListIn] + mListCounts[kListMain];
+    outCounters.mByteCount  = mByteCount;
+}
+
+    void
+BlockCache::Reclaim(
+    int64_t inTargetByteCount)
+{
+    while (inTargetByteCount < mByteCount) {
+        Entry* const thePtr = (
+            mInMaxBytes < mInByteCount ||
+            Entry::List::IsEmpty(mLists[kListMain])) ?
+            Entry::List::Back(mLists[kListIn]) :
+            Entry::List::Back(mLists[kListMain]);
+        if (! thePtr) {
+            break;
+        }
+        mCounters.mEvictCount++;
+        if (thePtr->mListType == kListIn && 0 < mGhostMaxCount) {
+            MakeGhost(*thePtr);
+        } else {
+            Delete(*thePtr);
+        }
+    }
+}
+
+    void
+BlockCache::MakeGhost(
+    Entry& inEntry)
+{
+    Unlink(inEntry);
+    inEntry.mData.Clear();
+    Link(inEntry, kListGhost);
+    Entry* thePtr;
+    while (mGhostMaxCount < mListCounts[kListGhost] &&
+            (thePtr = Entry::List::Back(mLists[kListGhost]))) {
+        Delete(*thePtr);
+    }
+}
+
+    void
+BlockCache::Link(
+    Entry&   inEntry,
+    ListType inListType)
+{
+    inEntry.mListType = inListType;
+    Entry::List::PushFront(mLists[inListType], inEntry);
+    mListCounts[inListType]++;
+    if (inListType != kListGhost) {
+        const int64_t theSize = inEntry.mData.BytesConsumable();
+        mByteCount += theSize;
+        if (inListType == kListIn) {
+            mInByteCount += theSize;
+        }
+    }
+}
+
+    void
+BlockCache::Unlink(
+    Entry& inEntry)
+{
+    Entry::List::Remove(mLists[inEntry.mListType], inEntry);
+    mListCounts[inEntry.mListType]--;
+    if (inEntry.mListType != kListGhost) {
+        const int64_t theSize = inEntry.mData.BytesConsumable();
+        mByteCount -= theSize;
+        if (inEntry.mListType == kListIn) {
+            mInByteCount -= theSize;
+        }
+    }
+    QCASSERT(0 <= mByteCount && 0 <= mInByteCount &&
+        0 <= mListCounts[inEntry.mListType]);
+}
+
+    void
+BlockCache::Delete(
+    Entry& inEntry)
+{
+    Unlink(inEntry);
+    Entry** const thePtr = mChunkTable.Find(inEntry.mKey.first);
+    QCASSERT(thePtr);
+    if (thePtr && *thePtr == &inEntry) {
+        if (Entry::ChunkRing::IsInList(inEntry)) {
+            *thePtr = &Entry::ChunkRing::GetNext(inEntry);
+        } else {
+            mChunkTable.Erase(inEntry.mKey.first);
+        }
+    }
+    Entry::ChunkRing::Remove(inEntry);
+    mBlockTable.Erase(inEntry.mKey);
+    delete &inEntry;
+}
+
+} // namespace KFS
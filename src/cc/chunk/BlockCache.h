@@ -0,0 +1,195 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file BlockCache.h
+// \brief Chunk server in memory cache of checksum verified chunk blocks.
+//
+// The cache is keyed by chunk id and checksum block index, and keeps the
+// chunk version with each block. The blocks are kept in io buffers shared with
+// the disk read buffers, and are shared with the read replies, therefore
+// neither insertion nor hits copy the data.
+// The replacement policy is 2Q: the newly inserted blocks are placed into the
+// "in" fifo, that is limited to a fraction of the cache size. The blocks
+// evicted from the "in" fifo keep their keys in the "ghost" fifo. Only the
+// blocks re-inserted while their keys are in the "ghost" fifo are placed into
+// the main lru list. This way sequential scans do not evict frequently read
+// blocks.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_BLOCK_CACHE_H
+#define CHUNK_BLOCK_CACHE_H
+
+#include "common/kfstypes.h"
+#include "common/LinearHash.h"
+#include "common/StdAllocator.h"
+#include "kfsio/IOBuffer.h"
+
+#include <vector>
+#include <utility>
+
+namespace KFS
+{
+
+using std::vector;
+using std::pair;
+
+class BlockCache
+{
+public:
+    struct Counters
+    {
+        typedef int64_t Counter;
+
+        Counter mHitCount;
+        Counter mMissCount;
+        Counter mHitBlockCount;
+        Counter mHitByteCount;
+        Counter mInsertCount;
+        Counter mGhostHitCount;
+        Counter mEvictCount;
+        Counter mInvalidateCount;
+        Counter mBlockCount;
+        Counter mByteCount;
+
+        void Clear()
+        {
+            mHitCount        = 0;
+            mMissCount       = 0;
+            mHitBlockCount   = 0;
+            mHitByteCount    = 0;
+            mInsertCount     = 0;
+            mGhostHitCount   = 0;
+            mEvictCount      = 0;
+            mInvalidateCount = 0;
+            mBlockCount      = 0;
+            mByteCount       = 0;
+        }
+    };
+
+    BlockCache();
+    ~BlockCache();
+    void SetParameters(
+        int64_t inMaxBytes,
+        double  inInRatio);
+    bool IsEnabled() const
+        { return (0 < mMaxBytes); }
+    int64_t GetByteCount() const
+        { return mByteCount; }
+    // Appends the blocks in the range
+    // [inStartBlock, inStartBlock + inBlockCount) to outBuf, and their
+    // checksums to outChecksums. Returns false, and does not modify outBuf and
+    // outChecksums, unless all blocks are in the cache.
+    bool Get(
+        kfsChunkId_t      inChunkId,
+        kfsSeq_t          inChunkVersion,
+        int               inStartBlock,
+        int               inBlockCount,
+        IOBuffer&         outBuf,
+        vector<uint32_t>& outChecksums);
+    // Moves the block data from ioBuf into the cache.
+    void Put(
+        kfsChunkId_t inChunkId,
+        kfsSeq_t     inChunkVersion,
+        int          inBlock,
+        IOBuffer&    ioBuf,
+        uint32_t     inChecksum);
+    // Removes all blocks of the chunk regardless of their version.
+    void Invalidate(
+        kfsChunkId_t inChunkId);
+    // Evicts blocks until the cache size is less or equal to the target.
+    void Shrink(
+        int64_t inTargetByteCount);
+    void Clear();
+    void GetCounters(
+        Counters& outCounters) const;
+private:
+    enum ListType
+    {
+        kListIn    = 0,
+        kListMain  = 1,
+        kListGhost = 2,
+        kListCount
+    };
+    class Entry;
+    typedef Entry* EntryList[1];
+    typedef pair<kfsChunkId_t, int> BlockKey;
+    typedef KVPair<BlockKey, Entry*> BlockTableEntry;
+    struct BlockKeyHash
+    {
+        static size_t Hash(
+            const BlockKey& inKey)
+            { return size_t((inKey.first << 10) ^ inKey.second); }
+    };
+    typedef LinearHash<
+        BlockTableEntry,
+        KeyCompare<BlockKey, BlockKeyHash>,
+        DynamicArray<
+            SingleLinkedList<BlockTableEntry>*,
+            16
+        >,
+        StdFastAllocator<BlockTableEntry>
+    > BlockTable;
+    // Chunk table maps chunk id to one of the chunk blocks, all chunk blocks
+    // are linked into circular list.
+    typedef KVPair<kfsChunkId_t, Entry*> ChunkTableEntry;
+    typedef LinearHash<
+        ChunkTableEntry,
+        KeyCompare<kfsChunkId_t>,
+        DynamicArray<
+            SingleLinkedList<ChunkTableEntry>*,
+            12
+        >,
+        StdFastAllocator<ChunkTableEntry>
+    > ChunkTable;
+
+    int64_t    mMaxBytes;
+    int64_t    mInMaxBytes;
+    int64_t    mGhostMaxCount;
+    int64_t    mByteCount;
+    int64_t    mInByteCount;
+    int64_t    mListCounts[kListCount];
+    BlockTable mBlockTable;
+    ChunkTable mChunkTable;
+    EntryList  mLists[kListCount];
+    Counters   mCounters;
+
+    void Reclaim(
+        int64_t inTargetByteCount);
+    void MakeGhost(
+        Entry& inEntry);
+    void Link(
+        Entry&   inEntry,
+        ListType inListType);
+    void Unlink(
+        Entry& inEntry);
+    void Delete(
+        Entry& inEntry);
+private:
+    BlockCache(
+        const BlockCache& inCache);
+    BlockCache& operator=(
+        const BlockCache& inCache);
+};
+
+} // namespace KFS
+
+#endif /* CHUNK_BLOCK_CACHE_H */
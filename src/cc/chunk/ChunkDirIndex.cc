@@ -0,0 +1,923 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkDirIndex.cc
+// \brief Persistent per chunk directory stable chunk file index.
+//
+// Index file format: 8 bytes magic, followed by records. Each record is
+// 1 byte type, varint payload length, payload, and 4 bytes little endian
+// checksum of the type, length, and payload. All integers in the payload are
+// varint encoded, signed integers are zig zag encoded.
+// The first record is the snapshot:
+//  count, [chunk id delta, file id, version, size] * count sorted by chunk id
+// Journal records:
+//  add:    file id, chunk id, version, size
+//  remove: file id, chunk id, version
+//  close:  file system id, directory inode, mtime sec, mtime nsec
+//
+//----------------------------------------------------------------------------
+
+#include "ChunkDirIndex.h"
+
+#include "common/MsgLogger.h"
+#include "common/VarIntCodec.h"
+#include "common/IntToString.h"
+#include "kfsio/checksum.h"
+#include "qcdio/QCUtils.h"
+#include "qcdio/QCThread.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+#include <deque>
+
+namespace KFS
+{
+
+using std::vector;
+using std::sort;
+using std::deque;
+
+const char   kChunkDirIndexMagic[]   = "QFSCDIX1";
+const size_t kChunkDirIndexMagicLen  = sizeof(kChunkDirIndexMagic) - 1;
+const size_t kChunkDirIndexFlushSize = 64 << 10;
+
+enum
+{
+    kRecordSnapshot = 'S',
+    kRecordAdd      = 'A',
+    kRecordRemove   = 'R',
+    kRecordClose    = 'C'
+};
+
+class ChunkDirIndex::Record
+{
+public:
+    Record(
+        int inType)
+        : mPayload()
+    {
+        mPayload.reserve(4 * VarIntCodec::kMaxEncodedLength);
+        mType = (char)inType;
+    }
+    Record& Put(
+        uint64_t inVal)
+    {
+        char        theBuf[VarIntCodec::kMaxEncodedLength];
+        const char* theEndPtr = VarIntCodec::Encode(inVal, theBuf);
+        mPayload.append(theBuf, theEndPtr - theBuf);
+        return *this;
+    }
+    Record& PutSigned(
+        int64_t inVal)
+    {
+        return Put(((uint64_t)inVal << 1) ^ (uint64_t)(inVal >> 63));
+    }
+    void AppendTo(
+        string& ioBuf) const
+    {
+        const size_t theStart = ioBuf.size();
+        ioBuf += mType;
+        char        theBuf[VarIntCodec::kMaxEncodedLength];
+        const char* theEndPtr = VarIntCodec::Encode(mPayload.size(), theBuf);
+        ioBuf.append(theBuf, theEndPtr - theBuf);
+        ioBuf += mPayload;
+        uint32_t theChecksum = ComputeBlockChecksum(
+            ioBuf.data() + theStart, ioBuf.size() - theStart);
+        for (int i = 0; i < 4; i++) {
+            ioBuf += (char)(theChecksum & 0xFF);
+            theChecksum >>= 8;
+        }
+    }
+    void Reserve(
+        size_t inSize)
+        { mPayload.reserve(inSize); }
+private:
+    char   mType;
+    string mPayload;
+};
+
+class ChunkDirIndexReader
+{
+public:
+    ChunkDirIndexReader(
+        const char* inPtr,
+        const char* inEndPtr)
+        : mPtr(inPtr),
+          mEndPtr(inEndPtr)
+        {}
+    bool Get(
+        uint64_t& outVal)
+    {
+        VarIntCodec::Decoder theDecoder;
+        while (mPtr < mEndPtr) {
+            const int theRet = theDecoder.Add((unsigned char)*mPtr++);
+            if (0 < theRet) {
+                outVal = theDecoder.Get();
+                return true;
+            }
+            if (theRet < 0) {
+                break;
+            }
+        }
+        return false;
+    }
+    template<typename T>
+    bool GetSigned(
+        T& outVal)
+    {
+        uint64_t theVal;
+        if (! Get(theVal)) {
+            return false;
+        }
+        outVal = (T)((int64_t)(theVal >> 1) ^ -(int64_t)(theVal & 1));
+        return true;
+    }
+    template<typename T>
+    bool GetUnsigned(
+        T& outVal)
+    {
+        uint64_t theVal;
+        if (! Get(theVal)) {
+            return false;
+        }
+        outVal = (T)theVal;
+        return true;
+    }
+    bool IsEmpty() const
+        { return (mEndPtr <= mPtr); }
+    const char* GetPtr() const
+        { return mPtr; }
+private:
+    const char* mPtr;
+    const char* mEndPtr;
+};
+
+struct ChunkDirIndexEntry
+{
+    kfsChunkId_t mChunkId;
+    kfsSeq_t     mChunkVersion;
+    int64_t      mSeq;
+    kfsFileId_t  mFileId;
+    int64_t      mChunkSize;
+    bool         mRemoveFlag;
+
+    bool operator<(
+        const ChunkDirIndexEntry& inRhs) const
+    {
+        return (
+            mChunkId < inRhs.mChunkId || (mChunkId == inRhs.mChunkId &&
+            (mChunkVersion < inRhs.mChunkVersion ||
+                (mChunkVersion == inRhs.mChunkVersion && mSeq < inRhs.mSeq)))
+        );
+    }
+};
+typedef vector<ChunkDirIndexEntry> ChunkDirIndexEntries;
+
+static bool
+GetDirModTime(
+    const string& inDirName,
+    uint64_t&     outInode,
+    int64_t&      outSec,
+    int64_t&      outNSec)
+{
+    struct stat theStat = {0};
+    if (stat(inDirName.c_str(), &theStat) != 0 || ! S_ISDIR(theStat.st_mode)) {
+        return false;
+    }
+    outInode = (uint64_t)theStat.st_ino;
+#ifdef KFS_OS_NAME_DARWIN
+    outSec   = theStat.st_mtimespec.tv_sec;
+    outNSec  = theStat.st_mtimespec.tv_nsec;
+#else
+    outSec   = theStat.st_mtim.tv_sec;
+    outNSec  = theStat.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+static int
+WriteAll(
+    int         inFd,
+    const char* inPtr,
+    size_t      inLen)
+{
+    const char*       thePtr    = inPtr;
+    const char* const theEndPtr = inPtr + inLen;
+    while (thePtr < theEndPtr) {
+        const ssize_t theNWr = write(inFd, thePtr, theEndPtr - thePtr);
+        if (theNWr < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno > 0 ? -errno : -EIO);
+        }
+        thePtr += theNWr;
+    }
+    return 0;
+}
+
+class ChunkDirIndex::Journal
+{
+public:
+    Journal(
+        const string& inDirName,
+        const string& inPathName)
+        : mDirName(inDirName),
+          mPathName(inPathName),
+          mFd(-1),
+          mStatus(0),
+          mCloseWaitFlag(false),
+          mClosedFlag(false)
+        {}
+    ~Journal()
+    {
+        if (0 <= mFd) {
+            close(mFd);
+        }
+    }
+    const string mDirName;
+    const string mPathName;
+    // The file descriptor is only accessed by the writer thread, and the
+    // remaining fields are protected by the writer mutex.
+    int          mFd;
+    int          mStatus;
+    bool         mCloseWaitFlag;
+    bool         mClosedFlag;
+private:
+    Journal(
+        const Journal& inJournal);
+    Journal& operator=(
+        const Journal& inJournal);
+};
+
+class ChunkDirIndex::Writer : public QCRunnable
+{
+public:
+    enum OpType
+    {
+        kOpTypeOpen  = 0,
+        kOpTypeWrite = 1,
+        kOpTypeClose = 2
+    };
+
+    Writer()
+        : QCRunnable(),
+          mQueue(),
+          mThread(),
+          mMutex(),
+          mCond(),
+          mDoneCond(),
+          mRunFlag(false)
+        {}
+    virtual ~Writer()
+        { Writer::Stop(); }
+    void Enqueue(
+        Journal& inJournal,
+        OpType   inType,
+        string*  inDataPtr         = 0,
+        bool     inCloseRecordFlag = false,
+        int64_t  inFileSystemId    = -1)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        if (! mRunFlag) {
+            mRunFlag = true;
+            const int kStackSize = 64 << 10;
+            mThread.Start(this, kStackSize, "ChunkDirIndex");
+        }
+        mQueue.push_back(Request());
+        Request& theReq = mQueue.back();
+        theReq.mJournalPtr      = &inJournal;
+        theReq.mType            = inType;
+        theReq.mCloseRecordFlag = inCloseRecordFlag;
+        theReq.mFileSystemId    = inFileSystemId;
+        if (inDataPtr) {
+            theReq.mData.swap(*inDataPtr);
+        }
+        mCond.Notify();
+    }
+    int GetStatus(
+        const Journal& inJournal)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        return inJournal.mStatus;
+    }
+    int WaitClose(
+        const Journal& inJournal)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        while (! inJournal.mClosedFlag) {
+            mDoneCond.Wait(mMutex);
+        }
+        return inJournal.mStatus;
+    }
+    void Stop()
+    {
+        {
+            QCStMutexLocker theLocker(mMutex);
+            mRunFlag = false;
+            mCond.Notify();
+        }
+        mThread.Join();
+    }
+    virtual void Run()
+    {
+        QCStMutexLocker theLocker(mMutex);
+        for (; ;) {
+            if (mQueue.empty()) {
+                if (! mRunFlag) {
+                    break;
+                }
+                mCond.Wait(mMutex);
+                continue;
+            }
+            Request theReq;
+            theReq.Swap(mQueue.front());
+            mQueue.pop_front();
+            Journal& theJournal = *theReq.mJournalPtr;
+            int      theStatus  = theJournal.mStatus;
+            {
+                QCStMutexUnlocker theUnlocker(mMutex);
+                theStatus = Process(theReq, theStatus);
+            }
+            theJournal.mStatus = theStatus;
+            if (kOpTypeClose == theReq.mType) {
+                if (theJournal.mCloseWaitFlag) {
+                    theJournal.mClosedFlag = true;
+                    mDoneCond.NotifyAll();
+                } else {
+                    delete &theJournal;
+                }
+            }
+        }
+    }
+private:
+    class Request
+    {
+    public:
+        Request()
+            : mJournalPtr(0),
+              mType(kOpTypeWrite),
+              mCloseRecordFlag(false),
+              mFileSystemId(-1),
+              mData()
+            {}
+        void Swap(
+            Request& inReq)
+        {
+            std::swap(mJournalPtr,      inReq.mJournalPtr);
+            std::swap(mType,            inReq.mType);
+            std::swap(mCloseRecordFlag, inReq.mCloseRecordFlag);
+            std::swap(mFileSystemId,    inReq.mFileSystemId);
+            mData.swap(inReq.mData);
+        }
+        Journal* mJournalPtr;
+        OpType   mType;
+        bool     mCloseRecordFlag;
+        int64_t  mFileSystemId;
+        string   mData;
+    };
+    typedef deque<Request> Queue;
+
+    Queue     mQueue;
+    QCThread  mThread;
+    QCMutex   mMutex;
+    QCCondVar mCond;
+    QCCondVar mDoneCond;
+    bool      mRunFlag;
+
+    static int Process(
+        Request& inReq,
+        int      inStatus)
+    {
+        Journal& theJournal = *inReq.mJournalPtr;
+        int      theErr     = inStatus;
+        switch (inReq.mType) {
+            case kOpTypeOpen:
+                theJournal.mFd = open(
+                    theJournal.mPathName.c_str(), O_WRONLY | O_APPEND);
+                if (theJournal.mFd < 0) {
+                    theErr = errno > 0 ? -errno : -EIO;
+                }
+                break;
+            case kOpTypeWrite:
+                if (theErr == 0 && 0 <= theJournal.mFd) {
+                    theErr = WriteAll(theJournal.mFd,
+                        inReq.mData.data(), inReq.mData.size());
+                }
+                break;
+            case kOpTypeClose:
+                if (theErr == 0 && 0 <= theJournal.mFd &&
+                        inReq.mCloseRecordFlag) {
+                    theErr = WriteCloseRecord(theJournal, inReq);
+                }
+                if (0 <= theJournal.mFd) {
+                    close(theJournal.mFd);
+                    theJournal.mFd = -1;
+                }
+                break;
+            default:
+                theErr = -EINVAL;
+                break;
+        }
+        if (theErr != 0 && theErr != inStatus) {
+            KFS_LOG_STREAM_ERROR <<
+                theJournal.mPathName << ": " << QCUtils::SysError(-theErr) <<
+            KFS_LOG_EOM;
+        }
+        return theErr;
+    }
+    static int WriteCloseRecord(
+        Journal& inJournal,
+        Request& inReq)
+    {
+        uint64_t theInode   = 0;
+        int64_t  theModSec  = -1;
+        int64_t  theModNSec = -1;
+        if (! GetDirModTime(
+                inJournal.mDirName, theInode, theModSec, theModNSec)) {
+            return -ENOENT;
+        }
+        inReq.mData.clear();
+        Record(kRecordClose)
+            .PutSigned(inReq.mFileSystemId)
+            .Put(theInode)
+            .PutSigned(theModSec)
+            .PutSigned(theModNSec)
+            .AppendTo(inReq.mData);
+        int theErr = WriteAll(
+            inJournal.mFd, inReq.mData.data(), inReq.mData.size());
+        if (theErr == 0 && fsync(inJournal.mFd) != 0) {
+            theErr = errno > 0 ? -errno : -EIO;
+        }
+        return theErr;
+    }
+private:
+    Writer(
+        const Writer& inWriter);
+    Writer& operator=(
+        const Writer& inWriter);
+};
+
+ChunkDirIndex::Writer* ChunkDirIndex::sWriterPtr = 0;
+
+ChunkDirIndex::ChunkDirIndex()
+    : mJournalPtr(0),
+      mErrorFlag(false),
+      mBuffer()
+    {}
+
+ChunkDirIndex::~ChunkDirIndex()
+{
+    Close(false, -1);
+}
+
+    /* static */ void
+ChunkDirIndex::Shutdown()
+{
+    if (! sWriterPtr) {
+        return;
+    }
+    sWriterPtr->Stop();
+    delete sWriterPtr;
+    sWriterPtr = 0;
+}
+
+    /* static */ int
+ChunkDirIndex::Load(
+    const string& inDirName,
+    const string& inFileName,
+    const string& inFsIdPrefix,
+    int64_t&      outFileSystemId,
+    string&       outFsIdPathName,
+    ChunkInfos&   outChunkInfos)
+{
+    const string thePathName = inDirName + inFileName;
+    const int    theFd       = open(thePathName.c_str(), O_RDONLY);
+    if (theFd < 0) {
+        const int theErr = errno;
+        KFS_LOG_STREAM(theErr == ENOENT ?
+                MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelERROR) <<
+            thePathName << ": " << QCUtils::SysError(theErr) <<
+        KFS_LOG_EOM;
+        return (theErr > 0 ? -theErr : -EIO);
+    }
+    struct stat theStat = {0};
+    string      theBuf;
+    int         theErr  = 0;
+    if (fstat(theFd, &theStat) != 0) {
+        theErr = errno > 0 ? -errno : -EIO;
+    } else {
+        theBuf.resize((size_t)theStat.st_size);
+        size_t theLen = 0;
+        while (theLen < theBuf.size()) {
+            const ssize_t theNRd = read(theFd,
+                &theBuf[theLen], theBuf.size() - theLen);
+            if (theNRd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                theErr = errno > 0 ? -errno : -EIO;
+                break;
+            }
+            if (theNRd == 0) {
+                theBuf.resize(theLen);
+                break;
+            }
+            theLen += theNRd;
+        }
+    }
+    close(theFd);
+    if (theErr != 0) {
+        KFS_LOG_STREAM_ERROR <<
+            thePathName << ": " << QCUtils::SysError(-theErr) <<
+        KFS_LOG_EOM;
+        return theErr;
+    }
+    if (theBuf.size() < kChunkDirIndexMagicLen || memcmp(
+            theBuf.data(), kChunkDirIndexMagic, kChunkDirIndexMagicLen) != 0) {
+        KFS_LOG_STREAM_ERROR <<
+            thePathName << ": invalid chunk directory index header" <<
+        KFS_LOG_EOM;
+        return -EINVAL;
+    }
+    ChunkDirIndexEntries theEntries;
+    const char*          thePtr          = theBuf.data() + kChunkDirIndexMagicLen;
+    const char* const    theEndPtr       = theBuf.data() + theBuf.size();
+    int                  theLastType     = -1;
+    int64_t              theSeq          = 0;
+    int64_t              theFsId         = -1;
+    uint64_t             theInode        = 0;
+    int64_t              theModSec       = -1;
+    int64_t              theModNSec      = -1;
+    const char*          theErrMsg       = 0;
+    while (thePtr < theEndPtr) {
+        const char* const  theRecPtr = thePtr;
+        const int          theType   = *thePtr++ & 0xFF;
+        ChunkDirIndexReader theLenReader(thePtr, theEndPtr);
+        uint64_t           theLen    = 0;
+        if (! theLenReader.Get(theLen)) {
+            theErrMsg = "truncated record";
+            break;
+        }
+        thePtr = theLenReader.GetPtr();
+        if ((uint64_t)(theEndPtr - thePtr) < theLen + 4) {
+            theErrMsg = "truncated record";
+            break;
+        }
+        const char* const thePayloadEndPtr = thePtr + theLen;
+        uint32_t          theChecksum      = 0;
+        for (int i = 3; 0 <= i; i--) {
+            theChecksum = (theChecksum << 8) | (thePayloadEndPtr[i] & 0xFF);
+        }
+        if (theChecksum != ComputeBlockChecksum(
+                theRecPtr, thePayloadEndPtr - theRecPtr)) {
+            theErrMsg = "record checksum mismatch";
+            break;
+        }
+        ChunkDirIndexReader theReader(thePtr, thePayloadEndPtr);
+        thePtr = thePayloadEndPtr + 4;
+        if ((kRecordSnapshot == theType) != (theLastType < 0)) {
+            theErrMsg = "invalid record order";
+            break;
+        }
+        theLastType = theType;
+        switch (theType) {
+            case kRecordSnapshot: {
+                uint64_t theCnt = 0;
+                if (! theReader.Get(theCnt) || theLen / 4 < theCnt) {
+                    theErrMsg = "invalid snapshot record";
+                    break;
+                }
+                theEntries.reserve((size_t)theCnt);
+                ChunkDirIndexEntry theEntry = {0};
+                uint64_t           theId    = 0;
+                for (uint64_t i = 0; i < theCnt; i++) {
+                    uint64_t theDelta = 0;
+                    if (! theReader.Get(theDelta) ||
+                            ! theReader.GetUnsigned(theEntry.mFileId) ||
+                            ! theReader.GetSigned(theEntry.mChunkVersion) ||
+                            ! theReader.GetSigned(theEntry.mChunkSize)) {
+                        theErrMsg = "invalid snapshot entry";
+                        break;
+                    }
+                    theId += theDelta;
+                    theEntry.mChunkId = (kfsChunkId_t)theId;
+                    theEntries.push_back(theEntry);
+                }
+                break;
+            }
+            case kRecordAdd:
+            case kRecordRemove: {
+                ChunkDirIndexEntry theEntry = {0};
+                theEntry.mSeq        = ++theSeq;
+                theEntry.mRemoveFlag = kRecordRemove == theType;
+                if (! theReader.GetUnsigned(theEntry.mFileId) ||
+                        ! theReader.GetUnsigned(theEntry.mChunkId) ||
+                        ! theReader.GetSigned(theEntry.mChunkVersion) ||
+                        (! theEntry.mRemoveFlag &&
+                            ! theReader.GetSigned(theEntry.mChunkSize))) {
+                    theErrMsg = "invalid journal record";
+                    break;
+                }
+                theEntries.push_back(theEntry);
+                break;
+            }
+            case kRecordClose:
+                if (! theReader.GetSigned(theFsId) ||
+                        ! theReader.Get(theInode) ||
+                        ! theReader.GetSigned(theModSec) ||
+                        ! theReader.GetSigned(theModNSec)) {
+                    theErrMsg = "invalid close record";
+                }
+                break;
+            default:
+                theErrMsg = "invalid record type";
+                break;
+        }
+        if (theErrMsg) {
+            break;
+        }
+        if (! theReader.IsEmpty()) {
+            theErrMsg = "invalid record length";
+            break;
+        }
+    }
+    uint64_t theCurInode   = 0;
+    int64_t  theCurModSec  = -1;
+    int64_t  theCurModNSec = -1;
+    if (! theErrMsg) {
+        if (kRecordClose != theLastType) {
+            theErrMsg = "no close record";
+        } else if (! GetDirModTime(
+                inDirName, theCurInode, theCurModSec, theCurModNSec) ||
+                theCurInode != theInode ||
+                theCurModSec != theModSec ||
+                theCurModNSec != theModNSec) {
+            theErrMsg = "directory modification time mismatch";
+        }
+    }
+    string theFsIdPathName;
+    if (! theErrMsg && ! inFsIdPrefix.empty()) {
+        if (theFsId <= 0) {
+            theErrMsg = "no file system id";
+        } else {
+            theFsIdPathName = inDirName + inFsIdPrefix;
+            AppendDecIntToString(theFsIdPathName, theFsId);
+            if (stat(theFsIdPathName.c_str(), &theStat) != 0) {
+                theErrMsg = "no file system id file";
+            }
+        }
+    }
+    if (theErrMsg) {
+        KFS_LOG_STREAM_INFO <<
+            thePathName << ": " << theErrMsg <<
+            " records: " << theEntries.size() <<
+            " scanning directory" <<
+        KFS_LOG_EOM;
+        return -EINVAL;
+    }
+    if (0 < theSeq) {
+        // Stable sort is not required, sequence makes all keys unique.
+        sort(theEntries.begin(), theEntries.end());
+    }
+    outChunkInfos.Clear();
+    ChunkInfo theInfo;
+    for (ChunkDirIndexEntries::const_iterator theIt = theEntries.begin();
+            theIt != theEntries.end();
+            ++theIt) {
+        ChunkDirIndexEntries::const_iterator const theNextIt = theIt + 1;
+        if (theNextIt != theEntries.end() &&
+                theNextIt->mChunkId == theIt->mChunkId &&
+                theNextIt->mChunkVersion == theIt->mChunkVersion) {
+            continue; // The last record for a given chunk file wins.
+        }
+        if (theIt->mRemoveFlag) {
+            continue;
+        }
+        theInfo.mFileId       = theIt->mFileId;
+        theInfo.mChunkId      = theIt->mChunkId;
+        theInfo.mChunkVersion = theIt->mChunkVersion;
+        theInfo.mChunkSize    = theIt->mChunkSize;
+        outChunkInfos.PushBack(theInfo);
+    }
+    outFileSystemId = theFsId;
+    outFsIdPathName.swap(theFsIdPathName);
+    KFS_LOG_STREAM_INFO <<
+        thePathName <<
+        ": loaded chunks: " << outChunkInfos.GetSize() <<
+        " journal records: " << theSeq <<
+        " fs id: " << outFileSystemId <<
+    KFS_LOG_EOM;
+    return 0;
+}
+
+    /* static */ int
+ChunkDirIndex::Write(
+    const string&     inDirName,
+    const string&     inFileName,
+    const ChunkInfos& inChunkInfos)
+{
+    ChunkDirIndexEntries theEntries;
+    theEntries.reserve(inChunkInfos.GetSize());
+    ChunkInfos::ConstIterator theIt(inChunkInfos);
+    const ChunkInfo*          thePtr;
+    ChunkDirIndexEntry        theEntry = {0};
+    while ((thePtr = theIt.Next())) {
+        theEntry.mFileId       = thePtr->mFileId;
+        theEntry.mChunkId      = thePtr->mChunkId;
+        theEntry.mChunkVersion = thePtr->mChunkVersion;
+        theEntry.mChunkSize    = thePtr->mChunkSize;
+        theEntries.push_back(theEntry);
+    }
+    sort(theEntries.begin(), theEntries.end());
+    Record theRecord(kRecordSnapshot);
+    theRecord.Reserve(theEntries.size() * 8 + VarIntCodec::kMaxEncodedLength);
+    theRecord.Put(theEntries.size());
+    uint64_t thePrevId = 0;
+    for (ChunkDirIndexEntries::const_iterator theIt = theEntries.begin();
+            theIt != theEntries.end();
+            ++theIt) {
+        theRecord
+            .Put((uint64_t)theIt->mChunkId - thePrevId)
+            .Put((uint64_t)theIt->mFileId)
+            .PutSigned(theIt->mChunkVersion)
+            .PutSigned(theIt->mChunkSize);
+        thePrevId = (uint64_t)theIt->mChunkId;
+    }
+    string theBuf(kChunkDirIndexMagic, kChunkDirIndexMagicLen);
+    theRecord.AppendTo(theBuf);
+    ChunkDirIndexEntries().swap(theEntries);
+    const string theTmpName  = inDirName + MakeTmpFileName(inFileName);
+    const string thePathName = inDirName + inFileName;
+    const int    theFd       = open(
+        theTmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int theErr = theFd < 0 ? (errno > 0 ? -errno : -EIO) : 0;
+    if (0 <= theFd) {
+        theErr = WriteAll(theFd, theBuf.data(), theBuf.size());
+        if (theErr == 0 && fsync(theFd) != 0) {
+            theErr = errno > 0 ? -errno : -EIO;
+        }
+        if (close(theFd) != 0 && theErr == 0) {
+            theErr = errno > 0 ? -errno : -EIO;
+        }
+        if (theErr == 0 && rename(theTmpName.c_str(), thePathName.c_str())) {
+            theErr = errno > 0 ? -errno : -EIO;
+        }
+        if (theErr != 0) {
+            unlink(theTmpName.c_str());
+        }
+    }
+    KFS_LOG_STREAM(theErr == 0 ?
+            MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelERROR) <<
+        thePathName <<
+        ": write chunks: " << inChunkInfos.GetSize() <<
+        " bytes: "         << theBuf.size() <<
+        " status: "        << QCUtils::SysError(-theErr) <<
+    KFS_LOG_EOM;
+    return theErr;
+}
+
+int
+ChunkDirIndex::Open(
+    const string& inDirName,
+    const string& inFileName)
+{
+    Close(false, -1);
+    if (! sWriterPtr) {
+        sWriterPtr = new Writer();
+    }
+    mJournalPtr = new Journal(inDirName, inDirName + inFileName);
+    mErrorFlag  = false;
+    sWriterPtr->Enqueue(*mJournalPtr, Writer::kOpTypeOpen);
+    return 0;
+}
+
+void
+ChunkDirIndex::Append(
+    const Record& inRecord)
+{
+    if (! mJournalPtr || mErrorFlag) {
+        return;
+    }
+    inRecord.AppendTo(mBuffer);
+    if (kChunkDirIndexFlushSize <= mBuffer.size()) {
+        Flush();
+    }
+}
+
+void
+ChunkDirIndex::Add(
+    kfsFileId_t  inFileId,
+    kfsChunkId_t inChunkId,
+    kfsSeq_t     inChunkVersion,
+    int64_t      inChunkSize)
+{
+    Append(Record(kRecordAdd)
+        .Put((uint64_t)inFileId)
+        .Put((uint64_t)inChunkId)
+        .PutSigned(inChunkVersion)
+        .PutSigned(inChunkSize)
+    );
+}
+
+void
+ChunkDirIndex::Remove(
+    kfsFileId_t  inFileId,
+    kfsChunkId_t inChunkId,
+    kfsSeq_t     inChunkVersion)
+{
+    Append(Record(kRecordRemove)
+        .Put((uint64_t)inFileId)
+        .Put((uint64_t)inChunkId)
+        .PutSigned(inChunkVersion)
+    );
+}
+
+void
+ChunkDirIndex::Invalidate()
+{
+    if (! mJournalPtr || mErrorFlag) {
+        return;
+    }
+    KFS_LOG_STREAM_INFO <<
+        mJournalPtr->mPathName << ": invalidated" <<
+    KFS_LOG_EOM;
+    mErrorFlag = true;
+    mBuffer.clear();
+}
+
+void
+ChunkDirIndex::Flush()
+{
+    if (! mJournalPtr || mErrorFlag || ! sWriterPtr) {
+        mBuffer.clear();
+        return;
+    }
+    if (sWriterPtr->GetStatus(*mJournalPtr) != 0) {
+        // Write failure, the index can not be used at startup.
+        mErrorFlag = true;
+        mBuffer.clear();
+        return;
+    }
+    sWriterPtr->Enqueue(*mJournalPtr, Writer::kOpTypeWrite, &mBuffer);
+    mBuffer.clear();
+}
+
+int
+ChunkDirIndex::Close(
+    bool    inCloseRecordFlag,
+    int64_t inFileSystemId)
+{
+    if (! mJournalPtr) {
+        return 0;
+    }
+    Flush();
+    int theErr = 0;
+    if (sWriterPtr) {
+        Journal& theJournal = *mJournalPtr;
+        theJournal.mCloseWaitFlag = inCloseRecordFlag && ! mErrorFlag;
+        sWriterPtr->Enqueue(theJournal, Writer::kOpTypeClose, 0,
+            theJournal.mCloseWaitFlag, inFileSystemId);
+        if (theJournal.mCloseWaitFlag) {
+            theErr = sWriterPtr->WaitClose(theJournal);
+            delete &theJournal;
+        }
+    } else {
+        // Writer has already been shut down, the journal is not
+        // referenced by the writer thread.
+        delete mJournalPtr;
+    }
+    mJournalPtr = 0;
+    mErrorFlag  = false;
+    mBuffer.clear();
+    return theErr;
+}
+
+}
@@ -0,0 +1,121 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkDirIndex.h
+// \brief Persistent per chunk directory stable chunk file index.
+//
+// The index file consists of the compacted snapshot of the directory's stable
+// chunk files followed by the journal of stable chunk file additions and
+// removals. The chunk manager appends the "close" record with the directory
+// modification time, once all chunk files renames and deletes have completed
+// on orderly shutdown. The index is used by the directory checker at startup
+// instead of directory scan only if the last record is the close record, and
+// the directory modification time matches. Any partial, or corrupted, or
+// missing close record results in the full directory scan.
+// The journal file open, writes, and close run on the index writer thread
+// shared by all directories, in order not to block the event thread.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_DIR_INDEX_H
+#define CHUNK_DIR_INDEX_H
+
+#include "DirChecker.h"
+
+#include <string>
+
+namespace KFS
+{
+
+using std::string;
+
+class ChunkDirIndex
+{
+public:
+    typedef DirChecker::ChunkInfo  ChunkInfo;
+    typedef DirChecker::ChunkInfos ChunkInfos;
+
+    ChunkDirIndex();
+    ~ChunkDirIndex();
+    // Loads and validates the index. Returns 0 if the index can be used instead
+    // of the directory scan.
+    static int Load(
+        const string& inDirName,
+        const string& inFileName,
+        const string& inFsIdPrefix,
+        int64_t&      outFileSystemId,
+        string&       outFsIdPathName,
+        ChunkInfos&   outChunkInfos);
+    // Writes compacted index, replacing existing one.
+    static int Write(
+        const string&     inDirName,
+        const string&     inFileName,
+        const ChunkInfos& inChunkInfos);
+    static string MakeTmpFileName(
+        const string& inFileName)
+        { return (inFileName + ".tmp"); }
+    int Open(
+        const string& inDirName,
+        const string& inFileName);
+    void Add(
+        kfsFileId_t  inFileId,
+        kfsChunkId_t inChunkId,
+        kfsSeq_t     inChunkVersion,
+        int64_t      inChunkSize);
+    void Remove(
+        kfsFileId_t  inFileId,
+        kfsChunkId_t inChunkId,
+        kfsSeq_t     inChunkVersion);
+    // Makes the index unusable for the next startup.
+    void Invalidate();
+    // Flushes journal, and if close flag is set, appends close record, and
+    // waits for the writer to complete the close.
+    int Close(
+        bool    inCloseRecordFlag,
+        int64_t inFileSystemId);
+    bool IsOpen() const
+        { return (0 != mJournalPtr); }
+    // Stops index writer thread. Must be invoked after all indexes are closed.
+    static void Shutdown();
+private:
+    class Record;
+    class Journal;
+    class Writer;
+
+    Journal* mJournalPtr;
+    bool     mErrorFlag;
+    string   mBuffer;
+
+    static Writer* sWriterPtr;
+
+    void Flush();
+    void Append(
+        const Record& inRecord);
+private:
+    ChunkDirIndex(
+        const ChunkDirIndex& inIndex);
+    ChunkDirIndex& operator=(
+        const ChunkDirIndex& inIndex);
+};
+
+}
+
+#endif /* CHUNK_DIR_INDEX_H */
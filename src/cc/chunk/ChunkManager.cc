@@ -35,12 +35,14 @@
 #include "BufferManager.h"
 #include "ClientManager.h"
 #include "ClientSM.h"
+#include "ChunkDirIndex.h"
 
 #include "common/MsgLogger.h"
 #include "common/kfstypes.h"
 #include "common/nofilelimit.h"
 #include "common/IntToString.h"
 #include "common/SingleLinkedQueue.h"
+#include "common/RequestTrace.h"
 
 #include "kfsio/Counter.h"
 #include "kfsio/checksum.h"
@@ -142,23 +144,32 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
           availableChunksOpInFlightFlag(false),
           notifyAvailableChunksStartFlag(false),
           timeoutPendingFlag(false),
+          scrubInFlightFlag(false),
           lastEvacuationActivityTime(
             globalNetManager().Now() - 365 * 24 * 60 * 60),
           startTime(globalNetManager().Now()),
           stopTime(startTime),
           startCount(0),
           evacuateCompletedCount(0),
+          scrubPassRemainingCount(0),
+          scrubPassChunkCount(0),
+          scrubPassByteCount(0),
+          scrubPassStartTime(0),
+          scrubNextTime(0),
+          scrubStartTime(0),
           readCounters(),
           writeCounters(),
           totalReadCounters(),
           totalWriteCounters(),
           availableChunks(),
+          chunkDirIndex(),
           fsSpaceAvailCb(),
           checkDirCb(),
           checkEvacuateFileCb(),
           evacuateChunksCb(),
           renameEvacuateFileCb(),
           availableChunksCb(),
+          scrubCb(),
           evacuateChunksOp(&evacuateChunksCb),
           availableChunksOp(&availableChunksCb),
           chunkDirInfoOp(*this)
@@ -175,6 +186,8 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
             &ChunkDirInfo::RenameEvacuateFileDone);
         availableChunksCb.SetHandler(this,
             &ChunkDirInfo::AvailableChunksDone);
+        scrubCb.SetHandler(this,
+            &ChunkDirInfo::ScrubDone);
         for (int i = 0; i < kChunkDirListCount; i++) {
             ChunkList::Init(chunkLists[i]);
             ChunkDirList::Init(chunkLists[i]);
@@ -194,6 +207,9 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
     void DiskError(int sysErr);
     int EvacuateChunksDone(int code, void* data);
     int AvailableChunksDone(int code, void* data);
+    int ScrubDone(int code, void* data);
+    void Scrub(int64_t nowUsec);
+    void ScrubPassDone(int64_t nowUsec);
     void ScheduleEvacuate(int maxChunkCount = -1);
     void RestartEvacuation();
     void NotifyAvailableChunks(bool tmeoutFlag = false);
@@ -261,7 +277,12 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
         evacuateStartChunkCount        = -1;
         evacuateStartByteCount         = -1;
         notifyAvailableChunksStartFlag = false;
+        gChunkManager.mCounters.mScrubPassRemainingCount -=
+            scrubPassRemainingCount;
+        scrubPassRemainingCount        = 0;
         availableChunks.Clear();
+        // Directory is no longer in use, and can not be trusted at startup.
+        chunkDirIndex.Close(false, -1);
         if (timeoutPendingFlag) {
             timeoutPendingFlag = false;
             globalNetManager().UnRegisterTimeoutHandler(this);
@@ -697,22 +718,31 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
     bool                   availableChunksOpInFlightFlag:1;
     bool                   notifyAvailableChunksStartFlag:1;
     bool                   timeoutPendingFlag:1;
+    bool                   scrubInFlightFlag:1;
     time_t                 lastEvacuationActivityTime;
     time_t                 startTime;
     time_t                 stopTime;
     int32_t                startCount;
     int32_t                evacuateCompletedCount;
+    int32_t                scrubPassRemainingCount;
+    int32_t                scrubPassChunkCount;
+    int64_t                scrubPassByteCount;
+    int64_t                scrubPassStartTime;
+    int64_t                scrubNextTime;
+    int64_t                scrubStartTime;
     Counters               readCounters;
     Counters               writeCounters;
     Counters               totalReadCounters;
     Counters               totalWriteCounters;
     DirChecker::ChunkInfos availableChunks;
+    ChunkDirIndex          chunkDirIndex;
     KfsCallbackObj         fsSpaceAvailCb;
     KfsCallbackObj         checkDirCb;
     KfsCallbackObj         checkEvacuateFileCb;
     KfsCallbackObj         evacuateChunksCb;
     KfsCallbackObj         renameEvacuateFileCb;
     KfsCallbackObj         availableChunksCb;
+    KfsCallbackObj         scrubCb;
     EvacuateChunksOp       evacuateChunksOp;
     AvailableChunksOp      availableChunksOp;
     ChunkDirInfoOp         chunkDirInfoOp;
@@ -1368,7 +1398,8 @@ public:
     {
         StaleChunkDeleteCompletion* ret = List::PopFront(lists[kFreeList]);
         if (ret) {
-            ret->mCbPtr = cb;
+            ret->mCbPtr    = cb;
+            ret->mIndexPtr = 0;
         } else {
             ret = new StaleChunkDeleteCompletion(cb);
         }
@@ -1391,7 +1422,8 @@ public:
         Lists                       lists)
     {
         KfsCallbackObj* const op = cb.mCbPtr;
-        cb.mCbPtr = 0;
+        cb.mCbPtr    = 0;
+        cb.mIndexPtr = 0;
         List::Remove(lists[kInFlightList], cb);
         List::PushBack(lists[kFreeList],   cb);
         if (op) {
@@ -1399,6 +1431,9 @@ public:
             op->HandleEvent(EVENT_DISK_ERROR, &res);
         }
     }
+    void SetDirIndex(
+        ChunkDirIndex* index)
+        { mIndexPtr = index; }
     static void Init(
         Lists lists,
         int   freeListSize)
@@ -1412,6 +1447,7 @@ public:
     }
 private:
     KfsCallbackObj*             mCbPtr;
+    ChunkDirIndex*              mIndexPtr;
     StaleChunkDeleteCompletion* mPrevPtr[1];
     StaleChunkDeleteCompletion* mNextPtr[1];
 
@@ -1420,7 +1456,8 @@ private:
     StaleChunkDeleteCompletion(
         KfsCallbackObj* cb)
         : KfsCallbackObj(),
-          mCbPtr(cb)
+          mCbPtr(cb),
+          mIndexPtr(0)
     {
         List::Init(*this);
         SET_HANDLER(this, &StaleChunkDeleteCompletion::Done);
@@ -1433,6 +1470,11 @@ private:
     }
     int Done(int code, void* data)
     {
+        if (mIndexPtr && EVENT_DISK_ERROR == code) {
+            // Chunk file removal was journaled when the request was issued.
+            mIndexPtr->Invalidate();
+        }
+        mIndexPtr = 0;
         KfsCallbackObj* const cb = mCbPtr;
         mCbPtr = 0;
         const int ret = cb ? cb->HandleEvent(code, data) : 0;
@@ -1597,6 +1639,7 @@ ChunkManager::AddMapping(ChunkInfoHandle* cih)
         return *ci;
     }
     if (0 <= cih->chunkInfo.chunkVersion) {
+        mBlockCache.Invalidate(cih->chunkInfo.chunkId);
         mUsedSpace += cih->chunkInfo.chunkSize;
     }
     UpdateDirSpace(cih, cih->chunkInfo.chunkSize);
@@ -1684,6 +1727,7 @@ ChunkManager::DeleteSelf(ChunkInfoHandle& cih)
 {
     if (0 <= cih.chunkInfo.chunkVersion) {
         HelloNotifyRemove(cih);
+        mBlockCache.Invalidate(cih.chunkInfo.chunkId);
     }
     cih.Delete(mChunkInfoLists);
 }
@@ -1710,6 +1754,7 @@ ChunkManager::RemoveFromChunkTable(ChunkInfoHandle& cih)
         return false;
     }
     HelloNotifyRemove(cih);
+    mBlockCache.Invalidate(cih.chunkInfo.chunkId);
     return true;
 }
 
@@ -2021,8 +2066,25 @@ ChunkInfoHandle::HandleChunkMetaWriteDone(int codeIn, void* dataIn)
                 const bool updateFlag =
                     mWriteMetaOps.Front()->stableFlag != mStableFlag &&
                     IsFileOpen();
+                const bool     prevStableFlag = mStableFlag;
+                const kfsSeq_t prevVersion    = chunkInfo.chunkVersion;
                 mStableFlag = mWriteMetaOps.Front()->stableFlag;
                 chunkInfo.chunkVersion = mWriteMetaOps.Front()->targetVersion;
+                if (0 <= chunkInfo.chunkVersion &&
+                        (prevStableFlag || mStableFlag) &&
+                        (prevStableFlag != mStableFlag ||
+                            prevVersion != chunkInfo.chunkVersion)) {
+                    // Journal stable chunk file name change.
+                    ChunkDirIndex& index = GetDirInfo().chunkDirIndex;
+                    if (prevStableFlag && 0 <= prevVersion) {
+                        index.Remove(chunkInfo.fileId, chunkInfo.chunkId,
+                            prevVersion);
+                    }
+                    if (mStableFlag) {
+                        index.Add(chunkInfo.fileId, chunkInfo.chunkId,
+                            chunkInfo.chunkVersion, chunkInfo.chunkSize);
+                    }
+                }
                 if (updateFlag) {
                     UpdateDirStableCount();
                 }
@@ -2140,6 +2202,7 @@ ChunkManager::ChunkManager()
       mEvacuateFileName("evacuate"),
       mEvacuateDoneFileName(mEvacuateFileName + ".done"),
       mChunkDirLockName("lock"),
+      mChunkDirIndexFileName(),
       mEvacuationInactivityTimeout(300),
       mMetaHeartbeatTime(globalNetManager().Now() - 365 * 24 * 60 * 60),
       mMetaEvacuateCount(-1),
@@ -2166,8 +2229,20 @@ ChunkManager::ChunkManager()
       mVersionChangePermitWritesInFlightFlag(true),
       mMinChunkCountForHelloResume(1 << 10),
       mHelloResumeFailureTraceFileName(),
+      mScrubberBytesPerSec(0),
+      mScrubberMinPassIntervalSecs(7 * 24 * 60 * 60),
+      mScrubberMaxChunksPerRun(64),
+      mBlockCacheMaxBytes(0),
+      mBlockCacheInRatio(0.25),
+      mAccessTokenCacheMaxEntries(8 << 10),
+      mTraceRingSize(0),
+      mTraceDumpFileName(),
+      mTraceDumpIntervalSecs(60),
+      mNextTraceDumpTime(0),
       mPendingNotifyLostChunks(),
       mCorruptChunkOp(-1),
+      mBlockCache(),
+      mAccessTokenCache(),
       mLastPendingInFlight(),
       mCleanupStaleChunksFlag(true),
       mDiskIoRequestAffinityFlag(false),
@@ -2234,7 +2309,7 @@ ChunkManager::ClearTable(T& table)
     table.Swap(tmp);
 }
 
-template<typename T> void
+template<typename T> bool
 ChunkManager::RunIoCompletion(T& table)
 {
     typename T::Entry::value_type const* p;
@@ -2294,6 +2369,7 @@ ChunkManager::RunIoCompletion(T& table)
         }
         usleep(10000);
     }
+    return table.IsEmpty();
 }
 
 void
@@ -2303,6 +2379,8 @@ ChunkManager::Shutdown()
     gMetaServerSM.Shutdown();
     mDirChecker.Stop();
     gClientManager.Shutdown();
+    mBlockCache.Clear();
+    mAccessTokenCache.Clear();
     // Run delete queue before removing chunk table entries.
     RunStaleChunksQueue();
     for (int i = 0; ;) {
@@ -2330,8 +2408,8 @@ ChunkManager::Shutdown()
     ClearTable(mObjTable);
     ClearTable(mChunkTable);
     gAtomicRecordAppendManager.Shutdown();
-    RunIoCompletion(mObjTable);
-    RunIoCompletion(mChunkTable);
+    const bool objIoDoneFlag   = RunIoCompletion(mObjTable);
+    const bool chunkIoDoneFlag = RunIoCompletion(mChunkTable);
     gClientManager.Shutdown();
     Replicator::Shutdown();
     for (int i = 0; i < 256; i++) {
@@ -2341,6 +2419,20 @@ ChunkManager::Shutdown()
             break;
         }
     }
+    // Mark chunk directory indexes usable on restart only if all chunk file
+    // renames and deletes have completed.
+    const bool indexCloseFlag = objIoDoneFlag && chunkIoDoneFlag &&
+        mStaleChunkOpsInFlight <= 0;
+    for (ChunkDirs::iterator it = mChunkDirs.begin();
+            it != mChunkDirs.end();
+            ++it) {
+        it->chunkDirIndex.Close(
+            indexCloseFlag && 0 <= it->availableSpace &&
+                ! it->checkDirFlightFlag,
+            it->fileSystemId
+        );
+    }
+    ChunkDirIndex::Shutdown();
     globalNetManager().UnRegisterTimeoutHandler(this);
     mCryptoKeys.Stop();
     string errMsg;
@@ -2483,6 +2575,13 @@ ChunkManager::SetParameters(const Properties& prop)
     mEvacuateDoneFileName = prop.getValue(
         "chunkServer.evacuateDoneFileName",
         mEvacuateDoneFileName);
+    mChunkDirIndexFileName = prop.getValue(
+        "chunkServer.chunkDirIndexFileName",
+        mChunkDirIndexFileName);
+    if (mChunkDirIndexFileName.find('/') != string::npos) {
+        mChunkDirIndexFileName.clear();
+    }
+    mDirChecker.SetChunkIndexFileName(mChunkDirIndexFileName);
     mEvacuationInactivityTimeout = prop.getValue(
         "chunkServer.evacuationInactivityTimeout",
         mEvacuationInactivityTimeout);
@@ -2539,6 +2638,10 @@ ChunkManager::SetParameters(const Properties& prop)
     if (! mCheckDirWritableTmpFileName.empty()) {
         names.insert(mCheckDirWritableTmpFileName);
     }
+    if (! mChunkDirIndexFileName.empty()) {
+        names.insert(mChunkDirIndexFileName);
+        names.insert(ChunkDirIndex::MakeTmpFileName(mChunkDirIndexFileName));
+    }
     mDirChecker.SetIgnoreFileNames(names);
 
     gAtomicRecordAppendManager.SetParameters(prop);
@@ -2587,6 +2690,38 @@ ChunkManager::SetParameters(const Properties& prop)
     mHelloResumeFailureTraceFileName = prop.getValue(
         "chunkServer.helloResumeFailureTraceFileName",
         mHelloResumeFailureTraceFileName);
+    mScrubberBytesPerSec = prop.getValue(
+        "chunkServer.scrubber.bytesPerSec",
+        mScrubberBytesPerSec);
+    mScrubberMinPassIntervalSecs = max(0, prop.getValue(
+        "chunkServer.scrubber.minPassIntervalSecs",
+        mScrubberMinPassIntervalSecs));
+    mScrubberMaxChunksPerRun = max(1, prop.getValue(
+        "chunkServer.scrubber.maxChunksPerRun",
+        mScrubberMaxChunksPerRun));
+    mBlockCacheMaxBytes = prop.getValue(
+        "chunkServer.blockCache.maxBytes",
+        mBlockCacheMaxBytes);
+    mBlockCacheInRatio = prop.getValue(
+        "chunkServer.blockCache.inRatio",
+        mBlockCacheInRatio);
+    mBlockCache.SetParameters(mBlockCacheMaxBytes, mBlockCacheInRatio);
+    mAccessTokenCacheMaxEntries = prop.getValue(
+        "chunkServer.accessTokenCache.maxEntries",
+        mAccessTokenCacheMaxEntries);
+    mAccessTokenCache.SetParameters(mAccessTokenCacheMaxEntries);
+    // The chunk server does not start traces, it only records the stages of
+    // the requests with the trace id assigned by the client.
+    mTraceRingSize = prop.getValue(
+        "chunkServer.trace.ringSize",
+        mTraceRingSize);
+    RequestTrace::SetParameters(mTraceRingSize, 0);
+    mTraceDumpFileName = prop.getValue(
+        "chunkServer.trace.dumpFileName",
+        mTraceDumpFileName);
+    mTraceDumpIntervalSecs = prop.getValue(
+        "chunkServer.trace.dumpIntervalSecs",
+        mTraceDumpIntervalSecs);
     mDiskIoRequestAffinityFlag = prop.getValue(
         "chunkServer.diskIoRequestAffinity",
         mDiskIoRequestAffinityFlag ? 1 : 0) != 0;
@@ -3783,6 +3918,7 @@ ChunkManager::TruncateChunk(kfsChunkId_t chunkId, int64_t chunkSize)
     }
     ChunkInfoHandle* const cih = *ci;
     string const chunkPathname = MakeChunkPathname(cih);
+    mBlockCache.Invalidate(chunkId);
 
     // Cnunk close will truncate it to the cih->chunkInfo.chunkSize
 
@@ -3965,6 +4101,9 @@ ChunkManager::ChangeChunkVers(
         ;
         die(os.str());
     }
+    if (0 <= chunkVersion) {
+        mBlockCache.Invalidate(cih->chunkInfo.chunkId);
+    }
     kfsChunkId_t const chunkId    = cih->chunkInfo.chunkId;
     const bool         renameFlag = true;
     const int          status     = cih->WriteChunkMetadata(
@@ -4304,24 +4443,33 @@ ChunkManager::AddMapping(ChunkManager::ChunkDirInfo& dir,
     ChunkInfoHandle* cih = GetChunkInfoHandle(
         chunkId, chunkVers, kAddObjectBlockMappingFlag);
     if (cih) {
-        string fileName;
-        string staleName;
-        string keepName;
+        string         fileName;
+        string         staleName;
+        string         keepName;
+        ChunkDirIndex* index;
+        kfsFileId_t    removeFileId;
+        kfsSeq_t       removeVersion;
         // Keep the chunk with the higher version.
         if (cih->chunkInfo.chunkVersion < chunkVers) {
-            fileName  = MakeChunkPathname(cih);
-            staleName = MakeStaleChunkPathname(cih);
-            keepName  = MakeChunkPathname(
+            fileName      = MakeChunkPathname(cih);
+            staleName     = MakeStaleChunkPathname(cih);
+            keepName      = MakeChunkPathname(
                 dir.dirname, fileId, chunkId, chunkVers, string());
+            index         = &cih->GetDirInfo().chunkDirIndex;
+            removeFileId  = cih->chunkInfo.fileId;
+            removeVersion = cih->chunkInfo.chunkVersion;
             RemoveFromChunkTable(*cih);
             Delete(*cih);
             cih = 0;
         } else {
-            fileName  = MakeChunkPathname(
+            fileName      = MakeChunkPathname(
                 dir.dirname, fileId, chunkId, chunkVers, string());
-            staleName = MakeChunkPathname(
+            staleName     = MakeChunkPathname(
                 dir.dirname, fileId, chunkId, chunkVers, mStaleChunksDir);
-            keepName  = MakeChunkPathname(cih);
+            keepName      = MakeChunkPathname(cih);
+            index         = &dir.chunkDirIndex;
+            removeFileId  = fileId;
+            removeVersion = chunkVers;
         }
         KFS_LOG_STREAM_INFO <<
             (mForceDeleteStaleChunksFlag ? "deleting" : "moving") <<
@@ -4337,6 +4485,8 @@ ChunkManager::AddMapping(ChunkManager::ChunkDirInfo& dir,
                     "failed to remove " << fileName <<
                     " error: " << QCUtils::SysError(err) <<
                 KFS_LOG_EOM;
+            } else {
+                index->Remove(removeFileId, chunkId, removeVersion);
             }
         } else {
             if (rename(fileName.c_str(), staleName.c_str())) {
@@ -4345,6 +4495,8 @@ ChunkManager::AddMapping(ChunkManager::ChunkDirInfo& dir,
                     "failed to rename " << fileName << " to " << staleName <<
                     " error: " << QCUtils::SysError(err) <<
                 KFS_LOG_EOM;
+            } else {
+                index->Remove(removeFileId, chunkId, removeVersion);
             }
         }
         if (cih) {
@@ -4557,6 +4709,7 @@ ChunkManager::ChunkSize(SizeOp* op)
         op->statusMsg = "no such chunk";
         return true;
     }
+    op->storageTier = cih->GetDirInfo().storageTier;
     if (cih->IsBeingReplicated()) {
         op->status    = -EAGAIN;
         op->statusMsg = "chunk replication in progress";
@@ -4611,6 +4764,18 @@ ChunkManager::GetDirName(chunkId_t chunkId, int64_t chunkVersion) const
     return cih->GetDirname();
 }
 
+kfsSTier_t
+ChunkManager::GetStorageTier(chunkId_t chunkId, int64_t chunkVersion) const
+{
+    const bool kAddObjectBlockMappingFlag = false;
+    ChunkInfoHandle* const cih = GetChunkInfoHandle(chunkId, chunkVersion,
+        kAddObjectBlockMappingFlag);
+    if (! cih) {
+        return kKfsSTierUndef;
+    }
+    return cih->GetDirInfo().storageTier;
+}
+
 int
 ChunkManager::ReadChunk(ReadOp* op)
 {
@@ -4628,13 +4793,6 @@ ChunkManager::ReadChunk(ReadOp* op)
         KFS_LOG_EOM;
         return -EBADVERS;
     }
-    DiskIo* const d = SetupDiskIo(cih, op);
-    if (! d) {
-        return -ESERVERBUSY;
-    }
-
-    op->diskIo.reset(d);
-
     // schedule a read based on the chunk size
     if (op->offset >= cih->chunkInfo.chunkSize) {
         op->numBytesIO = 0;
@@ -4653,6 +4811,41 @@ ChunkManager::ReadChunk(ReadOp* op)
 
     size_t numBytesIO = OffsetToChecksumBlockEnd(op->offset + op->numBytesIO - 1) - offset;
 
+    op->blockCacheHitFlag = false;
+    if (IsBlockCacheRead(*cih, *op)) {
+        IOBuffer         buf;
+        vector<uint32_t> checksums;
+        if (mBlockCache.Get(
+                cih->chunkInfo.chunkId,
+                cih->chunkInfo.chunkVersion,
+                (int)OffsetToChecksumBlockNum(offset),
+                (int)(numBytesIO / CHECKSUM_BLOCKSIZE),
+                buf,
+                checksums)) {
+            // The cached blocks are zero padded, and their checksums are
+            // verified, complete the read the same way as disk read does.
+            op->checksum.swap(checksums);
+            op->blockCacheHitFlag = true;
+            op->HandleEvent(EVENT_DISK_READ, &buf);
+            return 0;
+        }
+    }
+
+    DiskIo* const d = SetupDiskIo(cih, op);
+    if (! d) {
+        return -ESERVERBUSY;
+    }
+    // Replication and scrub reads, including replication write partial
+    // checksum block reads, yield to the client io.
+    d->SetIoPriority(
+        (op->backgroundIoFlag || op->scrubOp ||
+            (op->wop && op->wop->isFromReReplication)) ?
+        QCDiskQueue::kPriorityClassBackground :
+        QCDiskQueue::kPriorityClassHigh
+    );
+    d->SetTraceId(op->traceId);
+    op->diskIo.reset(d);
+
     // Make sure we don't try to read past EOF; the checksumming will
     // do the necessary zero-padding.
     if ((int64_t) (offset + numBytesIO) > cih->chunkInfo.chunkSize) {
@@ -4825,6 +5018,11 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
     if (! d) {
         return -ESERVERBUSY;
     }
+    d->SetIoPriority(op->isFromReReplication ?
+        QCDiskQueue::kPriorityClassBackground :
+        QCDiskQueue::kPriorityClassHigh
+    );
+    d->SetTraceId(op->traceId);
     op->diskIo.reset(d);
     op->diskIOTime = microseconds();
     int res = op->diskIo->Write(
@@ -4899,7 +5097,8 @@ ChunkManager::ReadChunkDone(ReadOp* op)
     bool staleRead = false;
     if (! cih ||
             op->chunkVersion != cih->chunkInfo.chunkVersion ||
-            (staleRead = ! cih->IsFileEquals(op->diskIo))) {
+            (staleRead = ! op->blockCacheHitFlag &&
+                ! cih->IsFileEquals(op->diskIo))) {
         op->dataBuf.Clear();
         if (cih) {
             KFS_LOG_STREAM_INFO <<
@@ -4915,6 +5114,11 @@ ChunkManager::ReadChunkDone(ReadOp* op)
         op->statusMsg = staleRead ? "stale read" : "version mismatch";
         return true;
     }
+    if (op->blockCacheHitFlag) {
+        // Checksums were set by the block cache lookup.
+        AdjustDataRead(op);
+        return true;
+    }
 
     op->diskIOTime = max(int64_t(1), microseconds() - op->diskIOTime);
     const int readLen = op->dataBuf.BytesConsumable();
@@ -5204,6 +5408,10 @@ ChunkManager::ReadChunkDone(ReadOp* op)
         // for checksums to verify, we did reads in multiples of
         // checksum block sizes.  so, get rid of the extra
         cih->ReadStats(op->status, readLen, op->diskIOTime);
+        if (! op->skipVerifyDiskChecksumFlag && ! op->backgroundIoFlag &&
+                IsBlockCacheRead(*cih, *op)) {
+            BlockCachePut(*cih, *op);
+        }
         AdjustDataRead(op);
         return true;
     }
@@ -5504,6 +5712,42 @@ ChunkManager::AdjustDataRead(ReadOp *op)
     op->dataBuf.Trim(op->numBytesIO);
 }
 
+inline bool
+ChunkManager::IsBlockCacheRead(
+    const ChunkInfoHandle& cih, const ReadOp& op) const
+{
+    // Buffered io directories have the os page cache. Replication, recovery,
+    // scrub, and read retries must go to the disk.
+    return (
+        mBlockCache.IsEnabled() &&
+        ! op.backgroundIoFlag &&
+        ! op.scrubOp &&
+        ! op.wop &&
+        op.retryCnt <= 0 &&
+        0 <= cih.chunkInfo.chunkVersion &&
+        cih.IsStable() &&
+        ! cih.GetDirInfo().bufferedIoFlag
+    );
+}
+
+void
+ChunkManager::BlockCachePut(const ChunkInfoHandle& cih, const ReadOp& op)
+{
+    if (DiskIo::GetBufferManager().IsLowOnBuffers()) {
+        return;
+    }
+    const int blockCount = (int)op.checksum.size();
+    IOBuffer  buf;
+    buf.Copy(&op.dataBuf, blockCount * (int)CHECKSUM_BLOCKSIZE);
+    const int firstBlock = (int)OffsetToChecksumBlockNum(op.offset);
+    for (int i = 0; i < blockCount && ! buf.IsEmpty(); i++) {
+        IOBuffer block;
+        block.Move(&buf, (int)CHECKSUM_BLOCKSIZE);
+        mBlockCache.Put(cih.chunkInfo.chunkId, cih.chunkInfo.chunkVersion,
+            firstBlock + i, block, op.checksum[i]);
+    }
+}
+
 uint32_t
 ChunkManager::GetChecksum(kfsChunkId_t chunkId, int64_t chunkVersion,
     int64_t offset)
@@ -5709,6 +5953,9 @@ ChunkManager::Restore()
                             "failed to rename " << src << " to " << dst <<
                             " error: " << QCUtils::SysError(err) <<
                         KFS_LOG_EOM;
+                    } else {
+                        it->chunkDirIndex.Remove(
+                            ci->mFileId, ci->mChunkId, ci->mChunkVersion);
                     }
                 } else {
                     const bool kStableFlag      = true;
@@ -5760,16 +6007,8 @@ AppendToHostedListSelf(
     kfsSeq_t                             chunkVersion,
     bool                                 noFidsFlag)
 {
-    (*list.first)++;
-    if (! noFidsFlag) {
-        (*list.second) <<
-            ' ' << chunkInfo.fileId
-        ;
-    }
-    (*list.second) <<
-        ' ' << chunkInfo.chunkId <<
-        ' ' << chunkVersion
-    ;
+    list.Append(
+        chunkInfo.fileId, chunkInfo.chunkId, chunkVersion, noFidsFlag);
 }
 
 inline void
@@ -5848,8 +6087,7 @@ ChunkManager::GetHostedChunksResume(
             if (! p) {
                 break;
             }
-            (*missing.first)++;
-            (*missing.second) << ' ' << *p;
+            missing.Append(*p);
         }
         for (mChunkTable.First(); ;) {
             const CMapEntry* const p = mChunkTable.Next();
@@ -5865,8 +6103,7 @@ ChunkManager::GetHostedChunksResume(
             if (! cih->IsBeingReplicated() &&
                     (! IsTargetChunkVersionStable(*cih, vers) || vers <= 0)) {
                 HelloNotifyRemove(*cih);
-                (*missing.first)++;
-                (*missing.second) << ' ' << chunkId;
+                missing.Append(chunkId);
             }
         }
         return;
@@ -5940,8 +6177,7 @@ ChunkManager::GetHostedChunksResume(
             ChunkInfoHandle** const cih = mChunkTable.Find(chunkId);
             if (! cih || (*cih)->IsBeingReplicated()) {
                 if (0 < pass) {
-                    (*missing.first)++;
-                    (*missing.second) << ' ' << chunkId;
+                    missing.Append(chunkId);
                 }
                 const kfsSeq_t* vers;
                 if (! mLastPendingInFlight.Find(chunkId) &&
@@ -5992,8 +6228,7 @@ ChunkManager::GetHostedChunksResume(
             }
             ChunkInfoHandle** const cih = mChunkTable.Find(chunkId);
             if (! cih || (*cih)->IsBeingReplicated()) {
-                (*missing.first)++;
-                (*missing.second) << ' ' << chunkId;
+                missing.Append(chunkId);
                 continue;
             }
             kfsSeq_t vers = -1;
@@ -6029,8 +6264,7 @@ ChunkManager::GetHostedChunksResume(
                 ChunkInfoHandle*    cih;
                 while ((cih = it.Next())) {
                     if (0 <= cih->chunkInfo.chunkVersion) {
-                        (*pendingStale.first)++;
-                        (*pendingStale.second) << ' ' << cih->chunkInfo.chunkId;
+                        pendingStale.Append(cih->chunkInfo.chunkId);
                     }
                 }
             }
@@ -6045,7 +6279,7 @@ ChunkManager::GetHostedChunksResume(
             " modified: "       << hello.resumeModified.size() <<
             " lastInflt: "      << mLastPendingInFlight.GetSize() <<
             " / "               << mCorruptChunkOp.chunkCount <<
-            " staleInFlt: "     << *pendingStale.first <<
+            " staleInFlt: "     << pendingStale.GetCount() <<
             " pending notify: " << pendingNotifyFlag <<
             " -> "              << hello.pendingNotifyFlag <<
         KFS_LOG_EOM;
@@ -6165,10 +6399,10 @@ ChunkManager::GetHostedChunksResume(
     }
     hello.resumeStep         = -1;
     hello.status             = 0;
-    *(stable.first)          = 0;
-    *(notStableAppend.first) = 0;
-    *(notStable.first)       = 0;
-    *(missing.first)         = 0;
+    stable.Clear();
+    notStableAppend.Clear();
+    notStable.Clear();
+    missing.Clear();
 }
 
 bool
@@ -6480,6 +6714,15 @@ ChunkManager::RunStaleChunksQueue(
                         cih->DetachStaleDeleteCompletionOp(),
                         mStaleChunkDeleteCompletionLists
                     );
+                if (cih->IsStable() && 0 <= cih->chunkInfo.chunkVersion &&
+                        cih->GetDirInfo().chunkDirIndex.IsOpen()) {
+                    cb.SetDirIndex(&cih->GetDirInfo().chunkDirIndex);
+                    cih->GetDirInfo().chunkDirIndex.Remove(
+                        cih->chunkInfo.fileId,
+                        cih->chunkInfo.chunkId,
+                        cih->chunkInfo.chunkVersion
+                    );
+                }
                 if (cih->IsKeep()) {
                     inFlightFlag = MarkChunkStale(cih, &cb) == 0;
                 } else {
@@ -6497,6 +6740,9 @@ ChunkManager::RunStaleChunksQueue(
                 if (inFlightFlag) {
                     mStaleChunkOpsInFlight++;
                 } else {
+                    if (cih->IsStable() && 0 <= cih->chunkInfo.chunkVersion) {
+                        cih->GetDirInfo().chunkDirIndex.Invalidate();
+                    }
                     StaleChunkDeleteCompletion::Release(
                         cb, mStaleChunkDeleteCompletionLists);
                 }
@@ -6588,6 +6834,25 @@ ChunkManager::Timeout()
             ! gMetaServerSM.IsUp()) {
         LogChunkServerCounters();
     }
+    if (0 < mScrubberBytesPerSec) {
+        RunScrubber();
+    }
+    if (0 < mBlockCache.GetByteCount() &&
+            DiskIo::GetBufferManager().IsLowOnBuffers()) {
+        // The cached blocks hold io buffers, give half of those back.
+        mBlockCache.Shrink(mBlockCache.GetByteCount() / 2);
+    }
+    if (0 < mTraceDumpIntervalSecs && ! mTraceDumpFileName.empty() &&
+            mNextTraceDumpTime <= now && RequestTrace::IsEnabled()) {
+        mNextTraceDumpTime = now + mTraceDumpIntervalSecs;
+        const int err = RequestTrace::Dump(mTraceDumpFileName.c_str());
+        if (err != 0) {
+            KFS_LOG_STREAM_ERROR <<
+                "request trace write failure: " << mTraceDumpFileName <<
+                ": " << QCUtils::SysError(-err) <<
+            KFS_LOG_EOM;
+        }
+    }
     gLeaseClerk.Timeout();
     gAtomicRecordAppendManager.Timeout();
 }
@@ -6893,6 +7158,9 @@ ChunkManager::StartDiskIo()
         if (! (it->diskQueue = DiskIo::FindDiskQueue(it->dirname.c_str()))) {
             die(it->dirname + ": failed to find disk queue");
         }
+        if (! mChunkDirIndexFileName.empty()) {
+            it->chunkDirIndex.Open(it->dirname, mChunkDirIndexFileName);
+        }
         it->startTime = globalNetManager().Now();
         it->startCount++;
         KFS_LOG_STREAM_INFO <<
@@ -7875,6 +8143,138 @@ ChunkManager::ChunkDirInfo::StopEvacuation()
     return true;
 }
 
+// The scrubber walks the directory chunk list in round robin order, by moving
+// each visited chunk to the list tail, and verifies stable chunks by issuing
+// get chunk meta data with read verify flag set. The chunk header is loaded,
+// and its checksum verified, if the chunk checksums are not already in memory,
+// then the chunk data is read at background priority, and verified against the
+// header block checksums. Checksum mismatch and io errors are handled by the
+// chunk read completion, which reports corrupted chunk to the meta server.
+// The scrub rate is limited by scheduling the next chunk scrub start no
+// earlier than the time required to read the previous chunk at the configured
+// bytes per second rate.
+void
+ChunkManager::ChunkDirInfo::Scrub(int64_t nowUsec)
+{
+    const int64_t bytesPerSec = gChunkManager.mScrubberBytesPerSec;
+    int           runCount    = gChunkManager.mScrubberMaxChunksPerRun;
+    while (! scrubInFlightFlag && 0 < availableSpace && diskQueue &&
+            0 < bytesPerSec && scrubNextTime <= nowUsec && 0 < runCount--) {
+        if (scrubPassRemainingCount <= 0) {
+            if (chunkCount <= 0) {
+                return;
+            }
+            scrubPassRemainingCount = chunkCount;
+            scrubPassChunkCount     = 0;
+            scrubPassByteCount      = 0;
+            scrubPassStartTime      = nowUsec;
+            gChunkManager.mCounters.mScrubPassRemainingCount +=
+                scrubPassRemainingCount;
+        }
+        ChunkInfoHandle* const cih =
+            ChunkDirList::PopFront(chunkLists[kChunkDirList]);
+        if (! cih) {
+            ScrubPassDone(nowUsec);
+            return;
+        }
+        ChunkDirList::PushBack(chunkLists[kChunkDirList], *cih);
+        scrubPassRemainingCount--;
+        gChunkManager.mCounters.mScrubPassRemainingCount--;
+        if (cih->chunkInfo.chunkVersion < 0 ||
+                cih->chunkInfo.chunkSize <= 0 ||
+                ! gChunkManager.IsChunkStable(cih)) {
+            gChunkManager.mCounters.mScrubSkipCount++;
+        } else {
+            GetChunkMetadataOp* const op = new GetChunkMetadataOp();
+            op->clnt           = &scrubCb;
+            op->chunkId        = cih->chunkInfo.chunkId;
+            op->chunkVersion   = cih->chunkInfo.chunkVersion;
+            op->readVerifyFlag = true;
+            scrubInFlightFlag  = true;
+            scrubStartTime     = nowUsec;
+            // Completion might be invoked synchronously.
+            op->Execute();
+        }
+        if (scrubPassRemainingCount <= 0) {
+            ScrubPassDone(nowUsec);
+        }
+    }
+}
+
+int
+ChunkManager::ChunkDirInfo::ScrubDone(int code, void* data)
+{
+    if (code != EVENT_CMD_DONE || ! data || ! scrubInFlightFlag) {
+        die("scrub: unexpected event or event data");
+        return -1;
+    }
+    GetChunkMetadataOp* const op = reinterpret_cast<GetChunkMetadataOp*>(data);
+    const int64_t             now = microseconds();
+    scrubInFlightFlag = false;
+    ChunkManager::Counters& counters = gChunkManager.mCounters;
+    counters.mScrubChunkCount++;
+    counters.mScrubByteCount += op->numBytesScrubbed;
+    counters.mScrubMicroSecs += max(int64_t(0), now - scrubStartTime);
+    scrubPassChunkCount++;
+    scrubPassByteCount += op->numBytesScrubbed;
+    if (op->status < 0) {
+        counters.mScrubErrorCount++;
+        if (op->status == -EBADCKSUM) {
+            counters.mScrubChecksumErrorCount++;
+        }
+        KFS_LOG_STREAM(op->status == -EBADF ?
+                MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelERROR) <<
+            "scrub: " << dirname <<
+            " chunk: "    << op->chunkId <<
+            " version: "  << op->chunkVersion <<
+            " scrubbed: " << op->numBytesScrubbed <<
+            " status: "   << op->status <<
+            " "           << op->statusMsg <<
+        KFS_LOG_EOM;
+    }
+    const int64_t bytesPerSec = gChunkManager.mScrubberBytesPerSec;
+    if (0 < bytesPerSec) {
+        // Account for the header read, and for the chunk meta data read
+        // failures, in order to avoid spinning on the failures.
+        const int64_t bytes = op->numBytesScrubbed + KFS_CHUNK_HEADER_SIZE;
+        scrubNextTime = max(scrubNextTime,
+            scrubStartTime + bytes * 1000 * 1000 / bytesPerSec);
+    }
+    delete op;
+    return 0;
+}
+
+void
+ChunkManager::ChunkDirInfo::ScrubPassDone(int64_t nowUsec)
+{
+    gChunkManager.mCounters.mScrubPassRemainingCount -=
+        scrubPassRemainingCount;
+    scrubPassRemainingCount = 0;
+    gChunkManager.mCounters.mScrubPassCount++;
+    const int64_t elapsed = max(int64_t(1), nowUsec - scrubPassStartTime);
+    KFS_LOG_STREAM_NOTICE <<
+        "scrub: " << dirname <<
+        " pass complete:"
+        " chunks: "  << scrubPassChunkCount <<
+        " bytes: "   << scrubPassByteCount <<
+        " seconds: " << elapsed / (1000 * 1000) <<
+        " bytes/sec: " <<
+            (double)scrubPassByteCount * 1e6 / (double)elapsed <<
+    KFS_LOG_EOM;
+    scrubNextTime = max(scrubNextTime, scrubPassStartTime +
+        int64_t(gChunkManager.mScrubberMinPassIntervalSecs) * 1000 * 1000);
+}
+
+void
+ChunkManager::RunScrubber()
+{
+    const int64_t now = microseconds();
+    for (ChunkDirs::iterator it = mChunkDirs.begin();
+            it < mChunkDirs.end(); ++it) {
+        it->Scrub(now);
+    }
+}
+
 void
 ChunkManager::MetaServerConnectionLost()
 {
@@ -7974,6 +8374,9 @@ ChunkManager::CheckChunkDirs()
                         it->dirname.c_str()))) {
                     die(it->dirname + ": failed to find disk queue");
                 }
+                if (! mChunkDirIndexFileName.empty()) {
+                    it->chunkDirIndex.Open(it->dirname, mChunkDirIndexFileName);
+                }
                 it->availableSpace              = 0;
                 it->fileSystemId                = dit->second.mFileSystemId;
                 it->deviceId                    = dit->second.mDeviceId;
@@ -33,6 +33,8 @@
 #include "KfsOps.h"
 #include "DiskIo.h"
 #include "DirChecker.h"
+#include "BlockCache.h"
+#include "AccessTokenCache.h"
 
 #include "kfsio/ITimeout.h"
 #include "kfsio/CryptoKeys.h"
@@ -95,6 +97,14 @@ public:
         Counter mHelloResumeCount;
         Counter mHelloResumeFailedCount;
         Counter mPartialHelloResumeFailedCount;
+        Counter mScrubChunkCount;
+        Counter mScrubByteCount;
+        Counter mScrubMicroSecs;
+        Counter mScrubSkipCount;
+        Counter mScrubErrorCount;
+        Counter mScrubChecksumErrorCount;
+        Counter mScrubPassCount;
+        Counter mScrubPassRemainingCount;
 
         void Clear()
         {
@@ -116,6 +126,14 @@ public:
             mHelloResumeCount                    = 0;
             mHelloResumeFailedCount              = 0;
             mPartialHelloResumeFailedCount       = 0;
+            mScrubChunkCount                     = 0;
+            mScrubByteCount                      = 0;
+            mScrubMicroSecs                      = 0;
+            mScrubSkipCount                      = 0;
+            mScrubErrorCount                     = 0;
+            mScrubChecksumErrorCount             = 0;
+            mScrubPassCount                      = 0;
+            mScrubPassRemainingCount             = 0;
         }
     };
 
@@ -225,6 +243,10 @@ public:
     /// is stored and pass that back to the client.
     string GetDirName(chunkId_t chunkId, int64_t chunkVersion) const;
 
+    /// Storage tier of the directory where the chunk is stored. Reported to
+    /// the meta server with chunk size and replication responses.
+    kfsSTier_t GetStorageTier(chunkId_t chunkId, int64_t chunkVersion) const;
+
     /// Schedule a read on a chunk.
     /// @param[in] op  The read operation being scheduled.
     /// @retval 0 if op was successfully scheduled; -1 otherwise
@@ -269,7 +291,61 @@ public:
 
     bool CanBeResumed(HelloMetaOp& hello);
     /// Retrieve the chunks hosted on this chunk server.
-    typedef pair<int64_t*, ostream*> HostedChunkList;
+    /// The list is either formatted as text into the stream, or, if the
+    /// entries vector is set, collected for subsequent sorting and binary
+    /// encoding.
+    class HostedChunkList
+    {
+    public:
+        typedef HelloMetaOp::ChunkIdVersions Entries;
+
+        HostedChunkList()
+            : mCount(0),
+              mStream(0),
+              mEntries(0)
+            {}
+        void Set(int64_t& count, ostream* stream, Entries* entries)
+        {
+            mCount   = &count;
+            mStream  = stream;
+            mEntries = entries;
+        }
+        void Append(kfsChunkId_t chunkId) const
+        {
+            (*mCount)++;
+            if (mEntries) {
+                mEntries->push_back(make_pair(chunkId, kfsSeq_t(-1)));
+            } else {
+                (*mStream) << ' ' << chunkId;
+            }
+        }
+        void Append(kfsFileId_t fileId, kfsChunkId_t chunkId,
+                kfsSeq_t chunkVersion, bool noFidsFlag) const
+        {
+            (*mCount)++;
+            if (mEntries) {
+                mEntries->push_back(make_pair(chunkId, chunkVersion));
+                return;
+            }
+            if (! noFidsFlag) {
+                (*mStream) << ' ' << fileId;
+            }
+            (*mStream) << ' ' << chunkId << ' ' << chunkVersion;
+        }
+        int64_t GetCount() const
+            { return *mCount; }
+        void Clear() const
+        {
+            *mCount = 0;
+            if (mEntries) {
+                mEntries->clear();
+            }
+        }
+    private:
+        int64_t* mCount;
+        ostream* mStream;
+        Entries* mEntries;
+    };
     void GetHostedChunksResume(
         HelloMetaOp&                         hello,
         const ChunkManager::HostedChunkList& stable,
@@ -369,6 +445,11 @@ public:
 
     void GetCounters(Counters& counters)
         { counters = mCounters; }
+    void GetBlockCacheCounters(BlockCache::Counters& counters) const
+        { mBlockCache.GetCounters(counters); }
+    void GetAccessTokenCacheCounters(
+            AccessTokenCache::Counters& counters) const
+        { mAccessTokenCache.GetCounters(counters); }
 
     /// Utility function that sets up a disk connection for an
     /// I/O operation on a chunk.
@@ -444,6 +525,8 @@ public:
         kfsChunkId_t chunkId, int64_t chunkVersion);
     const CryptoKeys& GetCryptoKeys() const
         { return mCryptoKeys; }
+    AccessTokenCache& GetAccessTokenCache()
+        { return mAccessTokenCache; }
     int64_t GetFileSystemId() const
         { return mFileSystemId; }
     bool SetFileSystemId(int64_t fileSystemId, bool deleteAllChunksFlag);
@@ -946,6 +1029,7 @@ private:
     string     mEvacuateFileName;
     string     mEvacuateDoneFileName;
     string     mChunkDirLockName;
+    string     mChunkDirIndexFileName;
     int        mEvacuationInactivityTimeout;
     time_t     mMetaHeartbeatTime;
     int64_t    mMetaEvacuateCount;
@@ -972,9 +1056,21 @@ private:
     bool       mVersionChangePermitWritesInFlightFlag;
     int64_t    mMinChunkCountForHelloResume;
     string     mHelloResumeFailureTraceFileName;
+    int64_t    mScrubberBytesPerSec;
+    int        mScrubberMinPassIntervalSecs;
+    int        mScrubberMaxChunksPerRun;
+    int64_t    mBlockCacheMaxBytes;
+    double     mBlockCacheInRatio;
+    int        mAccessTokenCacheMaxEntries;
+    int        mTraceRingSize;
+    string     mTraceDumpFileName;
+    int        mTraceDumpIntervalSecs;
+    time_t     mNextTraceDumpTime;
 
     PendingNotifyLostChunks mPendingNotifyLostChunks;
     CorruptChunkOp          mCorruptChunkOp;
+    BlockCache              mBlockCache;
+    AccessTokenCache        mAccessTokenCache;
 
     typedef LinearHashSet<
         kfsChunkId_t,
@@ -1039,6 +1135,9 @@ private:
 
     void CheckChunkDirs();
     void GetFsSpaceAvailable();
+    /// Start background scrub of the next stable chunk in each chunk
+    /// directory that is within its scrub bytes per second budget.
+    void RunScrubber();
 
     string MakeChunkPathname(const string& chunkdir, kfsFileId_t fid,
         kfsChunkId_t chunkId, kfsSeq_t chunkVersion, const string& subDir);
@@ -1056,6 +1155,14 @@ private:
     /// adjust appropriately.
     void AdjustDataRead(ReadOp *op);
 
+    /// Returns true if the read can be served from, and its verified data
+    /// blocks inserted into the block cache.
+    inline bool IsBlockCacheRead(
+        const ChunkInfoHandle& cih, const ReadOp& op) const;
+    /// Insert checksum verified checksum block aligned read buffer blocks
+    /// into the block cache.
+    void BlockCachePut(const ChunkInfoHandle& cih, const ReadOp& op);
+
     /// Pad the buffer with sufficient 0's so that checksumming works
     /// out.
     /// @param[in/out] buffer  The buffer to be padded with 0's
@@ -1127,7 +1234,7 @@ private:
     inline void HelloNotifyRemove(ChunkInfoHandle& cih);
     inline bool IsPendingHelloNotify(const ChunkInfoHandle& cih) const;
     template<typename T> void ClearTable(T& table);
-    template<typename T> void RunIoCompletion(T& table);
+    template<typename T> bool RunIoCompletion(T& table);
     friend class ChunkServerGlobals;
 private:
     // No copy.
@@ -35,6 +35,8 @@
 #include "common/MsgLogger.h"
 #include "kfsio/Globals.h"
 #include "qcdio/qcstutils.h"
+#include "qcdio/QCNuma.h"
+#include "qcdio/QCUtils.h"
 
 namespace KFS {
 
@@ -47,7 +49,8 @@ ChunkServer::Init(
     bool                  ipV6OnlyFlag,
     const string&         serverIp,
     int                   threadCount,
-    int                   firstCpuIdx)
+    int                   firstCpuIdx,
+    bool                  numaFlag)
 {
     if (clientListener.port < 0) {
         KFS_LOG_STREAM_FATAL <<
@@ -86,7 +89,8 @@ ChunkServer::Init(
                 ipV6OnlyFlag,
                 threadCount,
                 firstCpuIdx,
-                mMutex) ||
+                mMutex,
+                numaFlag) ||
             gClientManager.GetPort() <= 0) {
         KFS_LOG_STREAM_FATAL <<
             "failed to bind acceptor to: " << clientListener <<
@@ -154,6 +158,18 @@ ChunkServer::MainLoop(
         gClientManager.Shutdown();
         return false;
     }
+    const int networkNode = gClientManager.GetNumaNetworkNode();
+    if (0 <= networkNode) {
+        // Run the network thread on the client network interface node.
+        const int err = QCThread::SetCurrentThreadAffinity(
+            QCNuma::GetNodeCpus(networkNode));
+        if (err) {
+            KFS_LOG_STREAM_ERROR <<
+                "failed to set network thread numa node: " << networkNode <<
+                " " << QCUtils::SysError(err) <<
+            KFS_LOG_EOM;
+        }
+    }
     {
         ClientThreadVerifier verifier(mMutex);
         QCStMutexUnlocker    unlocker(mMutex);
@@ -38,12 +38,14 @@
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcdebug.h"
 #include "qcdio/qcstutils.h"
+#include "qcdio/QCNuma.h"
 
 #include <algorithm>
 
 namespace KFS
 {
 using std::max;
+using std::make_pair;
 
 using libkfsio::globalNetManager;
 
@@ -185,7 +187,11 @@ ClientManager::ClientManager()
       mCurThreadIdx(0),
       mFirstClientThreadIndex(0),
       mThreadCount(0),
-      mThreadsPtr(0)
+      mThreadsPtr(0),
+      mNumaNodeCount(0),
+      mNumaNetworkNode(-1),
+      mNumaAcceptCounts(),
+      mNumaAddressNodes()
 {
     mCounters.Clear();
 }
@@ -204,14 +210,19 @@ ClientManager::BindAcceptor(
     bool                  ipV6OnlyFlag,
     int                   inThreadCount,
     int                   inFirstCpuIdx,
-    QCMutex*&             outMutexPtr)
+    QCMutex*&             outMutexPtr,
+    bool                  inNumaFlag)
 {
     Stop();
     delete mAcceptorPtr;
     delete [] mThreadsPtr;
-    mAcceptorPtr = 0;
-    mThreadsPtr  = 0;
-    mThreadCount = 0;
+    mAcceptorPtr     = 0;
+    mThreadsPtr      = 0;
+    mThreadCount     = 0;
+    mNumaNodeCount   = 0;
+    mNumaNetworkNode = -1;
+    mNumaAcceptCounts.clear();
+    mNumaAddressNodes.clear();
     const bool kBindOnlyFlag = true;
     mAcceptorPtr = new Acceptor(
         globalNetManager(), clientListener, ipV6OnlyFlag, this, kBindOnlyFlag);
@@ -219,8 +230,28 @@ ClientManager::BindAcceptor(
     if (theOkFlag && 0 < inThreadCount) {
         static QCMutex sOpsMutex;
         KfsOp::SetMutex(&sOpsMutex);
+        vector<int> theNodes;
+        if (inNumaFlag && inFirstCpuIdx < 0 && 1 < QCNuma::GetNodeCount()) {
+            // If bound to a specific address, run all client threads on the
+            // interface node, otherwise spread the threads evenly, and route
+            // connections by the accepting interface node.
+            mNumaNodeCount   = QCNuma::GetNodeCount();
+            mNumaNetworkNode = QCNuma::GetAddressNode(
+                clientListener.hostname.c_str());
+            mNumaAcceptCounts.assign(mNumaNodeCount, int64_t(0));
+            theNodes.reserve(inThreadCount);
+            for (int i = 0; i < inThreadCount; i++) {
+                theNodes.push_back(0 <= mNumaNetworkNode ?
+                    mNumaNetworkNode : i % mNumaNodeCount);
+            }
+            KFS_LOG_STREAM_INFO <<
+                "numa nodes: "    << mNumaNodeCount <<
+                " network node: " << mNumaNetworkNode <<
+            KFS_LOG_EOM;
+        }
         mThreadsPtr  = ClientThread::CreateThreads(
-            inThreadCount, inFirstCpuIdx, outMutexPtr);
+            inThreadCount, inFirstCpuIdx, outMutexPtr,
+            theNodes.empty() ? 0 : &theNodes[0]);
         mThreadCount = mThreadsPtr ? inThreadCount : 0;
     } else {
         outMutexPtr = 0;
@@ -263,7 +294,11 @@ ClientManager::CreateKfsCallbackObj(
     }
     mCounters.mAcceptCount++;
     mCounters.mClientCount++;
-    ClientThread* const theThreadPtr = GetNextClientThreadPtr();
+    const int theNumaNode = GetNumaNode(*inConnPtr);
+    if (0 <= theNumaNode) {
+        mNumaAcceptCounts[theNumaNode]++;
+    }
+    ClientThread* const theThreadPtr = GetNextClientThreadPtr(theNumaNode);
     ClientSM*     const theClientPtr = new ClientSM(inConnPtr, theThreadPtr);
     if (! mAuth.Setup(*inConnPtr, *theClientPtr)) {
         delete theClientPtr;
@@ -342,13 +377,77 @@ ClientManager::GetCurrentClientThreadPtr()
     );
 }
 
+    int
+ClientManager::GetNumaNode(
+    const NetConnection& inConn)
+{
+    if (mNumaNodeCount <= 0) {
+        return -1;
+    }
+    if (0 <= mNumaNetworkNode) {
+        return mNumaNetworkNode;
+    }
+    ServerLocation theLocation;
+    if (inConn.GetSockLocation(theLocation) != 0) {
+        return -1;
+    }
+    // The number of local addresses is small, cache the address to node
+    // mapping, to avoid interface list lookup on every accept.
+    NumaAddressNodes::iterator theIt =
+        mNumaAddressNodes.find(theLocation.hostname);
+    if (theIt == mNumaAddressNodes.end()) {
+        int theNode = QCNuma::GetAddressNode(theLocation.hostname.c_str());
+        if (mNumaNodeCount <= theNode) {
+            theNode = -1;
+        }
+        theIt = mNumaAddressNodes.insert(
+            make_pair(theLocation.hostname, theNode)).first;
+    }
+    return theIt->second;
+}
+
+    bool
+ClientManager::GetNumaNodeCounters(
+    int                             inNode,
+    ClientManager::NumaNodeCounters& outCounters) const
+{
+    outCounters.mThreadCount = 0;
+    outCounters.mAcceptCount = 0;
+    if (inNode < 0 || mNumaNodeCount <= inNode) {
+        return false;
+    }
+    outCounters.mAcceptCount = mNumaAcceptCounts[inNode];
+    for (int i = 0; i < mThreadCount; i++) {
+        if (mThreadsPtr[i].GetNumaNode() == inNode) {
+            outCounters.mThreadCount++;
+        }
+    }
+    return true;
+}
+
     ClientThread*
-ClientManager::GetNextClientThreadPtr()
+ClientManager::GetNextClientThreadPtr(
+    int inNumaNode)
 {
     if (mThreadCount <= 0 || mThreadCount <= mFirstClientThreadIndex) {
         return 0;
     }
     QCASSERT(0 <= mCurThreadIdx && mCurThreadIdx < mThreadCount);
+    if (0 <= inNumaNode) {
+        // Round robin between the threads running on the node, if any.
+        const int theStartIdx = max(mFirstClientThreadIndex, 0);
+        int       theIdx      = mCurThreadIdx;
+        for (int i = theStartIdx; i < mThreadCount; i++) {
+            ClientThread* const thePtr = mThreadsPtr + theIdx;
+            if (mThreadCount <= ++theIdx) {
+                theIdx = theStartIdx;
+            }
+            if (thePtr->GetNumaNode() == inNumaNode) {
+                mCurThreadIdx = theIdx;
+                return thePtr;
+            }
+        }
+    }
     ClientThread* const theRetPtr = mThreadsPtr + mCurThreadIdx;
     mCurThreadIdx++;
     if (mThreadCount <= mCurThreadIdx) {
@@ -32,10 +32,17 @@
 #include "kfsio/Acceptor.h"
 #include "KfsOps.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 class QCMutex;
 
 namespace KFS
 {
+using std::map;
+using std::string;
+using std::vector;
 
 class Properties;
 class ClientSM;
@@ -101,12 +108,20 @@ public:
             mOverClientLimitCount       = 0;
         }
     };
+    struct NumaNodeCounters
+    {
+        typedef int64_t Counter;
+
+        Counter mThreadCount;
+        Counter mAcceptCount;
+    };
     bool BindAcceptor(
         const ServerLocation& clientListener,
         bool                  ipV6OnlyFlag,
         int                   inThreadCount,
         int                   inFirstCpuIdx,
-        QCMutex*&             outMutexPtr);
+        QCMutex*&             outMutexPtr,
+        bool                  inNumaFlag = false);
     bool StartListening();
     virtual KfsCallbackObj* CreateKfsCallbackObj(
         NetConnectionPtr& inConnPtr);
@@ -205,7 +220,8 @@ public:
         { return mThreadCount; }
     const QCMutex* GetMutexPtr() const;
     ClientThread* GetCurrentClientThreadPtr();
-    ClientThread* GetNextClientThreadPtr();
+    ClientThread* GetNextClientThreadPtr(
+        int inNumaNode = -1);
     ClientThread* GetClientThread(
         int inIdx);
     bool IsAuthEnabled() const;
@@ -217,8 +233,19 @@ public:
     void Shutdown();
     int GetMaxClientCount() const
         { return mMaxClientCount; }
+    // Returns 0 if NUMA placement is not enabled.
+    int GetNumaNodeCount() const
+        { return mNumaNodeCount; }
+    // Returns node of the network interface the client listener is bound to,
+    // or -1 if listening on all interfaces, or the node is not known.
+    int GetNumaNetworkNode() const
+        { return mNumaNetworkNode; }
+    bool GetNumaNodeCounters(
+        int               inNode,
+        NumaNodeCounters& outCounters) const;
 private:
     class Auth;
+    typedef map<string, int> NumaAddressNodes;
 
     Acceptor*     mAcceptorPtr;
     int           mIoTimeoutSec;
@@ -230,6 +257,13 @@ private:
     int           mFirstClientThreadIndex;
     int           mThreadCount;
     ClientThread* mThreadsPtr;
+    int           mNumaNodeCount;
+    int           mNumaNetworkNode;
+    vector<int64_t>  mNumaAcceptCounts;
+    NumaAddressNodes mNumaAddressNodes;
+
+    int GetNumaNode(
+        const NetConnection& inConn);
 
     ClientManager();
     ~ClientManager();
@@ -36,8 +36,10 @@
 
 #include "common/MsgLogger.h"
 #include "common/time.h"
+#include "common/RequestTrace.h"
 #include "kfsio/Globals.h"
 #include "kfsio/ChunkAccessToken.h"
+#include "kfsio/checksum.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcdebug.h"
 
@@ -72,8 +74,10 @@ using std::list;
 int      ClientSM::sMaxCmdHeaderReadAhead    = 1 << 10;
 bool     ClientSM::sTraceRequestResponseFlag = false;
 bool     ClientSM::sEnforceMaxWaitFlag       = true;
+bool     ClientSM::sBinaryRpcFlag            = false;
 int      ClientSM::sMaxReqSizeDiscard        = 256 << 10;
 size_t   ClientSM::sMaxAppendRequestSize     = CHUNKSIZE;
+int      ClientSM::sCutThroughMinWriteSize   = -1;
 uint64_t ClientSM::sInstanceNum              = 10000;
 
 inline time_t
@@ -168,6 +172,9 @@ ClientSM::SetParameters(const Properties& prop)
     sEnforceMaxWaitFlag = prop.getValue(
         "chunkServer.clientSM.enforceMaxWait",
         sEnforceMaxWaitFlag ? 1 : 0) != 0;
+    sBinaryRpcFlag = prop.getValue(
+        "chunkServer.clientSM.binaryRpc",
+        sBinaryRpcFlag ? 1 : 0) != 0;
     sMaxReqSizeDiscard = prop.getValue(
         "chunkServer.clientSM.maxReqSizeDiscard",
         sMaxReqSizeDiscard);
@@ -177,6 +184,9 @@ ClientSM::SetParameters(const Properties& prop)
     sMaxCmdHeaderReadAhead = prop.getValue(
         "chunkServer.clientSM.maxCmdHeaderReadAhead",
         sMaxCmdHeaderReadAhead);
+    sCutThroughMinWriteSize = prop.getValue(
+        "chunkServer.clientSM.cutThroughMinWriteSize",
+        sCutThroughMinWriteSize);
 }
 
 ClientSM::ClientSM(
@@ -208,7 +218,9 @@ ClientSM::ClientSM(
       mContentReceivedFlag(false),
       mDelegationToken(),
       mSessionKey(),
-      mHandleTerminateFlag(false)
+      mHandleTerminateFlag(false),
+      mCutThroughPeer(),
+      mCutThroughChecksumByteCount(0)
 {
     if (! mNetConnection) {
         die("ClientSM: null connection");
@@ -243,6 +255,7 @@ ClientSM::~ClientSM()
         die("~ClientSM: ops queue(s) are not empty");
         return;
     }
+    CutThroughAbort();
     delete mCurOp;
     mCurOp = 0;
     mDevBufMgrClients.First();
@@ -494,6 +507,7 @@ ClientSM::HandleRequest(int code, void* data)
                 PutAndResetDevBufferManager(*mCurOp, GetWaitingForByteCount());
                 CancelRequest();
             }
+            CutThroughAbort();
             delete mCurOp;
             mCurOp = 0;
         }
@@ -742,7 +756,11 @@ ClientSM::GetWriteOp(KfsOp& op, int align, int numBytes,
     }
     if (nAvail < numBytes) {
         mNetConnection->SetMaxReadAhead(numBytes - nAvail);
-        SetReceiveContent(numBytes, op.op == CMD_WRITE_PREPARE);
+        const bool cutThroughFlag = op.op == CMD_WRITE_PREPARE &&
+            CutThroughForward(static_cast<WritePrepareOp&>(op), iobuf, nAvail);
+        SetReceiveContent(numBytes,
+            op.op == CMD_WRITE_PREPARE && ! cutThroughFlag,
+            CHECKSUM_BLOCKSIZE, cutThroughFlag);
         // we couldn't process the command...so, wait
         return false;
     }
@@ -761,6 +779,77 @@ ClientSM::GetWriteOp(KfsOp& op, int align, int numBytes,
     return true;
 }
 
+///
+/// Forward write prepare data received so far to the next server in the
+/// synchronous replication chain, and compute checksums of the complete
+/// checksum blocks received so far. The peer validates the data checksum
+/// independently, and reports failure back up the chain with the response.
+///
+bool
+ClientSM::CutThroughForward(WritePrepareOp& op, const IOBuffer& buf,
+    int numBytes)
+{
+    if (! mCutThroughPeer) {
+        if (op.writeFwdOp || sCutThroughMinWriteSize < 0 ||
+                op.numBytes < (size_t)sCutThroughMinWriteSize) {
+            return false;
+        }
+        op.clientSMFlag = true;
+        op.clnt         = this;
+        if (! op.StartCutThroughForward(mCutThroughPeer)) {
+            return false;
+        }
+        mCutThroughChecksumByteCount = 0;
+        op.receivedChecksum = 0;
+        op.blocksChecksums.clear();
+    }
+    if (IsClientThread()) {
+        // The client thread computes the checksums of the blocks received so
+        // far before acquiring the global mutex.
+        const vector<uint32_t>& checksums = GetBlockChecksums();
+        if (op.blocksChecksums.size() < checksums.size()) {
+            op.blocksChecksums.insert(op.blocksChecksums.end(),
+                checksums.begin() + op.blocksChecksums.size(),
+                checksums.end());
+            op.receivedChecksum = GetChecksum();
+        }
+        mCutThroughPeer->CutThroughWrite(*op.writeFwdOp, buf, numBytes);
+        return true;
+    }
+    const int size = (int)op.numBytes;
+    while (mCutThroughChecksumByteCount < size) {
+        const int len = min(size - mCutThroughChecksumByteCount,
+            (int)CHECKSUM_BLOCKSIZE);
+        if (numBytes < mCutThroughChecksumByteCount + len) {
+            break;
+        }
+        const uint32_t cksum = ComputeBlockChecksumAt(
+            &buf, mCutThroughChecksumByteCount, len);
+        op.receivedChecksum = op.blocksChecksums.empty() ? cksum :
+            ChecksumBlocksCombine(op.receivedChecksum, cksum, len);
+        op.blocksChecksums.push_back(cksum);
+        mCutThroughChecksumByteCount += len;
+    }
+    mCutThroughPeer->CutThroughWrite(*op.writeFwdOp, buf, numBytes);
+    return true;
+}
+
+void
+ClientSM::CutThroughAbort()
+{
+    if (! mCutThroughPeer) {
+        return;
+    }
+    RemoteSyncSMPtr peer;
+    peer.swap(mCutThroughPeer);
+    if (mCurOp && mCurOp->op == CMD_WRITE_PREPARE) {
+        WritePrepareOp& op = *static_cast<WritePrepareOp*>(mCurOp);
+        if (op.writeFwdOp) {
+            peer->CutThroughAbort(*op.writeFwdOp);
+        }
+    }
+}
+
 bool
 ClientSM::FailIfExceedsWait(
     BufferManager&         bufMgr,
@@ -844,6 +933,9 @@ ClientSM::HandleClientCmd(IOBuffer& iobuf, int inCmdLen)
             // got a bogus command
             return false;
         }
+        if (! sBinaryRpcFlag) {
+            op->binaryRpcFlag = false;
+        }
         CLIENT_SM_LOG_STREAM_DEBUG <<
             "+req: " << op->Show() <<
         KFS_LOG_EOM;
@@ -932,7 +1024,10 @@ ClientSM::HandleClientCmd(IOBuffer& iobuf, int inCmdLen)
             return false;
         }
         bufferBytes = 0 <= op->status ? IoRequestBytes(wop->numBytes) : 0;
-        if (GetReceiveByteCount() == (int)wop->numBytes) {
+        if (mCutThroughPeer) {
+            CutThroughForward(*wop, wop->dataBuf, (int)wop->numBytes);
+            mCutThroughPeer.reset();
+        } else if (GetReceiveByteCount() == (int)wop->numBytes) {
             wop->receivedChecksum = GetChecksum();
             wop->blocksChecksums.swap(GetBlockChecksums());
         }
@@ -1203,6 +1298,12 @@ ClientSM::GrantedSelf(ClientSM::ByteCount byteCount, bool devBufManagerFlag)
         " dev. mgr: " << (const void*)mDevBufMgr <<
     KFS_LOG_EOM;
     assert(devBufManagerFlag == (mDevBufMgr != 0));
+    if (mCurOp && mCurOp->traceId != 0) {
+        // The wait starts when the request header is parsed.
+        RequestTrace::Record(mCurOp->traceId,
+            devBufManagerFlag ? "device buffer wait" : "buffer wait",
+            mCurOp->startTime, microseconds() - mCurOp->startTime);
+    }
     if (IsClientThread()) {
         DispatchGranted(*this);
     } else {
@@ -1228,14 +1329,36 @@ ClientSM::GetPsk(
     string&        outAuthName)
 {
     outAuthName.clear();
+    const int         theIdentityLen = (int)strlen(inIdentityPtr);
+    const int         theMaxKeyLen   = (int)min(inPskBufferLen, 0x7FFFFu);
+    const int64_t     theNow         = (int64_t)TimeNow();
+    const CryptoKeys& theKeys        = gChunkManager.GetCryptoKeys();
+    AccessTokenCache& theCache       = gChunkManager.GetAccessTokenCache();
+    if (theCache.Get(
+            inIdentityPtr,
+            theIdentityLen,
+            -1, // chunk id
+            -1, // subject id
+            theNow,
+            theKeys,
+            mDelegationToken,
+            &mSessionKey) &&
+            (int)mSessionKey.size() <= theMaxKeyLen) {
+        CLIENT_SM_LOG_STREAM_DEBUG <<
+            "authentication succeeded:" <<
+            " cached delegation: " << mDelegationToken.Show() <<
+        KFS_LOG_EOM;
+        memcpy(inPskBufferPtr, mSessionKey.data(), mSessionKey.size());
+        return (unsigned long)mSessionKey.size();
+    }
     string theErrMsg;
     const int theKeyLen = mDelegationToken.Process(
         inIdentityPtr,
-        strlen(inIdentityPtr),
-        (int64_t)TimeNow(),
-        gChunkManager.GetCryptoKeys(),
+        theIdentityLen,
+        theNow,
+        theKeys,
         reinterpret_cast<char*>(inPskBufferPtr),
-        (int)min(inPskBufferLen, 0x7FFFFu),
+        theMaxKeyLen,
         &theErrMsg
     );
     if (theKeyLen > 0) {
@@ -1245,6 +1368,16 @@ ClientSM::GetPsk(
         KFS_LOG_EOM;
         mSessionKey.assign(
             reinterpret_cast<const char*>(inPskBufferPtr), theKeyLen);
+        theCache.Put(
+            inIdentityPtr,
+            theIdentityLen,
+            -1, // chunk id
+            -1, // subject id
+            mDelegationToken,
+            theKeys,
+            mSessionKey.data(),
+            theKeyLen
+        );
         return theKeyLen;
     }
     CLIENT_SM_LOG_STREAM_ERROR <<
@@ -81,11 +81,13 @@ protected:
           mChecksum(0),
           mFirstChecksumBlockLen(CHECKSUM_BLOCKSIZE),
           mReceiveByteCount(-1),
+          mChecksumByteCount(0),
           mReceivedHeaderLen(0),
           mRpcFormat(kRpcFormatUndef),
           mGrantedFlag(false),
           mReceiveOpFlag(false),
-          mComputeChecksumFlag(false)
+          mComputeChecksumFlag(false),
+          mReceivePartialFlag(false)
         { DispatchQueue::Init(*this); }
     ~ClientThreadListEntry();
     void ReceiveClear()
@@ -95,9 +97,11 @@ protected:
         }
         mFirstChecksumBlockLen = CHECKSUM_BLOCKSIZE;
         mReceiveByteCount      = -1;
+        mChecksumByteCount     = 0;
         mReceivedHeaderLen     = 0;
         mReceiveOpFlag         = false;
         mComputeChecksumFlag   = false;
+        mReceivePartialFlag    = false;
         mReceivedOpPtr         = 0;
         mChecksum              = 0;
         mBlocksChecksums.clear();
@@ -110,10 +114,15 @@ protected:
         ReceiveClear();
         mReceiveOpFlag = true;
     }
+    // With partial flag set the client is notified as soon as any data
+    // arrives, instead of waiting for the specified length, and the
+    // checksums of the complete blocks received so far are computed before
+    // the notification.
     void SetReceiveContent(
         int     inLength,
         bool    inComputeChecksumFlag,
-        int32_t inFirstCheckSumBlockLen = CHECKSUM_BLOCKSIZE)
+        int32_t inFirstCheckSumBlockLen = CHECKSUM_BLOCKSIZE,
+        bool    inPartialFlag           = false)
     {
         if (! mClientThreadPtr) {
             return;
@@ -123,6 +132,7 @@ protected:
         mFirstChecksumBlockLen = inFirstCheckSumBlockLen;
         mComputeChecksumFlag   =
             0 <= mReceiveByteCount && inComputeChecksumFlag;
+        mReceivePartialFlag    = 0 <= mReceiveByteCount && inPartialFlag;
     }
     RpcFormat& GetRpcFormat()
         { return mRpcFormat; }
@@ -153,11 +163,13 @@ private:
     uint32_t               mChecksum;
     uint32_t               mFirstChecksumBlockLen;
     int                    mReceiveByteCount;
+    int                    mChecksumByteCount;
     int                    mReceivedHeaderLen;
     RpcFormat              mRpcFormat;
     bool                   mGrantedFlag:1;
     bool                   mReceiveOpFlag:1;
     bool                   mComputeChecksumFlag:1;
+    bool                   mReceivePartialFlag:1;
     ClientThreadListEntry* mPrevPtr[kDispatchQueueCount];
     ClientThreadListEntry* mNextPtr[kDispatchQueueCount];
 
@@ -386,13 +398,19 @@ private:
     DelegationToken            mDelegationToken;
     string                     mSessionKey;
     bool                       mHandleTerminateFlag;
+    /// Next server in the chain that the current write prepare data is
+    /// forwarded to as it arrives.
+    RemoteSyncSMPtr            mCutThroughPeer;
+    int                        mCutThroughChecksumByteCount;
 
     static int                 sMaxCmdHeaderReadAhead;
     static bool                sTraceRequestResponseFlag;
     static bool                sEnforceMaxWaitFlag;
+    static bool                sBinaryRpcFlag;
     static bool                sSslPskEnabledFlag;
     static int                 sMaxReqSizeDiscard;
     static size_t              sMaxAppendRequestSize;
+    static int                 sCutThroughMinWriteSize;
     static uint64_t            sInstanceNum;
 
     int HandleRequest(int code, void *data);
@@ -414,6 +432,9 @@ private:
     bool Discard(IOBuffer& iobuf);
     bool GetWriteOp(KfsOp& op, int align, int numBytes, IOBuffer& iobuf,
         IOBuffer& ioOpBuf, bool forwardFlag);
+    bool CutThroughForward(WritePrepareOp& op, const IOBuffer& buf,
+        int numBytes);
+    void CutThroughAbort();
     string GetPeerName();
     int HandleRequestSelf(int code, void* data);
     int HandleGranted();
@@ -31,6 +31,7 @@
 #include "common/kfsatomic.h"
 
 #include "qcdio/QCThread.h"
+#include "qcdio/QCNuma.h"
 #include "qcdio/QCMutex.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcstutils.h"
@@ -227,7 +228,7 @@ public:
     bool IsStarted() const
         { return mThread.IsStarted(); }
     void Start(
-        int inCpuIndex)
+        QCThread::CpuAffinity inCpuAffinity)
     {
         QCASSERT(GetMutex().IsOwned());
         if (! IsStarted()) {
@@ -238,9 +239,7 @@ public:
                 this,
                 kStackSize,
                 "ClientThread",
-                inCpuIndex < 0 ?
-                    QCThread::CpuAffinity::None() :
-                    QCThread::CpuAffinity(inCpuIndex)
+                inCpuAffinity
             );
         }
     }
@@ -404,10 +403,14 @@ public:
                     theEntry.ReceiveClear();
                 }
             } else if (0 <= theEntry.mReceiveByteCount) {
-                if (theBuf.BytesConsumable() < theEntry.mReceiveByteCount) {
+                if (theEntry.mReceivePartialFlag) {
+                    // Compute cut-through checksums without holding the
+                    // mutex.
+                    AppendPartialChecksums(theEntry, theBuf);
+                } else if (theBuf.BytesConsumable() <
+                        theEntry.mReceiveByteCount) {
                     return 0;
-                }
-                if (theEntry.mComputeChecksumFlag) {
+                } else if (theEntry.mComputeChecksumFlag) {
                     theEntry.mBlocksChecksums.clear();
                     AppendToChecksumVector(
                         theBuf,
@@ -433,6 +436,28 @@ public:
         }
         return theRet;
     }
+    static void AppendPartialChecksums(
+        ClientThreadListEntry& inEntry,
+        const IOBuffer&        inBuf)
+    {
+        const int theSize  = inEntry.mReceiveByteCount;
+        const int theAvail = (int)min(inBuf.BytesConsumable(),
+            (IOBuffer::BufPos)theSize);
+        while (inEntry.mChecksumByteCount < theSize) {
+            const int theLen = min(theSize - inEntry.mChecksumByteCount,
+                (int)CHECKSUM_BLOCKSIZE);
+            if (theAvail < inEntry.mChecksumByteCount + theLen) {
+                break;
+            }
+            const uint32_t theChecksum = ComputeBlockChecksumAt(
+                &inBuf, inEntry.mChecksumByteCount, theLen);
+            inEntry.mChecksum = inEntry.mBlocksChecksums.empty() ?
+                theChecksum :
+                ChecksumBlocksCombine(inEntry.mChecksum, theChecksum, theLen);
+            inEntry.mBlocksChecksums.push_back(theChecksum);
+            inEntry.mChecksumByteCount += theLen;
+        }
+    }
     void Granted(
         ClientSM& inClient)
     {
@@ -793,7 +818,8 @@ RSReplicatorEntry::Enqueue()
 }
 
 ClientThread::ClientThread()
-    : mImpl(*(new ClientThreadImpl(*this)))
+    : mImpl(*(new ClientThreadImpl(*this))),
+      mNumaNode(-1)
     {}
 
 ClientThread::~ClientThread()
@@ -846,9 +872,10 @@ ClientThread::GetCurrentClientThreadPtr()
 
     /* static */ ClientThread*
 ClientThread::CreateThreads(
-    int       inThreadCount,
-    int       inFirstCpuIdx,
-    QCMutex*& outMutexPtr)
+    int        inThreadCount,
+    int        inFirstCpuIdx,
+    QCMutex*&  outMutexPtr,
+    const int* inNumaNodesPtr /* = 0 */)
 {
     if (inThreadCount <= 0) {
         outMutexPtr = 0;
@@ -858,8 +885,14 @@ ClientThread::CreateThreads(
     QCStMutexLocker theLocker(outMutexPtr);
     ClientThread* const theThreadsPtr = new ClientThread[inThreadCount];
     for (int i = 0; i < inThreadCount; i++) {
-        theThreadsPtr[i].mImpl.Start(
-            inFirstCpuIdx < 0 ? -1 : inFirstCpuIdx + i);
+        QCThread::CpuAffinity theAffinity = QCThread::CpuAffinity::None();
+        if (0 <= inFirstCpuIdx) {
+            theAffinity = QCThread::CpuAffinity(inFirstCpuIdx + i);
+        } else if (inNumaNodesPtr && 0 <= inNumaNodesPtr[i]) {
+            theThreadsPtr[i].mNumaNode = inNumaNodesPtr[i];
+            theAffinity = QCNuma::GetNodeCpus(inNumaNodesPtr[i]);
+        }
+        theThreadsPtr[i].mImpl.Start(theAffinity);
     }
     return theThreadsPtr;
 }
@@ -80,17 +80,23 @@ public:
     void Lock();
     void Unlock();
     const QCThread& GetThread() const;
+    int GetNumaNode() const
+        { return mNumaNode; }
     static ClientThread* GetCurrentClientThreadPtr();
     static const QCMutex& GetMutex();
+    // If first cpu index is negative, and the nodes are specified, each
+    // thread runs on the cpus of the corresponding node.
     static ClientThread* CreateThreads(
-        int       inThreadCount,
-        int       inFirstCpuIdx,
-        QCMutex*& outMutexPtr);
+        int        inThreadCount,
+        int        inFirstCpuIdx,
+        QCMutex*&  outMutexPtr,
+        const int* inNumaNodesPtr = 0);
     static void Stop(
         ClientThread* inThreadsPtr,
         int           inThreadCount);
 private:
     ClientThreadImpl& mImpl;
+    int               mNumaNode;
 
     friend class ClientThreadImpl;
 private:
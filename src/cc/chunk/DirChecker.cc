@@ -28,6 +28,7 @@
 #include "DirChecker.h"
 #include "utils.h"
 #include "Chunk.h"
+#include "ChunkDirIndex.h"
 
 #include "common/MsgLogger.h"
 #include "common/StBuffer.h"
@@ -54,6 +55,7 @@
 #include <utility>
 #include <map>
 #include <deque>
+#include <vector>
 
 namespace KFS
 {
@@ -102,8 +104,7 @@ public:
           mIgnoreErrorsFlag(false),
           mDeleteAllChaunksOnFsMismatchFlag(false),
           mMaxChunkFilesSampled(16),
-          mRandom(),
-          mChunkHeaderBuffer(),
+          mChunkIndexFileName(),
           mTestIoBufferAllocPtr(new char[kTestIoBufferAlign + kTestIoSize]),
           mTestIoBufferPtr(mTestIoBufferAllocPtr +
             (unsigned int)kTestIoBufferAlign -
@@ -126,6 +127,7 @@ public:
         FileNames       theIgnoreFileNames         = mIgnoreFileNames;
         string          theLockFileName;
         string          theFsIdPrefix;
+        string          theChunkIndexFileName;
         DirLocks        theDirLocks;
         mUpdateDirInfosFlag = false;
         int64_t         theLastCheckStartTime      = microseconds();
@@ -161,8 +163,9 @@ public:
             const int     theIoTimeoutSec                     = mIoTimeoutSec;
             const size_t  theMaxChunkFilesSampled             =
                 mMaxChunkFilesSampled;
-            theLockFileName = mLockFileName;
-            theFsIdPrefix   = mFsIdPrefix;
+            theLockFileName       = mLockFileName;
+            theFsIdPrefix         = mFsIdPrefix;
+            theChunkIndexFileName = mChunkIndexFileName;
             DirsAvailable theAvailableDirs;
             theDirLocks.swap(mDirLocks);
             QCASSERT(mDirLocks.empty());
@@ -186,14 +189,13 @@ public:
                         theIgnoreErrorsFlag,
                         theLockFileName,
                         theRequireChunkHeaderChecksumFlag,
-                        mChunkHeaderBuffer,
                         theFsIdPrefix,
+                        theChunkIndexFileName,
                         theFileSystemId,
                         theDeleteAllChaunksOnFsMismatchFlag,
                         theIoTimeoutSec,
                         mTestIoBufferPtr,
                         theMaxChunkFilesSampled,
-                        mRandom,
                         theAvailableDirs
                     );
                 }
@@ -451,6 +453,12 @@ public:
         QCStMutexLocker theLocker(mMutex);
         return (int)mMaxChunkFilesSampled;
     }
+    void SetChunkIndexFileName(
+        const string& inName)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        mChunkIndexFileName = inName;
+    }
     void Wakeup()
     {
         QCStMutexLocker theLocker(mMutex);
@@ -489,11 +497,200 @@ private:
     bool              mIgnoreErrorsFlag;
     bool              mDeleteAllChaunksOnFsMismatchFlag;
     size_t            mMaxChunkFilesSampled;
-    PrngIsaac64       mRandom;
-    ChunkHeaderBuffer mChunkHeaderBuffer;
+    string            mChunkIndexFileName;
     char* const       mTestIoBufferAllocPtr;
     char* const       mTestIoBufferPtr;
 
+    struct DirLoad
+    {
+        DirLoad()
+            : mDirIt(),
+              mLockFdPtr(),
+              mSupportsSpaceReservatonFlag(false),
+              mDev(0),
+              mStatus(-EINVAL),
+              mFsId(-1),
+              mFsIdPathName(),
+              mChunkInfos()
+            {}
+        DirInfos::const_iterator mDirIt;
+        LockFdPtr                mLockFdPtr;
+        bool                     mSupportsSpaceReservatonFlag;
+        dev_t                    mDev;
+        int                      mStatus;
+        int64_t                  mFsId;
+        string                   mFsIdPathName;
+        ChunkInfos               mChunkInfos;
+    };
+    typedef std::deque<DirLoad> DirLoads;
+
+    // Loads chunk directories residing on the same device sequentially.
+    class DirLoader : public QCRunnable
+    {
+    public:
+        DirLoader(
+            const string&    inLockName,
+            const FileNames& inIgnoreFileNames,
+            bool             inRequireChunkHeaderChecksumFlag,
+            bool             inRemoveFilesFlag,
+            bool             inIgnoreErrorsFlag,
+            const string&    inFsIdPrefix,
+            const string&    inChunkIndexFileName,
+            int              inIoTimeout,
+            size_t           inMaxChunkFilesSampled)
+            : QCRunnable(),
+              mLockName(inLockName),
+              mIgnoreFileNames(inIgnoreFileNames),
+              mRequireChunkHeaderChecksumFlag(inRequireChunkHeaderChecksumFlag),
+              mRemoveFilesFlag(inRemoveFilesFlag),
+              mIgnoreErrorsFlag(inIgnoreErrorsFlag),
+              mFsIdPrefix(inFsIdPrefix),
+              mChunkIndexFileName(inChunkIndexFileName),
+              mIoTimeout(inIoTimeout),
+              mMaxChunkFilesSampled(inMaxChunkFilesSampled),
+              mDirs(),
+              mThread(),
+              mRandom(),
+              mChunkHeaderBuffer()
+            {}
+        virtual ~DirLoader()
+            {}
+        void Add(
+            DirLoad& inDir)
+            { mDirs.push_back(&inDir); }
+        void Start()
+        {
+            const int kStackSize = 64 << 10;
+            mThread.Start(this, kStackSize, "ChunkDirLoad");
+        }
+        void Join()
+        {
+            if (mThread.IsStarted()) {
+                mThread.Join();
+            }
+        }
+        virtual void Run()
+        {
+            for (Dirs::const_iterator theIt = mDirs.begin();
+                    theIt != mDirs.end();
+                    ++theIt) {
+                Load(**theIt);
+            }
+        }
+    private:
+        typedef std::vector<DirLoad*> Dirs;
+
+        const string&     mLockName;
+        const FileNames&  mIgnoreFileNames;
+        const bool        mRequireChunkHeaderChecksumFlag;
+        const bool        mRemoveFilesFlag;
+        const bool        mIgnoreErrorsFlag;
+        const string&     mFsIdPrefix;
+        const string&     mChunkIndexFileName;
+        const int         mIoTimeout;
+        const size_t      mMaxChunkFilesSampled;
+        Dirs              mDirs;
+        QCThread          mThread;
+        PrngIsaac64       mRandom;
+        ChunkHeaderBuffer mChunkHeaderBuffer;
+
+        void Load(
+            DirLoad& inDir)
+        {
+            const string& theDirName = inDir.mDirIt->first;
+            if (! mChunkIndexFileName.empty() && ChunkDirIndex::Load(
+                    theDirName,
+                    mChunkIndexFileName,
+                    mFsIdPrefix,
+                    inDir.mFsId,
+                    inDir.mFsIdPathName,
+                    inDir.mChunkInfos) == 0) {
+                inDir.mStatus = 0;
+                return;
+            }
+            inDir.mFsId = -1;
+            inDir.mFsIdPathName.clear();
+            inDir.mChunkInfos.Clear();
+            inDir.mStatus = GetChunkFiles(
+                theDirName,
+                mLockName,
+                mIgnoreFileNames,
+                mRequireChunkHeaderChecksumFlag,
+                mRemoveFilesFlag,
+                mIgnoreErrorsFlag,
+                mFsIdPrefix,
+                mChunkHeaderBuffer,
+                mIoTimeout,
+                mMaxChunkFilesSampled,
+                mRandom,
+                inDir.mFsId,
+                inDir.mFsIdPathName,
+                inDir.mChunkInfos
+            );
+        }
+    private:
+        DirLoader(
+            const DirLoader& inLoader);
+        DirLoader& operator=(
+            const DirLoader& inLoader);
+    };
+    friend class DirLoader;
+
+    static void LoadDirs(
+        const string&    inLockName,
+        const FileNames& inIgnoreFileNames,
+        bool             inRequireChunkHeaderChecksumFlag,
+        bool             inRemoveFilesFlag,
+        bool             inIgnoreErrorsFlag,
+        const string&    inFsIdPrefix,
+        const string&    inChunkIndexFileName,
+        int              inIoTimeout,
+        size_t           inMaxChunkFilesSampled,
+        DirLoads&        ioDirLoads)
+    {
+        if (ioDirLoads.empty()) {
+            return;
+        }
+        typedef std::map<dev_t, DirLoader*> DirLoaders;
+        const int64_t theStartTime = microseconds();
+        DirLoaders    theLoaders;
+        for (DirLoads::iterator theIt = ioDirLoads.begin();
+                theIt != ioDirLoads.end();
+                ++theIt) {
+            DirLoader*& theLoaderPtr = theLoaders[theIt->mDev];
+            if (! theLoaderPtr) {
+                theLoaderPtr = new DirLoader(
+                    inLockName,
+                    inIgnoreFileNames,
+                    inRequireChunkHeaderChecksumFlag,
+                    inRemoveFilesFlag,
+                    inIgnoreErrorsFlag,
+                    inFsIdPrefix,
+                    inChunkIndexFileName,
+                    inIoTimeout,
+                    inMaxChunkFilesSampled
+                );
+            }
+            theLoaderPtr->Add(*theIt);
+        }
+        // Load directories on different devices in parallel, use the calling
+        // thread for the first device.
+        DirLoaders::const_iterator theIt = theLoaders.begin();
+        while (++theIt != theLoaders.end()) {
+            theIt->second->Start();
+        }
+        theLoaders.begin()->second->Run();
+        for (theIt = theLoaders.begin(); theIt != theLoaders.end(); ++theIt) {
+            theIt->second->Join();
+            delete theIt->second;
+        }
+        KFS_LOG_STREAM_INFO <<
+            "loaded directories: " << ioDirLoads.size() <<
+            " devices: "           << theLoaders.size() <<
+            " time: "              <<
+                (microseconds() - theStartTime) * 1e-6 << " sec." <<
+        KFS_LOG_EOM;
+    }
     static void CheckDirs(
         const DirInfos&    inDirInfos,
         const SubDirNames& inSubDirNames,
@@ -505,16 +702,16 @@ private:
         bool               inIgnoreErrorsFlag,
         const string&      inLockName,
         bool               inRequireChunkHeaderChecksumFlag,
-        ChunkHeaderBuffer& inChunkHeaderBuffer,
         const string&      inFsIdPrefix,
+        const string&      inChunkIndexFileName,
         int64_t            inFileSystemId,
         bool               inDeleteAllChaunksOnFsMismatchFlag,
         int                inIoTimeout,
         char*              inTestBufferPtr,
         size_t             inMaxChunkFilesSampled,
-        PrngIsaac64&       inRandom,
         DirsAvailable&     outDirsAvailable)
     {
+        DirLoads theDirLoads;
         for (DirInfos::const_iterator theIt = inDirInfos.begin();
                 theIt != inDirInfos.end();
                 ++theIt) {
@@ -609,26 +806,38 @@ private:
             if (theSit != inSubDirNames.end()) {
                 continue;
             }
-            int64_t    theFsId = -1;
-            ChunkInfos theChunkInfos;
-            string     theFsIdPathName;
-            if (GetChunkFiles(
-                    theIt->first,
-                    inLockName,
-                    inIgnoreFileNames,
-                    inRequireChunkHeaderChecksumFlag,
-                    inRemoveFilesFlag,
-                    inIgnoreErrorsFlag,
-                    inFsIdPrefix,
-                    inChunkHeaderBuffer,
-                    inIoTimeout,
-                    inMaxChunkFilesSampled,
-                    inRandom,
-                    theFsId,
-                    theFsIdPathName,
-                    theChunkInfos) != 0) {
+            theDirLoads.push_back(DirLoad());
+            DirLoad& theLoad = theDirLoads.back();
+            theLoad.mDirIt                       = theIt;
+            theLoad.mLockFdPtr                   = theLockFdPtr;
+            theLoad.mSupportsSpaceReservatonFlag =
+                theSupportsSpaceReservatonFlag;
+            theLoad.mDev                         = theStat.st_dev;
+        }
+        LoadDirs(
+            inLockName,
+            inIgnoreFileNames,
+            inRequireChunkHeaderChecksumFlag,
+            inRemoveFilesFlag,
+            inIgnoreErrorsFlag,
+            inFsIdPrefix,
+            inChunkIndexFileName,
+            inIoTimeout,
+            inMaxChunkFilesSampled,
+            theDirLoads
+        );
+        for (DirLoads::iterator theLoadIt = theDirLoads.begin();
+                theLoadIt != theDirLoads.end();
+                ++theLoadIt) {
+            if (theLoadIt->mStatus != 0) {
                 continue;
             }
+            DirInfos::const_iterator const theIt           = theLoadIt->mDirIt;
+            int64_t&                       theFsId         = theLoadIt->mFsId;
+            ChunkInfos&                    theChunkInfos   =
+                theLoadIt->mChunkInfos;
+            string&                        theFsIdPathName =
+                theLoadIt->mFsIdPathName;
             if (0 < inFileSystemId && 0 < theFsId &&
                     inFileSystemId != theFsId) {
                 const int theCleanupFlag =
@@ -709,8 +918,14 @@ private:
                     continue;
                 }
             }
+            if (! inChunkIndexFileName.empty()) {
+                // Failure to write index only results in directory scan on
+                // the next restart.
+                ChunkDirIndex::Write(
+                    theIt->first, inChunkIndexFileName, theChunkInfos);
+            }
             pair<DeviceIds::iterator, bool> const theDevRes =
-                inDeviceIds.insert(make_pair(theStat.st_dev, ioNextDevId));
+                inDeviceIds.insert(make_pair(theLoadIt->mDev, ioNextDevId));
             if (theDevRes.second) {
                 ioNextDevId++;
             }
@@ -718,9 +933,9 @@ private:
                 outDirsAvailable.insert(make_pair(theIt->first,
                     DirInfo(
                         theDevRes.first->second,
-                        theLockFdPtr,
+                        theLoadIt->mLockFdPtr,
                         theIt->second,
-                        theSupportsSpaceReservatonFlag,
+                        theLoadIt->mSupportsSpaceReservatonFlag,
                         theFsId
                     )));
             if (! theChunkInfos.IsEmpty() && theDirRes.second) {
@@ -1454,6 +1669,13 @@ DirChecker::GetMaxChunkFilesSampled()
     return mImpl.GetMaxChunkFilesSampled();
 }
 
+    void
+DirChecker::SetChunkIndexFileName(
+    const string& inName)
+{
+    mImpl.SetChunkIndexFileName(inName);
+}
+
     void
 DirChecker::Wakeup()
 {
@@ -162,6 +162,8 @@ public:
     void SetMaxChunkFilesSampled(
         int inValue);
     int GetMaxChunkFilesSampled();
+    void SetChunkIndexFileName(
+        const string& inName);
     void Wakeup();
 private:
     class Impl;
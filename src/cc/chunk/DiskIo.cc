@@ -33,12 +33,15 @@
 #include "common/Properties.h"
 #include "common/MsgLogger.h"
 #include "common/kfstypes.h"
+#include "common/time.h"
+#include "common/RequestTrace.h"
 
 #include "qcdio/QCDLList.h"
 #include "qcdio/QCMutex.h"
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/QCIoBufferPool.h"
+#include "qcdio/QCNuma.h"
 #include "qcdio/qcdebug.h"
 
 #include <cerrno>
@@ -297,6 +300,8 @@ private:
 };
 
 const char* const kDiskQueueParametersPrefixPtr = "chunkServer.diskQueue.";
+const char* const kDiskQueuePriorityClassNames[
+    QCDiskQueue::kPriorityClassCount] = { "High", "Normal", "Background" };
 // Disk io queue.
 class DiskQueue : public QCDiskQueue,
     private QCDiskQueue::DebugTracer
@@ -337,6 +342,7 @@ public:
           mBufferDataIgnoreOverwriteFlag(inBufferDataIgnoreOverwriteFlag),
           mBufferDataTailToKeepSize(max(0, inBufferDataTailToKeepSize)),
           mThreadCount(inThreadCount),
+          mNumaNode(-1),
           mIoMethodsPtr(inIoMethodsPtr),
           mRequestProcessorsPtr(
             inIoMethodsPtr ? new RequestProcessor*[inThreadCount]: 0),
@@ -473,6 +479,11 @@ public:
     DeviceId SetDeviceId(
         DeviceId inDeviceId)
         { return mDeviceId = inDeviceId; }
+    int GetNumaNode() const
+        { return mNumaNode; }
+    void SetNumaNode(
+        int inNode)
+        { mNumaNode = inNode; }
     void AddFileNamePrefix(
         const char* inFileNamePtr)
     {
@@ -485,7 +496,9 @@ public:
         InputIterator* inBufferIteratorPtr,
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
-        Time           inTimeWaitNanoSec)
+        Time           inTimeWaitNanoSec,
+        PriorityClass  inPriorityClass,
+        Time           inDeadlineNanoSec)
     {
         if (! mSimulatorPtr || mSimulatorPtr->Enqueue()) {
             return QCDiskQueue::Read(
@@ -494,7 +507,9 @@ public:
                 inBufferIteratorPtr,
                 inBufferCount,
                 inIoCompletionPtr,
-                inTimeWaitNanoSec);
+                inTimeWaitNanoSec,
+                inPriorityClass,
+                inDeadlineNanoSec);
         }
         return EnqueueStatus(kRequestIdNone, kErrorOutOfRequests);
     }
@@ -506,7 +521,9 @@ public:
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec,
         bool           inSyncFlag,
-        int64_t        inEofHint)
+        int64_t        inEofHint,
+        PriorityClass  inPriorityClass,
+        Time           inDeadlineNanoSec)
     {
         if (! mSimulatorPtr || mSimulatorPtr->Enqueue()) {
             return QCDiskQueue::Write(
@@ -517,7 +534,9 @@ public:
                 inIoCompletionPtr,
                 inTimeWaitNanoSec,
                 inSyncFlag,
-                inEofHint
+                inEofHint,
+                inPriorityClass,
+                inDeadlineNanoSec
             );
         }
         return EnqueueStatus(kRequestIdNone, kErrorOutOfRequests);
@@ -619,6 +638,7 @@ private:
     bool                const mBufferDataIgnoreOverwriteFlag;
     int                 const mBufferDataTailToKeepSize;
     int                 const mThreadCount;
+    int                       mNumaNode;
     IOMethod**          const mIoMethodsPtr;
     RequestProcessor**  const mRequestProcessorsPtr;
     bool                      mCanEnforceIoTimeoutFlag;
@@ -783,24 +803,43 @@ public:
           mNullBufferDataPtr(0),
           mNullBufferDataWrittenPtr(0),
           mCounters(),
+          mReadLatency("Latency Disk read"),
+          mWriteLatency("Latency Disk write"),
+          mMetaLatency("Latency Disk meta"),
           mDiskErrorSimulatorConfig(inConfig),
           mCpuAffinity(inConfig.getValue(
             "chunkServer.diskQueue.cpuAffinity", -1)),
+          mNumaNodeCount((inConfig.getValue(
+            "chunkServer.numa.enabled", 0) != 0 &&
+                1 < QCNuma::GetNodeCount()) ? QCNuma::GetNodeCount() : 0),
           mDiskQueueTraceFlag(inConfig.getValue(
             "chunkServer.diskQueue.trace", 0) != 0),
           mParameters(inConfig)
     {
+        const int kDefaultWeights[QCDiskQueue::kPriorityClassCount] =
+            { 8, 4, 1 };
+        for (int i = 0; i < QCDiskQueue::kPriorityClassCount; i++) {
+            mPriorityClassWeights[i]         = kDefaultWeights[i];
+            mPriorityClassDeadlineNanoSec[i] = -1;
+        }
+        SetPriorityClassParameters(inConfig);
         mCounters.Clear();
         IoQueue::Init(mIoInFlightQueuePtr);
         IoQueue::Init(mIoInFlightNoTimeoutQueuePtr);
         IoQueue::Init(mIoDoneQueuePtr);
         DiskQueueList::Init(mDiskQueuesPtr);
+        globals().counterManager.AddCounter(&mReadLatency);
+        globals().counterManager.AddCounter(&mWriteLatency);
+        globals().counterManager.AddCounter(&mMetaLatency);
         // Call Timeout() every time NetManager goes trough its work loop.
         ITimeout::SetTimeoutInterval(0);
     }
     ~DiskIoQueues()
     {
         DiskIoQueues::Shutdown(0, false);
+        globals().counterManager.RemoveCounter(&mReadLatency);
+        globals().counterManager.RemoveCounter(&mWriteLatency);
+        globals().counterManager.RemoveCounter(&mMetaLatency);
         globalNetManager().UnRegisterTimeoutHandler(this);
         if (mDebugVerifyIoBuffersFlag) {
             SetIOBufferVerifier(0);
@@ -815,7 +854,8 @@ public:
             mBufferPoolPartitionCount,
             mBufferPoolPartitionBufferCount,
             mBufferPoolBufferSize,
-            mBufferPoolLockMemoryFlag
+            mBufferPoolLockMemoryFlag,
+            mNumaNodeCount
         );
         if (theSysError) {
             if (inErrMessagePtr) {
@@ -1103,6 +1143,21 @@ public:
             }
             theIoMethodsPtr[i] = thePtr;
         }
+        // With NUMA placement, and no explicit disk queue cpu affinity, run
+        // the io threads on the node the device is attached to.
+        const int theNumaNode = 0 < mNumaNodeCount ?
+            QCNuma::GetPathNode(inDirNamePtr) : -1;
+        QCDiskQueue::CpuAffinity theCpuAffinity = mCpuAffinity;
+        if (0 <= theNumaNode &&
+                mCpuAffinity == QCDiskQueue::CpuAffinity::None()) {
+            theCpuAffinity = QCNuma::GetNodeCpus(theNumaNode);
+        }
+        if (0 < mNumaNodeCount) {
+            KFS_LOG_STREAM_INFO <<
+                "disk queue: " << inDirNamePtr <<
+                " numa node: " << theNumaNode <<
+            KFS_LOG_EOM;
+        }
         theQueuePtr = new DiskQueue(
             mDiskQueuesPtr,
             inDeviceId,
@@ -1127,7 +1182,7 @@ public:
             inMaxOpenFiles,
             0, // FileNamesPtr
             GetBufferPool(),
-            mCpuAffinity,
+            theCpuAffinity,
             mDiskQueueTraceFlag,
             inCreateExclusiveFlag,
             inRequestAffinityFlag || 0 != theIoMethodsPtr,
@@ -1142,6 +1197,33 @@ public:
             }
             return false;
         }
+        theQueuePtr->SetPriorityClassWeights(mPriorityClassWeights);
+        theQueuePtr->SetNumaNode(theNumaNode);
+        return true;
+    }
+    int GetNumaNodeCount() const
+        { return mNumaNodeCount; }
+    bool GetNumaNodeCounters(
+        int                       inNode,
+        DiskIo::NumaNodeCounters& outCounters)
+    {
+        outCounters.Clear();
+        QCIoBufferPool::NodeCounters theBufCounters;
+        if (inNode < 0 || mNumaNodeCount <= inNode ||
+                ! GetBufferPool().GetNodeCounters(inNode, theBufCounters)) {
+            return false;
+        }
+        outCounters.mBufferCount          = theBufCounters.mTotalCount;
+        outCounters.mFreeBufferCount      = theBufCounters.mFreeCount;
+        outCounters.mLocalBufferGetCount  = theBufCounters.mLocalGetCount;
+        outCounters.mRemoteBufferGetCount = theBufCounters.mRemoteGetCount;
+        DiskQueueList::Iterator theIt(mDiskQueuesPtr);
+        const DiskQueue* thePtr;
+        while ((thePtr = theIt.Next())) {
+            if (thePtr->GetNumaNode() == inNode && thePtr->IsInUse()) {
+                outCounters.mDiskQueueCount++;
+            }
+        }
         return true;
     }
     DiskQueue::Time GetMaxEnqueueWaitTimeNanoSec() const
@@ -1269,7 +1351,40 @@ public:
         { return mDiskQueueThreadCount; }
     void GetCounters(
         Counters& outCounters)
-        { outCounters = mCounters; }
+    {
+        outCounters = mCounters;
+        QCDiskQueue::PriorityClassCounters
+            theCounters[QCDiskQueue::kPriorityClassCount];
+        DiskQueueList::Iterator theIt(mDiskQueuesPtr);
+        DiskQueue* thePtr;
+        while ((thePtr = theIt.Next())) {
+            thePtr->GetPriorityClassCounters(theCounters);
+            for (int i = 0; i < QCDiskQueue::kPriorityClassCount; i++) {
+                QCDiskQueue::PriorityClassCounters& theTotal =
+                    outCounters.mPriorityClassCounters[i];
+                const QCDiskQueue::PriorityClassCounters& theCur =
+                    theCounters[i];
+                theTotal.mRequestCount      += theCur.mRequestCount;
+                theTotal.mBlockCount        += theCur.mBlockCount;
+                theTotal.mQueueWaitTime     += theCur.mQueueWaitTime;
+                theTotal.mMaxQueueWaitTime  = max(theTotal.mMaxQueueWaitTime,
+                    theCur.mMaxQueueWaitTime);
+                theTotal.mTotalTime         += theCur.mTotalTime;
+                theTotal.mMaxTotalTime      = max(theTotal.mMaxTotalTime,
+                    theCur.mMaxTotalTime);
+                theTotal.mDeadlineCount     += theCur.mDeadlineCount;
+                theTotal.mDeadlineMissCount += theCur.mDeadlineMissCount;
+            }
+        }
+    }
+    DiskQueue::Time GetDeadlineNanoSec(
+        DiskIo::PriorityClass inPriorityClass,
+        int64_t               inDeadlineMicroSec) const
+    {
+        return (inDeadlineMicroSec < 0 ?
+            mPriorityClassDeadlineNanoSec[inPriorityClass] :
+            DiskQueue::Time(inDeadlineMicroSec) * 1000);
+    }
     void SetInFlight(
         DiskIo* inIoPtr)
     {
@@ -1277,10 +1392,30 @@ public:
             return;
         }
         Pin(*inIoPtr);
-        inIoPtr->mEnqueueTime = Now();
+        inIoPtr->mEnqueueTime     = Now();
+        inIoPtr->mEnqueueTimeUsec = microseconds();
         QCStMutexLocker theLocker(mMutex);
         AddInFlight(*inIoPtr);
     }
+    // Records the time from the request submission to the completion
+    // processing by the main thread.
+    void UpdateLatency(
+        const DiskIo& inIo,
+        bool          inMetaFlag)
+    {
+        if (inIo.mEnqueueTimeUsec <= 0) {
+            return;
+        }
+        const int64_t theTime = microseconds() - inIo.mEnqueueTimeUsec;
+        LatencyCounter& theCounter = inMetaFlag ? mMetaLatency :
+            (0 < inIo.mReadLength ? mReadLatency :
+            (inIo.mIoBuffers.empty() ? mMetaLatency : mWriteLatency));
+        theCounter.UpdateTime(theTime);
+        RequestTrace::Record(inIo.mTraceId,
+            &theCounter == &mReadLatency  ? "disk read"  :
+            &theCounter == &mWriteLatency ? "disk write" : "disk meta",
+            inIo.mEnqueueTimeUsec, theTime);
+    }
     void ResetInFlight(
         DiskIo* inIoPtr)
     {
@@ -1331,11 +1466,33 @@ public:
         mValidateIoBuffersFlag = inProperties.getValue(
             "chunkServer.diskIo.debugValidateIoBuffers",
             mValidateIoBuffersFlag ? 1 : 0) != 0;
+        SetPriorityClassParameters(inProperties);
         mParameters = inProperties;
         DiskQueue* thePtr;
         DiskQueueList::Iterator theIt(mDiskQueuesPtr);
         while ((thePtr = theIt.Next())) {
             thePtr->SetParameters(mParameters);
+            thePtr->SetPriorityClassWeights(mPriorityClassWeights);
+        }
+    }
+    void SetPriorityClassParameters(
+        const Properties& inProperties)
+    {
+        string theName;
+        for (int i = 0; i < QCDiskQueue::kPriorityClassCount; i++) {
+            theName = kDiskQueueParametersPrefixPtr;
+            theName += "priorityWeight";
+            theName += kDiskQueuePriorityClassNames[i];
+            mPriorityClassWeights[i] = max(1, inProperties.getValue(
+                theName, mPriorityClassWeights[i]));
+            theName = kDiskQueueParametersPrefixPtr;
+            theName += "priorityDeadlineMilliSec";
+            theName += kDiskQueuePriorityClassNames[i];
+            const int64_t theDeadline = inProperties.getValue(theName,
+                mPriorityClassDeadlineNanoSec[i] < 0 ? int64_t(-1) :
+                mPriorityClassDeadlineNanoSec[i] / 1000000);
+            mPriorityClassDeadlineNanoSec[i] = theDeadline < 0 ?
+                DiskQueue::Time(-1) : DiskQueue::Time(theDeadline) * 1000000;
         }
     }
     int GetMaxIoTimeSec() const
@@ -1561,10 +1718,18 @@ private:
     DiskIo*                        mIoDoneQueuePtr[1];
     DiskQueue*                     mDiskQueuesPtr[1];
     Counters                       mCounters;
+    LatencyCounter                 mReadLatency;
+    LatencyCounter                 mWriteLatency;
+    LatencyCounter                 mMetaLatency;
     DiskErrorSimulator::Config     mDiskErrorSimulatorConfig;
     const QCDiskQueue::CpuAffinity mCpuAffinity;
+    const int                      mNumaNodeCount;
     const int                      mDiskQueueTraceFlag;
     Properties                     mParameters;
+    int                            mPriorityClassWeights[
+        QCDiskQueue::kPriorityClassCount];
+    DiskQueue::Time                mPriorityClassDeadlineNanoSec[
+        QCDiskQueue::kPriorityClassCount];
 
     QCIoBufferPool& GetBufferPool()
         { return mBufferAllocator.GetBufferPool(); }
@@ -1874,6 +2039,24 @@ DiskIo::GetCounters(
     sDiskIoQueuesPtr->GetCounters(outCounters);
 }
 
+    /* static */ int
+DiskIo::GetNumaNodeCount()
+{
+    return (sDiskIoQueuesPtr ? sDiskIoQueuesPtr->GetNumaNodeCount() : 0);
+}
+
+    /* static */ bool
+DiskIo::GetNumaNodeCounters(
+    int                       inNode,
+    DiskIo::NumaNodeCounters& outCounters)
+{
+    if (! sDiskIoQueuesPtr) {
+        outCounters.Clear();
+        return false;
+    }
+    return sDiskIoQueuesPtr->GetNumaNodeCounters(inNode, outCounters);
+}
+
      /* static */ bool
 DiskIo::Delete(
     const char*     inFileNamePtr,
@@ -2334,8 +2517,12 @@ DiskIo::DiskIo(
       mBlockIdx(0),
       mIoRetCode(0),
       mEnqueueTime(),
+      mEnqueueTimeUsec(0),
       mWriteSyncFlag(false),
       mCachedFlag(false),
+      mPriorityClass(QCDiskQueue::kPriorityClassNormal),
+      mDeadlineMicroSec(-1),
+      mTraceId(0),
       mCompletionRequestId(QCDiskQueue::kRequestIdNone),
       mCompletionCode(QCDiskQueue::kErrorNone),
       mChainedPtr(0)
@@ -2490,7 +2677,9 @@ DiskIo::Read(
         0, // inBufferIteratorPtr // allocate buffers just beofre read
         theBufferCnt,
         this,
-        sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec()
+        sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec(),
+        mPriorityClass,
+        sDiskIoQueuesPtr->GetDeadlineNanoSec(mPriorityClass, mDeadlineMicroSec)
     );
     if (theStatus.IsGood()) {
         theQueuePtr->ReadPending(inNumBytes, 0, mCachedFlag);
@@ -2657,6 +2846,8 @@ DiskIo::Write(
             if ((theFBufIt - theIoBuffers.begin()) % theBlkCnt == 0) {
                 theIoPtr = new DiskIo(mFilePtr,
                     sDiskIoQueuesPtr->GetBufferredWriteNullCallbackPtr());
+                theIoPtr->SetIoPriority(mPriorityClass, mDeadlineMicroSec);
+                theIoPtr->SetTraceId(mTraceId);
                 while (theFBufIt != theLastIt && ! theFBufIt->IsEmpty()) {
                     theIoPtr->mIoBuffers.push_back(*theFBufIt);
                     *theFBufIt = theWBIgnoreOverwriteFlag ?
@@ -2774,6 +2965,8 @@ DiskIo::Write(
         if (theFBufIt != theEndIt) {
             DiskIo& theIo = *(new DiskIo(mFilePtr,
                 sDiskIoQueuesPtr->GetBufferredWriteNullCallbackPtr()));
+            theIo.SetIoPriority(mPriorityClass, mDeadlineMicroSec);
+            theIo.SetTraceId(mTraceId);
             theBlkIdx =
                 (QCDiskQueue::BlockIdx)(theFBufIt - theIoBuffers.begin());
             while (theFBufIt != theEndIt) {
@@ -2902,7 +3095,9 @@ DiskIo::SubmitWrite(
         this,
         sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec(),
         inSyncFlag,
-        inEofHint
+        inEofHint,
+        mPriorityClass,
+        sDiskIoQueuesPtr->GetDeadlineNanoSec(mPriorityClass, mDeadlineMicroSec)
     );
     if (theStatus.IsGood()) {
         inQueuePtr->WritePending(inNumBytes, 0, mCachedFlag);
@@ -3090,6 +3285,7 @@ DiskIo::RunCompletion()
         theOpNamePtr = "check status";
         sDiskIoQueuesPtr->CheckOpenStatusDone(mIoRetCode);
     }
+    sDiskIoQueuesPtr->UpdateLatency(*this, theMetaFlag);
     int theNumRead(mIoRetCode);
     if (mIoRetCode < 0) {
         string theErrMsg(QCDiskQueue::ToString(mCompletionCode));
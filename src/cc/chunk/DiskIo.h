@@ -81,6 +81,8 @@ public:
         Counter mTimedOutErrorReadByteCount;
         Counter mTimedOutErrorWriteByteCount;
         Counter mOpenFilesCount;
+        QCDiskQueue::PriorityClassCounters
+            mPriorityClassCounters[QCDiskQueue::kPriorityClassCount];
         void Clear()
         {
             mReadCount                     = 0;
@@ -106,8 +108,30 @@ public:
             mTimedOutErrorReadByteCount    = 0;
             mTimedOutErrorWriteByteCount   = 0;
             mOpenFilesCount                = 0;
+            for (int i = 0; i < QCDiskQueue::kPriorityClassCount; i++) {
+                mPriorityClassCounters[i].Clear();
+            }
+        }
+    };
+    struct NumaNodeCounters
+    {
+        typedef int64_t Counter;
+
+        Counter mBufferCount;
+        Counter mFreeBufferCount;
+        Counter mLocalBufferGetCount;
+        Counter mRemoteBufferGetCount;
+        Counter mDiskQueueCount;
+        void Clear()
+        {
+            mBufferCount          = 0;
+            mFreeBufferCount      = 0;
+            mLocalBufferGetCount  = 0;
+            mRemoteBufferGetCount = 0;
+            mDiskQueueCount       = 0;
         }
     };
+    typedef QCDiskQueue::PriorityClass PriorityClass;
     typedef int64_t Offset;
     typedef int64_t DeviceId;
 
@@ -143,6 +167,11 @@ public:
         DiskQueue* inDiskQueuePtr);
     static void GetCounters(
         Counters& outCounters);
+    // Returns 0 if NUMA placement is not enabled.
+    static int GetNumaNodeCount();
+    static bool GetNumaNodeCounters(
+        int               inNode,
+        NumaNodeCounters& outCounters);
     static bool Delete(
         const char*     inFileNamePtr,
         KfsCallbackObj* inCallbackObjPtr = 0,
@@ -284,6 +313,20 @@ public:
     /// Retrieves [pending] open completion by queuing empty read.
     int CheckOpenStatus();
 
+    /// Set disk queue priority class and deadline for the subsequent reads
+    /// and writes. Negative deadline means use priority class default.
+    void SetIoPriority(
+        PriorityClass inPriorityClass,
+        int64_t       inDeadlineMicroSec = -1)
+    {
+        mPriorityClass    = inPriorityClass;
+        mDeadlineMicroSec = inDeadlineMicroSec;
+    }
+    /// Set request trace id for the subsequent reads and writes.
+    void SetTraceId(
+        int64_t inTraceId)
+        { mTraceId = inTraceId; }
+
     FilePtr GetFilePtr() const
         { return mFilePtr; }
 private:
@@ -297,8 +340,12 @@ private:
     int64_t                mBlockIdx;
     int64_t                mIoRetCode;
     time_t                 mEnqueueTime;
+    int64_t                mEnqueueTimeUsec;
     bool                   mWriteSyncFlag;
     bool                   mCachedFlag;
+    PriorityClass          mPriorityClass;
+    int64_t                mDeadlineMicroSec;
+    int64_t                mTraceId;
     QCDiskQueue::RequestId mCompletionRequestId;
     QCDiskQueue::Error     mCompletionCode;
     DiskIo*                mChainedPtr;
@@ -43,13 +43,16 @@
 #include "common/kfstypes.h"
 #include "common/time.h"
 #include "common/RequestParser.h"
+#include "common/RequestTrace.h"
 #include "common/kfserrno.h"
 #include "common/IntToString.h"
+#include "common/VarIntCodec.h"
 
 #include "kfsio/Globals.h"
 #include "kfsio/checksum.h"
 #include "kfsio/CryptoKeys.h"
 #include "kfsio/ChunkAccessToken.h"
+#include "kfsio/IOBufferWriter.h"
 
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCUtils.h"
@@ -82,14 +85,18 @@ using namespace KFS::libkfsio;
 // Counters for the various ops
 struct OpCounters : private map<KfsOp_t, Counter *>
 {
-    static void Update(KfsOp_t opName, int64_t startTime)
+    static void Update(KfsOp_t opName, int64_t startTime, int64_t traceId)
     {
         Counter* const c = GetCounter(opName);
         if (! c) {
             return;
         }
+        const int64_t timeSpent = microseconds() - startTime;
         c->Update(1);
-        c->UpdateTime(microseconds() - startTime);
+        c->UpdateTime(timeSpent);
+        sInstance->mLatency[opName]->UpdateTime(timeSpent);
+        RequestTrace::Record(traceId, c->GetName().c_str(),
+            startTime, timeSpent);
     }
     static void WriteMaster()
     {
@@ -113,22 +120,30 @@ struct OpCounters : private map<KfsOp_t, Counter *>
         }
     }
 private:
-    Counter mWriteMaster;
-    Counter mWriteDuration;
+    Counter         mWriteMaster;
+    Counter         mWriteDuration;
+    // Op creation to op completion time distribution.
+    LatencyCounter* mLatency[CMD_NCMDS];
     static OpCounters* sInstance;
 
     OpCounters()
         : map<KfsOp_t, Counter *>(),
           mWriteMaster("Write Master"),
           mWriteDuration("Write Duration")
-      {}
+    {
+        for (int i = 0; i < CMD_NCMDS; i++) {
+            mLatency[i] = 0;
+        }
+    }
     ~OpCounters()
     {
         for (iterator i = begin(); i != end(); ++i) {
             if (sInstance == this) {
                 globals().counterManager.RemoveCounter(i->second);
+                globals().counterManager.RemoveCounter(mLatency[i->first]);
             }
             delete i->second;
+            delete mLatency[i->first];
         }
         if (sInstance == this) {
             globals().counterManager.RemoveCounter(&mWriteMaster);
@@ -144,6 +159,9 @@ private:
             return;
         }
         globals().counterManager.AddCounter(c);
+        mLatency[opName] = new LatencyCounter(
+            (string("Latency ") + name).c_str());
+        globals().counterManager.AddCounter(mLatency[opName]);
     }
     static Counter* GetCounter(KfsOp_t opName)
     {
@@ -163,6 +181,7 @@ private:
         static OpCounters instance;
         instance.AddCounter("Read", CMD_READ);
         instance.AddCounter("Write Prepare", CMD_WRITE_PREPARE);
+        instance.AddCounter("Write Prepare Fwd", CMD_WRITE_PREPARE_FWD);
         instance.AddCounter("Write Sync", CMD_WRITE_SYNC);
         instance.AddCounter("Write (AIO)", CMD_WRITE);
         instance.AddCounter("Size", CMD_SIZE);
@@ -177,6 +196,12 @@ private:
         instance.AddCounter("Heartbeat", CMD_HEARTBEAT);
         instance.AddCounter("Change Chunk Vers", CMD_CHANGE_CHUNK_VERS);
         instance.AddCounter("Make Chunk Stable", CMD_MAKE_CHUNK_STABLE);
+        instance.AddCounter("Begin Make Chunk Stable",
+            CMD_BEGIN_MAKE_CHUNK_STABLE);
+        instance.AddCounter("Write Id Alloc", CMD_WRITE_ID_ALLOC);
+        instance.AddCounter("Close", CMD_CLOSE);
+        instance.AddCounter("Get Record Append Status",
+            CMD_GET_RECORD_APPEND_STATUS);
         globals().counterManager.AddCounter(&instance.mWriteMaster);
         globals().counterManager.AddCounter(&instance.mWriteDuration);
         return &instance;
@@ -677,6 +702,8 @@ KfsOp::KfsOp(KfsOp_t o)
       shortRpcFormatFlag(false),
       initialShortRpcFormatFlag(false),
       maxWaitMillisec(-1),
+      traceId(0),
+      binaryRpcFlag(false),
       statusMsg(),
       clnt(0),
       generation(0),
@@ -699,7 +726,7 @@ KfsOp::~KfsOp()
         die("~KfsOp: invalid instance");
         return;
     }
-    OpCounters::Update(op, startTime);
+    OpCounters::Update(op, startTime, traceId);
     sOpsCount--;
     OpsList::Remove(sOpsList, *this);
     clnt = 0;
@@ -736,17 +763,42 @@ KfsClientChunkOp::Validate()
         return false;
     }
     if ((hasChunkAccessTokenFlag = ! chunkAccessVal.empty())) {
-        ChunkAccessToken token;
-        if ((chunkAccessTokenValidFlag = token.Process(
-                chunkId,
+        // Skip signature verification if the same token was already
+        // verified with the same chunk and subject id.
+        AccessTokenCache&  cache = gChunkManager.GetAccessTokenCache();
+        const CryptoKeys&  keys  = gChunkManager.GetCryptoKeys();
+        DelegationToken    cachedToken;
+        if ((chunkAccessTokenValidFlag = cache.Get(
                 chunkAccessVal.mPtr,
                 chunkAccessVal.mLen,
+                chunkId,
+                subjectId,
                 globalNetManager().Now(),
-                gChunkManager.GetCryptoKeys(),
-                &statusMsg,
-                subjectId))) {
-            chunkAccessUid   = token.Get().GetUid();
-            chunkAccessFlags = token.Get().GetFlags();
+                keys,
+                cachedToken))) {
+            chunkAccessUid   = cachedToken.GetUid();
+            chunkAccessFlags = cachedToken.GetFlags();
+        } else {
+            ChunkAccessToken token;
+            if ((chunkAccessTokenValidFlag = token.Process(
+                    chunkId,
+                    chunkAccessVal.mPtr,
+                    chunkAccessVal.mLen,
+                    globalNetManager().Now(),
+                    keys,
+                    &statusMsg,
+                    subjectId))) {
+                chunkAccessUid   = token.Get().GetUid();
+                chunkAccessFlags = token.Get().GetFlags();
+                cache.Put(
+                    chunkAccessVal.mPtr,
+                    chunkAccessVal.mLen,
+                    chunkId,
+                    subjectId,
+                    token.Get(),
+                    keys
+                );
+            }
         }
         chunkAccessVal.clear();
     }
@@ -1788,6 +1840,37 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Read-chksum-skip-bytes",    cm.mReadSkipDiskVerifyByteCount);
     HBAppend(os, "Read-chksum-skip-cs-bytes",
         cm.mReadSkipDiskVerifyChecksumByteCount);
+    HBAppend(os, "Scrub-chunks",              cm.mScrubChunkCount);
+    HBAppend(os, "Scrub-bytes",               cm.mScrubByteCount);
+    HBAppend(os, "Scrub-micro-sec",           cm.mScrubMicroSecs);
+    HBAppend(os, "Scrub-skip",                cm.mScrubSkipCount);
+    HBAppend(os, "Scrub-errors",              cm.mScrubErrorCount);
+    HBAppend(os, "Scrub-chksum-errors",       cm.mScrubChecksumErrorCount);
+    HBAppend(os, "Scrub-passes",              cm.mScrubPassCount);
+    HBAppend(os, "Scrub-pass-remaining",      cm.mScrubPassRemainingCount);
+
+    BlockCache::Counters bc;
+    gChunkManager.GetBlockCacheCounters(bc);
+    HBAppend(os, "Block-cache-hits",          bc.mHitCount);
+    HBAppend(os, "Block-cache-misses",        bc.mMissCount);
+    HBAppend(os, "Block-cache-hit-blocks",    bc.mHitBlockCount);
+    HBAppend(os, "Block-cache-hit-bytes",     bc.mHitByteCount);
+    HBAppend(os, "Block-cache-inserts",       bc.mInsertCount);
+    HBAppend(os, "Block-cache-ghost-hits",    bc.mGhostHitCount);
+    HBAppend(os, "Block-cache-evictions",     bc.mEvictCount);
+    HBAppend(os, "Block-cache-invalidations", bc.mInvalidateCount);
+    HBAppend(os, "Block-cache-blocks",        bc.mBlockCount);
+    HBAppend(os, "Block-cache-bytes",         bc.mByteCount);
+
+    AccessTokenCache::Counters tc;
+    gChunkManager.GetAccessTokenCacheCounters(tc);
+    HBAppend(os, "Token-cache-hits",          tc.mHitCount);
+    HBAppend(os, "Token-cache-misses",        tc.mMissCount);
+    HBAppend(os, "Token-cache-inserts",       tc.mInsertCount);
+    HBAppend(os, "Token-cache-evictions",     tc.mEvictCount);
+    HBAppend(os, "Token-cache-expired",       tc.mExpiredCount);
+    HBAppend(os, "Token-cache-invalidations", tc.mInvalidateCount);
+    HBAppend(os, "Token-cache-entries",       tc.mEntryCount);
 
     MetaServerSM::Counters mc;
     gMetaServerSM.GetCounters(mc);
@@ -1869,6 +1952,8 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "WAppend-lost-chunks",          wa.mLostChunkCount);
     HBAppend(os, "WAppend-pending-bytes",        wa.mPendingByteCount);
     HBAppend(os, "WAppend-low-buf-flush",        wa.mLowOnBuffersFlushCount);
+    HBAppend(os, "WAppend-group-commits",        wa.mGroupCommitCount);
+    HBAppend(os, "WAppend-group-commit-records", wa.mGroupCommitRecordCount);
 
     const BufferManager& bufMgr = DiskIo::GetBufferManager();
     HBAppend(os, "Buffer-bytes-total",      bufMgr.GetTotalByteCount());
@@ -1926,6 +2011,46 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Disk-timedout-read-bytes",  dio.mTimedOutErrorReadByteCount);
     HBAppend(os, "Disk-timedout-write-bytes", dio.mTimedOutErrorWriteByteCount);
     HBAppend(os, "Disk-open-files",           dio.mOpenFilesCount);
+    const char* const kDiskIoPriorityClassNames[
+        QCDiskQueue::kPriorityClassCount] = { "high", "normal", "background" };
+    for (int i = 0; i < QCDiskQueue::kPriorityClassCount; i++) {
+        const QCDiskQueue::PriorityClassCounters& ctrs =
+            dio.mPriorityClassCounters[i];
+        const string prefix = string("Disk-queue-") +
+            kDiskIoPriorityClassNames[i];
+        HBAppend(os, (prefix + "-count").c_str(),     ctrs.mRequestCount);
+        HBAppend(os, (prefix + "-blocks").c_str(),    ctrs.mBlockCount);
+        HBAppend(os, (prefix + "-wait-usec").c_str(),
+            ctrs.mQueueWaitTime / 1000);
+        HBAppend(os, (prefix + "-wait-max-usec").c_str(),
+            ctrs.mMaxQueueWaitTime / 1000);
+        HBAppend(os, (prefix + "-usec").c_str(),      ctrs.mTotalTime / 1000);
+        HBAppend(os, (prefix + "-max-usec").c_str(),
+            ctrs.mMaxTotalTime / 1000);
+        HBAppend(os, (prefix + "-deadline").c_str(),  ctrs.mDeadlineCount);
+        HBAppend(os, (prefix + "-deadline-miss").c_str(),
+            ctrs.mDeadlineMissCount);
+    }
+
+    const int numaNodeCount = DiskIo::GetNumaNodeCount();
+    HBAppend(os, "Numa-nodes", numaNodeCount);
+    for (int i = 0; i < numaNodeCount; i++) {
+        DiskIo::NumaNodeCounters        dnc;
+        ClientManager::NumaNodeCounters cnc;
+        DiskIo::GetNumaNodeCounters(i, dnc);
+        gClientManager.GetNumaNodeCounters(i, cnc);
+        string prefix("Numa-");
+        AppendDecIntToString(prefix, i);
+        HBAppend(os, (prefix + "-buffers").c_str(),       dnc.mBufferCount);
+        HBAppend(os, (prefix + "-buffers-free").c_str(),  dnc.mFreeBufferCount);
+        HBAppend(os, (prefix + "-buffers-local").c_str(),
+            dnc.mLocalBufferGetCount);
+        HBAppend(os, (prefix + "-buffers-remote").c_str(),
+            dnc.mRemoteBufferGetCount);
+        HBAppend(os, (prefix + "-disk-queues").c_str(),   dnc.mDiskQueueCount);
+        HBAppend(os, (prefix + "-client-threads").c_str(), cnc.mThreadCount);
+        HBAppend(os, (prefix + "-client-accept").c_str(), cnc.mAcceptCount);
+    }
 
     MsgLogger::Counters msgLogCntrs;
     MsgLogger::GetLogger()->GetCounters(msgLogCntrs);
@@ -1936,6 +2061,9 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Msg-log-write-errors",     msgLogCntrs.mWriteErrorCount);
     HBAppend(os, "Msg-log-wait",             msgLogCntrs.mAppendWaitCount);
     HBAppend(os, "Msg-log-waited-micro-sec", msgLogCntrs.mAppendWaitMicroSecs);
+    HBAppend(os, "Msg-log-async-count",      msgLogCntrs.mAsyncAppendCount);
+    HBAppend(os, "Msg-log-async-drop",       msgLogCntrs.mAsyncDroppedCount);
+    HBAppend(os, "Msg-log-async-wait",       msgLogCntrs.mAsyncWaitCount);
 
     Replicator::Counters replCntrs;
     Replicator::GetCounters(replCntrs);
@@ -2451,7 +2579,12 @@ WritePrepareOp::Execute()
     if (! gChunkManager.IsValidWriteId(writeId)) {
         statusMsg = "invalid write id";
         status = -EINVAL;
-        Submit();
+        if (writeFwdOp) {
+            // Cut-through forwarding is in flight, wait for its completion.
+            Done(EVENT_CMD_DONE, this);
+        } else {
+            Submit();
+        }
         return;
     }
 
@@ -2509,7 +2642,7 @@ WritePrepareOp::Execute()
         return;
     }
 
-    if (needToForward) {
+    if (needToForward && ! writeFwdOp) {
         ForwardToPeer(peerLoc, writeMaster, allowCSClearTextFlag);
         if (status < 0) {
             // can't forward to peer...so fail the write
@@ -2523,6 +2656,7 @@ WritePrepareOp::Execute()
     writeOp->dataBuf.Move(&dataBuf);
     writeOp->wpop = this;
     writeOp->checksums.swap(blocksChecksums);
+    writeOp->traceId = traceId;
 
     writeOp->enqueueTime = globalNetManager().Now();
 
@@ -2569,6 +2703,53 @@ WritePrepareOp::ForwardToPeer(
     peer->Enqueue(writeFwdOp);
 }
 
+bool
+WritePrepareOp::StartCutThroughForward(RemoteSyncSMPtr& peer)
+{
+    if (status < 0 || writeFwdOp || ! GetClientSM()) {
+        return false;
+    }
+    ServerLocation peerLoc;
+    int            myPos = -1;
+    if (! needToForwardToPeer(shortRpcFormatFlag,
+                servers, numServers, myPos, peerLoc, true, writeId) ||
+            myPos < 0 ||
+            (chunkAccessTokenValidFlag &&
+                (chunkAccessFlags & ChunkAccessToken::kUsesWriteIdFlag) != 0 &&
+                subjectId != writeId) ||
+            ! gChunkManager.IsValidWriteId(writeId)) {
+        return false;
+    }
+    const bool writeMaster          = myPos == 0;
+    bool       allowCSClearTextFlag = chunkAccessTokenValidFlag &&
+        (chunkAccessFlags & ChunkAccessToken::kAllowClearTextFlag) != 0;
+    if (writeMaster && ! gLeaseClerk.IsLeaseValid(
+            chunkId, chunkVersion,
+            &syncReplicationAccess, &allowCSClearTextFlag)) {
+        return false;
+    }
+    peer = FindPeer(*this, peerLoc, writeMaster, allowCSClearTextFlag);
+    if (! peer) {
+        // Let Execute() report the error.
+        status = 0;
+        statusMsg.clear();
+        return false;
+    }
+    writeFwdOp = new WritePrepareFwdOp(*this);
+    writeFwdOp->clnt = this;
+    if (! peer->StartCutThrough(*writeFwdOp)) {
+        delete writeFwdOp;
+        writeFwdOp = 0;
+        peer.reset();
+        return false;
+    }
+    KFS_LOG_STREAM_DEBUG <<
+        "cut-through forwarding to: " << peerLoc <<
+        " " << Show() <<
+    KFS_LOG_EOM;
+    return true;
+}
+
 int
 WritePrepareOp::Done(int code, void* data)
 {
@@ -2639,6 +2820,7 @@ WriteSyncOp::Execute()
         return;
     }
 
+    writeOp->traceId     = traceId;
     writeOp->enqueueTime = globalNetManager().Now();
 
     if (writeOp->status < 0) {
@@ -3193,6 +3375,10 @@ OkHeader(const KfsOp* op, ReqOstream& os, bool checkStatus = true)
     os << (op->shortRpcFormatFlag ? "c:" : "Cseq: ") << op->seq << "\r\n";
     os << (op->shortRpcFormatFlag ? "s:" : "Status: ") <<
         (op->status >= 0 ? op->status : -SysToKfsErrno(-op->status)) << "\r\n";
+    if (op->binaryRpcFlag && op->shortRpcFormatFlag) {
+        // Let the client know that binary rpc frames are accepted.
+        os << "BR:1\r\n";
+    }
     if (! op->statusMsg.empty()) {
         if (op->statusMsg.find('\r') != string::npos ||
                 op->statusMsg.find('\n') != string::npos) {
@@ -3246,6 +3432,10 @@ SizeOp::Response(ReqOstream& os)
         os << (shortRpcFormatFlag ? "SC:" : "Stable-flag: ") <<
             (stableFlag ? 1 : 0) << "\r\n";
     }
+    if (kKfsSTierUndef != storageTier) {
+        os << (shortRpcFormatFlag ? "ST:" : "Storage-tier: ") <<
+            (int)storageTier << "\r\n";
+    }
     os << (shortRpcFormatFlag ? "S:" : "Size: ") << size << "\r\n\r\n";
 }
 
@@ -3356,6 +3546,14 @@ RecordAppendOp::Request(ReqOstream& os)
     (shortRpcFormatFlag ? "M:"  : "Master-committed: ") <<
         masterCommittedOffset << "\r\n"
     ;
+    if (0 < groupRecordCount) {
+        os <<
+        (shortRpcFormatFlag ? "GC:" : "Group-count: ")   << groupRecordCount <<
+            "\r\n" <<
+        (shortRpcFormatFlag ? "GR:" : "Group-records: ") << groupRecords <<
+            "\r\n"
+        ;
+    }
     WriteServers(os, *this);
     WriteSyncReplicationAccess(syncReplicationAccess, os, shortRpcFormatFlag,
         shortRpcFormatFlag ? "AF:" : "Access-fwd-length: ");
@@ -3519,6 +3717,9 @@ ReadOp::Request(ReqOstream& os)
     if (skipVerifyDiskChecksumFlag) {
         os << (shortRpcFormatFlag ? "KS:1\r\n" : "Skip-Disk-Chksum: 1\r\n");
     }
+    if (backgroundIoFlag) {
+        os << (shortRpcFormatFlag ? "BI:1\r\n" : "Background-io: 1\r\n");
+    }
     if (requestChunkAccess) {
         os << (shortRpcFormatFlag ? "C:" : "C-access: ") <<
             requestChunkAccess << "\r\n";
@@ -3565,6 +3766,9 @@ WritePrepareFwdOp::Request(ReqOstream& os)
     if (! shortRpcFormatFlag) {
         os << "Version: "       << KFS_VERSION_STR << "\r\n";
     }
+    if (traceId != 0) {
+        os << (shortRpcFormatFlag ? "TD:" : "Trace-id: ") << traceId << "\r\n";
+    }
     os <<
     (shortRpcFormatFlag ? "H:"  : "Chunk-handle: ")  <<
         owner.chunkId      << "\r\n" <<
@@ -3653,6 +3857,10 @@ ReplicateChunkOp::Response(ReqOstream& os)
         os << (shortRpcFormatFlag ? "IS:" : "Invalid-stripes: ") <<
             invalidStripeIdx << "\r\n";
     }
+    if (kKfsSTierUndef != storageTier) {
+        os << (shortRpcFormatFlag ? "ST:" : "Storage-tier: ") <<
+            (int)storageTier << "\r\n";
+    }
     os << "\r\n";
 }
 
@@ -4111,6 +4319,9 @@ HelloMetaOp::Request(ReqOstream& os, IOBuffer& buf)
     if (supportsResumeFlag) {
         os << (shortRpcFormatFlag ?  "SR:1" : "SupportsResume: 1") << "\r\n";
     }
+    if (deltaVarIntFlag) {
+        os << (shortRpcFormatFlag ?  "CF:1" : "Content-fmt: 1") << "\r\n";
+    }
     os << (shortRpcFormatFlag ? "TC:" : "Total-chunks: ") <<
         totalChunks << "\r\n";
     int64_t contentLength = 1;
@@ -4180,6 +4391,37 @@ HelloMetaOp::ParseResponseContent(istream& is, int len)
     return true;
 }
 
+// Delta varint chunk list format: the list is sorted by chunk id, every entry
+// is encoded as chunk id delta relative to the previous entry (the first entry
+// is relative to 0), followed by the chunk version, unless the list contains
+// only chunk ids. Sorting makes the deltas small, and with the dense chunk id
+// space the majority of the entries fit into 3-4 bytes, instead of ~20 bytes
+// in hex text format. Sorted order also allows the meta server to decode the
+// list as the bytes arrive.
+void
+HelloMetaOp::EncodeDeltaVarInt(HelloMetaOp::ChunkList& list, bool idOnlyFlag)
+{
+    if (list.entries.empty()) {
+        return;
+    }
+    sort(list.entries.begin(), list.entries.end());
+    IOBufferWriter writer(list.ioBuf);
+    char           buf[2 * VarIntCodec::kMaxEncodedLength];
+    kfsChunkId_t   prev = 0;
+    for (ChunkIdVersions::const_iterator it = list.entries.begin();
+            it != list.entries.end();
+            ++it) {
+        char* ptr = VarIntCodec::Encode((uint64_t)(it->first - prev), buf);
+        if (! idOnlyFlag) {
+            ptr = VarIntCodec::Encode((uint64_t)it->second, ptr);
+        }
+        writer.Write(buf, ptr - buf);
+        prev = it->first;
+    }
+    writer.Close();
+    ChunkIdVersions().swap(list.entries);
+}
+
 void
 SetProperties::Request(ReqOstream& os)
 {
@@ -4247,13 +4489,20 @@ HelloMetaOp::Execute()
     totalFsSpace = 0;
     statusMsg.clear();
     lostChunkDirs.clear();
+    // Binary format has no room for file ids, and is only used with no fids.
+    deltaVarIntFlag = deltaVarIntFlag && noFidsFlag;
     IOBuffer::WOStream            streams[kChunkListCount];
     ChunkManager::HostedChunkList lists[kChunkListCount];
     for (int i = 0; i < kChunkListCount; i++) {
         chunkLists[i].count = 0;
         chunkLists[i].ioBuf.Clear();
-        lists[i].first  = &(chunkLists[i].count);
-        lists[i].second = &(streams[i].Set(chunkLists[i].ioBuf) << hex);
+        chunkLists[i].entries.clear();
+        if (deltaVarIntFlag) {
+            lists[i].Set(chunkLists[i].count, 0, &chunkLists[i].entries);
+        } else {
+            lists[i].Set(chunkLists[i].count,
+                &(streams[i].Set(chunkLists[i].ioBuf) << hex), 0);
+        }
     }
     if (resumeStep < 0) {
         gChunkManager.GetHostedChunks(
@@ -4279,8 +4528,13 @@ HelloMetaOp::Execute()
         }
     }
     for (int i = 0; i < kChunkListCount; i++) {
-        lists[i].second->flush();
-        streams[i].Reset();
+        if (deltaVarIntFlag) {
+            EncodeDeltaVarInt(chunkLists[i],
+                kMissingList == i || kPendingStaleList == i);
+        } else {
+            streams[i].flush();
+            streams[i].Reset();
+        }
         if (chunkLists[i].count <= 0) {
             chunkLists[i].ioBuf.Clear();
         }
@@ -289,6 +289,8 @@ struct KfsOp : public KfsCallbackObj
     bool            shortRpcFormatFlag:1;
     bool            initialShortRpcFormatFlag:1;
     int64_t         maxWaitMillisec;
+    int64_t         traceId; // request trace id, 0 if not traced
+    bool            binaryRpcFlag; // client can send binary rpc frames
     string          statusMsg; // output, optional, mostly for debugging
     KfsCallbackObj* clnt;
     uint64_t        generation;
@@ -365,6 +367,8 @@ struct KfsOp : public KfsCallbackObj
         return parser
         .Def2("Cseq",       "c", &KfsOp::seq,            kfsSeq_t(-1))
         .Def2("Max-wait-ms","w", &KfsOp::maxWaitMillisec, int64_t(-1))
+        .Def2("Trace-id",   "TD", &KfsOp::traceId,        int64_t(0))
+        .Def2("Binary-rpc", "BR", &KfsOp::binaryRpcFlag,  false)
         ;
     }
     static inline BufferManager* GetDeviceBufferManagerSelf(
@@ -796,6 +800,7 @@ struct ReplicateChunkOp : public KfsOp {
     int32_t         stripeSize;
     kfsSTier_t      minStorageTier;
     kfsSTier_t      maxStorageTier;
+    kfsSTier_t      storageTier; // output: replica storage tier
     string          pathName;
     string          invalidStripeIdx;
     int             metaPort;
@@ -820,6 +825,7 @@ struct ReplicateChunkOp : public KfsOp {
         stripeSize(0),
         minStorageTier(kKfsSTierUndef),
         maxStorageTier(kKfsSTierUndef),
+        storageTier(kKfsSTierUndef),
         pathName(),
         invalidStripeIdx(),
         metaPort(-1),
@@ -1124,6 +1130,14 @@ struct RecordAppendOp : public ChunkAccessRequestOp {
     kfsSeq_t        origSeq;
     time_t          replicationStartTime;
     BufferManager*  devBufMgr;
+    /*
+     * group commit: number of records, and "client-seq num-bytes write-ids"
+     * of each record coalesced by the chain master into this op.
+     */
+    int             groupRecordCount;
+    string          groupRecords;
+    /* group commit: next group member on the chain master */
+    RecordAppendOp* groupNext;
     RecordAppendOp* mPrevPtr[1];
     RecordAppendOp* mNextPtr[1];
 
@@ -1166,6 +1180,8 @@ struct RecordAppendOp : public ChunkAccessRequestOp {
         .Def2("Master-committed",  "M",  &RecordAppendOp::masterCommittedOffset, int64_t(-1))
         .Def2("Access-fwd-length", "AF", &RecordAppendOp::accessFwdLength, 0)
         .Def2("C-access-length",   "AL", &RecordAppendOp::chunkAccessLength)
+        .Def2("Group-count",       "GC", &RecordAppendOp::groupRecordCount, 0)
+        .Def2("Group-records",     "GR", &RecordAppendOp::groupRecords)
         ;
     }
 };
@@ -1413,6 +1429,10 @@ struct WritePrepareOp : public ChunkAccessRequestOp {
         const ServerLocation& loc,
         bool                  wrtieMasterFlag,
         bool                  allowCSClearTextFlag);
+    // Starts forwarding to the next server in the chain before the data is
+    // fully received. Returns false if the forwarding cannot be started, in
+    // which case Execute() forwards the data the normal way.
+    bool StartCutThroughForward(RemoteSyncSMPtr& peer);
     int Done(int code, void* data);
     virtual BufferManager* GetDeviceBufferManager(
         bool findFlag, bool resetFlag)
@@ -1448,13 +1468,18 @@ struct WritePrepareOp : public ChunkAccessRequestOp {
 
 struct WritePrepareFwdOp : public KfsOp {
     const WritePrepareOp& owner;
+    // Number of data bytes sent with cut-through forwarding, or -1 if the
+    // data is sent all at once.
+    int                   cutThroughByteCount;
 
     WritePrepareFwdOp(WritePrepareOp& o)
         : KfsOp(CMD_WRITE_PREPARE_FWD),
-          owner(o)
+          owner(o),
+          cutThroughByteCount(-1)
     {
         shortRpcFormatFlag        = o.shortRpcFormatFlag;
         initialShortRpcFormatFlag = o.initialShortRpcFormatFlag;
+        traceId                   = o.traceId;
     }
     void Request(ReqOstream& os);
     // nothing to do...we send the data to peer and wait. have a
@@ -1708,6 +1733,8 @@ struct ReadOp : public KfsClientChunkOp {
     int64_t          diskIOTime; /* how long did the AIOs take */
     int              retryCnt;
     bool             skipVerifyDiskChecksumFlag;
+    bool             backgroundIoFlag; /* replication or recovery read */
+    bool             blockCacheHitFlag; /* served from the block cache */
     const char*      requestChunkAccess;
     /*
      * for writes that require the associated checksum block to be
@@ -1729,6 +1756,8 @@ struct ReadOp : public KfsClientChunkOp {
           diskIOTime(0),
           retryCnt(0),
           skipVerifyDiskChecksumFlag(false),
+          backgroundIoFlag(false),
+          blockCacheHitFlag(false),
           requestChunkAccess(0),
           wop(0),
           scrubOp(0),
@@ -1745,6 +1774,8 @@ struct ReadOp : public KfsClientChunkOp {
           diskIOTime(0),
           retryCnt(0),
           skipVerifyDiskChecksumFlag(false),
+          backgroundIoFlag(false),
+          blockCacheHitFlag(false),
           requestChunkAccess(0),
           wop(w),
           scrubOp(0),
@@ -1787,7 +1818,8 @@ struct ReadOp : public KfsClientChunkOp {
             " version: "  << chunkVersion <<
             " offset: "   << offset <<
             " numBytes: " << numBytes <<
-            (skipVerifyDiskChecksumFlag ? " skip-disk-chksum" : "")
+            (skipVerifyDiskChecksumFlag ? " skip-disk-chksum" : "") <<
+            (backgroundIoFlag ? " background" : "")
         ;
     }
     virtual bool IsChunkReadOp(int64_t& outNumBytes, kfsChunkId_t& outChunkId);
@@ -1814,6 +1846,7 @@ struct ReadOp : public KfsClientChunkOp {
         .Def2("Offset",           "O",  &ReadOp::offset)
         .Def2("Num-bytes",        "B",  &ReadOp::numBytes)
         .Def2("Skip-Disk-Chksum", "KS", &ReadOp::skipVerifyDiskChecksumFlag, false)
+        .Def2("Background-io",    "BI", &ReadOp::backgroundIoFlag,           false)
         ;
     }
 };
@@ -1824,12 +1857,14 @@ struct SizeOp : public KfsClientChunkOp {
     int64_t     size; /* result */
     bool        checkFlag;
     bool        stableFlag;
+    kfsSTier_t  storageTier; /* result: chunk directory storage tier */
     SizeOp()
         : KfsClientChunkOp(CMD_SIZE),
           fileId(-1),
           size(-1),
           checkFlag(false),
-          stableFlag(false)
+          stableFlag(false),
+          storageTier(kKfsSTierUndef)
         { SET_HANDLER(this, &SizeOp::HandleChunkMetaReadDone); }
 
     void Request(ReqOstream& os);
@@ -2204,15 +2239,18 @@ struct LeaseRelinquishOp : public KfsOp {
 
 // This is just a helper op for building a hello request to the metaserver.
 struct HelloMetaOp : public KfsOp {
-    typedef vector<string>       LostChunkDirs;
-    typedef vector<kfsChunkId_t> ChunkIds;
+    typedef vector<string>                       LostChunkDirs;
+    typedef vector<kfsChunkId_t>                 ChunkIds;
+    typedef vector<pair<kfsChunkId_t, kfsSeq_t> > ChunkIdVersions;
     struct ChunkList
     {
-        int64_t  count;
-        IOBuffer ioBuf;
+        int64_t         count;
+        IOBuffer        ioBuf;
+        ChunkIdVersions entries;
         ChunkList()
             : count(0),
-              ioBuf()
+              ioBuf(),
+              entries()
             {}
     };
     enum
@@ -2256,6 +2294,7 @@ struct HelloMetaOp : public KfsOp {
     int64_t                  totalChunks;
     int64_t                  channelId;
     bool                     supportsResumeFlag;
+    bool                     deltaVarIntFlag;
 
     HelloMetaOp(const ServerLocation& l,
             const string& k, const string& m, int r, int64_t chanId)
@@ -2290,7 +2329,8 @@ struct HelloMetaOp : public KfsOp {
           helloResumeFailedCount(0),
           totalChunks(0),
           channelId(chanId),
-          supportsResumeFlag(false)
+          supportsResumeFlag(false),
+          deltaVarIntFlag(false)
         {}
     void Execute();
     void Request(ReqOstream& os, IOBuffer& buf);
@@ -2315,10 +2355,13 @@ struct HelloMetaOp : public KfsOp {
             " delete flag: "  << deleteAllChunksFlag <<
             " total chunks: " << totalChunks <<
             " resume: "       << resumeStep <<
-            " channel: "      << channelId
+            " channel: "      << channelId <<
+            " delta varint: " << deltaVarIntFlag
         ;
     }
     virtual bool ParseResponseContent(istream& is, int len);
+private:
+    void EncodeDeltaVarInt(ChunkList& list, bool idOnlyFlag);
 };
 
 struct CorruptChunkOp : public KfsOp {
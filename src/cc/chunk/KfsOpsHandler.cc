@@ -24,6 +24,7 @@
 
 #include "KfsOps.h"
 #include "common/RequestParser.h"
+#include "common/BinaryRpc.h"
 
 namespace KFS
 {
@@ -185,6 +186,16 @@ ParseCommand(const TS& shortRequestHandlers, const T& requestHandlers,
     if (reqLen != len) {
         return -1;
     }
+    if (BinaryRpc::IsFrame(buf, reqLen)) {
+        // Binary frames use short field names, and the responses are sent
+        // in short format.
+        if (ioRpcFormat == kRpcFormatLong ||
+                ! (*res = shortRequestHandlers.HandleBinary(buf, reqLen))) {
+            return -1;
+        }
+        ioRpcFormat = kRpcFormatShort;
+        return 0;
+    }
     if (ioRpcFormat != kRpcFormatLong) {
         *res = shortRequestHandlers.Handle(buf, reqLen);
         if (*res) {
@@ -223,6 +223,7 @@ private:
     kfsKeyId_t                    mCurrentKeyId;
     bool                          mUpdateCurrentKeyFlag;
     bool                          mNoFidsFlag;
+    bool                          mHelloDeltaVarIntFlag;
     int                           mHelloResume;
     KfsOp*                        mOp;
     bool                          mRequestFlag;
@@ -400,6 +401,7 @@ MetaServerSM::Impl::Impl(
       mCurrentKeyId(),
       mUpdateCurrentKeyFlag(false),
       mNoFidsFlag(true),
+      mHelloDeltaVarIntFlag(false),
       mHelloResume(-1),
       mOp(0),
       mRequestFlag(false),
@@ -525,6 +527,9 @@ MetaServerSM::Impl::SetParameters(const Properties& prop)
         mAbortOnRequestParseErrorFlag ? 1 : 0) != 0;
     mNoFidsFlag                   = prop.getValue(
         "chunkServer.meta.noFids",            mNoFidsFlag ? 1 : 0) != 0;
+    mHelloDeltaVarIntFlag         = prop.getValue(
+        "chunkServer.meta.helloDeltaVarInt",
+        mHelloDeltaVarIntFlag ? 1 : 0) != 0;
     mHelloResume                  = prop.getValue(
         "chunkServer.meta.helloResume",       mHelloResume);
     mTraceRequestResponseFlag = prop.getValue(
@@ -1787,6 +1792,7 @@ MetaServerSM::Impl::SubmitHello()
     mHelloOp->shortRpcFormatFlag = kRpcFormatShort == mRpcFormat;
     mHelloOp->reqShortRpcFmtFlag = kRpcFormatShort != mRpcFormat;
     mHelloOp->supportsResumeFlag = true;
+    mHelloOp->deltaVarIntFlag    = mHelloDeltaVarIntFlag;
     // Send the op and wait for the reply.
     KFS_LOG_STREAM_DEBUG <<
         mLocation << ": submit hello" <<
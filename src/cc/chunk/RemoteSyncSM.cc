@@ -321,7 +321,9 @@ RemoteSyncSM::RemoteSyncSM(
       mFinishRecursionCount(0),
       mDeletedFlagPtr(0),
       mOpResponseTimeoutSec(sOpResponseTimeoutSec),
-      mTraceRequestResponseFlag(sTraceRequestResponseFlag)
+      mTraceRequestResponseFlag(sTraceRequestResponseFlag),
+      mCutThroughOpPtr(0),
+      mCutThroughPendingOps()
 {
     QCASSERT(IsMutexOwner(GetMutexPtr()));
     SET_HANDLER(this, &RemoteSyncSM::HandleEvent);
@@ -339,6 +341,8 @@ RemoteSyncSM::~RemoteSyncSM()
             mFinishRecursionCount != 0 ||
             mNetConnection ||
             ! mDispatchedOps.empty() ||
+            mCutThroughOpPtr ||
+            ! mCutThroughPendingOps.empty() ||
             mList ||
             ! mDeleteFlag) {
         die("invalid remote sync destructor invocation");
@@ -446,6 +450,11 @@ RemoteSyncSM::EnqueueSelf(KfsOp* op)
         SubmitOpResponse(op);
         return false;
     }
+    if (mCutThroughOpPtr) {
+        // Do not interleave with the cut-through write data.
+        mCutThroughPendingOps.push_back(op);
+        return true;
+    }
     if (mNetConnection && ! mNetConnection->IsGood()) {
         SYNC_SM_LOG_STREAM_INFO <<
             "lost connection to peer, failing ops" <<
@@ -526,13 +535,18 @@ RemoteSyncSM::EnqueueSelf(KfsOp* op)
         // send the data as well
         WritePrepareFwdOp* const wpfo = static_cast<WritePrepareFwdOp*>(op);
         op->status = 0;
-        mNetConnection->WriteCopy(&wpfo->owner.dataBuf,
-            wpfo->owner.dataBuf.BytesConsumable());
+        if (0 <= wpfo->cutThroughByteCount) {
+            // The data will be sent by CutThroughWrite() as it arrives.
+            mCutThroughOpPtr = wpfo;
+        } else {
+            mNetConnection->WriteCopy(&wpfo->owner.dataBuf,
+                wpfo->owner.dataBuf.BytesConsumable());
+        }
         if (wpfo->owner.replyRequestedFlag) {
             if (! mDispatchedOps.insert(make_pair(op->seq, op)).second) {
                 die("duplicate seq. number");
             }
-        } else {
+        } else if (! mCutThroughOpPtr) {
             // fire'n'forget
             SubmitOpResponse(op);
         }
@@ -564,6 +578,112 @@ RemoteSyncSM::EnqueueSelf(KfsOp* op)
         mNetConnection && mNetConnection->IsGood());
 }
 
+// Helper functor that fails an op with an error code.
+class OpFailer
+{
+public:
+    OpFailer(int c)
+        : errCode(c)
+        {}
+    template <typename T>
+    void operator()(const T& val)
+        { (*this)(val.second); }
+    void operator()(KfsOp* op)
+    {
+        op->status = errCode;
+        SubmitOpResponse(op);
+    }
+private:
+    const int errCode;
+};
+
+bool
+RemoteSyncSM::StartCutThrough(WritePrepareFwdOp& op)
+{
+    QCASSERT(IsMutexOwner(GetMutexPtr()) && ! mDeleteFlag);
+
+    if (mCutThroughOpPtr || IsDispatchPending() || 0 < mFinishRecursionCount ||
+            op.cutThroughByteCount >= 0) {
+        return false;
+    }
+    op.cutThroughByteCount = 0;
+    EnqueueSelf(&op);
+    return true;
+}
+
+bool
+RemoteSyncSM::CutThroughWrite(
+    WritePrepareFwdOp& op,
+    const IOBuffer&    buf,
+    int                numBytes)
+{
+    QCASSERT(IsMutexOwner(GetMutexPtr()));
+
+    if (&op != mCutThroughOpPtr || ! mNetConnection) {
+        return false;
+    }
+    QCStDeleteNotifier const deleteNotifier(mDeletedFlagPtr);
+    const int len = min(numBytes, (int)op.owner.numBytes) -
+        op.cutThroughByteCount;
+    if (0 < len) {
+        IOBuffer data;
+        data.Copy(&buf, op.cutThroughByteCount + len);
+        data.Consume(op.cutThroughByteCount);
+        mNetConnection->Write(&data, len);
+        op.cutThroughByteCount += len;
+    }
+    if (op.cutThroughByteCount < (int)op.owner.numBytes) {
+        if (mRecursionCount <= 0 && ! IsClientThread()) {
+            mNetConnection->StartFlush();
+        }
+        return (! deleteNotifier.IsDeleted() && mCutThroughOpPtr == &op);
+    }
+    SYNC_SM_LOG_STREAM_DEBUG <<
+        "cut-through write done: " << op.Show() <<
+        " pending: " << mCutThroughPendingOps.size() <<
+    KFS_LOG_EOM;
+    mCutThroughOpPtr = 0;
+    if (! op.owner.replyRequestedFlag) {
+        // fire'n'forget
+        SubmitOpResponse(&op);
+        if (deleteNotifier.IsDeleted()) {
+            return false;
+        }
+    }
+    PendingOps ops;
+    ops.swap(mCutThroughPendingOps);
+    while (! ops.empty()) {
+        KfsOp* const pop = ops.front();
+        ops.pop_front();
+        EnqueueSelf(pop);
+        if (deleteNotifier.IsDeleted()) {
+            for_each(ops.begin(), ops.end(), OpFailer(-EHOSTUNREACH));
+            return false;
+        }
+    }
+    if (mRecursionCount <= 0 && mNetConnection && ! IsClientThread()) {
+        mNetConnection->StartFlush();
+    }
+    return true;
+}
+
+void
+RemoteSyncSM::CutThroughAbort(WritePrepareFwdOp& op)
+{
+    QCASSERT(IsMutexOwner(GetMutexPtr()));
+
+    if (&op != mCutThroughOpPtr) {
+        return;
+    }
+    SYNC_SM_LOG_STREAM_ERROR <<
+        "aborting cut-through write:"
+        " sent: " << op.cutThroughByteCount <<
+        " " << op.Show() <<
+    KFS_LOG_EOM;
+    // FailAllOps() fails the op.
+    ResetConnection();
+}
+
 int
 RemoteSyncSM::HandleEvent(int code, void *data)
 {
@@ -787,29 +907,19 @@ RemoteSyncSM::HandleResponse(IOBuffer& iobuf, int msgLen)
     return true;
 }
 
-// Helper functor that fails an op with an error code.
-class OpFailer
-{
-public:
-    OpFailer(int c)
-        : errCode(c)
-        {}
-    template <typename T>
-    void operator()(const T& val)
-    {
-        KfsOp* const op = val.second;
-        op->status = errCode;
-        SubmitOpResponse(op);
-    }
-private:
-    const int errCode;
-};
-
 void
 RemoteSyncSM::FailAllOps()
 {
     QCASSERT(IsMutexOwner(GetMutexPtr()));
 
+    WritePrepareFwdOp* const cutThroughOp = mCutThroughOpPtr;
+    mCutThroughOpPtr = 0;
+    PendingOps pendingOps;
+    pendingOps.swap(mCutThroughPendingOps);
+    if (cutThroughOp && ! cutThroughOp->owner.replyRequestedFlag) {
+        pendingOps.push_front(cutThroughOp);
+    }
+    for_each(pendingOps.begin(), pendingOps.end(), OpFailer(-EHOSTUNREACH));
     if (mDispatchedOps.empty()) {
         return;
     }
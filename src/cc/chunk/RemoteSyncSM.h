@@ -55,6 +55,7 @@ class RemoteSyncSMList;
 class ClientThread;
 class RemoteSyncSM;
 struct KfsOp;
+struct WritePrepareFwdOp;
 
 class ClientThreadRemoteSyncListEntry
 {
@@ -78,6 +79,8 @@ protected:
         { return (mClientThreadPtr != 0); }
     bool IsFinishPending() const
         { return mFinishFlag; }
+    bool IsDispatchPending() const
+        { return IsPending(); }
     class StMutexLocker;
     friend class StMutexLocker;
 private:
@@ -165,6 +168,23 @@ public:
         { return mShortRpcFormatFlag; }
     void Enqueue(
         KfsOp* op);
+    // Cut-through write forwarding. The write prepare header is sent
+    // immediately, and the data is sent with CutThroughWrite() as it arrives.
+    // Other ops are queued until all the data is sent, in order not to
+    // interleave those with the data. Must be invoked from the thread that
+    // owns the remote sync. Returns false if the op cannot be started now.
+    bool StartCutThrough(
+        WritePrepareFwdOp& op);
+    // Sends the data received so far. The buffer must start with the write
+    // data. Returns false if the op is no longer forwarded.
+    bool CutThroughWrite(
+        WritePrepareFwdOp& op,
+        const IOBuffer&    buf,
+        int                numBytes);
+    // The peer has partial data at this point, therefore the connection is
+    // closed in order to fail the op down the replication chain.
+    void CutThroughAbort(
+        WritePrepareFwdOp& op);
     void Finish();
     bool UpdateSession(
         const char* sessionTokenPtr,
@@ -183,6 +203,10 @@ private:
             std::pair<const kfsSeq_t, KfsOp*>
         >
     > DispatchedOps;
+    typedef list<
+        KfsOp*,
+        StdFastAllocator<KfsOp*>
+    > PendingOps;
     class Auth;
 
     NetConnectionPtr     mNetConnection;
@@ -213,6 +237,8 @@ private:
     bool*                mDeletedFlagPtr;
     const int            mOpResponseTimeoutSec;
     const bool           mTraceRequestResponseFlag;
+    WritePrepareFwdOp*   mCutThroughOpPtr;
+    PendingOps           mCutThroughPendingOps;
 
     static bool          sTraceRequestResponseFlag;
     static int           sOpResponseTimeoutSec;
@@ -276,6 +276,7 @@ ReplicatorImpl::ReplicatorImpl(ReplicateChunkOp* op, const RemoteSyncSMPtr& peer
         mChunkMetadataOp.requestChunkAccess = mReadOp.requestChunkAccess;
     }
     mReadOp.clnt = this;
+    mReadOp.backgroundIoFlag = true;
     mWriteOp.clnt = this;
     mChunkMetadataOp.clnt = this;
     mWriteOp.Reset();
@@ -679,6 +680,8 @@ ReplicatorImpl::HandleReplicationDone(int code, void* data)
     } else {
         const ChunkInfo_t* const ci = gChunkManager.GetChunkInfo(
             mChunkId, mChunkVersion);
+        mOwner->storageTier = gChunkManager.GetStorageTier(
+            mChunkId, mChunkVersion);
         KFS_LOG_STREAM_NOTICE << mOwner->Show() <<
             " chunk size: " << (ci ? ci->chunkSize : -1) <<
         KFS_LOG_EOM;
@@ -26,6 +26,7 @@
 
 #include "utils.h"
 
+#include "common/BinaryRpc.h"
 #include "common/MsgLogger.h"
 #include "kfsio/IOBuffer.h"
 #include "kfsio/CryptoKeys.h"
@@ -40,7 +41,8 @@ namespace KFS
 using std::string;
 
 ///
-/// Return true if there is a sequence of "\r\n\r\n".
+/// Return true if there is a sequence of "\r\n\r\n", or complete binary
+/// rpc frame.
 /// @param[in] iobuf: Buffer with data sent by the client
 /// @param[out] msgLen: string length of the command in the buffer
 /// @retval true if a command is present; false otherwise.
@@ -48,6 +50,19 @@ using std::string;
 bool
 IsMsgAvail(IOBuffer* iobuf, int* msgLen)
 {
+    char hdr[BinaryRpc::kHeaderSize];
+    if (iobuf->CopyOut(hdr, 1) == 1 && BinaryRpc::IsFrame(hdr, 1)) {
+        // Binary frame length is in the fixed header.
+        if (iobuf->CopyOut(hdr, sizeof(hdr)) < (int)sizeof(hdr)) {
+            return false;
+        }
+        const int len = BinaryRpc::GetFrameLength(hdr);
+        if (iobuf->BytesConsumable() < len) {
+            return false;
+        }
+        *msgLen = len;
+        return true;
+    }
     const int idx = iobuf->IndexOf(0, "\r\n\r\n");
     if (idx < 0) {
         return false;
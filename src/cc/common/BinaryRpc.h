@@ -0,0 +1,322 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file BinaryRpc.h
+// \brief Compact binary rpc request header framing.
+//
+// Binary request header is an alternative to the rfc822 style short format
+// request header. The field names are the same as the short rpc format field
+// names, therefore the same request parser definitions are used to parse both
+// formats. Integer values are sent as zig zag variable length integers, thus
+// the request parser does not have to tokenize header lines, and convert the
+// integer values from hex. All other values are sent as byte strings, and
+// parsed with the short rpc format value parser.
+//
+// Frame layout:
+//  fixed header: magic byte, format version byte, 16 bit big endian body
+//  length;
+//  body: varint request name length, request name, followed by the fields:
+//  varint (field name length << 1 | byte string value flag), field name,
+//  zig zag varint integer value, or varint value length followed by value
+//  bytes.
+// The magic byte has high bit set, and can not be the first byte of the text
+// rpc header.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_COMMON_BINARY_RPC_H
+#define KFS_COMMON_BINARY_RPC_H
+
+#include "VarIntCodec.h"
+#include "kfstypes.h"
+
+#include <string>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace KFS
+{
+using std::string;
+
+class BinaryRpc
+{
+public:
+    enum
+    {
+        kMagic         = 0xB7,
+        kVersion       = 1,
+        kHeaderSize    = 4,
+        kMaxBodyLength = 0xFFFF
+    };
+
+    static bool IsFrame(
+        const char* inPtr,
+        size_t      inLen)
+        { return (0 < inLen && (*inPtr & 0xFF) == kMagic); }
+    // Returns frame length including fixed header, or -1 if the buffer does
+    // not start with the binary frame. The buffer must contain at least
+    // kHeaderSize bytes.
+    static int GetFrameLength(
+        const char* inHeaderPtr)
+    {
+        if ((inHeaderPtr[0] & 0xFF) != kMagic) {
+            return -1;
+        }
+        return (kHeaderSize +
+            (((inHeaderPtr[2] & 0xFF) << 8) | (inHeaderPtr[3] & 0xFF)));
+    }
+    // Splits the frame into request name and fields.
+    static bool Parse(
+        const char*  inPtr,
+        size_t       inLen,
+        const char*& outNamePtr,
+        size_t&      outNameLen,
+        const char*& outFieldsPtr,
+        size_t&      outFieldsLen)
+    {
+        if (inLen < (size_t)kHeaderSize || (inPtr[1] & 0xFF) != kVersion ||
+                GetFrameLength(inPtr) != (int)inLen) {
+            return false;
+        }
+        const char* const theEndPtr = inPtr + inLen;
+        uint64_t          theLen    = 0;
+        const char* const thePtr    = VarIntCodec::Decode(
+            inPtr + kHeaderSize, theEndPtr, theLen);
+        if (! thePtr || theLen <= 0 ||
+                (uint64_t)(theEndPtr - thePtr) < theLen) {
+            return false;
+        }
+        outNamePtr   = thePtr;
+        outNameLen   = (size_t)theLen;
+        outFieldsPtr = thePtr + theLen;
+        outFieldsLen = (size_t)(theEndPtr - outFieldsPtr);
+        return true;
+    }
+private:
+    BinaryRpc();
+};
+
+class BinaryRpcTokenizer
+{
+public:
+    BinaryRpcTokenizer(
+        const char* inPtr,
+        size_t      inLen)
+        : mPtr(inPtr),
+          mEndPtr(inPtr + inLen),
+          mKeyPtr(0),
+          mKeyLen(0),
+          mValuePtr(0),
+          mValueLen(0),
+          mIntValue(0),
+          mIntFlag(false),
+          mErrorFlag(false)
+        {}
+    bool Next()
+    {
+        if (mEndPtr <= mPtr) {
+            return false;
+        }
+        uint64_t    theTag = 0;
+        const char* thePtr = VarIntCodec::Decode(mPtr, mEndPtr, theTag);
+        if (! thePtr || (uint64_t)(mEndPtr - thePtr) < (theTag >> 1) ||
+                (theTag >> 1) <= 0) {
+            return Error();
+        }
+        mKeyPtr  = thePtr;
+        mKeyLen  = (size_t)(theTag >> 1);
+        thePtr  += mKeyLen;
+        mIntFlag = (theTag & 1) == 0;
+        uint64_t theVal = 0;
+        if (! (thePtr = VarIntCodec::Decode(thePtr, mEndPtr, theVal))) {
+            return Error();
+        }
+        if (mIntFlag) {
+            mIntValue = VarIntCodec::ZigZagDecode(theVal);
+            mValuePtr = 0;
+            mValueLen = 0;
+        } else {
+            if ((uint64_t)(mEndPtr - thePtr) < theVal) {
+                return Error();
+            }
+            mIntValue = 0;
+            mValuePtr = thePtr;
+            mValueLen = (size_t)theVal;
+            thePtr += mValueLen;
+        }
+        mPtr = thePtr;
+        return true;
+    }
+    const char* GetKeyPtr() const
+        { return mKeyPtr; }
+    size_t GetKeyLen() const
+        { return mKeyLen; }
+    bool IsInt() const
+        { return mIntFlag; }
+    int64_t GetInt() const
+        { return mIntValue; }
+    const char* GetValuePtr() const
+        { return mValuePtr; }
+    size_t GetValueLen() const
+        { return mValueLen; }
+    bool IsError() const
+        { return mErrorFlag; }
+private:
+    const char*       mPtr;
+    const char* const mEndPtr;
+    const char*       mKeyPtr;
+    size_t            mKeyLen;
+    const char*       mValuePtr;
+    size_t            mValueLen;
+    int64_t           mIntValue;
+    bool              mIntFlag;
+    bool              mErrorFlag;
+
+    bool Error()
+    {
+        mErrorFlag = true;
+        mPtr       = mEndPtr;
+        return false;
+    }
+};
+
+class BinaryRpcWriter
+{
+public:
+    BinaryRpcWriter()
+        : mBuf()
+        {}
+    BinaryRpcWriter& Begin(
+        const char* inNamePtr)
+    {
+        mBuf.clear();
+        mBuf.append(BinaryRpc::kHeaderSize, char(0));
+        mBuf[0] = (char)BinaryRpc::kMagic;
+        mBuf[1] = (char)BinaryRpc::kVersion;
+        return AppendBytes(inNamePtr, strlen(inNamePtr));
+    }
+    template<typename T>
+    BinaryRpcWriter& AddInt(
+        const char* inKeyPtr,
+        T           inVal)
+    {
+        AppendKey(inKeyPtr, strlen(inKeyPtr), false);
+        return AppendVarInt(VarIntCodec::ZigZagEncode((int64_t)inVal));
+    }
+    BinaryRpcWriter& AddBytes(
+        const char* inKeyPtr,
+        const char* inValPtr,
+        size_t      inValLen)
+    {
+        AppendKey(inKeyPtr, strlen(inKeyPtr), true);
+        return AppendBytes(inValPtr, inValLen);
+    }
+    BinaryRpcWriter& AddBytes(
+        const char*   inKeyPtr,
+        const string& inVal)
+        { return AddBytes(inKeyPtr, inVal.data(), inVal.size()); }
+    // Adds pre-formatted "name:value\r\n" short format header lines as byte
+    // string fields.
+    BinaryRpcWriter& AddHeaders(
+        const string& inHeaders)
+    {
+        const char*       thePtr    = inHeaders.data();
+        const char* const theEndPtr = thePtr + inHeaders.size();
+        while (thePtr < theEndPtr) {
+            const char* theEolPtr = (const char*)memchr(
+                thePtr, '\n', theEndPtr - thePtr);
+            if (! theEolPtr) {
+                theEolPtr = theEndPtr;
+            }
+            const char* const theSepPtr = (const char*)memchr(
+                thePtr, ':', theEolPtr - thePtr);
+            if (theSepPtr && thePtr < theSepPtr) {
+                const char* theValPtr    = theSepPtr + 1;
+                const char* theValEndPtr = theEolPtr;
+                while (theValPtr < theValEndPtr && (*theValPtr & 0xFF) <= ' ') {
+                    ++theValPtr;
+                }
+                while (theValPtr < theValEndPtr &&
+                        (theValEndPtr[-1] & 0xFF) <= ' ') {
+                    --theValEndPtr;
+                }
+                AppendKey(thePtr, theSepPtr - thePtr, true);
+                AppendBytes(theValPtr, theValEndPtr - theValPtr);
+            }
+            thePtr = theEolPtr + 1;
+        }
+        return *this;
+    }
+    // Sets body length in the fixed header. Returns false if the frame
+    // exceeds max rpc header length.
+    bool End()
+    {
+        const size_t theLen = mBuf.size() - BinaryRpc::kHeaderSize;
+        if ((size_t)BinaryRpc::kMaxBodyLength < theLen ||
+                (size_t)MAX_RPC_HEADER_LEN < mBuf.size()) {
+            return false;
+        }
+        mBuf[2] = (char)(theLen >> 8);
+        mBuf[3] = (char)theLen;
+        return true;
+    }
+    const char* GetPtr() const
+        { return mBuf.data(); }
+    size_t GetSize() const
+        { return mBuf.size(); }
+private:
+    string mBuf;
+
+    BinaryRpcWriter& AppendVarInt(
+        uint64_t inVal)
+    {
+        char theBuf[VarIntCodec::kMaxEncodedLength];
+        mBuf.append(theBuf, VarIntCodec::Encode(inVal, theBuf) - theBuf);
+        return *this;
+    }
+    BinaryRpcWriter& AppendBytes(
+        const char* inPtr,
+        size_t      inLen)
+    {
+        AppendVarInt(inLen);
+        mBuf.append(inPtr, inLen);
+        return *this;
+    }
+    void AppendKey(
+        const char* inKeyPtr,
+        size_t      inKeyLen,
+        bool        inBytesFlag)
+    {
+        AppendVarInt(((uint64_t)inKeyLen << 1) | (inBytesFlag ? 1 : 0));
+        mBuf.append(inKeyPtr, inKeyLen);
+    }
+private:
+    BinaryRpcWriter(
+        const BinaryRpcWriter& inWriter);
+    BinaryRpcWriter& operator=(
+        const BinaryRpcWriter& inWriter);
+};
+
+}
+
+#endif /* KFS_COMMON_BINARY_RPC_H */
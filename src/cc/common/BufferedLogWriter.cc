@@ -26,6 +26,7 @@
 
 #include "BufferedLogWriter.h"
 #include "Properties.h"
+#include "kfsatomic.h"
 
 #include "qcdio/QCMutex.h"
 #include "qcdio/QCUtils.h"
@@ -45,6 +46,7 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <string.h>
+#include <pthread.h>
 
 #include <vector>
 #include <string>
@@ -65,6 +67,8 @@ using std::setw;
 using std::setfill;
 using std::streamsize;
 using std::vector;
+using std::pair;
+using std::make_pair;
 
 const char* const kBufferedLogWriter_LogLevels[] = {
     "FATAL",
@@ -84,6 +88,8 @@ const int     kLogWriterMinLogBufferSize             = 16 << 10;
 const int64_t kLogWirterDefaultTimeToKeepSecs        = 60 * 60 * 24 * 30;
 const int     kLogWriterDefaulOpenFlags              =
     O_CREAT | O_APPEND | O_WRONLY /* | O_SYNC */;
+const int     kLogWriterMinAsyncRingSize             = 64 << 10;
+const int     kLogWriterMaxMsgPrefixSize             = 512;
 
 class BufferedLogWriter::Impl : public QCRunnable
 {
@@ -157,7 +163,15 @@ public:
           mCpuAffinityIndex(-1),
           mMaxMsgStreamCount(256),
           mMsgStreamCount(0),
-          mMsgStreamHeadPtr(0)
+          mMsgStreamHeadPtr(0),
+          mAsyncRingSize(0),
+          mAsyncPollInterval(10000),
+          mThreadRingsHeadPtr(0),
+          mAsyncRetiredAppendCount(0),
+          mAsyncRetiredDroppedCount(0),
+          mAsyncRetiredWaitCount(0),
+          mSubsystemLogLevelsPtr(0),
+          mRetiredSubsystemLogLevels()
     {
         if (! mFileName.empty()) {
             mLogFileNamePrefixes.push_back(mFileName);
@@ -187,6 +201,19 @@ public:
     virtual ~Impl()
     {
         Impl::Stop();
+        while (mThreadRingsHeadPtr) {
+            ThreadRing& theRing = *mThreadRingsHeadPtr;
+            mThreadRingsHeadPtr = theRing.mNextPtr;
+            theRing.mOwnerPtr = 0;
+            theRing.Release();
+        }
+        delete mSubsystemLogLevelsPtr;
+        for (RetiredSubsystemLogLevels::const_iterator theIt =
+                mRetiredSubsystemLogLevels.begin();
+                theIt != mRetiredSubsystemLogLevels.end();
+                ++theIt) {
+            delete *theIt;
+        }
         delete [] mBuf0Ptr;
         while (mMsgStreamHeadPtr) {
             QCASSERT(mMsgStreamCount > 0);
@@ -295,7 +322,82 @@ public:
             delete thePtr;
             mMsgStreamCount--;
         }
-
+        // The ring size only applies to the rings created after the change,
+        // 0 turns off asynchronous mode for the subsequent messages.
+        const int theRingSize = inProps.getValue(
+            inPropsPrefix + "asyncRingSize", mAsyncRingSize);
+        if (theRingSize <= 0) {
+            mAsyncRingSize = 0;
+        } else {
+            mAsyncRingSize = kLogWriterMinAsyncRingSize;
+            while (mAsyncRingSize < theRingSize && mAsyncRingSize < (1 << 28)) {
+                mAsyncRingSize <<= 1;
+            }
+        }
+        mAsyncPollInterval = max(Time(1000), (Time)inProps.getValue(
+            inPropsPrefix + "asyncPollIntervalMicroSec",
+            (double)mAsyncPollInterval));
+    }
+    LogLevel SetSubsystemLogLevels(
+        string            inPropsPrefix,
+        const Properties& inProps)
+    {
+        Properties theProps;
+        const string thePrefix = inPropsPrefix + "logLevel.";
+        inProps.copyWithPrefix(thePrefix.c_str(), theProps);
+        SubsystemLogLevels* thePtr      = 0;
+        LogLevel            theMaxLevel = kLogLevelUndef;
+        for (Properties::iterator theIt = theProps.begin();
+                theIt != theProps.end();
+                ++theIt) {
+            const LogLevel theLevel = GetLogLevelId(theIt->second.GetPtr());
+            if (theLevel == kLogLevelUndef ||
+                    theIt->first.GetSize() <= thePrefix.size()) {
+                continue;
+            }
+            if (! thePtr) {
+                thePtr = new SubsystemLogLevels();
+            }
+            thePtr->push_back(make_pair(string(
+                theIt->first.GetPtr() + thePrefix.size(),
+                theIt->first.GetSize() - thePrefix.size()), theLevel));
+            theMaxLevel = max(theMaxLevel, theLevel);
+        }
+        QCStMutexLocker theLocker(mMutex);
+        if (! thePtr && ! mSubsystemLogLevelsPtr) {
+            return theMaxLevel;
+        }
+        // The lookup is performed without locking, keep the previous tables
+        // until the writer is destroyed.
+        if (mSubsystemLogLevelsPtr) {
+            mRetiredSubsystemLogLevels.push_back(
+                const_cast<SubsystemLogLevels*>(mSubsystemLogLevelsPtr));
+        }
+        mSubsystemLogLevelsPtr = thePtr;
+        return theMaxLevel;
+    }
+    bool IsSubsystemLogLevelEnabled(
+        LogLevel    inLogLevel,
+        const char* inSrcFileNamePtr) const
+    {
+        const SubsystemLogLevels* const theLevelsPtr = mSubsystemLogLevelsPtr;
+        if (! theLevelsPtr || ! inSrcFileNamePtr) {
+            return false;
+        }
+        const char* thePtr = strrchr(inSrcFileNamePtr, '/');
+        thePtr = thePtr ? thePtr + 1 : inSrcFileNamePtr;
+        const char* const theEndPtr = strchr(thePtr, '.');
+        const size_t      theLen    = theEndPtr ?
+            (size_t)(theEndPtr - thePtr) : strlen(thePtr);
+        for (SubsystemLogLevels::const_iterator theIt = theLevelsPtr->begin();
+                theIt != theLevelsPtr->end();
+                ++theIt) {
+            if (theIt->first.size() == theLen &&
+                    memcmp(theIt->first.data(), thePtr, theLen) == 0) {
+                return (inLogLevel <= theIt->second);
+            }
+        }
+        return false;
     }
     void Stop()
     {
@@ -453,6 +555,16 @@ public:
         outCounters.mWriteErrorCount     = mWriteErrCount;
         outCounters.mAppendWaitCount     = mBufWaitedCount;
         outCounters.mAppendWaitMicroSecs = mTotalLogWaitedTime;
+        outCounters.mAsyncAppendCount    = mAsyncRetiredAppendCount;
+        outCounters.mAsyncDroppedCount   = mAsyncRetiredDroppedCount;
+        outCounters.mAsyncWaitCount      = mAsyncRetiredWaitCount;
+        for (const ThreadRing* thePtr = mThreadRingsHeadPtr;
+                thePtr;
+                thePtr = thePtr->mNextPtr) {
+            outCounters.mAsyncAppendCount  += thePtr->mAppendCount;
+            outCounters.mAsyncDroppedCount += thePtr->mDroppedCount;
+            outCounters.mAsyncWaitCount    += thePtr->mWaitCount;
+        }
     }
     void PrepareToFork()
         { mMutex.Lock(); }
@@ -491,17 +603,20 @@ public:
     void AppendSelf(
         LogLevel    inLogLevel,
         const char* inStrPtr,
-        int         inStrLen)
+        int         inStrLen,
+        int64_t     inTimeMicroSec = -1)
     {
         static va_list theArgs; // dummy
-        AppendSelf(inLogLevel, 0, max(0, inStrLen), inStrPtr, theArgs);
+        AppendSelf(inLogLevel, 0, max(0, inStrLen), inStrPtr, theArgs,
+            inTimeMicroSec);
     }
     void AppendSelf(
         LogLevel    inLogLevel,
         Writer*     inWriterPtr,
         int         inStrLen,
         const char* inFmtStrPtr,
-        va_list     inArgs)
+        va_list     inArgs,
+        int64_t     inTimeMicroSec = -1)
     {
         mMsgAppendCount++;
 
@@ -519,6 +634,12 @@ public:
             kAvgPrefSize + (inWriterPtr ? inWriterPtr->GetMsgLength() : 0) +
             (inStrLen >= 0 ? inStrLen : kAvgMsgSize));
         Time       theTimeWaited      = 0;
+        if (0 <= inTimeMicroSec) {
+            // Asynchronous message time stamp.
+            theSec         = inTimeMicroSec / Seconds(1);
+            theMicroSec    = inTimeMicroSec % Seconds(1);
+            theGetTimeFlag = false;
+        }
         for (int i = 0; ; i++) {
             while (mCurPtr + theBufSize >= mEndPtr && ! FlushSelf()) {
                 if (theTimeWaited >= mMaxLogWaitTime || ! mRunFlag || i >= 4 ||
@@ -629,15 +750,16 @@ public:
         );
         for (; ;) {
             while (mRunFlag && ! mWritePtr) {
-                const QCMutex::Time theTimeoutNanoSecs = NanoSec(max(
-                    QCMutex::Time(10000),
-                    (QCMutex::Time)(mFlushInterval > 0 ?
-                        mFlushInterval / 2 : Time(500000))
-                ));
-                mWriteCond.Wait(mMutex, theTimeoutNanoSecs);
+                Time theTimeout = max(Time(10000), mFlushInterval > 0 ?
+                        mFlushInterval / 2 : Time(500000));
+                if (mThreadRingsHeadPtr) {
+                    theTimeout = min(theTimeout, mAsyncPollInterval);
+                }
+                mWriteCond.Wait(mMutex, NanoSec(theTimeout));
                 if (mWritePtr) {
                     break;
                 }
+                DrainThreadRings();
                 int64_t theSec      = 0;
                 int64_t theMicroSec = 0;
                 Now(theSec, theMicroSec);
@@ -651,8 +773,12 @@ public:
                 }
             }
             if (! mWritePtr && ! mRunFlag) {
-                QCASSERT(mBufWaitersCount <= 0);
-                break;
+                DrainThreadRings();
+                FlushSelf();
+                if (! mWritePtr) {
+                    QCASSERT(mBufWaitersCount <= 0);
+                    break;
+                }
             }
             if (mCloseFlag && mFd >= 0 && ! mFileName.empty()) {
                 const int theFd = mFd;
@@ -810,6 +936,19 @@ public:
             return *(new MsgStream(
                 inLogLevel, inDiscardFlag, inTeeStreamPtr));
         }
+        ThreadRing* const theRingPtr = 0 < mAsyncRingSize ?
+            GetThreadRing() : 0;
+        if (theRingPtr && ! theRingPtr->mStreamInUseFlag) {
+            theRingPtr->mStreamInUseFlag = true;
+            if (theRingPtr->mStreamPtr) {
+                theRingPtr->mStreamPtr->Clear(
+                    inLogLevel, inDiscardFlag, inTeeStreamPtr);
+            } else {
+                theRingPtr->mStreamPtr = new MsgStream(
+                    inLogLevel, inDiscardFlag, inTeeStreamPtr);
+            }
+            return *theRingPtr->mStreamPtr;
+        }
         QCStMutexLocker theLocker(mMutex);
         MsgStream* theRetPtr = mMsgStreamHeadPtr;
         if (theRetPtr) {
@@ -828,6 +967,27 @@ public:
         ostream& inStream)
     {
         MsgStream& theStream = static_cast<MsgStream&>(inStream);
+        ThreadRing* const theRingPtr = sThreadRingPtr;
+        if (theRingPtr && theRingPtr->mStreamPtr == &theStream) {
+            if (mRunFlag && ! theStream.IsDiscard()) {
+                int64_t theSec      = 0;
+                int64_t theMicroSec = 0;
+                Now(theSec, theMicroSec);
+                theRingPtr->Put(
+                    theStream.GetLogLevel(),
+                    Seconds(theSec) + theMicroSec,
+                    theStream.GetMsgPtr(),
+                    (size_t)theStream.GetMsgLength(),
+                    (size_t)mMaxAppendLength / 2,
+                    mMaxLogWaitTime,
+                    mWriteCond
+                );
+            }
+            theStream.ClearTeeStreamPtr();
+            theStream.tie(0);
+            theRingPtr->mStreamInUseFlag = false;
+            return;
+        }
         if (! mRunFlag) {
             delete &theStream;
             return;
@@ -955,6 +1115,158 @@ private:
         MsgStream& operator=(
             const MsgStream&);
     };
+    // Single producer, single consumer ring buffer of the messages appended
+    // by one thread. The producer owns the head, the writer thread owns the
+    // tail. The ring is referenced by the thread and by the writer, the last
+    // to release the reference deletes the ring.
+    class ThreadRing
+    {
+    public:
+        struct Header
+        {
+            int32_t mLength; // Negative -- skip to the beginning of the ring.
+            int32_t mLogLevel;
+            int64_t mTime;
+        };
+        enum { kAlign = sizeof(Header) };
+
+        Impl* volatile   mOwnerPtr;
+        ThreadRing*      mNextPtr;
+        volatile int64_t mAppendCount;
+        volatile int64_t mDroppedCount;
+        volatile int64_t mWaitCount;
+        int64_t          mReportedDroppedCount;
+        volatile bool    mThreadExitedFlag;
+        bool             mStreamInUseFlag;
+        MsgStream*       mStreamPtr;
+
+        ThreadRing(
+            Impl& inOwner,
+            int   inSize)
+            : mOwnerPtr(&inOwner),
+              mNextPtr(0),
+              mAppendCount(0),
+              mDroppedCount(0),
+              mWaitCount(0),
+              mReportedDroppedCount(0),
+              mThreadExitedFlag(false),
+              mStreamInUseFlag(false),
+              mStreamPtr(0),
+              mRefCount(2),
+              mHead(0),
+              mTail(0),
+              mSize(inSize),
+              mBufPtr(new char[inSize])
+            {}
+        void Release()
+        {
+            if (SyncAddAndFetch(mRefCount, -1) <= 0) {
+                delete this;
+            }
+        }
+        bool Put(
+            LogLevel    inLogLevel,
+            Time        inTime,
+            const char* inMsgPtr,
+            size_t      inLength,
+            size_t      inMaxLength,
+            Time        inMaxWaitTime,
+            QCCondVar&  inWriteCond)
+        {
+            const size_t  theLength   = min(inLength, min(inMaxLength,
+                (size_t)mSize / 2 - sizeof(Header)));
+            const size_t  theRecSize  = RecordSize(theLength);
+            const int64_t theHead     = mHead;
+            const size_t  thePos      = (size_t)(theHead & (mSize - 1));
+            const size_t  theTailRoom = mSize - thePos;
+            const size_t  theSize     = theRecSize <= theTailRoom ?
+                theRecSize : theTailRoom + theRecSize;
+            Time          theWaited   = 0;
+            while ((size_t)mSize <
+                    (size_t)(theHead - SyncAddAndFetch(mTail, int64_t(0))) +
+                    theSize) {
+                // Back pressure: wake up the writer, and wait up to the max
+                // log wait time.
+                inWriteCond.Notify();
+                if (inMaxWaitTime <= theWaited) {
+                    mDroppedCount++;
+                    return false;
+                }
+                if (theWaited <= 0) {
+                    mWaitCount++;
+                }
+                const Time kSleepMicroSec = 1000;
+                ::usleep(kSleepMicroSec);
+                theWaited += kSleepMicroSec;
+            }
+            char* thePtr = mBufPtr + thePos;
+            if (theTailRoom < theRecSize) {
+                reinterpret_cast<Header*>(thePtr)->mLength = -1;
+                thePtr = mBufPtr;
+            }
+            Header& theHeader = *reinterpret_cast<Header*>(thePtr);
+            theHeader.mLength   = (int32_t)theLength;
+            theHeader.mLogLevel = (int32_t)inLogLevel;
+            theHeader.mTime     = inTime;
+            memcpy(thePtr + sizeof(Header), inMsgPtr, theLength);
+            mAppendCount++;
+            // Atomic add is a full barrier, the record is visible to the
+            // writer before the head.
+            const int64_t theUsed =
+                SyncAddAndFetch(mHead, (int64_t)theSize) - mTail;
+            if ((int64_t)mSize / 2 < theUsed) {
+                inWriteCond.Notify();
+            }
+            return true;
+        }
+        const Header* Peek()
+        {
+            for (; ;) {
+                const int64_t theTail = mTail;
+                if (SyncAddAndFetch(mHead, int64_t(0)) <= theTail) {
+                    return 0;
+                }
+                const size_t thePos = (size_t)(theTail & (mSize - 1));
+                const Header* const thePtr =
+                    reinterpret_cast<const Header*>(mBufPtr + thePos);
+                if (0 <= thePtr->mLength) {
+                    return thePtr;
+                }
+                SyncAddAndFetch(mTail, (int64_t)(mSize - thePos));
+            }
+        }
+        void Consume(
+            const Header& inHeader)
+            { SyncAddAndFetch(mTail, (int64_t)RecordSize(inHeader.mLength)); }
+        static const char* GetMsgPtr(
+            const Header& inHeader)
+            { return reinterpret_cast<const char*>(&inHeader + 1); }
+    private:
+        volatile int     mRefCount;
+        volatile int64_t mHead;
+        volatile int64_t mTail;
+        const int        mSize;
+        char* const      mBufPtr;
+
+        ~ThreadRing()
+        {
+            delete mStreamPtr;
+            delete [] mBufPtr;
+        }
+        static size_t RecordSize(
+            size_t inLength)
+        {
+            return ((sizeof(Header) + inLength + kAlign - 1) /
+                kAlign * kAlign);
+        }
+    private:
+        ThreadRing(
+            const ThreadRing&);
+        ThreadRing& operator=(
+            const ThreadRing&);
+    };
+    typedef vector<pair<string, LogLevel> > SubsystemLogLevels;
+    typedef vector<SubsystemLogLevels*>     RetiredSubsystemLogLevels;
 
     QCMutex      mMutex;
     QCCondVar    mWriteCond;
@@ -1011,8 +1323,120 @@ private:
     int          mMaxMsgStreamCount;
     int          mMsgStreamCount;
     MsgStream*   mMsgStreamHeadPtr;
+    int          mAsyncRingSize;
+    Time         mAsyncPollInterval;
+    ThreadRing*  mThreadRingsHeadPtr;
+    Count        mAsyncRetiredAppendCount;
+    Count        mAsyncRetiredDroppedCount;
+    Count        mAsyncRetiredWaitCount;
+    SubsystemLogLevels* volatile mSubsystemLogLevelsPtr;
+    RetiredSubsystemLogLevels    mRetiredSubsystemLogLevels;
     char         mLogTimeStampPrefixStr[256];
 
+    static __thread ThreadRing* sThreadRingPtr;
+    static pthread_key_t        sThreadRingKey;
+    static pthread_once_t       sThreadRingKeyOnce;
+
+    static void CreateThreadRingKey()
+    {
+        const int theErr = pthread_key_create(&sThreadRingKey, &ThreadExit);
+        if (theErr) {
+            QCUtils::FatalError("pthread_key_create", theErr);
+        }
+    }
+    static void ThreadExit(
+        void* inRingPtr)
+    {
+        ThreadRing* const thePtr = reinterpret_cast<ThreadRing*>(inRingPtr);
+        if (thePtr == sThreadRingPtr) {
+            sThreadRingPtr = 0;
+        }
+        thePtr->mThreadExitedFlag = true;
+        thePtr->Release();
+    }
+    ThreadRing* GetThreadRing()
+    {
+        ThreadRing* thePtr = sThreadRingPtr;
+        if (thePtr) {
+            if (thePtr->mOwnerPtr == this) {
+                return thePtr;
+            }
+            if (thePtr->mOwnerPtr || thePtr->mStreamInUseFlag) {
+                // Owned by other writer, or the writer is being destroyed.
+                return 0;
+            }
+            // The previous writer has been destroyed.
+            sThreadRingPtr = 0;
+            pthread_setspecific(sThreadRingKey, 0);
+            thePtr->Release();
+        }
+        pthread_once(&sThreadRingKeyOnce, &CreateThreadRingKey);
+        thePtr = new ThreadRing(*this, mAsyncRingSize);
+        {
+            QCStMutexLocker theLocker(mMutex);
+            thePtr->mNextPtr    = mThreadRingsHeadPtr;
+            mThreadRingsHeadPtr = thePtr;
+        }
+        sThreadRingPtr = thePtr;
+        pthread_setspecific(sThreadRingKey, thePtr);
+        return thePtr;
+    }
+    // Merges the available thread rings messages in time stamp order into the
+    // write buffer. Invoked by the writer thread, stops if the write buffer is
+    // full and the write is in flight.
+    void DrainThreadRings()
+    {
+        QCASSERT(mMutex.IsOwned());
+        if (! mThreadRingsHeadPtr) {
+            return;
+        }
+        // The writer thread must not wait for its own write completion.
+        QCStValueChanger<Time> theChanger(mMaxLogWaitTime, 0);
+        for (; ;) {
+            ThreadRing*                 theMinRingPtr = 0;
+            const ThreadRing::Header*   theMinPtr     = 0;
+            ThreadRing**                thePrevPtr    = &mThreadRingsHeadPtr;
+            while (*thePrevPtr) {
+                ThreadRing& theRing = **thePrevPtr;
+                if (theRing.mReportedDroppedCount != theRing.mDroppedCount) {
+                    const int64_t theCount = theRing.mDroppedCount;
+                    mDroppedCount      +=
+                        theCount - theRing.mReportedDroppedCount;
+                    mTotalDroppedCount +=
+                        theCount - theRing.mReportedDroppedCount;
+                    theRing.mReportedDroppedCount = theCount;
+                }
+                const ThreadRing::Header* const thePtr = theRing.Peek();
+                if (thePtr) {
+                    if (! theMinPtr || thePtr->mTime < theMinPtr->mTime) {
+                        theMinPtr     = thePtr;
+                        theMinRingPtr = &theRing;
+                    }
+                } else if (theRing.mThreadExitedFlag) {
+                    *thePrevPtr = theRing.mNextPtr;
+                    mAsyncRetiredAppendCount  += theRing.mAppendCount;
+                    mAsyncRetiredDroppedCount += theRing.mDroppedCount;
+                    mAsyncRetiredWaitCount    += theRing.mWaitCount;
+                    theRing.Release();
+                    continue;
+                }
+                thePrevPtr = &theRing.mNextPtr;
+            }
+            if (! theMinPtr) {
+                break;
+            }
+            if (mEndPtr <= mCurPtr + kLogWriterMaxMsgPrefixSize +
+                        theMinPtr->mLength + 1 &&
+                    ! FlushSelf()) {
+                break;
+            }
+            AppendSelf((LogLevel)theMinPtr->mLogLevel,
+                ThreadRing::GetMsgPtr(*theMinPtr), theMinPtr->mLength,
+                theMinPtr->mTime);
+            theMinRingPtr->Consume(*theMinPtr);
+        }
+    }
+
     static inline Time Seconds(
         Time inSec)
         { return (inSec * 1000000); }
@@ -1343,6 +1767,11 @@ private:
         const Impl& inImpl);
 };
 
+__thread BufferedLogWriter::Impl::ThreadRing*
+    BufferedLogWriter::Impl::sThreadRingPtr = 0;
+pthread_key_t  BufferedLogWriter::Impl::sThreadRingKey;
+pthread_once_t BufferedLogWriter::Impl::sThreadRingKeyOnce = PTHREAD_ONCE_INIT;
+
 BufferedLogWriter::BufferedLogWriter(
     int                         inFd,
     const char*                 inFileNamePtr               /* = 0 */,
@@ -1358,6 +1787,7 @@ BufferedLogWriter::BufferedLogWriter(
     bool                        inUseGMTFlag                /* = false */,
     const char*                 inThreadNamePtr             /* = 0 */)
     : mLogLevel(inLogLevel),
+      mMaxSubsystemLogLevel(kLogLevelUndef),
       mImpl(*(new Impl(
         inFd,
         inFileNamePtr,
@@ -1391,6 +1821,16 @@ BufferedLogWriter::SetParameters(
     SetLogLevel(inProps.getValue(thePropsPrefix + "logLevel",
         Impl::GetLogLevelNamePtr(mLogLevel)
     ));
+    mMaxSubsystemLogLevel = mImpl.SetSubsystemLogLevels(
+        thePropsPrefix, inProps);
+}
+
+bool
+BufferedLogWriter::IsSubsystemLogLevelEnabled(
+    LogLevel    inLogLevel,
+    const char* inSrcFileNamePtr) const
+{
+    return mImpl.IsSubsystemLogLevelEnabled(inLogLevel, inSrcFileNamePtr);
 }
 
 bool
@@ -1549,11 +1989,12 @@ BufferedLogWriter::PutStream(
 
 ostream&
 BufferedLogWriter::GetStream(
-    LogLevel inLogLevel,
-    ostream* inTeeStreamPtr)
+    LogLevel    inLogLevel,
+    ostream*    inTeeStreamPtr,
+    const char* inSrcFileNamePtr)
 {
-    return mImpl.GetStream(
-        inLogLevel, mLogLevel < inLogLevel, inTeeStreamPtr);
+    return mImpl.GetStream(inLogLevel,
+        ! IsLogLevelEnabled(inLogLevel, inSrcFileNamePtr), inTeeStreamPtr);
 }
 
 void
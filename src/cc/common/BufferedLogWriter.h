@@ -46,6 +46,14 @@ class Properties;
 // need to prevent blocking on message log write with "bad" disks in the cases
 // where the disk becomes unavailable or just cannot keep up. Chunk and meta
 // servers message log writes are configured with 0 write wait time by default.
+// With asynchronous mode enabled, the stream messages are copied into the per
+// thread single producer single consumer ring buffer without acquiring the
+// writer mutex. The writer thread merges the messages from all thread rings
+// by time stamp, and formats the message prefix. The max wait applies to the
+// full ring buffer the same way as it does to the full write buffer.
+// The log level can be set per "subsystem", i.e. per source file name without
+// directory and extension, in order to enable debug messages only for the
+// specified source files.
 class BufferedLogWriter
 {
 public:
@@ -70,6 +78,9 @@ public:
         int64_t mWriteErrorCount;
         int64_t mAppendWaitCount;
         int64_t mAppendWaitMicroSecs;
+        int64_t mAsyncAppendCount;
+        int64_t mAsyncDroppedCount;
+        int64_t mAsyncWaitCount;
     };
     BufferedLogWriter(
         int         inFd                        = -1,
@@ -122,6 +133,15 @@ public:
     bool IsLogLevelEnabled(
         LogLevel inLogLevel) const
         { return (mLogLevel >= inLogLevel); }
+    bool IsLogLevelEnabled(
+        LogLevel    inLogLevel,
+        const char* inSrcFileNamePtr) const
+    {
+        return (mLogLevel >= inLogLevel || (
+            mMaxSubsystemLogLevel >= inLogLevel &&
+            IsSubsystemLogLevelEnabled(inLogLevel, inSrcFileNamePtr)
+        ));
+    }
     void Append(
         LogLevel    inLogLevel,
         const char* inFmtStrPtr,
@@ -142,8 +162,9 @@ public:
     void GetCounters(
         Counters& outCounters);
     ostream& GetStream(
-        LogLevel inLogLevel,
-        ostream* inTeeStreamPtr = 0);
+        LogLevel    inLogLevel,
+        ostream*    inTeeStreamPtr   = 0,
+        const char* inSrcFileNamePtr = 0);
     void PutStream(ostream& inStreamPtr);
     void ChildAtFork();
 
@@ -153,9 +174,11 @@ public:
         StStream(
             BufferedLogWriter& inLogWriter,
             LogLevel           inLogLevel,
-            ostream*           inTeeStreamPtr = 0)
+            ostream*           inTeeStreamPtr   = 0,
+            const char*        inSrcFileNamePtr = 0)
             : mLogWriter(inLogWriter),
-              mStream(inLogWriter.GetStream(inLogLevel, inTeeStreamPtr))
+              mStream(inLogWriter.GetStream(
+                inLogLevel, inTeeStreamPtr, inSrcFileNamePtr))
             {}
         ~StStream()
             { mLogWriter.PutStream(mStream); }
@@ -197,8 +220,13 @@ public:
 private:
     class Impl;
     volatile LogLevel mLogLevel;
+    volatile LogLevel mMaxSubsystemLogLevel;
     Impl&             mImpl;
 
+    bool IsSubsystemLogLevelEnabled(
+        LogLevel    inLogLevel,
+        const char* inSrcFileNamePtr) const;
+
 private:
     BufferedLogWriter(
         const BufferedLogWriter& inWriter);
@@ -0,0 +1,249 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+//
+// \file HierarchicalTimerWheel.h
+// \brief Multi level timer wheel with intrusive list entries.
+//
+// Each level has 2^SlotBitsT slots, a slot of the level N covers
+// 2^(N * SlotBitsT) timer ticks. The entries from the higher level slot are
+// re-distributed into the lower levels ("cascaded") when the current tick
+// reaches the slot start. With the expiration time stored in the entry,
+// schedule, re-schedule, and cancel are O(1), and each entry is moved at most
+// LevelCntT - 1 times before it expires, regardless of the timeout. Timeouts
+// beyond the wheel range of 2^(LevelCntT * SlotBitsT) ticks are kept in the
+// highest level, and re-distributed every time the wheel range passes.
+//
+// The list type is expected to have the same interface as QCDLListOp, the
+// same as TimerWheel, and the entry type must be derived from
+// HierarchicalTimerWheelEntry. Entries are removed from the timer by removing
+// them from the list.
+//
+//----------------------------------------------------------------------------
+
+#ifndef HIERARCHICAL_TIMER_WHEEL_H
+#define HIERARCHICAL_TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <assert.h>
+
+namespace KFS
+{
+
+template<
+    typename T,
+    typename ListT,
+    typename TimeT,
+    size_t   SlotBitsT,
+    size_t   LevelCntT,
+    size_t   TimerResolutionT
+> class HierarchicalTimerWheel;
+
+template<typename TimeT>
+class HierarchicalTimerWheelEntry
+{
+public:
+    HierarchicalTimerWheelEntry()
+        : mTimerWheelExpires()
+        {}
+    TimeT GetTimerWheelExpires() const
+        { return mTimerWheelExpires; }
+private:
+    TimeT mTimerWheelExpires;
+
+    template<typename, typename, typename, size_t, size_t, size_t>
+    friend class HierarchicalTimerWheel;
+};
+
+template<
+    typename T,
+    typename ListT,
+    typename TimeT,
+    size_t   SlotBitsT,
+    size_t   LevelCntT,
+    size_t   TimerResolutionT
+>
+class HierarchicalTimerWheel
+{
+public:
+    typedef HierarchicalTimerWheelEntry<TimeT> Entry;
+
+    HierarchicalTimerWheel(
+        TimeT inNextRunTime)
+        : mCurTick(0),
+          mNextRunTime(inNextRunTime),
+          mTmpList()
+        {}
+    void Schedule(
+        T&    inEntry,
+        TimeT inExpires)
+    {
+        static_cast<Entry&>(inEntry).mTimerWheelExpires = inExpires;
+        Place(inEntry);
+    }
+    static TimeT GetExpires(
+        const T& inEntry)
+        { return static_cast<const Entry&>(inEntry).mTimerWheelExpires; }
+    void SetNextRunTime(
+        TimeT inNextRunTime)
+        { mNextRunTime = inNextRunTime; }
+    TimeT GetNextRunTime() const
+        { return mNextRunTime; }
+    template<typename FT>
+    void Run(
+        TimeT inNow,
+        FT&   inFunctor)
+    {
+        RunCurrent(inFunctor);
+        if (inNow < mNextRunTime) {
+            return;
+        }
+        size_t theTickCnt = 1 +
+            (size_t)(inNow - mNextRunTime) / TimerResolutionT;
+        if (kTickRange <= theTickCnt) {
+            // Timer overrun longer than the wheel range: re-distribute all
+            // entries instead of traversing every tick.
+            mCurTick     += theTickCnt;
+            mNextRunTime += theTickCnt * TimerResolutionT;
+            for (size_t k = 0; k < LevelCntT; k++) {
+                for (size_t i = 0; i < kSlotCount; i++) {
+                    Cascade(mSlots[k][i]);
+                }
+            }
+            RunCurrent(inFunctor);
+            return;
+        }
+        while (0 < theTickCnt--) {
+            mCurTick++;
+            mNextRunTime += TimerResolutionT;
+            for (size_t k = 1; k < LevelCntT; k++) {
+                if ((mCurTick & ((size_t(1) << (k * SlotBitsT)) - 1)) != 0) {
+                    break;
+                }
+                Cascade(mSlots[k][
+                    (mCurTick >> (k * SlotBitsT)) & kSlotMask]);
+            }
+            RunCurrent(inFunctor);
+        }
+    }
+    template<typename FT>
+    void Apply(
+        FT& inFunctor) const
+        { ApplySelf(inFunctor, &mTmpList); }
+    template<typename FT>
+    void Apply(
+        FT& inFunctor)
+        { ApplySelf(inFunctor, &mTmpList); }
+private:
+    enum { kSlotCount = size_t(1) << SlotBitsT };
+    enum { kSlotMask  = kSlotCount - 1 };
+    enum { kTickRange = size_t(1) << (SlotBitsT * LevelCntT) };
+
+    size_t mCurTick;
+    TimeT  mNextRunTime;
+    T      mTmpList;
+    T      mSlots[LevelCntT][kSlotCount];
+
+    void Place(
+        T& inEntry)
+    {
+        // The current tick slot is traversed on every Run() invocation, and
+        // the slot N ticks ahead is traversed when the current time reaches
+        // mNextRunTime + (N - 1) * TimerResolutionT. Round up to ensure that
+        // the entry is never traversed before its expiration time.
+        const TimeT theExpires =
+            static_cast<const Entry&>(inEntry).mTimerWheelExpires;
+        const TimeT theCurTime = mNextRunTime - TimeT(TimerResolutionT);
+        size_t      theDelta;
+        if (theExpires <= theCurTime) {
+            theDelta = 0;
+        } else {
+            const TimeT theTicks = (theExpires - theCurTime +
+                TimeT(TimerResolutionT - 1)) / TimeT(TimerResolutionT);
+            theDelta = TimeT(kTickRange) <= theTicks ?
+                size_t(kTickRange) - 1 : (size_t)theTicks;
+        }
+        const size_t theTick  = mCurTick + theDelta;
+        size_t       theLevel = 0;
+        while ((theDelta >> ((theLevel + 1) * SlotBitsT)) != 0) {
+            theLevel++;
+        }
+        ListT::Insert(inEntry, mSlots[theLevel][
+            (theTick >> (theLevel * SlotBitsT)) & kSlotMask]);
+    }
+    void Cascade(
+        T& inSlot)
+    {
+        if (! ListT::IsInList(inSlot)) {
+            return;
+        }
+        ListT::Insert(mTmpList, inSlot);
+        ListT::Remove(inSlot);
+        while (ListT::IsInList(mTmpList)) {
+            Place(ListT::GetNext(mTmpList));
+        }
+    }
+    template<typename FT>
+    void RunCurrent(
+        FT& inFunctor)
+    {
+        T& theSlot = mSlots[0][mCurTick & kSlotMask];
+        if (! ListT::IsInList(theSlot)) {
+            return;
+        }
+        ListT::Insert(mTmpList, theSlot);
+        ListT::Remove(theSlot);
+        while (ListT::IsInList(mTmpList)) {
+            T& theCur = ListT::GetNext(mTmpList);
+            inFunctor(theCur);
+            if (&theCur == &ListT::GetNext(mTmpList)) {
+                assert(! "HierarchicalTimerWheel::Run: the element still"
+                    " the list.");
+                abort();
+            }
+        }
+    }
+    template<typename FT, typename ET>
+    void ApplySelf(
+        FT& inFunctor,
+        ET* /* inConstQualifiedElementTypePtr */) const
+    {
+        for (size_t k = 0; k < LevelCntT; k++) {
+            for (size_t i = 0; i < kSlotCount; i++) {
+                ET& theList = mSlots[k][i];
+                ET* thePtr  = &theList;
+                while (&theList != (thePtr = ListT::GetNextPtr(thePtr))) {
+                    inFunctor(*thePtr);
+                }
+            }
+        }
+    }
+private:
+    HierarchicalTimerWheel(
+        const HierarchicalTimerWheel& inTimerWheel);
+    HierarchicalTimerWheel& operator=(
+        const HierarchicalTimerWheel& inTimerWheel);
+};
+
+} // namespace KFS
+
+#endif /* HIERARCHICAL_TIMER_WHEEL_H */
@@ -0,0 +1,206 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file LatencyHistogram.h
+// \brief Fixed size log-linear latency histogram.
+//
+// Each power of two range of values is split into kSubBucketCount equal width
+// buckets, therefore the bucket width relative error is at most 1 /
+// kSubBucketCount, or 12.5%, with the fixed memory footprint, and constant
+// time recording. Recording uses atomic increments, and can be performed
+// concurrently from multiple threads without locking. The values are expected
+// to be in microseconds, values larger than 2^kMaxValueBits, or about 19 hours,
+// are counted in the last bucket.
+//
+//----------------------------------------------------------------------------
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include "kfsatomic.h"
+
+#include <inttypes.h>
+#include <ostream>
+
+namespace KFS
+{
+
+using std::ostream;
+
+class LatencyHistogram
+{
+public:
+    typedef int64_t Count;
+    typedef int64_t Value;
+    enum
+    {
+        kSubBucketBits  = 3,
+        kSubBucketCount = 1 << kSubBucketBits,
+        kMaxValueBits   = 36,
+        kBucketCount    =
+            (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount
+    };
+
+    LatencyHistogram()
+        { LatencyHistogram::Clear(); }
+    LatencyHistogram(
+        const LatencyHistogram& inHistogram)
+    {
+        LatencyHistogram::Clear();
+        LatencyHistogram::Add(inHistogram);
+    }
+    LatencyHistogram& operator=(
+        const LatencyHistogram& inHistogram)
+    {
+        if (this != &inHistogram) {
+            Clear();
+            Add(inHistogram);
+        }
+        return *this;
+    }
+    void Record(
+        Value inValue)
+    {
+        const Value theValue = inValue < 0 ? Value(0) : inValue;
+        SyncAddAndFetch(mBuckets[GetBucketIdx(theValue)], Count(1));
+        SyncAddAndFetch(mCount, Count(1));
+        SyncAddAndFetch(mSum,   theValue);
+    }
+    void Add(
+        const LatencyHistogram& inHistogram)
+    {
+        for (int i = 0; i < kBucketCount; i++) {
+            mBuckets[i] += inHistogram.mBuckets[i];
+        }
+        mCount += inHistogram.mCount;
+        mSum   += inHistogram.mSum;
+    }
+    void Clear()
+    {
+        for (int i = 0; i < kBucketCount; i++) {
+            mBuckets[i] = 0;
+        }
+        mCount = 0;
+        mSum   = 0;
+    }
+    Count GetCount() const
+        { return mCount; }
+    Value GetSum() const
+        { return mSum; }
+    Value GetAverage() const
+        { return (mCount <= 0 ? Value(0) : mSum / mCount); }
+    // Returns the upper bound of the bucket that contains the value at the
+    // specified percentile, or 0 if the histogram is empty.
+    Value GetPercentile(
+        double inPercentile) const
+    {
+        const Count theCount = mCount;
+        if (theCount <= 0) {
+            return 0;
+        }
+        Count theRank = (Count)(theCount * inPercentile / 100. + .5);
+        if (theRank < 1) {
+            theRank = 1;
+        }
+        Count theSum = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            theSum += mBuckets[i];
+            if (theRank <= theSum) {
+                return GetBucketMax(i);
+            }
+        }
+        return GetMax();
+    }
+    // Returns the upper bound of the highest non empty bucket.
+    Value GetMax() const
+    {
+        for (int i = kBucketCount - 1; 0 <= i; i--) {
+            if (0 < mBuckets[i]) {
+                return GetBucketMax(i);
+            }
+        }
+        return 0;
+    }
+    // Returns the number of values in the buckets starting from the bucket
+    // that contains the threshold value.
+    Count GetCountAtOrAbove(
+        Value inThreshold) const
+    {
+        Count theSum = 0;
+        for (int i = GetBucketIdx(inThreshold < 0 ? Value(0) : inThreshold);
+                i < kBucketCount;
+                i++) {
+            theSum += mBuckets[i];
+        }
+        return theSum;
+    }
+    // Writes count, average, 50, 90, 99, 99.9 percentiles, and max.
+    ostream& Display(
+        ostream& inStream) const
+    {
+        return (inStream <<
+            GetCount()            << "," <<
+            GetAverage()          << "," <<
+            GetPercentile(50)     << "," <<
+            GetPercentile(90)     << "," <<
+            GetPercentile(99)     << "," <<
+            GetPercentile(99.9)   << "," <<
+            GetMax()
+        );
+    }
+    static int GetBucketIdx(
+        Value inValue)
+    {
+        if (inValue < kSubBucketCount) {
+            return (int)inValue;
+        }
+        const int theMsb = 63 - __builtin_clzll((unsigned long long)inValue);
+        if (kMaxValueBits <= theMsb) {
+            return (kBucketCount - 1);
+        }
+        return ((theMsb - kSubBucketBits + 1) * kSubBucketCount +
+            (int)((inValue >> (theMsb - kSubBucketBits)) &
+                (kSubBucketCount - 1)));
+    }
+    static Value GetBucketMax(
+        int inIdx)
+    {
+        if (inIdx < kSubBucketCount) {
+            return inIdx;
+        }
+        const int theShift = inIdx / kSubBucketCount - 1;
+        return ((Value(kSubBucketCount + inIdx % kSubBucketCount + 1) <<
+            theShift) - 1);
+    }
+private:
+    volatile Count mBuckets[kBucketCount];
+    volatile Count mCount;
+    volatile Value mSum;
+};
+
+inline static ostream& operator<<(
+    ostream&                inStream,
+    const LatencyHistogram& inHistogram)
+{ return inHistogram.Display(inStream); }
+
+} // namespace KFS
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,266 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file LrcStripeLayout.h
+// \brief Locally repairable code stripe layout.
+//
+// The recovery stripes of the LRC striped file block are split into global
+// and local parity stripes. The global parity stripes are computed from all
+// data stripes, and go first, immediately after the data stripes. The local
+// parity stripes follow the global parity stripes, each local parity stripe is
+// xor of the data stripes of the corresponding local group. The data stripes
+// are split into the local groups of equal, or off by one, size in order. The
+// number of global parity stripes is half of the recovery stripes rounded
+// down, therefore with 6 data and 4 recovery stripes, the layout is 6 data
+// stripes, 2 global parity stripes, and 2 local parity stripes with the local
+// groups of 3 data stripes. A single lost data or local parity stripe can be
+// rebuilt from the stripes of the same local group.
+// The global parity row j coefficient of the data stripe i is the Cauchy
+// matrix element 1 / (i xor (data stripe count + j)) in GF(2^8) with
+// x^8 + x^4 + x^3 + x^2 + 1 polynomial.
+// Unlike Reed-Solomon, not every combination of the recovery stripe count
+// lost stripes can be recovered, and the local and global parity rows
+// combined are not guaranteed to be independent on every subset of the data
+// stripes. CanRecover() must be used to determine if the chunk block with the
+// given lost stripes can be recovered. It computes the rank of the present
+// parity rows restricted to the lost data stripes columns.
+//
+// The layout is shared by the client library ec method, and by the meta
+// server chunk placement.
+//
+//----------------------------------------------------------------------------
+
+#ifndef COMMON_LRC_STRIPE_LAYOUT_H
+#define COMMON_LRC_STRIPE_LAYOUT_H
+
+#include "StBuffer.h"
+
+namespace KFS
+{
+
+class LrcStripeLayout
+{
+public:
+    typedef unsigned char Symbol;
+    enum { kMinRecoveryStripeCount = 2 };
+    enum { kSymbolCount = 256 };
+
+    static bool IsValid(
+        int inStripeCount,
+        int inRecoveryStripeCount)
+    {
+        return (
+            0 < inStripeCount &&
+            kMinRecoveryStripeCount <= inRecoveryStripeCount &&
+            GetLocalGroupCount(inRecoveryStripeCount) <= inStripeCount
+        );
+    }
+    static int GetGlobalParityCount(
+        int inRecoveryStripeCount)
+        { return (inRecoveryStripeCount / 2); }
+    static int GetLocalGroupCount(
+        int inRecoveryStripeCount)
+    {
+        return (inRecoveryStripeCount -
+            GetGlobalParityCount(inRecoveryStripeCount));
+    }
+    // Returns local group index of data or local parity stripe, or -1 for
+    // global parity stripe.
+    static int GetLocalGroup(
+        int inStripeCount,
+        int inRecoveryStripeCount,
+        int inStripeIdx)
+    {
+        if (inStripeIdx < 0) {
+            return -1;
+        }
+        if (inStripeIdx < inStripeCount) {
+            return (inStripeIdx *
+                GetLocalGroupCount(inRecoveryStripeCount) / inStripeCount);
+        }
+        const int theIdx = inStripeIdx - inStripeCount -
+            GetGlobalParityCount(inRecoveryStripeCount);
+        return ((theIdx < 0 ||
+                GetLocalGroupCount(inRecoveryStripeCount) <= theIdx) ?
+            -1 : theIdx);
+    }
+    static int GetLocalParityIdx(
+        int inStripeCount,
+        int inRecoveryStripeCount,
+        int inLocalGroup)
+    {
+        return (inStripeCount +
+            GetGlobalParityCount(inRecoveryStripeCount) + inLocalGroup);
+    }
+    // Returns the max number of the lost stripes that the block can always be
+    // recovered from, regardless of the lost stripes positions.
+    static int GetFailureTolerance(
+        int inRecoveryStripeCount)
+        { return (GetGlobalParityCount(inRecoveryStripeCount) + 1); }
+    static Symbol GfMul(
+        Symbol inA,
+        Symbol inB)
+    {
+        unsigned int theRes = 0;
+        unsigned int theA   = inA;
+        for (unsigned int theB = inB; theB != 0; theB >>= 1) {
+            if ((theB & 1) != 0) {
+                theRes ^= theA;
+            }
+            theA <<= 1;
+            if ((theA & kSymbolCount) != 0) {
+                theA ^= 0x11D;
+            }
+        }
+        return (Symbol)theRes;
+    }
+    static Symbol GfInv(
+        Symbol inA)
+    {
+        // a^-1 = a^254
+        Symbol theRes = 1;
+        Symbol theSq  = inA;
+        for (unsigned int theExp = kSymbolCount - 2; theExp != 0;
+                theExp >>= 1) {
+            if ((theExp & 1) != 0) {
+                theRes = GfMul(theRes, theSq);
+            }
+            theSq = GfMul(theSq, theSq);
+        }
+        return theRes;
+    }
+    static Symbol GetGlobalCoefficient(
+        int inStripeCount,
+        int inGlobalIdx,
+        int inStripeIdx)
+    {
+        return GfInv((Symbol)(inStripeIdx ^ (inStripeCount + inGlobalIdx)));
+    }
+    // Returns the coefficient of the data stripe in the parity stripe row,
+    // the row index is the stripe index in the block.
+    static Symbol GetCoefficient(
+        int inStripeCount,
+        int inRecoveryStripeCount,
+        int inRowIdx,
+        int inStripeIdx)
+    {
+        if (inRowIdx < inStripeCount) {
+            return (inRowIdx == inStripeIdx ? 1 : 0);
+        }
+        const int theGlobalIdx = inRowIdx - inStripeCount;
+        if (theGlobalIdx < GetGlobalParityCount(inRecoveryStripeCount)) {
+            return GetGlobalCoefficient(
+                inStripeCount, theGlobalIdx, inStripeIdx);
+        }
+        return (IsSameLocalGroup(inStripeCount, inRecoveryStripeCount,
+            inRowIdx, inStripeIdx) ? 1 : 0);
+    }
+    // Returns true if the block with the given lost stripes can be recovered.
+    // The lost flags array is indexed by the stripe index in the block. The
+    // block can be recovered if the present parity rows restricted to the
+    // lost data stripes columns have full rank. The rows are reduced in the
+    // same order as the decoder does: local parities first.
+    static bool CanRecover(
+        int         inStripeCount,
+        int         inRecoveryStripeCount,
+        const char* inLostFlagsPtr)
+    {
+        typedef StBufferT<Symbol, 256> Symbols;
+        typedef StBufferT<int, 32>     Ints;
+        Ints       theColsBuf;
+        int* const theColsPtr = theColsBuf.Resize(inRecoveryStripeCount + 1);
+        int        theColCnt  = 0;
+        for (int i = 0; i < inStripeCount; i++) {
+            if (inLostFlagsPtr[i]) {
+                if (inRecoveryStripeCount <= theColCnt) {
+                    return false;
+                }
+                theColsPtr[theColCnt++] = i;
+            }
+        }
+        if (theColCnt <= 0) {
+            return true;
+        }
+        const int     theGlobalCount =
+            GetGlobalParityCount(inRecoveryStripeCount);
+        Symbols       theBasisBuf;
+        Symbol* const theBasisPtr    =
+            theBasisBuf.Resize(theColCnt * theColCnt);
+        Ints          thePivotsBuf;
+        int* const    thePivotsPtr   = thePivotsBuf.Resize(theColCnt);
+        Symbols       theVecBuf;
+        Symbol* const theVecPtr      = theVecBuf.Resize(theColCnt);
+        int           theRank        = 0;
+        for (int j = 0; j < inRecoveryStripeCount && theRank < theColCnt;
+                j++) {
+            const int theRow = inStripeCount +
+                (j + theGlobalCount) % inRecoveryStripeCount;
+            if (inLostFlagsPtr[theRow]) {
+                continue;
+            }
+            for (int a = 0; a < theColCnt; a++) {
+                theVecPtr[a] = GetCoefficient(inStripeCount,
+                    inRecoveryStripeCount, theRow, theColsPtr[a]);
+            }
+            for (int r = 0; r < theRank; r++) {
+                const Symbol theFactor = theVecPtr[thePivotsPtr[r]];
+                if (theFactor == 0) {
+                    continue;
+                }
+                const Symbol* const theBPtr = theBasisPtr + r * theColCnt;
+                for (int a = 0; a < theColCnt; a++) {
+                    theVecPtr[a] ^= GfMul(theFactor, theBPtr[a]);
+                }
+            }
+            int thePivot = 0;
+            while (thePivot < theColCnt && theVecPtr[thePivot] == 0) {
+                thePivot++;
+            }
+            if (theColCnt <= thePivot) {
+                continue;
+            }
+            const Symbol  theInv  = GfInv(theVecPtr[thePivot]);
+            Symbol* const theBPtr = theBasisPtr + theRank * theColCnt;
+            for (int a = 0; a < theColCnt; a++) {
+                theBPtr[a] = GfMul(theInv, theVecPtr[a]);
+            }
+            thePivotsPtr[theRank++] = thePivot;
+        }
+        return (theColCnt <= theRank);
+    }
+    static bool IsSameLocalGroup(
+        int inStripeCount,
+        int inRecoveryStripeCount,
+        int inStripeIdx,
+        int inOtherStripeIdx)
+    {
+        const int theGroup = GetLocalGroup(
+            inStripeCount, inRecoveryStripeCount, inStripeIdx);
+        return (0 <= theGroup && theGroup == GetLocalGroup(
+            inStripeCount, inRecoveryStripeCount, inOtherStripeIdx));
+    }
+private:
+    LrcStripeLayout();
+};
+
+} // namespace KFS
+
+#endif /* COMMON_LRC_STRIPE_LAYOUT_H */
@@ -84,10 +84,10 @@ namespace KFS
 #ifndef KFS_LOG_STREAM_START_TEE
 #   define KFS_LOG_STREAM_START_TEE(logLevel, streamVarName, teeStreamPtr) \
     if (MsgLogger::GetLogger() && \
-            (MsgLogger::GetLogger()->IsLogLevelEnabled(logLevel) || \
+            (MsgLogger::GetLogger()->IsLogLevelEnabled(logLevel, __FILE__) || \
                 teeStreamPtr)) {\
         MsgLogger::StStream streamVarName( \
-            *MsgLogger::GetLogger(), logLevel, teeStreamPtr); \
+            *MsgLogger::GetLogger(), logLevel, teeStreamPtr, __FILE__); \
         streamVarName.GetStream() << KFS_LOG_STREAM_SRC_PREFIX
 #endif
 #ifndef KFS_LOG_STREAM_START
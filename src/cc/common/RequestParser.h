@@ -28,6 +28,8 @@
 #define REQUEST_PARSER_H
 
 #include "StBuffer.h"
+#include "BinaryRpc.h"
+#include "IntToString.h"
 
 #include <utility>
 #include <string>
@@ -322,6 +324,37 @@ _KFS_ValueParser_IntTypes(_KFS_DEFINE_ValueParser_IntSetValue)
 
 typedef ValueParserT<DecIntParser> ValueParser;
 
+// Binary rpc integer value setter. Integer values of the fields with non
+// integer types are treated as malformed, and the default value is used.
+class BinaryIntValueParser
+{
+public:
+    template<typename T>
+    static void SetValue(
+        int64_t  /* inVal */,
+        const T& inDefaultValue,
+        T&       outValue)
+        { outValue = inDefaultValue; }
+
+#define _KFS_DEFINE_BinaryIntValueParser_SetValue(IT) \
+    static void SetValue(                             \
+        int64_t   inVal,                              \
+        const IT& /* inDefaultValue */,               \
+        IT&       outValue)                           \
+        { outValue = (IT)inVal; }
+
+_KFS_ValueParser_IntTypes(_KFS_DEFINE_BinaryIntValueParser_SetValue)
+_KFS_DEFINE_BinaryIntValueParser_SetValue(float)
+_KFS_DEFINE_BinaryIntValueParser_SetValue(double)
+#undef _KFS_DEFINE_BinaryIntValueParser_SetValue
+
+    static void SetValue(
+        int64_t     inVal,
+        const bool& /* inDefaultValue */,
+        bool&       outValue)
+        { outValue = inVal != 0; }
+};
+
 template<char SEPARATOR, char DELIMITER>
 class PropertiesTokenizerT
 {
@@ -737,6 +770,34 @@ public:
             }
         }
     }
+    bool ParseBinary(
+        BinaryRpcTokenizer& inTokenizer,
+        OBJ*                inObjPtr) const
+    {
+        while (inTokenizer.Next()) {
+            const Token theKey(
+                inTokenizer.GetKeyPtr(), inTokenizer.GetKeyLen());
+            typename Fields::const_iterator const theIt = mFields.find(theKey);
+            if (theIt != mFields.end()) {
+                theIt->second->SetBinary(inObjPtr, inTokenizer);
+                continue;
+            }
+            const char* theValPtr = inTokenizer.GetValuePtr();
+            size_t      theValLen = inTokenizer.GetValueLen();
+            char        theBuf[sizeof(int64_t) * 2 + 2];
+            if (inTokenizer.IsInt()) {
+                char* const theEndPtr = theBuf + sizeof(theBuf);
+                theValPtr = IntToString<16>::Convert(
+                    inTokenizer.GetInt(), theEndPtr);
+                theValLen = theEndPtr - theValPtr;
+            }
+            if (! inObjPtr->HandleUnknownField(
+                    theKey.mPtr, theKey.mLen, theValPtr, theValLen)) {
+                break;
+            }
+        }
+        return (! inTokenizer.IsError());
+    }
     void Write(
         ST&        inStream,
         const OBJ* inObjPtr,
@@ -767,6 +828,9 @@ private:
         virtual void Set(
             OBJ*         inObjPtr,
             const Value& inValue) const = 0;
+        virtual void SetBinary(
+            OBJ*                      inObjPtr,
+            const BinaryRpcTokenizer& inTokenizer) const = 0;
         virtual void Get(
             const OBJ* inObjPtr,
             ST&        inStream,
@@ -807,6 +871,25 @@ private:
                 inObjPtr->*mFieldPtr
             );
         }
+        virtual void SetBinary(
+            OBJ*                      inObjPtr,
+            const BinaryRpcTokenizer& inTokenizer) const
+        {
+            if (inTokenizer.IsInt()) {
+                BinaryIntValueParser::SetValue(
+                    inTokenizer.GetInt(),
+                    mDefault,
+                    inObjPtr->*mFieldPtr
+                );
+            } else {
+                VALUE_PARSER::SetValue(
+                    inTokenizer.GetValuePtr(),
+                    inTokenizer.GetValueLen(),
+                    mDefault,
+                    inObjPtr->*mFieldPtr
+                );
+            }
+        }
         virtual void Get(
             const OBJ* inObjPtr,
             ST&        inStream,
@@ -854,6 +937,11 @@ public:
         size_t      inRequestNameLen,
         bool        inHasHeaderChecksumFlag,
         Checksum    inChecksum) const = 0;
+    virtual ABSTRACT_OBJ* ParseBinary(
+        const char* inFieldsPtr,
+        size_t      inLen,
+        const char* inRequestNamePtr,
+        size_t      inRequestNameLen) const = 0;
     virtual void Write(
         ST&                 inStream,
         const ABSTRACT_OBJ* inObjPtr,
@@ -940,6 +1028,32 @@ public:
         REQUEST_DELETER::Delete(theObjPtr);
         return 0;
     }
+    virtual ABSTRACT_OBJ* ParseBinary(
+        const char* inFieldsPtr,
+        size_t      inLen,
+        const char* inRequestNamePtr,
+        size_t      inRequestNameLen) const
+    {
+        OBJ* const theObjPtr = new OBJ();
+        if (! theObjPtr->ValidateRequestHeader(
+                inRequestNamePtr,
+                inRequestNameLen,
+                inFieldsPtr,
+                inLen,
+                false, // No header checksum.
+                Checksum(0),
+                SHORT_NAMES_FLAG)) {
+            REQUEST_DELETER::Delete(theObjPtr);
+            return 0;
+        }
+        BinaryRpcTokenizer theTokenizer(inFieldsPtr, inLen);
+        if (ObjParser::ParseBinary(theTokenizer, theObjPtr) &&
+                (! VALIDATE_FLAG || theObjPtr->Validate())) {
+            return theObjPtr;
+        }
+        REQUEST_DELETER::Delete(theObjPtr);
+        return 0;
+    }
     virtual void Write(
         ST&                 inStream,
         const ABSTRACT_OBJ* inObjPtr,
@@ -1069,6 +1183,32 @@ public:
             theChecksum
         );
     }
+    // Binary frame field names are short rpc format field names, therefore
+    // only short names handler can parse binary frames.
+    ABSTRACT_OBJ* HandleBinary(
+        const char* inBufferPtr,
+        size_t      inLen) const
+    {
+        const char* theNamePtr   = 0;
+        size_t      theNameLen   = 0;
+        const char* theFieldsPtr = 0;
+        size_t      theFieldsLen = 0;
+        if (! BinaryRpc::Parse(inBufferPtr, inLen,
+                theNamePtr, theNameLen, theFieldsPtr, theFieldsLen)) {
+            return 0;
+        }
+        typename Parsers::const_iterator const theIt =
+            mParsers.find(Name(theNamePtr, theNameLen));
+        if (theIt == mParsers.end()) {
+            return 0;
+        }
+        return theIt->second.second->ParseBinary(
+            theFieldsPtr,
+            theFieldsLen,
+            theNamePtr,
+            theNameLen
+        );
+    }
     TokenValue ObjIdToName(
         int inObjId) const
     {
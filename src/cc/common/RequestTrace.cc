@@ -0,0 +1,190 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file RequestTrace.cc
+// \brief Sampled per request stage timing trace.
+//
+//----------------------------------------------------------------------------
+
+#include "RequestTrace.h"
+#include "time.h"
+
+#include <fstream>
+#include <string>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace KFS
+{
+
+using std::ofstream;
+using std::string;
+using std::hex;
+using std::dec;
+
+class RequestTrace::Event
+{
+public:
+    // Sequence number of the last completed record, or -1 if the record is
+    // being written.
+    volatile int64_t mSeq;
+    TraceId          mTraceId;
+    const char*      mStageNamePtr;
+    int64_t          mStartUsec;
+    int64_t          mDurationUsec;
+    uint64_t         mThreadId;
+};
+
+RequestTrace::Event* volatile  RequestTrace::sEventsPtr      = 0;
+int64_t                        RequestTrace::sMask           = 0;
+int                            RequestTrace::sSampleInterval = 0;
+volatile int64_t               RequestTrace::sSampleCount    = 0;
+volatile int64_t               RequestTrace::sNextIdx        = 0;
+volatile RequestTrace::TraceId RequestTrace::sNextId         = 0;
+
+    /* static */ void
+RequestTrace::SetParameters(
+    int inRingSize,
+    int inSampleInterval)
+{
+    if (! sEventsPtr && 0 < inRingSize) {
+        int64_t theSize = 1;
+        while (theSize < inRingSize && theSize < (int64_t(1) << 24)) {
+            theSize <<= 1;
+        }
+        Event* const thePtr = new Event[theSize];
+        for (int64_t i = 0; i < theSize; i++) {
+            thePtr[i].mSeq = -1;
+        }
+        // Seed the trace ids with the process id and the start time, in order
+        // to make ids from different processes unlikely to collide.
+        sNextId    = ((int64_t)getpid() << 40) ^ microseconds();
+        sMask      = theSize - 1;
+        sEventsPtr = thePtr;
+    }
+    sSampleInterval = sEventsPtr ? inSampleInterval : 0;
+}
+
+    /* static */ RequestTrace::TraceId
+RequestTrace::NewId()
+{
+    TraceId theId;
+    do {
+        theId = SyncAddAndFetch(sNextId, TraceId(1)) &
+            ~(TraceId(1) << 63);
+    } while (theId == 0);
+    return theId;
+}
+
+    /* static */ void
+RequestTrace::RecordSelf(
+    RequestTrace::TraceId inTraceId,
+    const char*           inStageNamePtr,
+    int64_t               inStartUsec,
+    int64_t               inDurationUsec)
+{
+    const int64_t theIdx   = SyncAddAndFetch(sNextIdx, int64_t(1)) - 1;
+    Event&        theEvent = sEventsPtr[theIdx & sMask];
+    theEvent.mSeq          = -1;
+    theEvent.mTraceId      = inTraceId;
+    theEvent.mStageNamePtr = inStageNamePtr;
+    theEvent.mStartUsec    = inStartUsec;
+    theEvent.mDurationUsec = inDurationUsec < 0 ? int64_t(0) : inDurationUsec;
+    theEvent.mThreadId     = (uint64_t)pthread_self();
+    // Atomic add is a full barrier, the record fields are visible before the
+    // sequence number.
+    SyncAddAndFetch(theEvent.mSeq, theIdx + 1);
+}
+
+    /* static */ ostream&
+RequestTrace::Display(
+    ostream& inStream)
+{
+    inStream << "{\"traceEvents\":[";
+    Event* const thePtr = sEventsPtr;
+    if (thePtr) {
+        const int64_t theEnd   = sNextIdx;
+        const int64_t theStart = theEnd <= sMask ? int64_t(0) :
+            theEnd - sMask - 1;
+        const long    thePid   = (long)getpid();
+        const char*   theSep   = "\n";
+        for (int64_t i = theStart; i < theEnd; i++) {
+            const Event& theSlot  = thePtr[i & sMask];
+            const int64_t theSeq  = theSlot.mSeq;
+            Event         theEvent;
+            theEvent.mTraceId      = theSlot.mTraceId;
+            theEvent.mStageNamePtr = theSlot.mStageNamePtr;
+            theEvent.mStartUsec    = theSlot.mStartUsec;
+            theEvent.mDurationUsec = theSlot.mDurationUsec;
+            theEvent.mThreadId     = theSlot.mThreadId;
+            if (theSeq != i || theSlot.mSeq != i ||
+                    ! theEvent.mStageNamePtr) {
+                // Being overwritten.
+                continue;
+            }
+            inStream << theSep <<
+                "{\"name\":\"" << theEvent.mStageNamePtr << "\""
+                ",\"cat\":\"qfs\",\"ph\":\"X\""
+                ",\"ts\":"   << theEvent.mStartUsec <<
+                ",\"dur\":"  << theEvent.mDurationUsec <<
+                ",\"pid\":"  << thePid <<
+                ",\"tid\":"  << (theEvent.mThreadId & 0xFFFFFFFF) <<
+                ",\"args\":{\"trace\":\"" << hex << theEvent.mTraceId <<
+                    dec << "\"}}"
+            ;
+            theSep = ",\n";
+        }
+    }
+    return (inStream << "\n],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+    /* static */ int
+RequestTrace::Dump(
+    const char* inFileNamePtr)
+{
+    if (! inFileNamePtr || ! *inFileNamePtr) {
+        return -EINVAL;
+    }
+    const string theTmpName = string(inFileNamePtr) + ".tmp";
+    ofstream     theStream(theTmpName.c_str());
+    if (! theStream) {
+        const int theErr = errno;
+        return (theErr > 0 ? -theErr : -EIO);
+    }
+    Display(theStream);
+    theStream.close();
+    if (theStream.fail()) {
+        const int theErr = errno;
+        unlink(theTmpName.c_str());
+        return (theErr > 0 ? -theErr : -EIO);
+    }
+    if (rename(theTmpName.c_str(), inFileNamePtr)) {
+        const int theErr = errno;
+        unlink(theTmpName.c_str());
+        return (theErr > 0 ? -theErr : -EIO);
+    }
+    return 0;
+}
+
+} // namespace KFS
@@ -0,0 +1,114 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file RequestTrace.h
+// \brief Sampled per request stage timing trace.
+//
+// The client assigns trace id to every sample interval's request, and passes
+// it in the request header. The chunk servers pass the trace id down the
+// synchronous replication chain, and to the disk io. Each process records
+// the request stages start time and duration into the fixed size process
+// wide ring buffer. Recording uses only atomic increments, and can be
+// performed from any thread. The ring buffer content can be written in Chrome
+// trace event json format, the files from multiple processes can be merged
+// by trace id, as the time stamps are wall clock microseconds.
+// The trace ring can only be allocated once, all methods are static in order
+// to keep the cost of the trace id check when tracing is disabled to a single
+// memory load and compare.
+//
+//----------------------------------------------------------------------------
+
+#ifndef REQUEST_TRACE_H
+#define REQUEST_TRACE_H
+
+#include "kfsatomic.h"
+
+#include <inttypes.h>
+#include <ostream>
+
+namespace KFS
+{
+
+using std::ostream;
+
+class RequestTrace
+{
+public:
+    typedef int64_t TraceId;
+
+    // Allocates the ring buffer on the first invocation with positive ring
+    // size. Sample interval 0 disables trace id assignment, 1 traces every
+    // request.
+    static void SetParameters(
+        int inRingSize,
+        int inSampleInterval);
+    static bool IsEnabled()
+        { return (0 != sEventsPtr); }
+    // Returns new trace id if the next request should be traced, or 0.
+    static TraceId Sample()
+    {
+        if (sSampleInterval <= 0 || (1 < sSampleInterval &&
+                SyncAddAndFetch(sSampleCount, int64_t(1)) %
+                    sSampleInterval != 0)) {
+            return 0;
+        }
+        return NewId();
+    }
+    static void Record(
+        TraceId     inTraceId,
+        const char* inStageNamePtr,
+        int64_t     inStartUsec,
+        int64_t     inDurationUsec)
+    {
+        if (inTraceId != 0 && sEventsPtr) {
+            RecordSelf(inTraceId, inStageNamePtr, inStartUsec, inDurationUsec);
+        }
+    }
+    static ostream& Display(
+        ostream& inStream);
+    // Writes the trace into temporary file, and renames it into the file
+    // name. Returns 0 on success, or negative errno.
+    static int Dump(
+        const char* inFileNamePtr);
+private:
+    class Event;
+
+    static Event* volatile  sEventsPtr;
+    static int64_t          sMask;
+    static int              sSampleInterval;
+    static volatile int64_t sSampleCount;
+    static volatile int64_t sNextIdx;
+    static volatile TraceId sNextId;
+
+    static TraceId NewId();
+    static void RecordSelf(
+        TraceId     inTraceId,
+        const char* inStageNamePtr,
+        int64_t     inStartUsec,
+        int64_t     inDurationUsec);
+private:
+    RequestTrace();
+    ~RequestTrace();
+};
+
+} // namespace KFS
+
+#endif /* REQUEST_TRACE_H */
@@ -0,0 +1,142 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Quantcast File System.
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file VarIntCodec.h
+// \brief Unsigned LEB128 style variable length integer encoding, and
+// incremental byte at a time, and contiguous buffer decoders. The byte at a
+// time decoder keeps its state between invocations, and can be used with
+// discontiguous buffers.
+//
+//----------------------------------------------------------------------------
+
+#ifndef COMMON_VARINTCODEC_H
+#define COMMON_VARINTCODEC_H
+
+#include <stdint.h>
+
+namespace KFS
+{
+
+class VarIntCodec
+{
+public:
+    enum { kMaxEncodedLength = 10 };
+    enum { kLastByteShift = (kMaxEncodedLength - 1) * 7 };
+
+    static char* Encode(
+        uint64_t inVal,
+        char*    inPtr)
+    {
+        uint64_t theVal = inVal;
+        char*    thePtr = inPtr;
+        while (0x80 <= theVal) {
+            *thePtr++ = (char)((theVal & 0x7F) | 0x80);
+            theVal >>= 7;
+        }
+        *thePtr++ = (char)theVal;
+        return thePtr;
+    }
+    static int EncodedLength(
+        uint64_t inVal)
+    {
+        int theRet = 1;
+        for (uint64_t theVal = inVal; 0x80 <= theVal; theVal >>= 7) {
+            theRet++;
+        }
+        return theRet;
+    }
+    // Decodes value from contiguous buffer. Returns pointer past the end of
+    // the encoded value, or 0 if the buffer is too short, or the value
+    // exceeds 64 bits.
+    static const char* Decode(
+        const char* inPtr,
+        const char* inEndPtr,
+        uint64_t&   outVal)
+    {
+        uint64_t theVal = 0;
+        for (int theShift = 0; inPtr < inEndPtr && theShift < 64;
+                theShift += 7) {
+            const uint64_t theByte = (uint64_t)(*inPtr++ & 0xFF);
+            if (kLastByteShift <= theShift && 1 < theByte) {
+                // 10th byte can only have the 64th bit set.
+                return 0;
+            }
+            theVal |= (theByte & 0x7F) << theShift;
+            if ((theByte & 0x80) == 0) {
+                outVal = theVal;
+                return inPtr;
+            }
+        }
+        return 0;
+    }
+    // Zig zag mapping of signed integers, in order to encode small negative
+    // values, like -1 "undefined" defaults, with a single byte.
+    static uint64_t ZigZagEncode(
+        int64_t inVal)
+        { return (((uint64_t)inVal << 1) ^ (uint64_t)(inVal >> 63)); }
+    static int64_t ZigZagDecode(
+        uint64_t inVal)
+        { return (int64_t)((inVal >> 1) ^ (~(inVal & 1) + 1)); }
+    class Decoder
+    {
+    public:
+        Decoder()
+            : mVal(0),
+              mShift(0)
+            {}
+        // Returns 1 if value is complete, 0 if more bytes are required, and
+        // -1 if the encoded value exceeds 64 bits.
+        int Add(
+            unsigned char inByte)
+        {
+            if (64 <= mShift || (kLastByteShift <= mShift && 1 < inByte)) {
+                return -1;
+            }
+            mVal |= (uint64_t)(inByte & 0x7F) << mShift;
+            if ((inByte & 0x80) == 0) {
+                return 1;
+            }
+            mShift += 7;
+            return 0;
+        }
+        uint64_t Get()
+        {
+            const uint64_t theRet = mVal;
+            mVal   = 0;
+            mShift = 0;
+            return theRet;
+        }
+        bool IsEmpty() const
+            { return (0 == mShift); }
+        void Reset()
+        {
+            mVal   = 0;
+            mShift = 0;
+        }
+    private:
+        uint64_t mVal;
+        int      mShift;
+    };
+};
+
+} // namespace KFS
+
+#endif /* COMMON_VARINTCODEC_H */
@@ -140,7 +140,8 @@ inline static bool IsMetaLogWriteOrVrError(int status)
 
 #define KFS_FOR_EACH_EC_METHOD(f) \
     f(STRIPED_FILE_TYPE_RS) \
-    f(STRIPED_FILE_TYPE_RS_JERASURE)
+    f(STRIPED_FILE_TYPE_RS_JERASURE) \
+    f(STRIPED_FILE_TYPE_LRC)
 
 enum StripedFileType
 {
@@ -0,0 +1,271 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Quantcast File System.
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Chunk server hello chunk inventory encoding unit and performance
+// test. Compares hex text format with delta varint format, by encoding and
+// decoding chunk inventory, by default with 10M chunks. The delta varint
+// decoding is performed in network read sized slices, the way the meta server
+// decodes hello as it arrives.
+//
+//----------------------------------------------------------------------------
+
+#include "common/VarIntCodec.h"
+#include "common/time.h"
+#include "kfsio/IOBuffer.h"
+#include "kfsio/IOBufferWriter.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace KFS;
+using namespace std;
+
+typedef vector<pair<int64_t, int64_t> > ChunkIdVersions;
+
+static int64_t
+EncodeHex(const ChunkIdVersions& chunks, IOBuffer& buf)
+{
+    const int64_t      start = microseconds();
+    IOBuffer::WOStream stream;
+    ostream&           os    = stream.Set(buf) << hex;
+    for (ChunkIdVersions::const_iterator it = chunks.begin();
+            it != chunks.end();
+            ++it) {
+        os << ' ' << it->first << ' ' << it->second;
+    }
+    os.flush();
+    stream.Reset();
+    return (microseconds() - start);
+}
+
+static int64_t
+DecodeHex(IOBuffer& buf, ChunkIdVersions& chunks)
+{
+    const int64_t          start = microseconds();
+    IOBuffer::ByteIterator it(buf);
+    const char*            p;
+    int64_t                val       = 0;
+    int64_t                id        = 0;
+    bool                   idFlag    = true;
+    bool                   spaceFlag = true;
+    while ((p = it.Next())) {
+        const int sym = *p & 0xFF;
+        if (sym <= ' ') {
+            if (! spaceFlag) {
+                if (idFlag) {
+                    id = val;
+                } else {
+                    chunks.push_back(make_pair(id, val));
+                }
+                idFlag = ! idFlag;
+                val    = 0;
+            }
+            spaceFlag = true;
+            continue;
+        }
+        spaceFlag = false;
+        val = (val << 4) | (sym <= '9' ? sym - '0' : (sym | 0x20) - 'a' + 10);
+    }
+    if (! spaceFlag && ! idFlag) {
+        chunks.push_back(make_pair(id, val));
+    }
+    buf.Clear();
+    return (microseconds() - start);
+}
+
+static int64_t
+EncodeDeltaVarInt(ChunkIdVersions& chunks, IOBuffer& buf)
+{
+    const int64_t start = microseconds();
+    sort(chunks.begin(), chunks.end());
+    IOBufferWriter writer(buf);
+    char           tmp[2 * VarIntCodec::kMaxEncodedLength];
+    int64_t        prev = 0;
+    for (ChunkIdVersions::const_iterator it = chunks.begin();
+            it != chunks.end();
+            ++it) {
+        char* const ptr = VarIntCodec::Encode((uint64_t)it->second,
+            VarIntCodec::Encode((uint64_t)(it->first - prev), tmp));
+        writer.Write(tmp, ptr - tmp);
+        prev = it->first;
+    }
+    writer.Close();
+    return (microseconds() - start);
+}
+
+static int64_t
+DecodeDeltaVarInt(IOBuffer& buf, int sliceSize, ChunkIdVersions& chunks,
+    int64_t& maxSliceUsec, bool& errorFlag)
+{
+    const int64_t        start  = microseconds();
+    VarIntCodec::Decoder decoder;
+    int64_t              prev   = 0;
+    int64_t              id     = 0;
+    bool                 idFlag = true;
+    maxSliceUsec = 0;
+    errorFlag    = false;
+    while (! buf.IsEmpty() && ! errorFlag) {
+        const int64_t          sliceStart = microseconds();
+        IOBuffer::ByteIterator it(buf);
+        const char*            p;
+        int                    len        = 0;
+        while (len < sliceSize && (p = it.Next())) {
+            len++;
+            const int ret = decoder.Add((unsigned char)*p);
+            if (ret <= 0) {
+                if (ret < 0) {
+                    errorFlag = true;
+                    break;
+                }
+                continue;
+            }
+            const uint64_t val = decoder.Get();
+            if (idFlag) {
+                id   = prev + (int64_t)val;
+                prev = id;
+            } else {
+                chunks.push_back(make_pair(id, (int64_t)val));
+            }
+            idFlag = ! idFlag;
+        }
+        buf.Consume(len);
+        maxSliceUsec = max(maxSliceUsec, microseconds() - sliceStart);
+    }
+    errorFlag = errorFlag || ! decoder.IsEmpty() || ! idFlag;
+    return (microseconds() - start);
+}
+
+static bool
+TestVarInt()
+{
+    const uint64_t vals[] = {
+        0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, (uint64_t(1) << 32) - 1,
+        uint64_t(1) << 56, ~uint64_t(0) >> 1, ~uint64_t(0)
+    };
+    for (size_t i = 0; i < sizeof(vals) / sizeof(vals[0]); i++) {
+        char        buf[VarIntCodec::kMaxEncodedLength];
+        const char* end = VarIntCodec::Encode(vals[i], buf);
+        if (end - buf != VarIntCodec::EncodedLength(vals[i])) {
+            cerr << "invalid encoded length: " << vals[i] << "\n";
+            return false;
+        }
+        VarIntCodec::Decoder decoder;
+        int                  ret = 0;
+        for (const char* p = buf; p < end && 0 == ret; ++p) {
+            ret = decoder.Add((unsigned char)*p);
+        }
+        if (1 != ret || decoder.Get() != vals[i]) {
+            cerr << "varint round trip failure: " << vals[i] << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    int64_t count     = 10 * 1000 * 1000;
+    int64_t maxVers   = 16;
+    int     sliceSize = 64 << 10;
+    int     opt;
+    while ((opt = getopt(argc, argv, "hn:v:s:")) != -1) {
+        switch (opt) {
+            case 'n': count     = atoll(optarg); break;
+            case 'v': maxVers   = atoll(optarg); break;
+            case 's': sliceSize = atoi(optarg);  break;
+            default:
+                cout << "Usage: " << argv[0] <<
+                    " [-n <chunk count> (default 10M)]"
+                    " [-v <max chunk version> (default 16)]"
+                    " [-s <decode slice size> (default 64K)]\n";
+                return (opt == 'h' ? 0 : 1);
+        }
+    }
+    if (count <= 0 || maxVers <= 0 || sliceSize <= 0) {
+        cerr << "invalid arguments\n";
+        return 1;
+    }
+    if (! TestVarInt()) {
+        return 1;
+    }
+    // Chunk ids are allocated sequentially by the meta server, and chunk
+    // server gets a random subset of those ids. Chunk table iteration order
+    // is effectively random.
+    srand(1);
+    ChunkIdVersions chunks;
+    chunks.reserve((size_t)count);
+    int64_t id = 1 << 20;
+    for (int64_t i = 0; i < count; i++) {
+        id += 1 + rand() % 64;
+        chunks.push_back(make_pair(id, 1 + rand() % maxVers));
+    }
+    for (int64_t i = count - 1; 0 < i; i--) {
+        swap(chunks[i], chunks[rand() % (i + 1)]);
+    }
+    ChunkIdVersions expected(chunks);
+    sort(expected.begin(), expected.end());
+
+    IOBuffer        buf;
+    ChunkIdVersions decoded;
+    decoded.reserve((size_t)count);
+    const int64_t hexEncUsec = EncodeHex(chunks, buf);
+    const int64_t hexBytes   = buf.BytesConsumable();
+    const int64_t hexDecUsec = DecodeHex(buf, decoded);
+    sort(decoded.begin(), decoded.end());
+    if (decoded != expected) {
+        cerr << "hex round trip failure\n";
+        return 1;
+    }
+    decoded.clear();
+    const int64_t dvEncUsec = EncodeDeltaVarInt(chunks, buf);
+    const int64_t dvBytes   = buf.BytesConsumable();
+    int64_t       maxSliceUsec;
+    bool          errorFlag;
+    const int64_t dvDecUsec = DecodeDeltaVarInt(
+        buf, sliceSize, decoded, maxSliceUsec, errorFlag);
+    if (errorFlag || decoded != expected) {
+        cerr << "delta varint round trip failure\n";
+        return 1;
+    }
+    cout <<
+        "chunks: "            << count <<
+        "\nhex:"
+        " bytes: "            << hexBytes <<
+        " encode usec: "      << hexEncUsec <<
+        " decode usec: "      << hexDecUsec <<
+        "\ndelta varint:"
+        " bytes: "            << dvBytes <<
+        " encode usec: "      << dvEncUsec <<
+        " decode usec: "      << dvDecUsec <<
+        " slice: "            << sliceSize <<
+        " max slice usec: "   << maxSliceUsec <<
+        "\nsize ratio: "      << (double)hexBytes / max(int64_t(1), dvBytes) <<
+        " decode ratio: "     <<
+            (double)hexDecUsec / max(int64_t(1), dvDecUsec) <<
+    "\n";
+    return 0;
+}
@@ -0,0 +1,204 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Quantcast File System.
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Locally repairable code erasure patterns test. For each data and
+// recovery stripe count configuration, sweeps every lost stripes pattern, and
+// checks that LrcStripeLayout::CanRecover() returns true if and only if the
+// decoder recovers the lost stripes, and that the recovered data matches.
+// LrcStripeLayout::GetFailureTolerance() is checked to be less than the
+// smallest unrecoverable pattern.
+//
+//----------------------------------------------------------------------------
+
+#include "common/LrcStripeLayout.h"
+#include "common/kfstypes.h"
+#include "libclient/ECMethod.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace KFS;
+using namespace std;
+
+using KFS::client::ECMethod;
+
+static bool
+TestPatterns(int stripes, int recovery, int length)
+{
+    string                   errMsg;
+    ECMethod::Encoder* const encoder = ECMethod::FindEncoder(
+        KFS_STRIPED_FILE_TYPE_LRC, stripes, recovery, &errMsg);
+    ECMethod::Decoder* const decoder = encoder ? ECMethod::FindDecoder(
+        KFS_STRIPED_FILE_TYPE_LRC, stripes, recovery, &errMsg) : 0;
+    if (! decoder) {
+        cerr << stripes << "+" << recovery << ": " << errMsg << "\n";
+        if (encoder) {
+            encoder->Release();
+        }
+        return false;
+    }
+    const int     count = stripes + recovery;
+    vector<char>  expected((size_t)count * length);
+    vector<char>  data((size_t)count * length);
+    vector<void*> bufs(count);
+    vector<int>   missing(count + 1);
+    vector<char>  lost(count);
+    for (int i = 0; i < count; i++) {
+        bufs[i] = &expected[(size_t)i * length];
+    }
+    for (size_t i = 0; i < (size_t)stripes * length; i++) {
+        expected[i] = (char)rand();
+    }
+    bool ok = 0 == encoder->Encode(stripes, recovery, length, &bufs[0]);
+    if (! ok) {
+        cerr << stripes << "+" << recovery << ": encode failure\n";
+    }
+    for (int i = 0; i < count; i++) {
+        bufs[i] = &data[(size_t)i * length];
+    }
+    const int     tolerance    =
+        LrcStripeLayout::GetFailureTolerance(recovery);
+    int64_t       recoverable  = 0;
+    int           minFailCount = count + 1;
+    const int64_t end          = int64_t(1) << count;
+    for (int64_t pattern = 1; ok && pattern < end; pattern++) {
+        int lostCount = 0;
+        memcpy(&data[0], &expected[0], data.size());
+        for (int i = 0; i < count; i++) {
+            lost[i] = (char)((pattern >> i) & 1);
+            if (lost[i]) {
+                missing[lostCount++] = i;
+                memset(bufs[i], 0x5A, length);
+            }
+        }
+        missing[lostCount] = -1;
+        const bool canRecoverFlag =
+            LrcStripeLayout::CanRecover(stripes, recovery, &lost[0]);
+        const bool decodedFlag = 0 == decoder->Decode(
+            stripes, recovery, length, &bufs[0], &missing[0]);
+        if (canRecoverFlag != decodedFlag) {
+            cerr << stripes << "+" << recovery << ": lost:";
+            for (int i = 0; i < lostCount; i++) {
+                cerr << " " << missing[i];
+            }
+            cerr << " can recover: " << canRecoverFlag <<
+                " decoded: " << decodedFlag << "\n";
+            ok = false;
+            break;
+        }
+        if (! decodedFlag) {
+            if (lostCount < minFailCount) {
+                minFailCount = lostCount;
+            }
+            continue;
+        }
+        recoverable++;
+        if (data != expected) {
+            cerr << stripes << "+" << recovery <<
+                ": recovered data mismatch, pattern: " << pattern << "\n";
+            ok = false;
+        }
+    }
+    if (ok && minFailCount <= tolerance) {
+        cerr << stripes << "+" << recovery <<
+            ": failure tolerance: " << tolerance <<
+            " unrecoverable: " << minFailCount << " lost stripes\n";
+        ok = false;
+    }
+    if (ok) {
+        cout << stripes << "+" << recovery <<
+            " patterns: "      << (end - 1) <<
+            " recoverable: "   << recoverable <<
+            " min lost unrecoverable: " << minFailCount <<
+            "\n";
+    }
+    encoder->Release();
+    decoder->Release();
+    return ok;
+}
+
+int
+main(int argc, char** argv)
+{
+    int length   = 64;
+    int maxCount = 18;
+    int opt;
+    while ((opt = getopt(argc, argv, "hl:m:")) != -1) {
+        switch (opt) {
+            case 'l': length   = atoi(optarg); break;
+            case 'm': maxCount = atoi(optarg); break;
+            default:
+                cout << "Usage: " << argv[0] <<
+                    " [-l <stripe length> (default 64)]"
+                    " [-m <max total stripe count> (default 18)]"
+                    " [<data stripes>+<recovery stripes> ...]\n";
+                return (opt == 'h' ? 0 : 1);
+        }
+    }
+    if (length <= 0 || maxCount <= 0 || 30 < maxCount) {
+        cerr << "invalid arguments\n";
+        return 1;
+    }
+    if (ECMethod::InitAll() <= 0) {
+        cerr << "no ec methods\n";
+        return 1;
+    }
+    srand(1);
+    int failures = 0;
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++) {
+            int stripes  = -1;
+            int recovery = -1;
+            if (sscanf(argv[i], "%d+%d", &stripes, &recovery) != 2 ||
+                    30 < stripes + recovery) {
+                cerr << "invalid configuration: " << argv[i] << "\n";
+                return 1;
+            }
+            if (! TestPatterns(stripes, recovery, length)) {
+                failures++;
+            }
+        }
+    } else {
+        for (int recovery = LrcStripeLayout::kMinRecoveryStripeCount;
+                recovery < maxCount;
+                recovery++) {
+            for (int stripes =
+                        LrcStripeLayout::GetLocalGroupCount(recovery);
+                    stripes + recovery <= maxCount;
+                    stripes++) {
+                if (! TestPatterns(stripes, recovery, length)) {
+                    failures++;
+                }
+            }
+        }
+    }
+    if (failures != 0) {
+        cerr << "failures: " << failures << "\n";
+        return 1;
+    }
+    return 0;
+}
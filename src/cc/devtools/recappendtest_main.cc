@@ -0,0 +1,316 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Quantcast File System.
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Atomic record append test. In append mode appends the specified
+// number of records with the writer id, sequence number, and the payload
+// derived from both. In verify mode reads the file, and checks that every
+// record of every writer is present exactly once, and its payload is intact.
+// Used by recappendtest.sh to test chunk server record append group commit
+// with chunk server failures.
+//
+//----------------------------------------------------------------------------
+
+#include "common/MsgLogger.h"
+#include "libclient/KfsClient.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace KFS;
+using namespace std;
+
+const size_t kHeaderSize    = 16;
+const char   kRecordMagic[] = { 'R', 'A', 'P', 'T' };
+
+static inline void
+PutUint32(char* ptr, uint32_t val)
+{
+    for (int i = 0; i < 4; i++) {
+        ptr[i] = (char)(val >> (8 * i));
+    }
+}
+
+static inline uint32_t
+GetUint32(const char* ptr)
+{
+    uint32_t ret = 0;
+    for (int i = 0; i < 4; i++) {
+        ret |= (uint32_t)(unsigned char)ptr[i] << (8 * i);
+    }
+    return ret;
+}
+
+static inline uint32_t
+NextRand(uint64_t& state)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(state >> 33);
+}
+
+static void
+MakeRecord(uint32_t writer, uint32_t seq, uint32_t maxPayloadSize,
+    string& record)
+{
+    uint64_t       state = ((uint64_t)writer << 32) | seq;
+    const uint32_t len   = NextRand(state) % (maxPayloadSize + 1);
+    record.resize(kHeaderSize + len);
+    char* const ptr = &record[0];
+    memcpy(ptr, kRecordMagic, sizeof(kRecordMagic));
+    PutUint32(ptr + 4,  writer);
+    PutUint32(ptr + 8,  seq);
+    PutUint32(ptr + 12, len);
+    for (uint32_t i = 0; i < len; i++) {
+        ptr[kHeaderSize + i] = (char)NextRand(state);
+    }
+}
+
+static int
+Create(KfsClient& client, const char* fileName, int replicas)
+{
+    const int fd = client.Open(
+        fileName, O_CREAT | O_EXCL | O_WRONLY, replicas);
+    if (fd < 0) {
+        cerr << fileName << ": " << ErrorCodeToStr(fd) << "\n";
+        return fd;
+    }
+    return client.Close(fd);
+}
+
+static int
+Append(KfsClient& client, const char* fileName, uint32_t writer,
+    uint32_t count, uint32_t maxPayloadSize)
+{
+    // Open without O_CREAT, as non exclusive create replaces existing file.
+    const int fd = client.Open(fileName, O_APPEND | O_WRONLY);
+    if (fd < 0) {
+        cerr << fileName << ": " << ErrorCodeToStr(fd) << "\n";
+        return fd;
+    }
+    string record;
+    int    ret = 0;
+    for (uint32_t seq = 0; seq < count; seq++) {
+        MakeRecord(writer, seq, maxPayloadSize, record);
+        const int res = client.AtomicRecordAppend(
+            fd, record.data(), (int)record.size());
+        if (res != (int)record.size()) {
+            cerr << fileName << ": writer: " << writer << " record: " << seq <<
+                " append failure: " <<
+                    (res < 0 ? ErrorCodeToStr(res) : string("short write")) <<
+                "\n";
+            ret = res < 0 ? res : -EIO;
+            break;
+        }
+    }
+    const int res = client.Close(fd);
+    if (res < 0) {
+        cerr << fileName << ": writer: " << writer << " close failure: " <<
+            ErrorCodeToStr(res) << "\n";
+        if (0 == ret) {
+            ret = res;
+        }
+    }
+    return ret;
+}
+
+static int
+Verify(KfsClient& client, const char* fileName, uint32_t writers,
+    uint32_t count, uint32_t maxPayloadSize)
+{
+    client.SetDefaultFullSparseFileSupport(true);
+    const int fd = client.Open(fileName, O_RDONLY);
+    if (fd < 0) {
+        cerr << fileName << ": " << ErrorCodeToStr(fd) << "\n";
+        return fd;
+    }
+    string       data;
+    const size_t kReadSize = 1 << 20;
+    for (; ;) {
+        const size_t size = data.size();
+        data.resize(size + kReadSize);
+        const ssize_t res = client.Read(fd, &data[size], kReadSize);
+        if (res < 0) {
+            cerr << fileName << ": read failure: " << ErrorCodeToStr(res) <<
+                "\n";
+            client.Close(fd);
+            return (int)res;
+        }
+        data.resize(size + res);
+        if (res == 0) {
+            break;
+        }
+    }
+    client.Close(fd);
+    vector<vector<bool> > seen(writers, vector<bool>(count, false));
+    string                record;
+    int64_t               errors  = 0;
+    int64_t               records = 0;
+    size_t                pos     = 0;
+    while (pos < data.size()) {
+        if (0 == data[pos]) {
+            // Skip holes at the end of chunks.
+            pos++;
+            continue;
+        }
+        if (data.size() < pos + kHeaderSize ||
+                memcmp(&data[pos], kRecordMagic, sizeof(kRecordMagic)) != 0) {
+            cerr << fileName << ": pos: " << pos <<
+                " invalid record header\n";
+            errors++;
+            break;
+        }
+        const uint32_t writer = GetUint32(&data[pos + 4]);
+        const uint32_t seq    = GetUint32(&data[pos + 8]);
+        const uint32_t len    = GetUint32(&data[pos + 12]);
+        if (writers <= writer || count <= seq || maxPayloadSize < len ||
+                data.size() < pos + kHeaderSize + len) {
+            cerr << fileName << ": pos: " << pos <<
+                " writer: " << writer << " record: " << seq <<
+                " length: " << len << " invalid record\n";
+            errors++;
+            break;
+        }
+        MakeRecord(writer, seq, maxPayloadSize, record);
+        if (record.size() != kHeaderSize + len ||
+                memcmp(record.data(), &data[pos], record.size()) != 0) {
+            cerr << fileName << ": pos: " << pos <<
+                " writer: " << writer << " record: " << seq <<
+                " payload mismatch\n";
+            errors++;
+        } else if (seen[writer][seq]) {
+            cerr << fileName << ": pos: " << pos <<
+                " writer: " << writer << " record: " << seq <<
+                " duplicate record\n";
+            errors++;
+        } else {
+            seen[writer][seq] = true;
+            records++;
+        }
+        pos += kHeaderSize + len;
+    }
+    for (uint32_t w = 0; w < writers; w++) {
+        for (uint32_t s = 0; s < count; s++) {
+            if (! seen[w][s]) {
+                cerr << fileName << ": writer: " << w << " record: " << s <<
+                    " missing\n";
+                errors++;
+            }
+        }
+    }
+    cout << fileName << ": size: " << data.size() <<
+        " records: " << records << " errors: " << errors << "\n";
+    return (0 == errors ? 0 : -EINVAL);
+}
+
+int
+main(int argc, char** argv)
+{
+    int         optchar;
+    bool        help           = false;
+    int         port           = -1;
+    const char* metaserver     = 0;
+    const char* fileName       = 0;
+    const char* config         = 0;
+    int         replicas       = 3;
+    int         writer         = 0;
+    int         writers        = 0;
+    int         count          = 10000;
+    int         maxPayloadSize = 2048;
+    bool        verboseLogging = false;
+    bool        createFlag     = false;
+
+    while ((optchar = getopt(argc, argv, "s:p:k:f:r:w:V:n:m:cvh")) != -1) {
+        switch (optchar) {
+            case 's':
+                metaserver = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'k':
+                fileName = optarg;
+                break;
+            case 'f':
+                config = optarg;
+                break;
+            case 'r':
+                replicas = atoi(optarg);
+                break;
+            case 'w':
+                writer = atoi(optarg);
+                break;
+            case 'V':
+                writers = atoi(optarg);
+                break;
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'm':
+                maxPayloadSize = atoi(optarg);
+                break;
+            case 'c':
+                createFlag = true;
+                break;
+            case 'v':
+                verboseLogging = true;
+                break;
+            case 'h':
+            default:
+                help = true;
+                break;
+        }
+    }
+    help = help || ! metaserver || port < 0 || ! fileName ||
+        writer < 0 || writers < 0 || count < 0 || maxPayloadSize < 0 ||
+        replicas <= 0;
+    if (help) {
+        cout << "Usage: " << argv[0] <<
+            " -s <metaserver> -p <port> -k <QFSfile>"
+            " [-f <config file name>] [-c [-r <replicas>]] [-w <writer id>]"
+            " [-V <writers count>] [-n <records>] [-m <max payload size>]"
+            " [-v]\n"
+            " -c: create the file with the specified number of replicas\n"
+            " -V: verify the records of all writers, otherwise append the"
+            " records\n"
+            "     with the writer id\n";
+        return 1;
+    }
+    MsgLogger::Init(0, verboseLogging ?
+        MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelINFO);
+
+    KfsClient* const client = KfsClient::Connect(metaserver, port, config);
+    if (! client) {
+        cerr << "qfs client failed to initialize\n";
+        return 1;
+    }
+    const int ret = createFlag ?
+        Create(*client, fileName, replicas) : (0 < writers ?
+        Verify(*client, fileName, writers, count, maxPayloadSize) :
+        Append(*client, fileName, writer, count, maxPayloadSize));
+    delete client;
+    MsgLogger::Stop();
+    return (0 == ret ? 0 : 1);
+}
@@ -0,0 +1,268 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file rpcformatbench_main.cc
+// \brief Short text and binary rpc request format encode and parse
+// single thread benchmark.
+//
+// Usage: rpcformatbench [iterations]
+//
+//----------------------------------------------------------------------------
+
+#include "common/RequestParser.h"
+#include "common/BinaryRpc.h"
+#include "common/ReqOstream.h"
+#include "common/StBuffer.h"
+#include "common/time.h"
+#include "kfsio/IOBuffer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <string>
+
+using namespace KFS;
+using std::string;
+using std::hex;
+
+class ReadTest
+{
+public:
+    int64_t         seq;
+    int             protoVers;
+    int64_t         chunkId;
+    int64_t         chunkVersion;
+    int64_t         offset;
+    int64_t         numBytes;
+    int64_t         subjectId;
+    StringBufT<256> access;
+    bool            skipVerifyDiskChecksumFlag;
+
+    ReadTest()
+        : seq(-1),
+          protoVers(-1),
+          chunkId(-1),
+          chunkVersion(-1),
+          offset(-1),
+          numBytes(-1),
+          subjectId(-1),
+          access(),
+          skipVerifyDiskChecksumFlag(false)
+        {}
+    bool Validate() const
+        { return true; }
+    bool ValidateRequestHeader(
+        const char* /* name */,
+        size_t      /* nameLen */,
+        const char* /* header */,
+        size_t      /* headerLen */,
+        bool        /* hasChecksum */,
+        uint32_t    /* checksum */,
+        bool        /* shortFieldNamesFlag */)
+        { return true; }
+    bool HandleUnknownField(
+        const char* /* key */, size_t /* keyLen */,
+        const char* /* val */, size_t /* valLen */)
+        { return true; }
+    template<typename T> static T& ParserDef(
+        T& inParser)
+    {
+        return inParser
+        .Def2("Cseq",             "c", &ReadTest::seq,          int64_t(-1))
+        .Def2("Client-Protocol-Version", "p",
+                                       &ReadTest::protoVers,    -1         )
+        .Def2("Chunk-handle",     "H", &ReadTest::chunkId,      int64_t(-1))
+        .Def2("Chunk-version",    "V", &ReadTest::chunkVersion, int64_t(-1))
+        .Def2("Offset",           "O", &ReadTest::offset,       int64_t(-1))
+        .Def2("Num-bytes",        "B", &ReadTest::numBytes,     int64_t(-1))
+        .Def2("Subject-id",       "I", &ReadTest::subjectId,    int64_t(-1))
+        .Def2("C-access",         "C", &ReadTest::access                   )
+        .Def2("Skip-Disk-Chksum", "KS",
+                                &ReadTest::skipVerifyDiskChecksumFlag, false)
+        ;
+    }
+};
+
+template <typename SUPER, typename OBJ>
+class ShortNamesTestParser : public RequestParser<
+    SUPER,
+    OBJ,
+    ValueParserT<HexIntParser>,
+    true, // Use short names / format.
+    PropertiesTokenizer,
+    NopOstream,
+    true,  // Invoke Validate
+    RequestDeleter,
+    RequestParserShortNamesDictionary
+> {};
+typedef RequestHandler<
+    ReadTest,
+    ShortNamesTestParser
+> TestRequestHandler;
+
+static const TestRequestHandler& MakeRequestHandler()
+{
+    static TestRequestHandler sHandler;
+    return sHandler
+        .MakeParser<ReadTest>("READ")
+    ;
+}
+static const TestRequestHandler& sReqHandler = MakeRequestHandler();
+
+static const char* const kAccess =
+    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
+
+static void
+WriteText(
+    ReqOstreamT<std::ostream>& os,
+    int64_t                    seq)
+{
+    os << hex <<
+        "READ\r\n"
+        "c:" << seq                  << "\r\n"
+        "p:" << 116                  << "\r\n"
+        "H:" << int64_t(123456789)   << "\r\n"
+        "V:" << int64_t(1)           << "\r\n"
+        "O:" << (int64_t(1) << 20)   << "\r\n"
+        "B:" << (int64_t(1) << 20)   << "\r\n"
+        "I:" << int64_t(987654321)   << "\r\n"
+        "C:" << kAccess              << "\r\n"
+        "\r\n";
+}
+
+static void
+WriteBinary(
+    BinaryRpcWriter& wr,
+    int64_t          seq)
+{
+    wr.Begin("READ")
+        .AddInt("c", seq)
+        .AddInt("p", 116)
+        .AddInt("H", int64_t(123456789))
+        .AddInt("V", int64_t(1))
+        .AddInt("O", int64_t(1) << 20)
+        .AddInt("B", int64_t(1) << 20)
+        .AddInt("I", int64_t(987654321))
+        .AddBytes("C", kAccess, strlen(kAccess));
+    wr.End();
+}
+
+static bool
+Check(
+    const ReadTest* op,
+    int64_t         seq)
+{
+    return (op &&
+        op->seq          == seq &&
+        op->protoVers    == 116 &&
+        op->chunkId      == 123456789 &&
+        op->chunkVersion == 1 &&
+        op->offset       == (int64_t(1) << 20) &&
+        op->numBytes     == (int64_t(1) << 20) &&
+        op->subjectId    == 987654321 &&
+        op->access.GetSize() == strlen(kAccess)
+    );
+}
+
+static void
+Report(
+    const char* name,
+    int64_t     count,
+    int64_t     startUsec,
+    size_t      reqSize)
+{
+    const int64_t usec = microseconds() - startUsec;
+    std::cout << name <<
+        ": " << count << " ops " << usec * 1e-6 << " sec " <<
+        (usec > 0 ? count * 1e6 / usec : 0.) << " ops/sec/core " <<
+        reqSize << " bytes/request\n";
+}
+
+int
+main(int argc, char** argv)
+{
+    if (1 < argc && (! strcmp(argv[1], "-h") || ! strcmp(argv[1], "--help"))) {
+        std::cout << "Usage: " << argv[0] << " [iterations]\n";
+        return 0;
+    }
+    const int64_t count = 1 < argc ? (int64_t)atof(argv[1]) : int64_t(1e6);
+
+    IOBuffer           buffer;
+    IOBuffer::WOStream wostream;
+    BinaryRpcWriter    writer;
+
+    int64_t start = microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        ReqOstreamT<std::ostream> os(wostream.Set(buffer));
+        WriteText(os, i);
+        wostream.Reset();
+        buffer.Clear();
+    }
+    ReqOstreamT<std::ostream> os(wostream.Set(buffer));
+    WriteText(os, count);
+    wostream.Reset();
+    const string text(buffer.BytesConsumable(), char(0));
+    buffer.CopyOut(const_cast<char*>(text.data()), (int)text.size());
+    buffer.Clear();
+    Report("text encode", count, start, text.size());
+
+    start = microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        WriteBinary(writer, i);
+        buffer.CopyIn(writer.GetPtr(), (int)writer.GetSize());
+        buffer.Clear();
+    }
+    WriteBinary(writer, count);
+    const string binary(writer.GetPtr(), writer.GetSize());
+    Report("binary encode", count, start, binary.size());
+
+    int errors = 0;
+    start = microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        ReadTest* const op = sReqHandler.Handle(text.data(), text.size());
+        if (! Check(op, count)) {
+            errors++;
+        }
+        delete op;
+    }
+    Report("text parse", count, start, text.size());
+
+    start = microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        ReadTest* const op = sReqHandler.HandleBinary(
+            binary.data(), binary.size());
+        if (! Check(op, count)) {
+            errors++;
+        }
+        delete op;
+    }
+    Report("binary parse", count, start, binary.size());
+
+    if (errors) {
+        std::cout << "parse errors: " << errors << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,236 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file timerwheelbench_main.cc
+// \brief Single level and hierarchical timer wheel schedule, re-schedule,
+// cancel, and expiration single thread benchmark.
+//
+// Usage: timerwheelbench [timers [max timeout sec]]
+//
+//----------------------------------------------------------------------------
+
+#include "common/TimerWheel.h"
+#include "common/HierarchicalTimerWheel.h"
+#include "common/time.h"
+#include "qcdio/QCDLList.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+using namespace KFS;
+
+class TimerEntry : public HierarchicalTimerWheelEntry<int64_t>
+{
+public:
+    typedef QCDLListOp<TimerEntry, 0> List;
+
+    TimerEntry()
+        : HierarchicalTimerWheelEntry<int64_t>(),
+          mExpires(0)
+        { List::Init(*this); }
+    ~TimerEntry()
+        { List::Remove(*this); }
+    int64_t mExpires;
+private:
+    TimerEntry* mPrevPtr[1];
+    TimerEntry* mNextPtr[1];
+    friend class QCDLListOp<TimerEntry, 0>;
+private:
+    TimerEntry(const TimerEntry&);
+    TimerEntry& operator=(const TimerEntry&);
+};
+
+// The same number of slots as the net manager used to have.
+typedef TimerWheel<
+    TimerEntry,
+    TimerEntry::List,
+    int64_t,
+    1 << 8,
+    1
+> FlatTimerWheel;
+
+typedef HierarchicalTimerWheel<
+    TimerEntry,
+    TimerEntry::List,
+    int64_t,
+    6,
+    4,
+    1
+> HTimerWheel;
+
+template<typename WT>
+class Expire
+{
+public:
+    Expire(
+        WT& wheel)
+        : mWheel(wheel),
+          mNow(0),
+          mExpiredCount(0),
+          mRescheduledCount(0),
+          mLateCount(0)
+        {}
+    void operator()(
+        TimerEntry& entry)
+    {
+        if (mNow < entry.mExpires) {
+            // Single level wheel clamps long timeouts, re-schedule.
+            mWheel.Schedule(entry, entry.mExpires);
+            mRescheduledCount++;
+            return;
+        }
+        if (entry.mExpires + 1 < mNow) {
+            mLateCount++;
+        }
+        TimerEntry::List::Remove(entry);
+        mExpiredCount++;
+    }
+    WT&     mWheel;
+    int64_t mNow;
+    int64_t mExpiredCount;
+    int64_t mRescheduledCount;
+    int64_t mLateCount;
+private:
+    Expire(const Expire&);
+    Expire& operator=(const Expire&);
+};
+
+static void
+Report(
+    const char* name,
+    const char* op,
+    int64_t     count,
+    int64_t     startUsec)
+{
+    const int64_t usec = microseconds() - startUsec;
+    std::cout << name << " " << op <<
+        ": " << count << " ops " << usec * 1e-6 << " sec " <<
+        (usec > 0 ? count * 1e6 / usec : 0.) << " ops/sec/core\n";
+}
+
+static inline uint64_t
+NextRandom(
+    uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+template<typename WT>
+static int
+Run(
+    const char* name,
+    TimerEntry* entries,
+    int64_t     count,
+    int64_t     maxTimeout,
+    bool        exactFlag)
+{
+    const int64_t kStartTime = 1000;
+    WT            wheel(kStartTime + 1);
+    uint64_t      rnd = 0x9E3779B97F4A7C15ull;
+
+    int64_t start = microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        TimerEntry& entry = entries[i];
+        entry.mExpires = kStartTime + 1 +
+            (int64_t)(NextRandom(rnd) % (uint64_t)maxTimeout);
+        wheel.Schedule(entry, entry.mExpires);
+    }
+    Report(name, "schedule", count, start);
+
+    start = microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        TimerEntry& entry = entries[i];
+        entry.mExpires = kStartTime + 1 +
+            (int64_t)(NextRandom(rnd) % (uint64_t)maxTimeout);
+        wheel.Schedule(entry, entry.mExpires);
+    }
+    Report(name, "re-schedule", count, start);
+
+    start = microseconds();
+    int64_t cancelCount = 0;
+    for (int64_t i = 0; i < count; i += 2) {
+        TimerEntry::List::Remove(entries[i]);
+        cancelCount++;
+    }
+    Report(name, "cancel", cancelCount, start);
+
+    Expire<WT> expire(wheel);
+    start = microseconds();
+    for (int64_t now = kStartTime;
+            now <= kStartTime + maxTimeout + 1;
+            now++) {
+        expire.mNow = now;
+        wheel.Run(now, expire);
+    }
+    Report(name, "expire", expire.mExpiredCount, start);
+    std::cout << name << ": rescheduled by timer: " <<
+        expire.mRescheduledCount << "\n";
+
+    int64_t remaining = 0;
+    for (int64_t i = 0; i < count; i++) {
+        if (TimerEntry::List::IsInList(entries[i])) {
+            TimerEntry::List::Remove(entries[i]);
+            remaining++;
+        }
+    }
+    if (expire.mExpiredCount + cancelCount != count ||
+            0 < remaining || 0 < expire.mLateCount ||
+            (exactFlag && 0 < expire.mRescheduledCount)) {
+        std::cout << name << ": error:"
+            " expired: "   << expire.mExpiredCount <<
+            " cancelled: " << cancelCount <<
+            " remaining: " << remaining <<
+            " late: "      << expire.mLateCount <<
+        "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (1 < argc && (! strcmp(argv[1], "-h") || ! strcmp(argv[1], "--help"))) {
+        std::cout << "Usage: " << argv[0] << " [timers [max timeout sec]]\n";
+        return 0;
+    }
+    const int64_t count      = 1 < argc ? (int64_t)atof(argv[1]) : int64_t(1e7);
+    const int64_t maxTimeout = 2 < argc ? (int64_t)atof(argv[2]) : 3600;
+    if (count <= 0 || maxTimeout <= 0) {
+        std::cout << "invalid arguments\n";
+        return 1;
+    }
+    TimerEntry* const entries = new TimerEntry[count];
+    int errors = 0;
+    // The hierarchical wheel must not deliver entries before expiration.
+    errors += Run<HTimerWheel>(
+        "hierarchical", entries, count, maxTimeout, true);
+    errors += Run<FlatTimerWheel>(
+        "single level", entries, count, maxTimeout, false);
+    delete [] entries;
+    return (errors == 0 ? 0 : 1);
+}
@@ -37,6 +37,7 @@
 #include <map>
 
 #include "common/kfsatomic.h"
+#include "common/LatencyHistogram.h"
 
 namespace KFS
 {
@@ -99,6 +100,36 @@ protected:
     volatile int64_t mTimeSpent;
 };
 
+/// Latency distribution counter. Show prints the number of samples, average,
+/// 50, 90, 99, 99.9 percentiles, and max in microseconds, and omits the
+/// counter if no samples were recorded.
+class LatencyCounter : public Counter {
+public:
+    LatencyCounter() : Counter(), mHistogram() { }
+    LatencyCounter(const char *name) : Counter(name), mHistogram() { }
+
+    virtual void Show(ostream &os) {
+        if (mHistogram.GetCount() <= 0) {
+            return;
+        }
+        os << mName << ": " << mHistogram << "\r\n";
+    }
+
+    virtual void UpdateTime(int64_t timeSpentMicroSec) {
+        Counter::Update(1);
+        Counter::UpdateTime(timeSpentMicroSec);
+        mHistogram.Record(timeSpentMicroSec);
+    }
+
+    virtual void Reset() { Counter::Reset(); mHistogram.Clear(); }
+
+    const LatencyHistogram& GetHistogram() const {
+        return mHistogram;
+    }
+private:
+    LatencyHistogram mHistogram;
+};
+
 class ShowCounter {
     ostream &os;
 public:
@@ -32,6 +32,7 @@
 #include "IOBuffer.h"
 #include "TcpSocket.h"
 #include "common/StdAllocator.h"
+#include "common/HierarchicalTimerWheel.h"
 #include "qcdio/QCDLList.h"
 
 #include <time.h>
@@ -428,12 +429,13 @@ public:
     bool IsReadPending() const
         { return (mFilter && IsReadReady() && mFilter->IsReadPending()); }
 
-    class NetManagerEntry
+    class NetManagerEntry : public HierarchicalTimerWheelEntry<time_t>
     {
     public:
         typedef list<NetConnectionPtr,
             StdFastAllocator<NetConnectionPtr> > List;
         typedef QCDLListOp<NetManagerEntry, 0>   PendingReadList;
+        typedef QCDLListOp<NetManagerEntry, 1>   TimerList;
 
         NetManagerEntry()
             : mIn(false),
@@ -446,13 +448,18 @@ public:
               mPendingResetTimerFlag(false),
               mFd(-1),
               mWriteByteCount(0),
-              mTimerWheelSlot(-1),
               mExpirationTime(-1),
               mNetManager(0),
               mListIt()
-            { PendingReadList::Init(*this); }
+        {
+            PendingReadList::Init(*this);
+            TimerList::Init(*this);
+        }
         ~NetManagerEntry()
-            { PendingReadList::Remove(*this); }
+        {
+            PendingReadList::Remove(*this);
+            TimerList::Remove(*this);
+        }
         void EnableReadIfOverloaded()     { mEnableReadIfOverloaded  = true; }
         void SetConnectPending(bool flag) { mConnectPending = flag; }
         bool IsConnectPending() const     { return mConnectPending; }
@@ -475,12 +482,11 @@ public:
         bool             mPendingResetTimerFlag:1;
         int              mFd;
         int              mWriteByteCount;
-        int              mTimerWheelSlot;
         time_t           mExpirationTime;
         NetManager*      mNetManager;
         List::iterator   mListIt;
-        NetManagerEntry* mPrevPtr[1];
-        NetManagerEntry* mNextPtr[1];
+        NetManagerEntry* mPrevPtr[2];
+        NetManagerEntry* mNextPtr[2];
 
         void CloseSocket(NetConnection& con)
         {
@@ -498,6 +504,7 @@ public:
         }
         friend class NetManager;
         friend class QCDLListOp<NetManagerEntry, 0>;
+        friend class QCDLListOp<NetManagerEntry, 1>;
 
     private:
         NetManagerEntry(const NetManagerEntry&);
@@ -51,18 +51,17 @@ using std::numeric_limits;
 
 NetManager::NetManager(int timeoutMs)
     : mRemove(),
-      mTimerWheelBucketItr(mRemove.end()),
+      mConnectionsItr(mRemove.end()),
       mCurConnection(0),
-      mCurTimerWheelSlot(0),
       mConnectionsCount(0),
       mDiskOverloaded(false),
       mNetworkOverloaded(false),
       mIsOverloaded(false),
       mRunFlag(true),
       mShutdownFlag(false),
-      mTimerRunningFlag(false),
       mPollFlag(false),
       mTimeoutMs(timeoutMs),
+      mPollTimeoutMs(timeoutMs),
       mStartTime(time(0)),
       mNow(mStartTime),
       mLastTimerTime(mNow - 1),
@@ -77,7 +76,9 @@ NetManager::NetManager(int timeoutMs)
       mPendingReadList(),
       mPendingUpdate(),
       mCurTimeoutHandler(0),
-      mEpollError()
+      mEpollError(),
+      mInactivityTimer(mNow + 1),
+      mConnections()
 {
     TimeoutHandlers::Init(mTimeoutHandlers);
     mPendingUpdate.reserve(1 << 10);
@@ -110,9 +111,7 @@ NetManager::AddConnection(const NetConnectionPtr& conn)
         abort();
     }
     if (! entry->mAdded) {
-        entry->mTimerWheelSlot = kTimerWheelSize;
-        entry->mListIt = mTimerWheel[kTimerWheelSize].insert(
-            mTimerWheel[kTimerWheelSize].end(), conn);
+        entry->mListIt = mConnections.insert(mConnections.end(), conn);
         mConnectionsCount++;
         assert(mConnectionsCount > 0);
         entry->mAdded = true;
@@ -155,31 +154,57 @@ NetManager::UpdateTimer(NetConnection::NetManagerEntry& entry, int timeOut)
     if (mShutdownFlag) {
         return;
     }
-    int timerWheelSlot;
     if (timeOut < 0) {
-        timerWheelSlot = kTimerWheelSize;
-    } else if ((timerWheelSlot = mCurTimerWheelSlot +
-            // When the timer is running the effective wheel size "grows" by 1:
-            // leave (move) entries with timeouts >= kTimerWheelSize in (to) the
-            // current slot.
-            min((kTimerWheelSize - (mTimerRunningFlag ? 0 : 1)), timeOut)) >=
-            kTimerWheelSize) {
-        timerWheelSlot -= kTimerWheelSize;
-    }
-    // This method can be invoked from timeout handler.
-    // Make sure  that the entry doesn't get moved to the end of the current
-    // list, which can be traversed by the timer.
-    if (timerWheelSlot != entry.mTimerWheelSlot) {
-        if (mTimerWheelBucketItr == entry.mListIt) {
-            ++mTimerWheelBucketItr;
-        }
-        mTimerWheel[timerWheelSlot].splice(
-            mTimerWheel[timerWheelSlot].end(),
-            mTimerWheel[entry.mTimerWheelSlot], entry.mListIt);
-        entry.mTimerWheelSlot = timerWheelSlot;
+        TimerList::Remove(entry);
+        return;
+    }
+    // The timer is reset on every i/o, therefore re-schedule only if the
+    // expiration time moves closer. Otherwise the timer re-schedules the
+    // entry when the previously scheduled time comes.
+    if (! TimerList::IsInList(entry) ||
+            entry.mExpirationTime < entry.GetTimerWheelExpires()) {
+        mInactivityTimer.Schedule(entry, entry.mExpirationTime);
     }
 }
 
+class NetManager::InactivityTimeout
+{
+public:
+    InactivityTimeout(
+        NetManager& netManager)
+        : mNetManager(netManager)
+        {}
+    void operator()(
+        NetManagerEntry& entry)
+    {
+        assert(*entry.mListIt);
+        NetConnection& conn = **entry.mListIt;
+        assert(conn.IsGood());
+        const int timeOut = conn.GetInactivityTimeout();
+        if (timeOut < 0) {
+            // No timeout, remove from the timer.
+            TimerList::Remove(entry);
+        } else if (entry.mExpirationTime <= mNetManager.mNow) {
+            // Re-schedule prior to invoking the handler, in order to re-run
+            // the handler later if the connection remains open and the
+            // timer isn't reset.
+            mNetManager.mInactivityTimer.Schedule(entry,
+                mNetManager.mNow + kTimeoutRetryIntervalSec);
+            conn.HandleTimeoutEvent();
+        } else {
+            // Not expired yet, the timer was reset after the entry was
+            // scheduled.
+            mNetManager.mInactivityTimer.Schedule(
+                entry, entry.mExpirationTime);
+        }
+    }
+private:
+    NetManager& mNetManager;
+private:
+    InactivityTimeout(const InactivityTimeout&);
+    InactivityTimeout& operator=(const InactivityTimeout&);
+};
+
 void
 NetManager::Update(NetConnection::NetManagerEntry& entry, int fd,
     bool resetTimer)
@@ -264,13 +289,13 @@ NetManager::UpdateSelf(NetConnection::NetManagerEntry& entry, int fd,
             }
             entry.mFd = -1;
         }
-        if (mTimerWheelBucketItr == entry.mListIt) {
-            ++mTimerWheelBucketItr;
+        if (mConnectionsItr == entry.mListIt) {
+            ++mConnectionsItr;
         }
+        TimerList::Remove(entry);
         if (epollError) {
             assert(conn.IsGood());
-            mEpollError.splice(mEpollError.end(),
-                mTimerWheel[entry.mTimerWheelSlot], entry.mListIt);
+            mEpollError.splice(mEpollError.end(), mConnections, entry.mListIt);
             return;
         }
         assert(mConnectionsCount > 0 &&
@@ -279,8 +304,7 @@ NetManager::UpdateSelf(NetConnection::NetManagerEntry& entry, int fd,
         entry.mAdded = false;
         mConnectionsCount--;
         mNumBytesToSend -= entry.mWriteByteCount;
-        mRemove.splice(mRemove.end(),
-            mTimerWheel[entry.mTimerWheelSlot], entry.mListIt);
+        mRemove.splice(mRemove.end(), mConnections, entry.mListIt);
         // Do not reset entry->mNetManager, it is an error to add connection to
         // a different net manager even after close.
         if (mPollEventHook) {
@@ -411,14 +435,12 @@ NetManager::MainLoop(
             // read event is pending.
             // The "lazy" processing here is to reduce number of system calls.
             if (! mIsOverloaded) {
-                for (int i = 0; i <= kTimerWheelSize; i++) {
-                    for (List::iterator c = mTimerWheel[i].begin();
-                            c != mTimerWheel[i].end(); ) {
-                        assert(*c);
-                        NetConnection& conn = **c;
-                        ++c;
-                        conn.Update(false);
-                    }
+                for (List::iterator c = mConnections.begin();
+                        c != mConnections.end(); ) {
+                    assert(*c);
+                    NetConnection& conn = **c;
+                    ++c;
+                    conn.Update(false);
                 }
             }
         }
@@ -426,7 +448,7 @@ NetManager::MainLoop(
             dispatcher->DispatchEnd();
         }
         const int timeout = PendingReadList::IsInList(mPendingReadList) ?
-            0 : mTimeoutMs;
+            0 : mPollTimeoutMs;
         const int fdCount = mConnectionsCount + 1;
         assert(mPendingUpdate.empty());
         mPollFlag = true;
@@ -524,7 +546,6 @@ NetManager::MainLoop(
         }
         mRemove.clear();
         UpdateGetCurrentTime(mNow, mNowUsec);
-        int slotCnt = min(int(kTimerWheelSize), int(mNow - mLastTimerTime));
         if (mLastTimerTime + timerOverrunWarningTime < mNow) {
             KFS_LOG_STREAM_INFO <<
                 "timer overrun " << (mNow - mLastTimerTime) <<
@@ -533,38 +554,10 @@ NetManager::MainLoop(
             mTimerOverrunCount++;
             mTimerOverrunSec += mNow - mLastTimerTime;
         }
-        mTimerRunningFlag = true;
-        while (slotCnt-- > 0) {
-            List& bucket = mTimerWheel[mCurTimerWheelSlot];
-            mTimerWheelBucketItr = bucket.begin();
-            while (mTimerWheelBucketItr != bucket.end()) {
-                assert(*mTimerWheelBucketItr);
-                NetConnection& conn = **mTimerWheelBucketItr;
-                assert(conn.IsGood());
-                ++mTimerWheelBucketItr;
-                NetConnection::NetManagerEntry& entry =
-                    *conn.GetNetManagerEntry();
-                const int timeOut = conn.GetInactivityTimeout();
-                if (timeOut < 0) {
-                    // No timeout, move it to the corresponding list.
-                    UpdateTimer(entry, timeOut);
-                } else if (entry.mExpirationTime <= mNow) {
-                    conn.HandleTimeoutEvent();
-                } else {
-                    // Not expired yet, move to the new slot, taking into the
-                    // account possible timer overrun.
-                    UpdateTimer(entry,
-                        slotCnt + int(entry.mExpirationTime - mNow));
-                }
-            }
-            if (++mCurTimerWheelSlot >= kTimerWheelSize) {
-                mCurTimerWheelSlot = 0;
-            }
-            mRemove.clear();
-        }
-        mTimerRunningFlag = false;
+        InactivityTimeout inactivityTimeout(*this);
+        mInactivityTimer.Run(mNow, inactivityTimeout);
+        mRemove.clear();
         mLastTimerTime = mNow;
-        mTimerWheelBucketItr = mRemove.end();
         if (runOnceFlag) {
             break;
         }
@@ -617,28 +610,26 @@ NetManager::CleanUp(bool childAtForkFlag, bool onlyCloseFdFlag)
     if (childAtForkFlag) {
         mPoll.Close();
     }
-    for (int i = 0; i <= kTimerWheelSize; i++) {
-        for (mTimerWheelBucketItr = mTimerWheel[i].begin();
-                mTimerWheelBucketItr != mTimerWheel[i].end(); ) {
-            NetConnection* const conn = mTimerWheelBucketItr->get();
-            ++mTimerWheelBucketItr;
-            if (conn) {
-                if (childAtForkFlag) {
-                    if (onlyCloseFdFlag) {
-                        conn->GetNetManagerEntry()->CloseSocket(*conn);
-                    } else {
-                        conn->GetNetManagerEntry()->mAdded = false;
-                    }
-                }
-                if (conn->IsGood()) {
-                    conn->HandleErrorEvent();
+    for (mConnectionsItr = mConnections.begin();
+            mConnectionsItr != mConnections.end(); ) {
+        NetConnection* const conn = mConnectionsItr->get();
+        ++mConnectionsItr;
+        if (conn) {
+            if (childAtForkFlag) {
+                if (onlyCloseFdFlag) {
+                    conn->GetNetManagerEntry()->CloseSocket(*conn);
+                } else {
+                    conn->GetNetManagerEntry()->mAdded = false;
                 }
             }
+            if (conn->IsGood()) {
+                conn->HandleErrorEvent();
+            }
         }
-        assert((childAtForkFlag && onlyCloseFdFlag) || mTimerWheel[i].empty());
-        mRemove.clear();
     }
-    mTimerWheelBucketItr = mRemove.end();
+    assert((childAtForkFlag && onlyCloseFdFlag) || mConnections.empty());
+    mRemove.clear();
+    mConnectionsItr = mRemove.end();
 }
 
 void
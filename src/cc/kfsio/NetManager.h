@@ -104,6 +104,16 @@ public:
         Dispatcher* dispatcher           = 0,
         bool        runOnceFlag          = false);
     void Wakeup();
+    /// Set poll timeout, limited by the timeout passed to the constructor.
+    /// Negative value restores the constructor timeout. Takes effect with
+    /// the next poll call, must be invoked from the net manager thread.
+    void SetPollTimeoutMs(int timeoutMs)
+    {
+        mPollTimeoutMs = (timeoutMs < 0 || mTimeoutMs < timeoutMs) ?
+            mTimeoutMs : timeoutMs;
+    }
+    int GetPollTimeoutMs() const
+        { return mPollTimeoutMs; }
 
     void Shutdown()
         { mRunFlag = false; }
@@ -211,13 +221,27 @@ private:
     typedef NetManagerEntry::List            List;
     typedef QCDLList<ITimeout>               TimeoutHandlers;
     typedef NetManagerEntry::PendingReadList PendingReadList;
+    typedef NetManagerEntry::TimerList       TimerList;
     typedef vector<NetConnection*>           PendingUpdate;
-    enum { kTimerWheelSize = (1 << 8) };
+    enum { kTimerWheelSlotBits   = 6 };
+    enum { kTimerWheelLevelCount = 4 };
+    /// Re-run interval of the timeout handler of the timed out connections
+    /// that remain open, and do not reset timer.
+    enum { kTimeoutRetryIntervalSec = (1 << 8) };
+    typedef HierarchicalTimerWheel<
+        NetManagerEntry,
+        TimerList,
+        time_t,
+        kTimerWheelSlotBits,
+        kTimerWheelLevelCount,
+        1
+    > InactivityTimer;
+    class InactivityTimeout;
+    friend class InactivityTimeout;
 
     List            mRemove;
-    List::iterator  mTimerWheelBucketItr;
+    List::iterator  mConnectionsItr;
     NetConnection*  mCurConnection;
-    int             mCurTimerWheelSlot;
     int             mConnectionsCount;
     /// when the system is overloaded--either because of disk or we
     /// have too much network I/O backlogged---we avoid polling fd's for
@@ -228,10 +252,10 @@ private:
     bool            mIsOverloaded;
     volatile bool   mRunFlag;
     bool            mShutdownFlag;
-    bool            mTimerRunningFlag;
     bool            mPollFlag;
     /// timeout interval specified in the call to select().
     const int       mTimeoutMs;
+    int             mPollTimeoutMs;
     const time_t    mStartTime;
     time_t          mNow;
     time_t          mLastTimerTime;
@@ -250,7 +274,10 @@ private:
     ITimeout*       mCurTimeoutHandler;
     ITimeout*       mTimeoutHandlers[1];
     List            mEpollError;
-    List            mTimerWheel[kTimerWheelSize + 1];
+    /// Connections with the inactivity timeout, declared before the
+    /// connections list in order to be destroyed after the list.
+    InactivityTimer mInactivityTimer;
+    List            mConnections;
 
     void CheckIfOverloaded();
     void CleanUp(bool childAtForkFlag = false, bool onlyCloseFdFlag = false);
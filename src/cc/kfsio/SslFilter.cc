@@ -237,6 +237,15 @@ public:
                 | (inPskOnlyFlag ? long(SSL_OP_NO_TICKET) : long(0))
 #endif
         ));
+#ifdef SSL_OP_ENABLE_KTLS
+        // Kernel TLS offload. OpenSSL installs the session keys into the
+        // socket after the handshake if the kernel and the negotiated cipher
+        // support it, and falls back to user space encryption otherwise.
+        if (inParams.getValue(
+                theParamName.Truncate(thePrefLen).Append("ktls"), 0) != 0) {
+            SSL_CTX_set_options(theRetPtr, SSL_OP_ENABLE_KTLS);
+        }
+#endif
         SSL_CTX_set_timeout(
                 theRetPtr,
                 inParams.getValue(
@@ -429,7 +438,8 @@ public:
           mSslErrorFlag(false),
           mShutdownCompleteFlag(false),
           mVerifyOrGetPskInvokedFlag(false),
-          mRenegotiationPendingFlag(false)
+          mRenegotiationPendingFlag(false),
+          mKtlsSendFlag(false)
     {
         if (! mSslPtr) {
             return;
@@ -525,6 +535,8 @@ public:
             }
             return (0 <= theRet ? -EAGAIN : theRet);
         }
+        // IOBuffer::Read() updates ctrNetBytesRead with the number of plain
+        // text bytes returned by the filter Read() below.
         theRet = inIoBuffer.Read(-1, inMaxRead, this);
         mReadPendingFlag = 0 < inMaxRead && inMaxRead <= theRet &&
             0 < SSL_peek(mSslPtr, &theByte, sizeof(theByte));
@@ -555,6 +567,13 @@ public:
         if (inIoBuffer.IsEmpty()) {
             return 0;
         }
+        if (IsKtlsSend()) {
+            // The kernel encrypts and frames the records, write the buffers
+            // directly with no user space copy. IOBuffer::Write() updates
+            // ctrNetBytesWritten with the number of bytes written, the same
+            // plain text byte count as SSL_write() path below.
+            return inIoBuffer.Write(inSocket.GetFd());
+        }
         ERR_clear_error();
         int theWrCnt = 0;
         for (IOBuffer::iterator theIt = inIoBuffer.begin();
@@ -627,6 +646,7 @@ public:
                 theRet = -ENOMEM;
             }
         }
+        mKtlsSendFlag = false;
         if (theRet == 0 && SSL_in_before(mSslPtr)) {
             mError                     = 0;
             mSslEofFlag                = false;
@@ -680,6 +700,7 @@ public:
         if (! mSslPtr) {
             return;
         }
+        mKtlsSendFlag = false;
         SSL_set_fd(mSslPtr, -1);
     }
     virtual int Read(
@@ -725,7 +746,9 @@ public:
     }
     virtual bool RenewSession()
     {
-        if (! mSslPtr || mError != 0) {
+        if (! mSslPtr || mError != 0 || mKtlsSendFlag) {
+            // Kernel keys can not be changed, the connection has to be
+            // re-established instead.
             return false;
         }
         mRenegotiationPendingFlag =
@@ -734,6 +757,28 @@ public:
     }
     bool IsHandshakeDone() const
         { return (mSslPtr && mError == 0 && SSL_is_init_finished(mSslPtr)); }
+    // Returns true if the write side of the connection is offloaded into
+    // the kernel, and no handshake or ssl record write is in progress.
+    bool IsKtlsSend()
+    {
+#ifdef SSL_OP_ENABLE_KTLS
+        if (! mKtlsSendFlag) {
+            if (mRenegotiationPendingFlag || ! SSL_is_init_finished(mSslPtr) ||
+                    ! BIO_get_ktls_send(SSL_get_wbio(mSslPtr))) {
+                return false;
+            }
+            mKtlsSendFlag = true;
+            KFS_LOG_STREAM_DEBUG <<
+                "ktls send enabled:"
+                " fd: "     << SSL_get_fd(mSslPtr) <<
+                " cipher: " << SSL_get_cipher_name(mSslPtr) <<
+            KFS_LOG_EOM;
+        }
+        return (SSL_is_init_finished(mSslPtr) && ! SSL_want_write(mSslPtr));
+#else
+        return false;
+#endif
+    }
     string GetAuthName() const
     {
         return (
@@ -814,6 +859,7 @@ private:
     bool              mShutdownCompleteFlag:1;
     bool              mVerifyOrGetPskInvokedFlag:1;
     bool              mRenegotiationPendingFlag:1;
+    bool              mKtlsSendFlag:1;
 
     struct OpenSslInit
     {
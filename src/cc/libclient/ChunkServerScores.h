@@ -0,0 +1,179 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkServerScores.h
+// \brief Client side chunk server read latency and error scores.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_SERVER_SCORES_H
+#define CHUNK_SERVER_SCORES_H
+
+#include "common/kfsdecls.h"
+#include "common/StdAllocator.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include <inttypes.h>
+
+namespace KFS
+{
+namespace client
+{
+using std::pair;
+using std::map;
+using std::less;
+using std::max;
+
+// Exponentially weighted moving average of the chunk server read latencies
+// and errors observed by the client. Shared by all readers running in the
+// same protocol worker thread, and used to choose the replica with the
+// smallest expected completion time. Not thread safe.
+class ChunkServerScores
+{
+public:
+    class Entry
+    {
+    public:
+        Entry()
+            : mLatencyUsec(-1),
+              mErrorScore(0),
+              mInFlightCount(0),
+              mUpdateTimeUsec(0)
+            {}
+    private:
+        int64_t mLatencyUsec;
+        int64_t mErrorScore;
+        int64_t mInFlightCount;
+        int64_t mUpdateTimeUsec;
+
+        friend class ChunkServerScores;
+    };
+
+    ChunkServerScores(
+        int64_t inMaxAgeUsec       = int64_t(60) * 1000 * 1000,
+        int64_t inErrorPenaltyUsec = int64_t(1000) * 1000)
+        : mEntries(),
+          mMaxAgeUsec(inMaxAgeUsec),
+          mErrorPenaltyUsec(inErrorPenaltyUsec)
+        {}
+    Entry& Get(
+        const ServerLocation& inLocation)
+        { return mEntries[inLocation]; }
+    void Start(
+        Entry& inEntry)
+        { inEntry.mInFlightCount++; }
+    // Negative latency means that the op was canceled, and the latency is
+    // not known.
+    void Done(
+        Entry&  inEntry,
+        int64_t inLatencyUsec,
+        bool    inErrorFlag,
+        int64_t inNowUsec)
+    {
+        if (0 < inEntry.mInFlightCount) {
+            inEntry.mInFlightCount--;
+        }
+        if (inLatencyUsec < 0 && ! inErrorFlag) {
+            return;
+        }
+        if (IsStale(inEntry, inNowUsec)) {
+            inEntry.mLatencyUsec = -1;
+            inEntry.mErrorScore  = 0;
+        }
+        if (0 <= inLatencyUsec) {
+            if (inEntry.mLatencyUsec < 0) {
+                inEntry.mLatencyUsec = inLatencyUsec;
+            } else {
+                inEntry.mLatencyUsec +=
+                    GetEwmaStep(inLatencyUsec - inEntry.mLatencyUsec);
+            }
+        }
+        inEntry.mErrorScore += GetEwmaStep(
+            (inErrorFlag ? kErrorScoreMax : 0) - inEntry.mErrorScore);
+        inEntry.mUpdateTimeUsec = inNowUsec;
+    }
+    // Expected completion time of the next op. Servers with no recent
+    // observations have zero expected time, in order to be probed again.
+    int64_t GetExpectedTimeUsec(
+        const Entry& inEntry,
+        int64_t      inNowUsec) const
+    {
+        if (IsStale(inEntry, inNowUsec)) {
+            return 0;
+        }
+        return ((max(int64_t(0), inEntry.mLatencyUsec) +
+                mErrorPenaltyUsec * inEntry.mErrorScore / kErrorScoreMax) *
+            (1 + inEntry.mInFlightCount));
+    }
+    int64_t GetExpectedTimeUsec(
+        const ServerLocation& inLocation,
+        int64_t               inNowUsec) const
+    {
+        Entries::const_iterator const theIt = mEntries.find(inLocation);
+        return (theIt == mEntries.end() ? int64_t(0) :
+            GetExpectedTimeUsec(theIt->second, inNowUsec));
+    }
+    size_t GetSize() const
+        { return mEntries.size(); }
+private:
+    typedef map<
+        ServerLocation,
+        Entry,
+        less<ServerLocation>,
+        StdFastAllocator<pair<const ServerLocation, Entry> >
+    > Entries;
+    enum { kWeightDiv     = 8    };
+    enum { kErrorScoreMax = 1024 };
+
+    // Round the step away from zero, in order to let the average converge
+    // to the observed value, otherwise truncating division leaves the score
+    // stuck at up to kWeightDiv - 1 away from it.
+    static int64_t GetEwmaStep(
+        int64_t inDelta)
+    {
+        return ((inDelta < 0 ? inDelta - (kWeightDiv - 1) :
+            inDelta + (kWeightDiv - 1)) / kWeightDiv);
+    }
+
+    Entries       mEntries;
+    const int64_t mMaxAgeUsec;
+    const int64_t mErrorPenaltyUsec;
+
+    bool IsStale(
+        const Entry& inEntry,
+        int64_t      inNowUsec) const
+    {
+        return (inEntry.mInFlightCount <= 0 &&
+            inEntry.mUpdateTimeUsec + mMaxAgeUsec < inNowUsec);
+    }
+private:
+    ChunkServerScores(
+        const ChunkServerScores& inScores);
+    ChunkServerScores& operator=(
+        const ChunkServerScores& inScores);
+};
+}
+}
+
+#endif /* CHUNK_SERVER_SCORES_H */
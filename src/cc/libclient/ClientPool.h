@@ -30,6 +30,7 @@
 #include "common/StdAllocator.h"
 #include "KfsNetClient.h"
 
+#include <algorithm>
 #include <map>
 #include <utility>
 #include <sstream>
@@ -45,10 +46,21 @@ using std::map;
 using std::less;
 using std::ostringstream;
 using std::string;
+using std::max;
+using std::min;
 
 // Client connection (KfsNetClient) pool. Used to reduce number of chunk
-// server connections. Presently used only with radix sort with write append
-// with M clients each appending to N buckets.
+// server connections, and to re-use connections, including their
+// authentication, with short lived readers and appenders. Each pool entry
+// multiplexes ops from all its users over one connection with multiple ops in
+// flight.
+// The entries are keyed by the server location, and the connection
+// authentication parameters: session key id, authentication context, and
+// clear text (ssl shutdown) flag. The users sharing an entry must not change
+// these parameters, in order not to affect other users of the connection.
+// Get() and Release() maintain the entry reference count. Reap() deletes the
+// entries with no references after the reap interval, or immediately if the
+// connection was lost, in order to keep only healthy connections.
 class ClientPool
 {
 public:
@@ -67,8 +79,10 @@ public:
         int                inMaxContentLength               = MAX_RPC_HEADER_LEN,
         bool               inFailAllOpsOnOpTimeoutFlag      = false,
         bool               inMaxOneOutstandingOpFlag        = false,
-        ClientAuthContext* inAuthContextPtr                 = 0)
+        ClientAuthContext* inAuthContextPtr                 = 0,
+        int                inReapIntervalSec                = 5  * 60)
         : mClients(),
+          mClientKeys(),
           mNetManager(inNetManager),
           mMaxRetryCount(inMaxRetryCount),
           mTimeSecBetweenRetries(inTimeSecBetweenRetries),
@@ -81,28 +95,45 @@ public:
           mMaxContentLength(inMaxContentLength),
           mFailAllOpsOnOpTimeoutFlag(inFailAllOpsOnOpTimeoutFlag),
           mMaxOneOutstandingOpFlag(inMaxOneOutstandingOpFlag),
-          mAuthContextPtr(inAuthContextPtr)
+          mAuthContextPtr(inAuthContextPtr),
+          mReapIntervalSec(inReapIntervalSec),
+          mNextReapTime(0),
+          mReapedCount(0),
+          mReapedStats()
         {}
     ~ClientPool()
     {
         for (Clients::const_iterator it = mClients.begin();
                 it != mClients.end();
                 ++it) {
-            delete it->second;
+            delete it->second.mClientPtr;
         }
     }
     KfsNetClient& Get(
         const ServerLocation& inLocation,
         bool                  inShortRpcFormatFlag)
     {
-        Clients::iterator it = mClients.find(inLocation);
+        const bool kShutdownSslFlag = false;
+        return Get(inLocation, inShortRpcFormatFlag, kShutdownSslFlag,
+            string(), mAuthContextPtr);
+    }
+    KfsNetClient& Get(
+        const ServerLocation& inLocation,
+        bool                  inShortRpcFormatFlag,
+        bool                  inShutdownSslFlag,
+        const string&         inKeyId,
+        ClientAuthContext*    inAuthContextPtr)
+    {
+        const Key         theKey(inLocation, inKeyId, inAuthContextPtr,
+            inShutdownSslFlag);
+        Clients::iterator it = mClients.find(theKey);
         if (it == mClients.end()) {
             ostringstream theStream;
             theStream <<
                 mLogPrefix << (mLogPrefix.empty() ? "" : ":") <<
                 inLocation.hostname << ":" << inLocation.port;
             const string thePrefix = theStream.str();
-            it = mClients.insert(make_pair(inLocation, new KfsNetClient(
+            it = mClients.insert(make_pair(theKey, Entry(new KfsNetClient(
                 mNetManager,
                 inLocation.hostname,
                 inLocation.port,
@@ -116,22 +147,67 @@ public:
                 mMaxContentLength,
                 mFailAllOpsOnOpTimeoutFlag,
                 mMaxOneOutstandingOpFlag,
-                mAuthContextPtr))).first;
-            it->second->SetRetryConnectOnly(mRetryConnectOnlyFlag);
-            it->second->SetRpcFormat(inShortRpcFormatFlag ?
+                inAuthContextPtr)))).first;
+            it->second.mClientPtr->SetRetryConnectOnly(mRetryConnectOnlyFlag);
+            it->second.mClientPtr->SetRpcFormat(inShortRpcFormatFlag ?
                 KfsNetClient::kRpcFormatShort : KfsNetClient::kRpcFormatLong);
+            it->second.mClientPtr->SetShutdownSsl(inShutdownSslFlag);
+            mClientKeys[it->second.mClientPtr] = it;
+        }
+        it->second.mRefCount++;
+        return *(it->second.mClientPtr);
+    }
+    void Release(
+        KfsNetClient& inClient)
+    {
+        ClientKeys::const_iterator const theIt = mClientKeys.find(&inClient);
+        if (theIt == mClientKeys.end()) {
+            return;
+        }
+        Clients::iterator const it = theIt->second;
+        if (it->second.mRefCount <= 0) {
+            return;
+        }
+        if (--(it->second.mRefCount) <= 0) {
+            it->second.mReleaseTime = mNetManager.Now();
+        }
+    }
+    // Deletes unreferenced entries that were not used for longer than the
+    // reap interval, or that lost their connection.
+    void Reap()
+    {
+        const time_t theNow = mNetManager.Now();
+        if (theNow < mNextReapTime) {
+            return;
+        }
+        mNextReapTime = theNow + max(1, min(mReapIntervalSec / 4, 30));
+        Stats theStats;
+        for (Clients::iterator it = mClients.begin(); it != mClients.end(); ) {
+            Entry& theEntry = it->second;
+            if (0 < theEntry.mRefCount || (
+                    theNow < theEntry.mReleaseTime + mReapIntervalSec &&
+                    ! theEntry.mClientPtr->WasDisconnected())) {
+                ++it;
+                continue;
+            }
+            theEntry.mClientPtr->Stop();
+            theEntry.mClientPtr->GetStats(theStats);
+            mReapedStats.Add(theStats);
+            mClientKeys.erase(theEntry.mClientPtr);
+            delete theEntry.mClientPtr;
+            mClients.erase(it++);
+            mReapedCount++;
         }
-        return *(it->second);
     }
     void GetStats(
         Stats& outStats) const
     {
-        outStats.Clear();
+        outStats = mReapedStats;
         Stats theStats;
         for (Clients::const_iterator it = mClients.begin();
                 it != mClients.end();
                 ++it) {
-            it->second->GetStats(theStats);
+            it->second.mClientPtr->GetStats(theStats);
             outStats.Add(theStats);
         }
     }
@@ -146,7 +222,7 @@ public:
             for (Clients::const_iterator theIt = mClients.begin();
                     theIt != mClients.end();
                     ++theIt) {
-                theIt->second->SetFailAllOpsOnOpTimeoutFlag(
+                theIt->second.mClientPtr->SetFailAllOpsOnOpTimeoutFlag(
                     mFailAllOpsOnOpTimeoutFlag);
             }
             return;
@@ -156,21 +232,74 @@ public:
         for (Clients::const_iterator theIt = mClients.begin();
                 theIt != mClients.end();
                 ++theIt) {
-            theIt->second->SetFailAllOpsOnOpTimeoutFlag(
+            theIt->second.mClientPtr->SetFailAllOpsOnOpTimeoutFlag(
                 mFailAllOpsOnOpTimeoutFlag);
-            theIt->second->ClearMaxOneOutstandingOpFlag();
+            theIt->second.mClientPtr->ClearMaxOneOutstandingOpFlag();
         }
     }
     size_t GetSize() const
         { return mClients.size(); }
+    int64_t GetReapedCount() const
+        { return mReapedCount; }
 private:
+    struct Key
+    {
+        Key(
+            const ServerLocation& inLocation,
+            const string&         inKeyId,
+            ClientAuthContext*    inAuthContextPtr,
+            bool                  inShutdownSslFlag)
+            : mLocation(inLocation),
+              mKeyId(inKeyId),
+              mAuthContextPtr(inAuthContextPtr),
+              mShutdownSslFlag(inShutdownSslFlag)
+            {}
+        bool operator<(
+            const Key& inRhs) const
+        {
+            if (mLocation != inRhs.mLocation) {
+                return (mLocation < inRhs.mLocation);
+            }
+            if (mKeyId != inRhs.mKeyId) {
+                return (mKeyId < inRhs.mKeyId);
+            }
+            if (mAuthContextPtr != inRhs.mAuthContextPtr) {
+                return less<ClientAuthContext*>()(
+                    mAuthContextPtr, inRhs.mAuthContextPtr);
+            }
+            return (mShutdownSslFlag < inRhs.mShutdownSslFlag);
+        }
+        ServerLocation     mLocation;
+        string             mKeyId;
+        ClientAuthContext* mAuthContextPtr;
+        bool               mShutdownSslFlag;
+    };
+    struct Entry
+    {
+        Entry(
+            KfsNetClient* inClientPtr = 0)
+            : mClientPtr(inClientPtr),
+              mRefCount(0),
+              mReleaseTime(0)
+            {}
+        KfsNetClient* mClientPtr;
+        int           mRefCount;
+        time_t        mReleaseTime;
+    };
     typedef map<
-        ServerLocation,
-        KfsNetClient*,
-        less<ServerLocation>,
-        StdFastAllocator<pair<const ServerLocation, KfsNetClient*> >
+        Key,
+        Entry,
+        less<Key>,
+        StdFastAllocator<pair<const Key, Entry> >
     > Clients;
+    typedef map<
+        const KfsNetClient*,
+        Clients::iterator,
+        less<const KfsNetClient*>,
+        StdFastAllocator<pair<const KfsNetClient* const, Clients::iterator> >
+    > ClientKeys;
     Clients            mClients;
+    ClientKeys         mClientKeys;
     NetManager&        mNetManager;
     int                mMaxRetryCount;
     int                mTimeSecBetweenRetries;
@@ -184,6 +313,10 @@ private:
     bool               mFailAllOpsOnOpTimeoutFlag;
     bool               mMaxOneOutstandingOpFlag;
     ClientAuthContext* mAuthContextPtr;
+    const int          mReapIntervalSec;
+    time_t             mNextReapTime;
+    int64_t            mReapedCount;
+    Stats              mReapedStats;
 private:
     ClientPool(
         const ClientPool& inPool);
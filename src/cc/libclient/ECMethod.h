@@ -71,6 +71,17 @@ public:
             int const* inMissingStripesIdx) = 0;
         virtual void Release() = 0;
         virtual bool SupportsOneRecoveryStripeRebuild() const = 0;
+        // Returns the index of the recovery stripe that, together with the
+        // stripes of the same local group, is sufficient to rebuild the
+        // stripe with the given index, or -1 if all data stripes are needed.
+        // When only such stripe is missing, Decode() must not access the
+        // buffers of the stripes outside of the local group, as the read
+        // striper might pass null pointers for these.
+        virtual int GetLocalRecoveryStripeIdx(
+            int /* inStripeCount */,
+            int /* inRecoveryStripeCount */,
+            int /* inStripeIdx */) const
+            { return -1; }
     protected:
         Decoder()
             {}
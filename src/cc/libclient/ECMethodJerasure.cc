@@ -33,13 +33,20 @@
 #include "common/kfsatomic.h"
 #include "common/StdAllocator.h"
 #include "common/IntToString.h"
+#include "common/StBuffer.h"
 
 #include "qcdio/QCUtils.h"
 #include "qcdio/QCDLList.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
 #include "qcdio/qcdebug.h"
 
 #include <map>
 #include <sstream>
+#include <string>
+#include <vector>
+
+#include <string.h>
 
 #include <stdlib.h>
 #endif
@@ -57,6 +64,8 @@ using std::map;
 using std::less;
 using std::pair;
 using std::make_pair;
+using std::string;
+using std::vector;
 
 class QCECMethodJerasure : public ECMethod
 {
@@ -153,10 +162,18 @@ private:
               mMatrixPtr(inMatrixPtr),
               mW(inW),
               mRefCount(1),
-              mIt()
-            { List::Init(*this); }
+              mIt(),
+              mMutex(),
+              mDecodingMatrices()
+        {
+            List::Init(*this);
+            DecodingMatrixLru::Init(mDecodingMatrixLru);
+        }
         virtual bool SupportsOneRecoveryStripeRebuild() const
             { return true; }
+        // Equivalent of jerasure_matrix_decode() with row_k_ones set, except
+        // that the decoding matrices are cached, as matrix inversion cost
+        // dominates decode with wide codes and short decode lengths.
         virtual int Decode(
             int        inStripeCount,
             int        inRecoveryStripeCount,
@@ -164,17 +181,95 @@ private:
             void**     inBuffersPtr,
             int const* inMissingStripesIdxPtr)
         {
-            return jerasure_matrix_decode(
-                inStripeCount,
-                inRecoveryStripeCount,
-                mW,
-                mMatrixPtr,
-                1, // row_k_ones
-                const_cast<int*>(inMissingStripesIdxPtr),
-                reinterpret_cast<char**>(inBuffersPtr),
-                reinterpret_cast<char**>(inBuffersPtr + inStripeCount),
-                inLength
-            );
+            const int   theCount   = inStripeCount + inRecoveryStripeCount;
+            Ints        theErasedBuf;
+            int* const  theErasedPtr = theErasedBuf.Resize(theCount);
+            int         theEddCnt    = 0;
+            int         theErasedCnt = 0;
+            int         theLastDrive = inStripeCount;
+            memset(theErasedPtr, 0, sizeof(theErasedPtr[0]) * theCount);
+            for (int const* thePtr = inMissingStripesIdxPtr;
+                    0 <= *thePtr;
+                    ++thePtr) {
+                if (theCount <= *thePtr) {
+                    return -1;
+                }
+                if (! theErasedPtr[*thePtr]) {
+                    theErasedPtr[*thePtr] = 1;
+                    // Same as jerasure_erasures_to_erased(): the decoding
+                    // matrix can not be built with more than m erasures.
+                    if (inRecoveryStripeCount < ++theErasedCnt) {
+                        return -1;
+                    }
+                }
+            }
+            for (int i = 0; i < inStripeCount; i++) {
+                if (theErasedPtr[i]) {
+                    theEddCnt++;
+                    theLastDrive = i;
+                }
+            }
+            if (theErasedPtr[inStripeCount]) {
+                theLastDrive = inStripeCount;
+            }
+            char** const theDataPtrs   = reinterpret_cast<char**>(inBuffersPtr);
+            char** const theCodingPtrs = theDataPtrs + inStripeCount;
+            Ints         theDecodingBuf;
+            Ints         theIdsBuf;
+            if (1 < theEddCnt ||
+                    (0 < theEddCnt && theErasedPtr[inStripeCount])) {
+                if (! GetDecodingMatrix(inStripeCount, inRecoveryStripeCount,
+                        theErasedPtr, theDecodingBuf, theIdsBuf)) {
+                    return -1;
+                }
+            }
+            for (int i = 0; 0 < theEddCnt && i < theLastDrive; i++) {
+                if (theErasedPtr[i]) {
+                    jerasure_matrix_dotprod(
+                        inStripeCount,
+                        mW,
+                        theDecodingBuf.GetPtr() + i * inStripeCount,
+                        theIdsBuf.GetPtr(),
+                        i,
+                        theDataPtrs,
+                        theCodingPtrs,
+                        inLength
+                    );
+                    theEddCnt--;
+                }
+            }
+            if (0 < theEddCnt) {
+                Ints       theTmpIdsBuf;
+                int* const theTmpIdsPtr = theTmpIdsBuf.Resize(inStripeCount);
+                for (int i = 0; i < inStripeCount; i++) {
+                    theTmpIdsPtr[i] = i < theLastDrive ? i : i + 1;
+                }
+                jerasure_matrix_dotprod(
+                    inStripeCount,
+                    mW,
+                    mMatrixPtr,
+                    theTmpIdsPtr,
+                    theLastDrive,
+                    theDataPtrs,
+                    theCodingPtrs,
+                    inLength
+                );
+            }
+            for (int i = 0; i < inRecoveryStripeCount; i++) {
+                if (theErasedPtr[inStripeCount + i] && theCodingPtrs[i]) {
+                    jerasure_matrix_dotprod(
+                        inStripeCount,
+                        mW,
+                        mMatrixPtr + i * inStripeCount,
+                        0,
+                        inStripeCount + i,
+                        theDataPtrs,
+                        theCodingPtrs,
+                        inLength
+                    );
+                }
+            }
+            return 0;
         }
         virtual int Encode(
             int    inStripeCount,
@@ -220,15 +315,122 @@ private:
 
         virtual ~JXCoder()
         {
+            DecodingMatrix* thePtr;
+            while ((thePtr = DecodingMatrixLru::PopFront(mDecodingMatrixLru))) {
+                delete thePtr;
+            }
             free(mMatrixPtr);
             mRefCount = -1000; // To catch double delete.
         }
     private:
+        typedef StBufferT<int, 128> Ints;
+        class DecodingMatrix;
+        typedef map<
+            string,
+            DecodingMatrix*,
+            less<string>,
+            StdFastAllocator<pair<const string, DecodingMatrix*> >
+        > DecodingMatrices;
+        // Inverted decoding matrix, and the ids of the stripes used to
+        // decode, keyed by the erasure pattern.
+        class DecodingMatrix
+        {
+        public:
+            typedef QCDLList<DecodingMatrix, 0> List;
+
+            DecodingMatrix()
+                : mMatrix(),
+                  mIds(),
+                  mIt()
+                { List::Init(*this); }
+            vector<int>                mMatrix;
+            vector<int>                mIds;
+            DecodingMatrices::iterator mIt;
+        private:
+            DecodingMatrix* mPrevPtr[1];
+            DecodingMatrix* mNextPtr[1];
+
+            friend class QCDLListOp<DecodingMatrix, 0>;
+        };
+        typedef DecodingMatrix::List DecodingMatrixLru;
+        enum { kMaxDecodingMatricesCacheCount = 256 };
+
         volatile int       mRefCount;
         JXCoders::iterator mIt;
+        QCMutex            mMutex;
+        DecodingMatrices   mDecodingMatrices;
+        DecodingMatrix*    mDecodingMatrixLru[1];
         JXCoder*           mPrevPtr[1];
         JXCoder*           mNextPtr[1];
 
+        bool GetDecodingMatrix(
+            int        inStripeCount,
+            int        inRecoveryStripeCount,
+            const int* inErasedPtr,
+            Ints&      outMatrix,
+            Ints&      outIds)
+        {
+            const int theCount = inStripeCount + inRecoveryStripeCount;
+            string    theKey(theCount, char(0));
+            for (int i = 0; i < theCount; i++) {
+                if (inErasedPtr[i]) {
+                    theKey[i] = 1;
+                }
+            }
+            int* const theMatrixPtr =
+                outMatrix.Resize(inStripeCount * inStripeCount);
+            int* const theIdsPtr    = outIds.Resize(inStripeCount);
+            {
+                QCStMutexLocker theLock(mMutex);
+                DecodingMatrices::iterator const theIt =
+                    mDecodingMatrices.find(theKey);
+                if (theIt != mDecodingMatrices.end()) {
+                    DecodingMatrix& theEntry = *theIt->second;
+                    DecodingMatrixLru::PushBack(mDecodingMatrixLru, theEntry);
+                    memcpy(theMatrixPtr, &theEntry.mMatrix[0],
+                        sizeof(theMatrixPtr[0]) * theEntry.mMatrix.size());
+                    memcpy(theIdsPtr, &theEntry.mIds[0],
+                        sizeof(theIdsPtr[0]) * theEntry.mIds.size());
+                    return true;
+                }
+            }
+            // Invert without holding the mutex, decode in other threads can
+            // proceed concurrently.
+            if (jerasure_make_decoding_matrix(
+                    inStripeCount,
+                    inRecoveryStripeCount,
+                    mW,
+                    mMatrixPtr,
+                    const_cast<int*>(inErasedPtr),
+                    theMatrixPtr,
+                    theIdsPtr) < 0) {
+                return false;
+            }
+            QCStMutexLocker theLock(mMutex);
+            pair<DecodingMatrices::iterator, bool> const theRes =
+                mDecodingMatrices.insert(make_pair(theKey,
+                    (DecodingMatrix*)0));
+            if (! theRes.second) {
+                return true;
+            }
+            DecodingMatrix& theEntry = *(new DecodingMatrix());
+            theEntry.mMatrix.assign(
+                theMatrixPtr, theMatrixPtr + inStripeCount * inStripeCount);
+            theEntry.mIds.assign(theIdsPtr, theIdsPtr + inStripeCount);
+            theEntry.mIt = theRes.first;
+            theRes.first->second = &theEntry;
+            DecodingMatrix* theFrontPtr;
+            while ((size_t)kMaxDecodingMatricesCacheCount <
+                        mDecodingMatrices.size() &&
+                    (theFrontPtr = DecodingMatrixLru::PopFront(
+                        mDecodingMatrixLru))) {
+                mDecodingMatrices.erase(theFrontPtr->mIt);
+                delete theFrontPtr;
+            }
+            DecodingMatrixLru::PushBack(mDecodingMatrixLru, theEntry);
+            return true;
+        }
+
         friend class QCDLListOp<JXCoder, 0>;
     };
     class JXCoderRaid6 : public JXCoder
@@ -0,0 +1,573 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ECMethodLrc.cc
+// \brief Locally repairable code ec method.
+//
+// The stripe layout is defined in common/LrcStripeLayout.h. The local parity
+// stripes are xor of the data stripes of the corresponding local group. The
+// global parity stripes are computed with Cauchy matrix over GF(2^8).
+// Decode selects the minimal set of the parity stripes required to recover
+// the missing data stripes, preferring local parity stripes, and computes
+// each missing data stripe as a linear combination of the present stripes.
+// With single missing data stripe only the stripes of its local group are
+// used.
+//
+//----------------------------------------------------------------------------
+
+#include "ECMethodDef.h"
+
+#include "common/kfstypes.h"
+#include "common/IntToString.h"
+#include "common/LrcStripeLayout.h"
+#include "common/StBuffer.h"
+
+#include "qcdio/QCUtils.h"
+#include "qcdio/qcdebug.h"
+
+#include <stdint.h>
+#include <string.h>
+
+namespace KFS
+{
+namespace client
+{
+
+class LrcECMethod : public ECMethod
+{
+public:
+    static ECMethod* GetMethod()
+    {
+        static LrcECMethod sMethod;
+        return &sMethod;
+    }
+protected:
+    LrcECMethod()
+        : ECMethod(),
+          mDescription(Describe())
+        { InitTables(); }
+    virtual ~LrcECMethod()
+    {
+        LrcECMethod::Unregister(KFS_STRIPED_FILE_TYPE_LRC);
+    }
+    virtual bool Init(
+        int inMethodType)
+    {
+        QCRTASSERT(inMethodType == KFS_STRIPED_FILE_TYPE_LRC);
+        return (inMethodType == KFS_STRIPED_FILE_TYPE_LRC);
+    }
+    virtual string GetDescription() const
+        { return mDescription; }
+    void Release(
+        int inMethodType)
+    {
+        QCRTASSERT(inMethodType == KFS_STRIPED_FILE_TYPE_LRC);
+    }
+    virtual Encoder* GetEncoder(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr)
+    {
+        return GetXCoder(
+            inMethodType,
+            inStripeCount,
+            inRecoveryStripeCount,
+            outErrMsgPtr
+        );
+    }
+    virtual Decoder* GetDecoder(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr)
+    {
+        return GetXCoder(
+            inMethodType,
+            inStripeCount,
+            inRecoveryStripeCount,
+            outErrMsgPtr
+        );
+    }
+    virtual bool Validate(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr)
+    {
+        if (inMethodType != KFS_STRIPED_FILE_TYPE_LRC) {
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = "LRC: invalid method type";
+            }
+            return false;
+        }
+        if (inStripeCount <= 0 || KFS_MAX_DATA_STRIPE_COUNT < inStripeCount ||
+                kSymbolCount < inStripeCount +
+                    LrcStripeLayout::GetGlobalParityCount(
+                        inRecoveryStripeCount)) {
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = "LRC: invalid data stripe count";
+            }
+            return false;
+        }
+        if (KFS_MAX_RECOVERY_STRIPE_COUNT < inRecoveryStripeCount ||
+                ! LrcStripeLayout::IsValid(
+                    inStripeCount, inRecoveryStripeCount)) {
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = "LRC: invalid recovery stripe count";
+            }
+            return false;
+        }
+        return true;
+    }
+private:
+    typedef uint8_t Symbol;
+    enum { kSymbolCount = 256 };
+
+    class LrcXCoder :
+        public ECMethod::Encoder,
+        public ECMethod::Decoder
+    {
+    public:
+        LrcXCoder(
+            int inStripeCount,
+            int inRecoveryStripeCount)
+            : ECMethod::Encoder(),
+              ECMethod::Decoder(),
+              mStripeCount(inStripeCount),
+              mRecoveryStripeCount(inRecoveryStripeCount),
+              mGlobalCount(LrcStripeLayout::GetGlobalParityCount(
+                inRecoveryStripeCount)),
+              mCoefficients()
+        {
+            Symbol* const thePtr =
+                mCoefficients.Resize(mGlobalCount * mStripeCount);
+            for (int j = 0; j < mGlobalCount; j++) {
+                for (int i = 0; i < mStripeCount; i++) {
+                    thePtr[j * mStripeCount + i] =
+                        LrcStripeLayout::GetGlobalCoefficient(
+                            mStripeCount, j, i);
+                }
+            }
+        }
+        virtual bool SupportsOneRecoveryStripeRebuild() const
+            { return true; }
+        virtual int GetLocalRecoveryStripeIdx(
+            int inStripeCount,
+            int inRecoveryStripeCount,
+            int inStripeIdx) const
+        {
+            const int theGroup = LrcStripeLayout::GetLocalGroup(
+                inStripeCount, inRecoveryStripeCount, inStripeIdx);
+            return (theGroup < 0 ? -1 : LrcStripeLayout::GetLocalParityIdx(
+                inStripeCount, inRecoveryStripeCount, theGroup));
+        }
+        virtual int Encode(
+            int    inStripeCount,
+            int    inRecoveryStripeCount,
+            int    inLength,
+            void** inBuffersPtr)
+        {
+            if (inStripeCount != mStripeCount ||
+                    inRecoveryStripeCount != mRecoveryStripeCount) {
+                return -1;
+            }
+            for (int i = mStripeCount;
+                    i < mStripeCount + mRecoveryStripeCount;
+                    i++) {
+                EncodeStripe(i, inLength, inBuffersPtr);
+            }
+            return 0;
+        }
+        virtual int Decode(
+            int        inStripeCount,
+            int        inRecoveryStripeCount,
+            int        inLength,
+            void**     inBuffersPtr,
+            int const* inMissingStripesIdxPtr)
+        {
+            if (inStripeCount != mStripeCount ||
+                    inRecoveryStripeCount != mRecoveryStripeCount) {
+                return -1;
+            }
+            const int   theCount = mStripeCount + mRecoveryStripeCount;
+            Flags       theMissingBuf;
+            char* const theMissingPtr = theMissingBuf.Resize(theCount);
+            Ints        theDataBuf;
+            int* const  theDataPtr = theDataBuf.Resize(mRecoveryStripeCount);
+            int         theDataCnt = 0;
+            memset(theMissingPtr, 0, theCount);
+            for (int const* thePtr = inMissingStripesIdxPtr;
+                    0 <= *thePtr;
+                    ++thePtr) {
+                if (theCount <= *thePtr || theMissingPtr[*thePtr]) {
+                    return -1;
+                }
+                theMissingPtr[*thePtr] = 1;
+                if (*thePtr < mStripeCount) {
+                    if (mRecoveryStripeCount <= theDataCnt ||
+                            ! inBuffersPtr[*thePtr]) {
+                        return -1;
+                    }
+                    theDataPtr[theDataCnt++] = *thePtr;
+                }
+            }
+            if (0 < theDataCnt && ! DecodeData(theDataPtr, theDataCnt,
+                    theMissingPtr, inLength, inBuffersPtr)) {
+                return -1;
+            }
+            for (int i = mStripeCount; i < theCount; i++) {
+                if (theMissingPtr[i] && inBuffersPtr[i]) {
+                    EncodeStripe(i, inLength, inBuffersPtr);
+                }
+            }
+            return 0;
+        }
+        virtual void Release()
+            { delete this; }
+    protected:
+        virtual ~LrcXCoder()
+            {}
+    private:
+        typedef StBufferT<Symbol, 64> Symbols;
+        typedef StBufferT<int, 16>    Ints;
+        typedef StBufferT<char, 64>   Flags;
+        const int mStripeCount;
+        const int mRecoveryStripeCount;
+        const int mGlobalCount;
+        Symbols   mCoefficients;
+
+        // Returns the coefficient of data stripe in the code word row.
+        Symbol GetCoefficient(
+            int inRowIdx,
+            int inStripeIdx) const
+        {
+            if (inRowIdx < mStripeCount) {
+                return (inRowIdx == inStripeIdx ? 1 : 0);
+            }
+            if (inRowIdx < mStripeCount + mGlobalCount) {
+                return mCoefficients.GetPtr()[
+                    (inRowIdx - mStripeCount) * mStripeCount + inStripeIdx];
+            }
+            return (LrcStripeLayout::IsSameLocalGroup(
+                mStripeCount, mRecoveryStripeCount, inRowIdx, inStripeIdx) ?
+                1 : 0);
+        }
+        void EncodeStripe(
+            int    inRowIdx,
+            int    inLength,
+            void** inBuffersPtr) const
+        {
+            char* const theDstPtr = (char*)inBuffersPtr[inRowIdx];
+            bool        theAddFlag = false;
+            for (int i = 0; i < mStripeCount; i++) {
+                const Symbol theCoef = GetCoefficient(inRowIdx, i);
+                if (theCoef != 0) {
+                    MulAdd(theCoef, (const char*)inBuffersPtr[i],
+                        theDstPtr, inLength, theAddFlag);
+                    theAddFlag = true;
+                }
+            }
+            if (! theAddFlag) {
+                memset(theDstPtr, 0, inLength);
+            }
+        }
+        bool DecodeData(
+            const int*  inDataIdxPtr,
+            int         inDataCnt,
+            const char* inMissingPtr,
+            int         inLength,
+            void**      inBuffersPtr) const
+        {
+            // Select parity rows linearly independent on the missing data
+            // stripes columns. Local parity rows go first, as these have the
+            // least non zero coefficients.
+            Symbols       theBasisBuf;
+            Symbol* const theBasisPtr  =
+                theBasisBuf.Resize(inDataCnt * inDataCnt);
+            Ints          thePivotsBuf;
+            int* const    thePivotsPtr = thePivotsBuf.Resize(inDataCnt);
+            Ints          theRowsBuf;
+            int* const    theRowsPtr   = theRowsBuf.Resize(inDataCnt);
+            Symbols       theVecBuf;
+            Symbol* const theVecPtr    = theVecBuf.Resize(inDataCnt);
+            int           theRowCnt    = 0;
+            for (int j = 0; j < mRecoveryStripeCount && theRowCnt < inDataCnt;
+                    j++) {
+                const int theRow = mStripeCount +
+                    (j + mGlobalCount) % mRecoveryStripeCount;
+                if (inMissingPtr[theRow] || ! inBuffersPtr[theRow]) {
+                    continue;
+                }
+                for (int a = 0; a < inDataCnt; a++) {
+                    theVecPtr[a] = GetCoefficient(theRow, inDataIdxPtr[a]);
+                }
+                for (int r = 0; r < theRowCnt; r++) {
+                    const Symbol theFactor = theVecPtr[thePivotsPtr[r]];
+                    if (theFactor == 0) {
+                        continue;
+                    }
+                    const Symbol* const theBPtr =
+                        theBasisPtr + r * inDataCnt;
+                    for (int a = 0; a < inDataCnt; a++) {
+                        theVecPtr[a] ^= Mul(theFactor, theBPtr[a]);
+                    }
+                }
+                int thePivot = 0;
+                while (thePivot < inDataCnt && theVecPtr[thePivot] == 0) {
+                    thePivot++;
+                }
+                if (inDataCnt <= thePivot) {
+                    continue;
+                }
+                const Symbol theInv  = Inv(theVecPtr[thePivot]);
+                Symbol* const theBPtr = theBasisPtr + theRowCnt * inDataCnt;
+                for (int a = 0; a < inDataCnt; a++) {
+                    theBPtr[a] = Mul(theInv, theVecPtr[a]);
+                }
+                thePivotsPtr[theRowCnt] = thePivot;
+                theRowsPtr[theRowCnt]   = theRow;
+                theRowCnt++;
+            }
+            if (theRowCnt < inDataCnt) {
+                return false;
+            }
+            // Invert the selected rows sub matrix with Gauss-Jordan
+            // elimination: theMatPtr is left, and theInvPtr is right half of
+            // the augmented matrix.
+            Symbols       theMatBuf;
+            Symbol* const theMatPtr = theMatBuf.Resize(inDataCnt * inDataCnt);
+            Symbols       theInvBuf;
+            Symbol* const theInvPtr = theInvBuf.Resize(inDataCnt * inDataCnt);
+            for (int r = 0; r < inDataCnt; r++) {
+                for (int a = 0; a < inDataCnt; a++) {
+                    theMatPtr[r * inDataCnt + a] =
+                        GetCoefficient(theRowsPtr[r], inDataIdxPtr[a]);
+                    theInvPtr[r * inDataCnt + a] = r == a ? 1 : 0;
+                }
+            }
+            for (int c = 0; c < inDataCnt; c++) {
+                int theP = c;
+                while (theP < inDataCnt &&
+                        theMatPtr[theP * inDataCnt + c] == 0) {
+                    theP++;
+                }
+                if (inDataCnt <= theP) {
+                    return false;
+                }
+                if (theP != c) {
+                    for (int a = 0; a < inDataCnt; a++) {
+                        Swap(theMatPtr[theP * inDataCnt + a],
+                            theMatPtr[c * inDataCnt + a]);
+                        Swap(theInvPtr[theP * inDataCnt + a],
+                            theInvPtr[c * inDataCnt + a]);
+                    }
+                }
+                const Symbol theInv = Inv(theMatPtr[c * inDataCnt + c]);
+                for (int a = 0; a < inDataCnt; a++) {
+                    theMatPtr[c * inDataCnt + a] =
+                        Mul(theInv, theMatPtr[c * inDataCnt + a]);
+                    theInvPtr[c * inDataCnt + a] =
+                        Mul(theInv, theInvPtr[c * inDataCnt + a]);
+                }
+                for (int r = 0; r < inDataCnt; r++) {
+                    const Symbol theFactor = theMatPtr[r * inDataCnt + c];
+                    if (r == c || theFactor == 0) {
+                        continue;
+                    }
+                    for (int a = 0; a < inDataCnt; a++) {
+                        theMatPtr[r * inDataCnt + a] ^=
+                            Mul(theFactor, theMatPtr[c * inDataCnt + a]);
+                        theInvPtr[r * inDataCnt + a] ^=
+                            Mul(theFactor, theInvPtr[c * inDataCnt + a]);
+                    }
+                }
+            }
+            // Missing data stripe a is the sum over the selected rows r of
+            // inv[a][r] * (parity[r] + sum of present data stripes i of
+            // coef[r][i] * data[i]).
+            for (int a = 0; a < inDataCnt; a++) {
+                char* const         theDstPtr  =
+                    (char*)inBuffersPtr[inDataIdxPtr[a]];
+                const Symbol* const theInvRPtr = theInvPtr + a * inDataCnt;
+                bool                theAddFlag = false;
+                for (int r = 0; r < inDataCnt; r++) {
+                    if (theInvRPtr[r] == 0) {
+                        continue;
+                    }
+                    MulAdd(theInvRPtr[r],
+                        (const char*)inBuffersPtr[theRowsPtr[r]],
+                        theDstPtr, inLength, theAddFlag);
+                    theAddFlag = true;
+                }
+                for (int i = 0; i < mStripeCount; i++) {
+                    if (inMissingPtr[i]) {
+                        continue;
+                    }
+                    Symbol theCoef = 0;
+                    for (int r = 0; r < inDataCnt; r++) {
+                        theCoef ^= Mul(theInvRPtr[r],
+                            GetCoefficient(theRowsPtr[r], i));
+                    }
+                    if (theCoef == 0) {
+                        continue;
+                    }
+                    MulAdd(theCoef, (const char*)inBuffersPtr[i],
+                        theDstPtr, inLength, theAddFlag);
+                    theAddFlag = true;
+                }
+                if (! theAddFlag) {
+                    memset(theDstPtr, 0, inLength);
+                }
+            }
+            return true;
+        }
+        static void Swap(
+            Symbol& ioLeft,
+            Symbol& ioRight)
+        {
+            const Symbol theTmp = ioLeft;
+            ioLeft  = ioRight;
+            ioRight = theTmp;
+        }
+    private:
+        LrcXCoder(
+            const LrcXCoder& inCoder);
+        LrcXCoder& operator=(
+            const LrcXCoder& inCoder);
+    };
+
+    static Symbol sLog[kSymbolCount];
+    static Symbol sExp[kSymbolCount * 2];
+    static Symbol sMul[kSymbolCount][kSymbolCount];
+    const string  mDescription;
+
+    static void InitTables()
+    {
+        // GF(2^8) with x^8 + x^4 + x^3 + x^2 + 1 polynomial.
+        int theVal = 1;
+        for (int i = 0; i < kSymbolCount - 1; i++) {
+            sExp[i] = (Symbol)theVal;
+            sExp[i + kSymbolCount - 1] = (Symbol)theVal;
+            sLog[theVal] = (Symbol)i;
+            theVal <<= 1;
+            if (kSymbolCount <= theVal) {
+                theVal ^= 0x11D;
+            }
+        }
+        for (int a = 0; a < kSymbolCount; a++) {
+            for (int b = 0; b < kSymbolCount; b++) {
+                sMul[a][b] = (a == 0 || b == 0) ? Symbol(0) :
+                    sExp[sLog[a] + sLog[b]];
+            }
+        }
+    }
+    static Symbol Mul(
+        Symbol inA,
+        Symbol inB)
+        { return sMul[inA][inB]; }
+    static Symbol Inv(
+        Symbol inA)
+    {
+        QCASSERT(inA != 0);
+        return sExp[kSymbolCount - 1 - sLog[inA]];
+    }
+    static void MulAdd(
+        Symbol      inCoef,
+        const char* inSrcPtr,
+        char*       inDstPtr,
+        int         inLength,
+        bool        inAddFlag)
+    {
+        int i = 0;
+        if (inCoef == 1) {
+            if (! inAddFlag) {
+                memcpy(inDstPtr, inSrcPtr, inLength);
+                return;
+            }
+            for (; i + (int)sizeof(uint64_t) <= inLength;
+                    i += (int)sizeof(uint64_t)) {
+                uint64_t theSrc;
+                uint64_t theDst;
+                memcpy(&theSrc, inSrcPtr + i, sizeof(theSrc));
+                memcpy(&theDst, inDstPtr + i, sizeof(theDst));
+                theDst ^= theSrc;
+                memcpy(inDstPtr + i, &theDst, sizeof(theDst));
+            }
+            for (; i < inLength; i++) {
+                inDstPtr[i] ^= inSrcPtr[i];
+            }
+            return;
+        }
+        const Symbol* const theMulPtr = sMul[inCoef];
+        const Symbol* const theSrcPtr = (const Symbol*)inSrcPtr;
+        Symbol* const       theDstPtr = (Symbol*)inDstPtr;
+        if (inAddFlag) {
+            for (; i < inLength; i++) {
+                theDstPtr[i] ^= theMulPtr[theSrcPtr[i]];
+            }
+        } else {
+            for (; i < inLength; i++) {
+                theDstPtr[i] = theMulPtr[theSrcPtr[i]];
+            }
+        }
+    }
+    LrcXCoder* GetXCoder(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr)
+    {
+        QCRTASSERT(inMethodType == KFS_STRIPED_FILE_TYPE_LRC);
+        if (! Validate(inMethodType, inStripeCount, inRecoveryStripeCount,
+                outErrMsgPtr)) {
+            return 0;
+        }
+        return new LrcXCoder(inStripeCount, inRecoveryStripeCount);
+    }
+    static string Describe()
+    {
+        string theRet;
+        theRet += "id: ";
+        AppendDecIntToString(theRet, int(KFS_STRIPED_FILE_TYPE_LRC)) +=
+            "; lrc"
+            "; global parities: recovery stripes / 2"
+            "; local parities: the remaining recovery stripes"
+            "; recovery stripes range: [";
+        AppendDecIntToString(theRet,
+                int(LrcStripeLayout::kMinRecoveryStripeCount)) += ", ";
+        AppendDecIntToString(theRet, KFS_MAX_RECOVERY_STRIPE_COUNT) +=
+            "]"
+            "; data stripes range: [local parities, ";
+        AppendDecIntToString(theRet, int(kSymbolCount)) +=
+            " - global parities]";
+        return theRet;
+    }
+};
+
+LrcECMethod::Symbol LrcECMethod::sLog[LrcECMethod::kSymbolCount];
+LrcECMethod::Symbol LrcECMethod::sExp[LrcECMethod::kSymbolCount * 2];
+LrcECMethod::Symbol LrcECMethod::sMul[LrcECMethod::kSymbolCount][
+    LrcECMethod::kSymbolCount];
+
+KFS_REGISTER_EC_METHOD(STRIPED_FILE_TYPE_LRC, LrcECMethod::GetMethod());
+
+}} /* namespace client KFS */
@@ -43,6 +43,7 @@
 #include "common/StdAllocator.h"
 #include "common/IntToString.h"
 #include "common/DisplayData.h"
+#include "common/RequestTrace.h"
 
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCUtils.h"
@@ -69,6 +70,7 @@
 #include <pwd.h>
 #include <grp.h>
 #include <fcntl.h>
+#include <fnmatch.h>
 
 #include <boost/scoped_array.hpp>
 #include <boost/bind.hpp>
@@ -297,6 +299,35 @@ KfsClient::ReaddirPlusSelf(
         computeFilesize, updateClientCache, fileIdAndTypeOnly);
 }
 
+int
+KfsClient::ReaddirPlus(
+    const char*                     pathname,
+    vector<KfsFileAttr>&            result,
+    const KfsClient::ReaddirFilter& filter,
+    bool                            computeFilesize,
+    bool                            updateClientCache,
+    bool                            fileIdAndTypeOnly)
+{
+    return mImpl->ReaddirPlus(pathname, result,
+        computeFilesize, updateClientCache, fileIdAndTypeOnly,
+        filter.IsEmpty() ? 0 : &filter);
+}
+
+bool
+KfsClient::ReaddirFilter::Matches(const KfsFileAttr& attr) const
+{
+    if (! mNamePattern.empty() && fnmatch(mNamePattern.c_str(),
+            attr.filename.c_str(),
+            mFnmatchFlags & (FNM_PERIOD | FNM_NOESCAPE)) != 0) {
+        return false;
+    }
+    if (attr.isDirectory) {
+        return true;
+    }
+    return (! mDirsOnlyFlag && (mMinMtimeUsec < 0 || mMinMtimeUsec <=
+        (int64_t)attr.mtime.tv_sec * 1000 * 1000 + attr.mtime.tv_usec));
+}
+
 int
 KfsClient::OpenDirectory(const char *pathname)
 {
@@ -1521,6 +1552,7 @@ KfsClientImpl::KfsClientImpl(
       mDefaultIoBufferSize(min(CHUNKSIZE, size_t(1) << 20)),
       mDefaultReadAheadSize(min(mDefaultIoBufferSize, size_t(1) << 20)),
       mFailShortReadsFlag(true),
+      mTraceDumpFileName(),
       mFileInstance(0),
       mProtocolWorker(0),
       mMaxNumRetriesPerOp(DEFAULT_NUM_RETRIES_PER_OP),
@@ -1535,6 +1567,7 @@ KfsClientImpl::KfsClientImpl(
       mIdempotentOpId(RandomSeqNo()),
       mUseOsUserAndGroupFlag(true),
       mInitLookupRootFlag(true),
+      mServerRmdirsFlag(true),
       mUserNames(),
       mGroupNames(),
       mUserIds(),
@@ -1627,6 +1660,16 @@ KfsClientImpl::ShutdownSelf()
     }
     mAuthCtx.Clear();
     mProtocolWorkerAuthCtx.Clear();
+    if (! mTraceDumpFileName.empty()) {
+        const int err = RequestTrace::Dump(mTraceDumpFileName.c_str());
+        if (err != 0) {
+            KFS_LOG_STREAM_ERROR <<
+                "request trace write failure: " << mTraceDumpFileName <<
+                ": " << ErrorCodeToStr(err) <<
+            KFS_LOG_EOM;
+        }
+        mTraceDumpFileName.clear();
+    }
 }
 
 int KfsClientImpl::Init(const string& metaServerHost, int metaServerPort,
@@ -1730,6 +1773,16 @@ int KfsClientImpl::Init(const string& metaServerHost, int metaServerPort,
             "client.defaultOpTimeout", mDefaultOpTimeout));
         mDefaultMetaOpTimeout = GetOpTimeout(properties->getValue(
             "client.defaultMetaOpTimeout", mDefaultMetaOpTimeout));
+        // Request tracing is process wide, the trace ring is allocated by
+        // the first client with the positive ring size.
+        const int traceRingSize = properties->getValue(
+            "client.trace.ringSize", 0);
+        if (0 < traceRingSize) {
+            RequestTrace::SetParameters(traceRingSize, properties->getValue(
+                "client.trace.sampleInterval", 1000));
+        }
+        mTraceDumpFileName = properties->getValue(
+            "client.trace.dumpFileName", mTraceDumpFileName);
         mConfig.clear();
         euser  = properties->getValue("client.euser",  euser);
         egroup = properties->getValue("client.egroup", egroup);
@@ -2146,6 +2199,29 @@ KfsClientImpl::RmdirsFast(const char *pathname,
         assert(! "internal error: invalid path name");
         return -EFAULT;
     }
+    if (mServerRmdirsFlag && ! (pos == 0 && dirname == "/")) {
+        // Attempt to remove the directory hierarchy with a single meta server
+        // request. The meta server moves the directory into the dumpster, and
+        // removes its content asynchronously. Fall back to the directory
+        // hierarchy traversal on failure, in order to remove all entries that
+        // can be removed, and to report individual entries failures. The meta
+        // server that does not support recursive remove returns ENOTEMPTY.
+        // Only the super user is permitted to remove non empty directory
+        // this way, as the sub tree permissions are not checked, other users
+        // get EPERM. As effective user can change, EPERM only turns the
+        // recursive remove off for this call.
+        const bool kRecursiveFlag = true;
+        RmdirOp op(0, parentFid, dirname.c_str(), path.c_str(),
+            NextIdempotentOpId(), kRecursiveFlag);
+        DoMetaOpWithRetry(&op);
+        if (0 <= op.status) {
+            InvalidateAllCachedAttrs();
+            return 0;
+        }
+        if (-ENOTEMPTY == op.status) {
+            mServerRmdirsFlag = false;
+        }
+    }
     DefaultErrHandler errorHandler(-ENOENT);
     ret = RmdirsSelf(
         path.substr(0, pos),
@@ -2544,7 +2620,8 @@ KfsClientImpl::Readdir(const char* pathname, vector<string>& result)
 /// @retval 0 if readdir is successful; -errno otherwise
 int
 KfsClientImpl::ReaddirPlus(const char* pathname, vector<KfsFileAttr>& result,
-    bool computeFilesize, bool updateClientCache, bool fileIdAndTypeOnly)
+    bool computeFilesize, bool updateClientCache, bool fileIdAndTypeOnly,
+    const KfsClient::ReaddirFilter* filter)
 {
     QCStMutexLocker l(mMutex);
 
@@ -2559,7 +2636,7 @@ KfsClientImpl::ReaddirPlus(const char* pathname, vector<KfsFileAttr>& result,
         return -ENOTDIR;
     }
     return ReaddirPlus(path, attr.fileId, result,
-        computeFilesize, updateClientCache, fileIdAndTypeOnly);
+        computeFilesize, updateClientCache, fileIdAndTypeOnly, filter);
 }
 
 class ReaddirPlusParser
@@ -2912,7 +2989,8 @@ public:
         vector<KfsFileAttr>& inResult,
         bool                 inComputeFilesize,
         kfsFileId_t          inDirFid,
-        time_t               inNow)
+        time_t               inNow,
+        const KfsClient::ReaddirFilter* inFilter = 0)
         : fileChunkInfo(),
           beginEntry("Begin-entry"),
           shortBeginEntry("B"),
@@ -2922,7 +3000,8 @@ public:
           computeFilesize(inComputeFilesize),
           outer(inOuter),
           dirFid(inDirFid),
-          now(inNow)
+          now(inNow),
+          filter(inFilter)
         { result.clear(); }
     int operator()(
         const char* inBuf,
@@ -2950,6 +3029,11 @@ public:
             if (attr.filename.empty()) {
                 return -EIO;
             }
+            if (filter && ! filter->Matches(attr)) {
+                // Meta server does not support filter.
+                result.pop_back();
+                continue;
+            }
             const TokenValue& uname = parser.GetUserName();
             if (0 < uname.mLen) {
                 outer.UpdateUserId(
@@ -2998,6 +3082,7 @@ private:
     KfsClientImpl&                   outer;
     kfsFileId_t const                dirFid;
     const time_t                     now;
+    const KfsClient::ReaddirFilter*  filter;
 private:
     ReadDirPlusResponseParser(
         const ReadDirPlusResponseParser&);
@@ -3008,7 +3093,7 @@ private:
 int
 KfsClientImpl::ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
     vector<KfsFileAttr>& result, bool computeFilesize, bool updateClientCache,
-    bool fileIdAndTypeOnly)
+    bool fileIdAndTypeOnly, const KfsClient::ReaddirFilter* filter)
 {
     assert(mMutex.IsOwned());
     if (pathname.empty() || pathname[0] != '/') {
@@ -3020,7 +3105,8 @@ KfsClientImpl::ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
 
     time_t const                      now = time(0);
     ReadDirPlusResponseParser         parser(
-        *this, result, computeFilesize && ! fileIdAndTypeOnly, dirFid, now);
+        *this, result, computeFilesize && ! fileIdAndTypeOnly, dirFid, now,
+        filter);
     const PropertiesTokenizer::Token* beginEntryToken = 0;
     const PropertiesTokenizer::Token* nameEntryToken  = 0;
     const PropertiesTokenizer::Token  nameToken("Name");
@@ -3030,6 +3116,13 @@ KfsClientImpl::ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
     ReaddirPlusOp                     op(
         0, dirFid, kGetLastChunkInfoIfSizeUnknown, kOmitLastChunkInfo,
         fileIdAndTypeOnly);
+    if (filter) {
+        op.namePattern       = filter->mNamePattern;
+        op.matchPeriodFlag   = (filter->mFnmatchFlags & FNM_PERIOD) != 0;
+        op.matchNoEscapeFlag = (filter->mFnmatchFlags & FNM_NOESCAPE) != 0;
+        op.dirsOnlyFlag      = filter->mDirsOnlyFlag;
+        op.minMtime          = filter->mMinMtimeUsec;
+    }
     ReaddirResult                     opResult;
     ReaddirResult*                    last  = &opResult;
     int                               count = 0;
@@ -3066,7 +3159,9 @@ KfsClientImpl::ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
             }
             continue;
         }
-        if (0 <= op.numEntries) {
+        // With the filter the meta server might return no entries, and the
+        // name of the last scanned entry to resume from.
+        if (0 < op.numEntries || (0 == op.numEntries && ! filter)) {
             if (op.contentLength <= 0) {
                 KFS_LOG_STREAM_ERROR <<
                     "invalid content length: " << op.contentLength <<
@@ -3093,7 +3188,8 @@ KfsClientImpl::ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
             last = last->Set(op);
             count += op.numEntries;
         }
-        if (! op.hasMoreEntriesFlag || op.numEntries <= 0) {
+        if (! op.hasMoreEntriesFlag ||
+                (op.numEntries <= 0 && op.fnameNext.empty())) {
             result.reserve(count);
             KFS_LOG_STREAM_DEBUG <<
                 "readdirplus parse: entries: " << count <<
@@ -3109,6 +3205,10 @@ KfsClientImpl::ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
             }
             break;
         }
+        if (! op.fnameNext.empty()) {
+            op.fnameStart = op.fnameNext;
+            continue;
+        }
         if (! last->GetLast(*beginEntryToken, *nameEntryToken, op.fnameStart)) {
             KFS_LOG_STREAM_ERROR <<
                 "response parse error:"
@@ -4707,10 +4807,24 @@ KfsClientImpl::StartProtocolWorker()
     }
     params.mUseClientPoolFlag = mConfig.getValue(
         "client.connectionPool", params.mUseClientPoolFlag ? 1 : 0) != 0;
+    params.mClientPoolReapIntervalSec = mConfig.getValue(
+        "client.connectionPoolReapIntervalSec",
+        params.mClientPoolReapIntervalSec);
     params.mMetaServerNodes = mConfig.getValue(
         KfsClient::GetMetaServerNodesParamName(), params.mMetaServerNodes);
     params.mClientRackId    = mConfig.getValue(
         "client.rackId", -1);
+    params.mReadHedgePercentile = mConfig.getValue(
+        "client.readHedgePercentile", params.mReadHedgePercentile);
+    params.mReadHedgeMinDelayMs = mConfig.getValue(
+        "client.readHedgeMinDelayMs", params.mReadHedgeMinDelayMs);
+    params.mReadHedgeMaxDelayMs = mConfig.getValue(
+        "client.readHedgeMaxDelayMs", params.mReadHedgeMaxDelayMs);
+    params.mWriteAheadChunkCount = mConfig.getValue(
+        "client.writeAheadChunks", params.mWriteAheadChunkCount);
+    params.mReadServerScoresFlag = mConfig.getValue(
+        "client.readLatencyAwareReplicaSelection",
+        params.mReadServerScoresFlag ? 1 : 0) != 0;
     mProtocolWorker = new KfsProtocolWorker(
         mMetaServerLoc.hostname,
         mMetaServerLoc.port,
@@ -75,6 +75,40 @@ public:
         ErrorHandler(const ErrorHandler&) {}
         ErrorHandler& operator=(const ErrorHandler&) { return *this; }
     };
+    /// Directory listing filter. The filter is evaluated by the meta server,
+    /// in order to avoid transferring the entries that do not match, and then
+    /// by the client, as the meta server might not support the filter.
+    class ReaddirFilter
+    {
+    public:
+        ReaddirFilter(
+            const string& namePattern  = string(),
+            bool          dirsOnly     = false,
+            int64_t       minMtimeUsec = -1,
+            int           fnmatchFlags = 0)
+            : mNamePattern(namePattern),
+              mFnmatchFlags(fnmatchFlags),
+              mDirsOnlyFlag(dirsOnly),
+              mMinMtimeUsec(minMtimeUsec)
+            {}
+        bool IsEmpty() const
+        {
+            return (mNamePattern.empty() && ! mDirsOnlyFlag &&
+                mMinMtimeUsec < 0);
+        }
+        bool Matches(const KfsFileAttr& attr) const;
+        /// fnmatch() pattern, empty pattern matches any name. The meta
+        /// server rejects patterns longer than 256 bytes or with more than
+        /// 8 '*' wildcards with -EINVAL.
+        string  mNamePattern;
+        /// fnmatch() flags, only FNM_PERIOD and FNM_NOESCAPE are supported.
+        int     mFnmatchFlags;
+        /// Return only directories.
+        bool    mDirsOnlyFlag;
+        /// If non negative, return only files modified at or after the
+        /// specified time in microseconds. Directories are always returned.
+        int64_t mMinMtimeUsec;
+    };
 
     KfsClient();
     KfsClient(client::KfsNetClient* metaServer);
@@ -173,6 +207,22 @@ public:
         );
     }
 
+    ///
+    /// Read a directory's contents matching the filter and retrieve the
+    /// attributes
+    /// @param[in] pathname The full pathname such as /.../dir
+    /// @param[out] result  The files in the directory and their attributes.
+    /// @param[in] filter   The directory entries filter.
+    /// @retval 0 if readdirplus is successful; -errno otherwise
+    ///
+    int ReaddirPlus(
+        const char*          pathname,
+        vector<KfsFileAttr>& result,
+        const ReaddirFilter& filter,
+        bool                 computeFilesize   = true,
+        bool                 updateClientCache = true,
+        bool                 fileIdAndTypeOnly = false);
+
     ///
     /// Read a directory's contents and retrieve the attributes
     /// Note: Intended for internal use only, format of returned data
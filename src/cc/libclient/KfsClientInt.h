@@ -321,7 +321,8 @@ public:
     ///
     int ReaddirPlus(const char *pathname, vector<KfsFileAttr> &result,
         bool computeFilesize = true, bool updateClientCache = true,
-        bool fileIdAndTypeOnly = false);
+        bool fileIdAndTypeOnly = false,
+        const KfsClient::ReaddirFilter* filter = 0);
 
     ///
     /// Read a directory's contents and retrieve the attributes
@@ -783,6 +784,7 @@ private:
     size_t                         mDefaultIoBufferSize;
     size_t                         mDefaultReadAheadSize;
     bool                           mFailShortReadsFlag;
+    string                         mTraceDumpFileName;
     unsigned int                   mFileInstance;
     KfsProtocolWorker*             mProtocolWorker;
     int                            mMaxNumRetriesPerOp;
@@ -797,6 +799,7 @@ private:
     kfsSeq_t                       mIdempotentOpId;
     bool                           mUseOsUserAndGroupFlag;
     bool                           mInitLookupRootFlag;
+    bool                           mServerRmdirsFlag;
     UserNames                      mUserNames;
     GroupNames                     mGroupNames;
     UserIds                        mUserIds;
@@ -987,7 +990,8 @@ private:
     int ReaddirPlus(const string& pathname, kfsFileId_t dirFid,
         vector<KfsFileAttr> &result,
         bool computeFilesize = true, bool updateClientCache = true,
-        bool fileIdAndTypeOnly = false);
+        bool fileIdAndTypeOnly = false,
+        const KfsClient::ReaddirFilter* filter = 0);
 
     int Rmdirs(const string& parentDir, kfsFileId_t parentFid,
         const string &dirname, kfsFileId_t dirFid);
@@ -36,6 +36,9 @@
 #include "common/kfsdecls.h"
 #include "common/MsgLogger.h"
 #include "common/StdAllocator.h"
+#include "common/RequestTrace.h"
+#include "common/BinaryRpc.h"
+#include "common/time.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCDLList.h"
@@ -200,6 +203,9 @@ public:
           mMetaLogWriteRetryCount(0),
           mMaxMetaLogWriteRetryCount(0),
           mRpcFormat(kRpcFormatUndef),
+          mBinaryRpcFlag(true),
+          mBinaryRpcConfirmedFlag(false),
+          mBinaryRpcWriter(),
           mInFlightOpPtr(0),
           mOutstandingOpPtr(0),
           mInFlightRecvBufPtr(0),
@@ -279,8 +285,9 @@ public:
             if (mSleepingFlag || IsConnected()) {
                 Reset();
             }
-            mServerLocation    = inLocation;
-            mAuthFailureCount  = 0;
+            mServerLocation         = inLocation;
+            mBinaryRpcConfirmedFlag = false;
+            mAuthFailureCount       = 0;
             mRetryCount        = 0;
             mNonAuthRetryCount = 0;
             mNextSeqNum += 100;
@@ -304,13 +311,24 @@ public:
         if (theConnectedFlag) {
             Reset();
         }
-        mRpcFormat = inRpcFormat;
+        mRpcFormat              = inRpcFormat;
+        mBinaryRpcConfirmedFlag = false;
         if (theConnectedFlag && ! mPendingOpQueue.empty()) {
             EnsureConnected();
         }
     }
     RpcFormat GetRpcFormat() const
         { return mRpcFormat; }
+    void SetBinaryRpc(
+        bool inFlag)
+    {
+        mBinaryRpcFlag = inFlag;
+        if (! mBinaryRpcFlag) {
+            mBinaryRpcConfirmedFlag = false;
+        }
+    }
+    bool IsBinaryRpc() const
+        { return mBinaryRpcFlag; }
     void SetAuthContext(
         ClientAuthContext* inAuthContextPtr)
         { mAuthContextPtr = inAuthContextPtr; }
@@ -1149,6 +1167,8 @@ private:
               mOwnerPtr(inOwnerPtr),
               mBufferPtr(inBufferPtr),
               mTime(0),
+              mEnqueueTimeUsec(inOpPtr ? microseconds() : int64_t(0)),
+              mSendTimeUsec(mEnqueueTimeUsec),
               mRetryCount(0),
               mExtraTimeout(max(0, inExtraTimeout)),
               mVrConnectPendingFlag(false)
@@ -1183,6 +1203,8 @@ private:
         OpOwner*  mOwnerPtr;
         IOBuffer* mBufferPtr;
         time_t    mTime;
+        int64_t   mEnqueueTimeUsec;
+        int64_t   mSendTimeUsec;
         int       mRetryCount;
         uint32_t  mExtraTimeout:31;
         bool      mVrConnectPendingFlag:1;
@@ -1645,6 +1667,9 @@ private:
     int                   mMetaLogWriteRetryCount;
     int                   mMaxMetaLogWriteRetryCount;
     RpcFormat             mRpcFormat;
+    bool                  mBinaryRpcFlag;
+    bool                  mBinaryRpcConfirmedFlag;
+    BinaryRpcWriter       mBinaryRpcWriter;
     OpQueueEntry*         mInFlightOpPtr;
     OpQueueEntry*         mOutstandingOpPtr;
     char*                 mInFlightRecvBufPtr;
@@ -1909,6 +1934,9 @@ private:
         mIdleTimeoutFlag = false;
         SetMaxWaitTime(*inOpPtr, inExtraTimeout);
         inOpPtr->seq = mNextSeqNum++;
+        if (inOpPtr->traceId == 0) {
+            inOpPtr->traceId = RequestTrace::Sample();
+        }
         const bool theResetTimerFlag = mPendingOpQueue.empty();
         pair<OpQueue::iterator, bool> const theRes =
             mPendingOpQueue.insert(make_pair(
@@ -1965,6 +1993,10 @@ private:
     {
         KfsOp& theOp = *inEntry.mOpPtr;
         theOp.shortRpcFormatFlag = mRpcFormat == kRpcFormatShort;
+        // Request binary format confirmation with each short format request
+        // until the server confirms it.
+        theOp.binaryRpcFlag = theOp.shortRpcFormatFlag && mBinaryRpcFlag &&
+            ! mBinaryRpcConfirmedFlag;
         {
             if (IsAuthEnabled()) {
                 theOp.extraHeaders = 0;
@@ -1972,10 +2004,19 @@ private:
                 theOp.extraHeaders = theOp.shortRpcFormatFlag ?
                     &mCommonShortHeaders : &mCommonHeaders;
             }
-            ReqOstream theStream(mOstream.Set(mConnPtr->GetOutBuffer()));
-            theOp.Request(theStream);
-            mOstream.Reset();
-            theOp.extraHeaders = 0;
+            if (mBinaryRpcConfirmedFlag && theOp.shortRpcFormatFlag &&
+                    theOp.BinaryRequest(mBinaryRpcWriter) &&
+                    mBinaryRpcWriter.End()) {
+                mConnPtr->GetOutBuffer().CopyIn(
+                    mBinaryRpcWriter.GetPtr(),
+                    (int)mBinaryRpcWriter.GetSize());
+            } else {
+                ReqOstream theStream(mOstream.Set(mConnPtr->GetOutBuffer()));
+                theOp.Request(theStream);
+                mOstream.Reset();
+            }
+            theOp.extraHeaders  = 0;
+            theOp.binaryRpcFlag = false;
         }
         if (theOp.contentLength > 0) {
             if (theOp.contentBuf && theOp.contentBufLen > 0) {
@@ -1999,8 +2040,9 @@ private:
         }
         mOstream.Reset();
         // Start the timer.
-        inEntry.mTime       = Now();
-        inEntry.mRetryCount = inRetryCount;
+        inEntry.mTime         = Now();
+        inEntry.mSendTimeUsec = microseconds();
+        inEntry.mRetryCount   = inRetryCount;
         mPendingBytesSend = mConnPtr->GetOutBuffer().BytesConsumable();
         if (inFlushFlag) {
             mConnPtr->SetInactivityTimeout(mOpTimeoutSec);
@@ -2099,6 +2141,7 @@ private:
                 mContentLength = 0;
             }
             mRetryCount = 0;
+            UpdateLatency(mCurOpIt->second);
             HandleOp(mCurOpIt);
         }
     }
@@ -2170,6 +2213,11 @@ private:
             return false;
         }
         mReadHeaderDoneFlag = true;
+        if (mBinaryRpcFlag && ! mBinaryRpcConfirmedFlag &&
+                kRpcFormatShort == mRpcFormat &&
+                mProperties.getValue("BR", 0) != 0) {
+            mBinaryRpcConfirmedFlag = true;
+        }
         if (mContentLength > mMaxContentLength) {
             KFS_LOG_STREAM_ERROR << mLogPrefix <<
                 "error: " << mServerLocation <<
@@ -2510,6 +2558,23 @@ private:
         mReadHeaderDoneFlag        = false;
         mContentLength             = 0;
         mSslShutdownInProgressFlag = false;
+        mBinaryRpcConfirmedFlag    = false;
+    }
+    void UpdateLatency(
+        const OpQueueEntry& inEntry)
+    {
+        const int64_t theNow = microseconds();
+        mStats.mQueueLatency.Record(
+            inEntry.mSendTimeUsec - inEntry.mEnqueueTimeUsec);
+        mStats.mNetworkLatency.Record(theNow - inEntry.mSendTimeUsec);
+        mStats.mTotalLatency.Record(theNow - inEntry.mEnqueueTimeUsec);
+        if (inEntry.mOpPtr && inEntry.mOpPtr->traceId != 0) {
+            RequestTrace::Record(inEntry.mOpPtr->traceId, "client queue",
+                inEntry.mEnqueueTimeUsec,
+                inEntry.mSendTimeUsec - inEntry.mEnqueueTimeUsec);
+            RequestTrace::Record(inEntry.mOpPtr->traceId, "client rpc",
+                inEntry.mSendTimeUsec, theNow - inEntry.mSendTimeUsec);
+        }
     }
     void HandleOp(
         OpQueue::iterator inIt,
@@ -2946,6 +3011,20 @@ KfsNetClient::GetRpcFormat() const
     return mImpl.GetRpcFormat();
 }
 
+    void
+KfsNetClient::SetBinaryRpc(
+    bool inFlag)
+{
+    Impl::StRef theRef(mImpl);
+    mImpl.SetBinaryRpc(inFlag);
+}
+
+    bool
+KfsNetClient::IsBinaryRpc() const
+{
+    return mImpl.IsBinaryRpc();
+}
+
     void
 KfsNetClient::SetKey(
     const char* inKeyIdPtr,
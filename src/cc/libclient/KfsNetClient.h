@@ -27,6 +27,7 @@
 #define KFS_NET_CLIENT_H
 
 #include "common/kfstypes.h"
+#include "common/LatencyHistogram.h"
 
 #include <cerrno>
 #include <string>
@@ -79,7 +80,10 @@ public:
               mOpsCancelledCount(0),
               mSleepTimeSec(0),
               mBytesReceivedCount(0),
-              mBytesSentCount(0)
+              mBytesSentCount(0),
+              mQueueLatency(),
+              mNetworkLatency(),
+              mTotalLatency()
             {}
         void Clear()
             { *this = Stats(); }
@@ -98,6 +102,9 @@ public:
             mSleepTimeSec               += inStats.mSleepTimeSec;
             mBytesReceivedCount         += inStats.mBytesReceivedCount;
             mBytesSentCount             += inStats.mBytesSentCount;
+            mQueueLatency.Add(inStats.mQueueLatency);
+            mNetworkLatency.Add(inStats.mNetworkLatency);
+            mTotalLatency.Add(inStats.mTotalLatency);
             return *this;
         }
         template<typename T>
@@ -116,6 +123,20 @@ public:
             inFunctor("SleepTimeSec",          mSleepTimeSec);
             inFunctor("BytesReceived",         mBytesReceivedCount);
             inFunctor("BytesSent",             mBytesSentCount);
+            // Latency sums and the number of ops with latency at or above
+            // the thresholds, in order to keep the values additive.
+            inFunctor("OpsLatencyUsec",        mTotalLatency.GetSum());
+            inFunctor("OpsQueueLatencyUsec",   mQueueLatency.GetSum());
+            inFunctor("OpsNetworkLatencyUsec", mNetworkLatency.GetSum());
+            inFunctor("OpsLatencyCount",       mTotalLatency.GetCount());
+            inFunctor("OpsLatency1ms",
+                mTotalLatency.GetCountAtOrAbove(1000));
+            inFunctor("OpsLatency10ms",
+                mTotalLatency.GetCountAtOrAbove(10 * 1000));
+            inFunctor("OpsLatency100ms",
+                mTotalLatency.GetCountAtOrAbove(100 * 1000));
+            inFunctor("OpsLatency1s",
+                mTotalLatency.GetCountAtOrAbove(1000 * 1000));
         }
         Counter mConnectCount;
         Counter mConnectFailureCount;
@@ -129,6 +150,11 @@ public:
         Counter mSleepTimeSec;
         Counter mBytesReceivedCount;
         Counter mBytesSentCount;
+        // Op enqueue to last send, last send to response, and enqueue to
+        // response times in microseconds.
+        LatencyHistogram mQueueLatency;
+        LatencyHistogram mNetworkLatency;
+        LatencyHistogram mTotalLatency;
     };
     enum {
         kErrorMaxRetryReached = -(10000 + ETIMEDOUT),
@@ -191,6 +217,11 @@ public:
     void SetRpcFormat(
         RpcFormat inRpcFormat);
     RpcFormat GetRpcFormat() const;
+    // Send binary format requests once the server confirms binary format
+    // support. Enabled by default.
+    void SetBinaryRpc(
+        bool inFlag);
+    bool IsBinaryRpc() const;
     void SetKey(
         const char* inKeyIdPtr,
         const char* inKeyDataPtr,
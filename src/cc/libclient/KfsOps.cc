@@ -81,9 +81,49 @@ KfsOp::ParentHeaders(ReqOstream& os) const
         os << (shortRpcFormatFlag ? "w:" : "Max-wait-ms: ") <<
             maxWaitMillisec << "\r\n";
     }
+    if (traceId != 0) {
+        os << (shortRpcFormatFlag ? "TD:" : "Trace-id: ") <<
+            traceId << "\r\n";
+    }
+    if (binaryRpcFlag && shortRpcFormatFlag) {
+        os << "BR:1\r\n";
+    }
     return os;
 }
 
+void
+KfsOp::BinaryParentHeaders(BinaryRpcWriter& wr) const
+{
+    wr.AddInt("c", seq);
+    wr.AddInt("p", KFS_CLIENT_PROTO_VERS);
+    if (extraHeaders) {
+        wr.AddHeaders(*extraHeaders);
+    }
+    if (0 < maxWaitMillisec) {
+        wr.AddInt("w", maxWaitMillisec);
+    }
+    if (traceId != 0) {
+        wr.AddInt("TD", traceId);
+    }
+}
+
+void
+ChunkAccessOp::BinaryAccess(BinaryRpcWriter& wr) const
+{
+    if (access.empty()) {
+        return;
+    }
+    if (hasSubjectIdFlag) {
+        wr.AddInt("I", subjectId);
+    }
+    wr.AddBytes("C", access);
+    if (createChunkServerAccessFlag) {
+        wr.AddInt("SR", 1);
+    } else if (createChunkAccessFlag) {
+        wr.AddInt("CR", 1);
+    }
+}
+
 inline ReqOstream&
 KfsIdempotentOp::ParentHeaders(ReqOstream& os) const
 {
@@ -276,8 +316,11 @@ RmdirOp::Request(ReqOstream& os)
         (shortRpcFormatFlag ? "P:" : "Parent File-handle: ") <<
             parentFid << "\r\n" <<
         (shortRpcFormatFlag ? "PN:" : "Pathname: ") << pathname << "\r\n" <<
-        (shortRpcFormatFlag ? "N:"  : "Directory: ") << dirname << "\r\n"
-    "\r\n";
+        (shortRpcFormatFlag ? "N:"  : "Directory: ") << dirname << "\r\n";
+    if (recursiveFlag) {
+        os << (shortRpcFormatFlag ? "R:1\r\n" : "Recursive: 1\r\n");
+    }
+    os << "\r\n";
 }
 
 void
@@ -383,6 +426,23 @@ ReaddirPlusOp::Request(ReqOstream& os)
         os << (shortRpcFormatFlag ? "S:" : "Fname-start: ") <<
             fnameStart << "\r\n";
     }
+    if (! namePattern.empty()) {
+        os << (shortRpcFormatFlag ? "NP:" : "Name-pattern: ") <<
+            namePattern << "\r\n";
+        if (matchPeriodFlag) {
+            os << (shortRpcFormatFlag ? "PD:1\r\n" : "Match-period: 1\r\n");
+        }
+        if (matchNoEscapeFlag) {
+            os << (shortRpcFormatFlag ? "NE:1\r\n" : "Match-noescape: 1\r\n");
+        }
+    }
+    if (dirsOnlyFlag) {
+        os << (shortRpcFormatFlag ? "DO:1\r\n" : "Dirs-only: 1\r\n");
+    }
+    if (0 <= minMtime) {
+        os << (shortRpcFormatFlag ? "MT:" : "Min-mtime: ") <<
+            minMtime << "\r\n";
+    }
     os << "\r\n";
 }
 
@@ -522,6 +582,16 @@ GetChunkMetadataOp::Request(ReqOstream& os)
     "\r\n";
 }
 
+bool
+GetChunkMetadataOp::BinaryRequest(BinaryRpcWriter& wr)
+{
+    BinaryParentHeaders(wr.Begin("GET_CHUNK_METADATA"));
+    wr.AddInt("H",  chunkId);
+    wr.AddInt("RV", readVerifyFlag ? 1 : 0);
+    BinaryAccess(wr);
+    return true;
+}
+
 void
 AllocateOp::Request(ReqOstream& os)
 {
@@ -635,6 +705,21 @@ ReadOp::Request(ReqOstream& os)
     os << "\r\n";
 }
 
+bool
+ReadOp::BinaryRequest(BinaryRpcWriter& wr)
+{
+    BinaryParentHeaders(wr.Begin("READ"));
+    wr.AddInt("H", chunkId);
+    wr.AddInt("V", chunkVersion);
+    wr.AddInt("O", offset);
+    wr.AddInt("B", numBytes);
+    BinaryAccess(wr);
+    if (skipVerifyDiskChecksumFlag) {
+        wr.AddInt("KS", 1);
+    }
+    return true;
+}
+
 void
 WriteIdAllocOp::Request(ReqOstream& os)
 {
@@ -782,6 +867,16 @@ SizeOp::Request(ReqOstream& os)
     "\r\n";
 }
 
+bool
+SizeOp::BinaryRequest(BinaryRpcWriter& wr)
+{
+    BinaryParentHeaders(wr.Begin("SIZE"));
+    wr.AddInt("H", chunkId);
+    wr.AddInt("V", chunkVersion);
+    BinaryAccess(wr);
+    return true;
+}
+
 void
 LeaseAcquireOp::Request(ReqOstream& os)
 {
@@ -857,6 +952,26 @@ LeaseRenewOp::Request(ReqOstream& os)
     os << "\r\n";
 }
 
+bool
+LeaseRenewOp::BinaryRequest(BinaryRpcWriter& wr)
+{
+    if (chunkServer.IsValid()) {
+        // Server location is sent as text.
+        return false;
+    }
+    BinaryParentHeaders(wr.Begin("LEASE_RENEW"));
+    wr.AddInt("H", chunkId);
+    wr.AddInt("L", leaseId);
+    wr.AddBytes("T", "READ_LEASE", 10);
+    if (0 <= chunkPos) {
+        wr.AddInt("O", chunkPos);
+    }
+    if (getCSAccessFlag) {
+        wr.AddInt("A", 1);
+    }
+    return true;
+}
+
 void
 LeaseRelinquishOp::Request(ReqOstream& os)
 {
@@ -1119,6 +1234,8 @@ ReaddirPlusOp::ParseResponseHeaderSelf(const Properties& prop)
         shortRpcFormatFlag ? "EC" : "Num-Entries", 0);
     hasMoreEntriesFlag = prop.getValue(
         shortRpcFormatFlag ? "EM" : "Has-more-entries", 0) != 0;
+    fnameNext          = prop.getValue(
+        shortRpcFormatFlag ? "FN" : "Fname-next", string());
 }
 
 void
@@ -156,7 +156,9 @@ struct KfsOp {
     char*         contentBuf;
     string        statusMsg; // optional, mostly for debugging
     const string* extraHeaders;
+    int64_t       traceId; // request trace id, 0 if not traced
     bool          shortRpcFormatFlag;
+    bool          binaryRpcFlag; // request binary rpc format confirmation
 
     KfsOp (KfsOp_t o, kfsSeq_t s)
         : op(o),
@@ -170,7 +172,9 @@ struct KfsOp {
           contentBuf(0),
           statusMsg(),
           extraHeaders(0),
+          traceId(0),
           shortRpcFormatFlag(false),
+          binaryRpcFlag(false),
           contentBufOwnerFlag(true)
         {}
     // to allow dynamic-type-casting, make the destructor virtual
@@ -216,6 +220,10 @@ struct KfsOp {
     virtual void Request(ReqOstream& os) = 0;
     virtual bool NextRequest(kfsSeq_t /* seq */, ReqOstream& /* os */)
         { return false; }
+    // Build binary rpc format request. Returns false if the op does not
+    // support binary format, in which case the text format must be used.
+    virtual bool BinaryRequest(BinaryRpcWriter& /* wr */)
+        { return false; }
 
     // Common parsing code: parse the response from string and fill
     // that into a properties structure.
@@ -239,6 +247,7 @@ struct KfsOp {
         kfsUid_t euser  = kKfsUserNone,
         kfsGid_t egroup = kKfsGroupNone);
     inline ReqOstream& ParentHeaders(ReqOstream& os) const;
+    void BinaryParentHeaders(BinaryRpcWriter& wr) const;
     template<typename T> class ReqHeadersT;
     template<typename T> static inline ReqHeadersT<T> ReqHeaders(const T& op);
 private:
@@ -389,21 +398,24 @@ struct RmdirOp : public KfsIdempotentOp {
     kfsFileId_t parentFid; // input parent file-id
     const char* dirname;
     const char* pathname; // input: full pathname
+    bool        recursiveFlag; // input: remove directory with its content
     RmdirOp(
         kfsSeq_t    s,
         kfsFileId_t p,
         const char* d,
         const char* pn,
-        kfsSeq_t    id = -1)
+        kfsSeq_t    id        = -1,
+        bool        recursive = false)
         : KfsIdempotentOp(CMD_RMDIR, s, id),
           parentFid(p),
           dirname(d),
-          pathname(pn)
+          pathname(pn),
+          recursiveFlag(recursive)
         {}
     void Request(ReqOstream& os);
     virtual ostream& ShowSelf(ostream& os) const {
         os << "rmdir: " << dirname << " (parentfid = " << parentFid << ")" <<
-            " reqId: " << reqId;
+            " reqId: " << reqId << (recursiveFlag ? " recursive" : "");
         return os;
     }
 };
@@ -541,6 +553,13 @@ struct ReaddirPlusOp : public KfsOp {
     bool        hasMoreEntriesFlag;
     int         numEntries; // # of entries in the directory
     string      fnameStart;
+    // Optional filter.
+    string      namePattern;
+    bool        matchPeriodFlag;
+    bool        matchNoEscapeFlag;
+    bool        dirsOnlyFlag;
+    int64_t     minMtime;
+    string      fnameNext; // output: last scanned entry with filter
     ReaddirPlusOp(kfsSeq_t s, kfsFileId_t f, bool cif, bool olcif, bool fidtof)
         : KfsOp(CMD_READDIRPLUS, s),
           fid(f),
@@ -549,7 +568,13 @@ struct ReaddirPlusOp : public KfsOp {
           fileIdAndTypeOnlyFlag(fidtof),
           hasMoreEntriesFlag(false),
           numEntries(0),
-          fnameStart()
+          fnameStart(),
+          namePattern(),
+          matchPeriodFlag(false),
+          matchNoEscapeFlag(false),
+          dirsOnlyFlag(false),
+          minMtime(-1),
+          fnameNext()
         {}
     void Request(ReqOstream& os);
     // This will only extract out the default+num-entries.  The actual
@@ -956,6 +981,7 @@ struct ChunkAccessOp: public KfsOp {
                 (shortRpcFormatFlag ? "CR:1\r\n" : "C-access-req: 1\r\n")  : "")
         ));
     }
+    void BinaryAccess(BinaryRpcWriter& wr) const;
     virtual void ParseResponseHeaderSelf(const Properties& prop);
 };
 
@@ -971,6 +997,7 @@ struct GetChunkMetadataOp: public ChunkAccessOp {
           readVerifyFlag(verifyFlag)
         {}
     void Request(ReqOstream& os);
+    bool BinaryRequest(BinaryRpcWriter& wr);
     virtual ostream& ShowSelf(ostream& os) const {
         os << "get chunk metadata:"
             " chunkId: " << chunkId <<
@@ -1170,6 +1197,7 @@ struct SizeOp : public ChunkAccessOp {
           size(-1)
         { chunkVersion = v; }
     void Request(ReqOstream& os);
+    bool BinaryRequest(BinaryRpcWriter& wr);
     virtual void ParseResponseHeaderSelf(const Properties& prop);
     virtual ostream& ShowSelf(ostream& os) const {
         os <<
@@ -1201,6 +1229,7 @@ struct ReadOp : public ChunkAccessOp {
           elapsedTime(0.0)
         { chunkVersion = v; }
     void Request(ReqOstream& os);
+    bool BinaryRequest(BinaryRpcWriter& wr);
     virtual void ParseResponseHeaderSelf(const Properties& prop);
     virtual ostream& ShowSelf(ostream& os) const {
         os << "read:"
@@ -1399,6 +1428,7 @@ struct LeaseRenewOp : public KfsOp {
           allowCSClearTextFlag(false)
         {}
     void Request(ReqOstream& os);
+    bool BinaryRequest(BinaryRpcWriter& wr);
     virtual void ParseResponseHeaderSelf(const Properties& prop);
     // default parsing of status is sufficient
     virtual ostream& ShowSelf(ostream& os) const {
@@ -51,6 +51,7 @@
 #include "Writer.h"
 #include "Reader.h"
 #include "ClientPool.h"
+#include "ChunkServerScores.h"
 
 #include <algorithm>
 #include <map>
@@ -127,9 +128,17 @@ public:
           mPreAllocateFlag(inParameters.mPreAllocateFlag),
           mMaxWriteSize(inParameters.mMaxWriteSize),
           mRandomWriteThreshold(inParameters.mRandomWriteThreshold),
+          mWriteAheadChunkCount(inParameters.mWriteAheadChunkCount),
           mMaxReadSize(inParameters.mMaxReadSize),
           mReadLeaseRetryTimeout(inParameters.mReadLeaseRetryTimeout),
           mLeaseWaitTimeout(inParameters.mLeaseWaitTimeout),
+          mReadHedge(
+            inParameters.mReadHedgePercentile,
+            int64_t(inParameters.mReadHedgeMinDelayMs) * 1000,
+            int64_t(inParameters.mReadHedgeMaxDelayMs) * 1000),
+          mChunkServerScores(),
+          mChunkServerScoresPtr(inParameters.mReadServerScoresFlag ?
+            &mChunkServerScores : 0),
           mChunkServerInitialSeqNum(
             inParameters.mChunkServerInitialSeqNum > 0 ?
                 inParameters.mChunkServerInitialSeqNum :
@@ -155,7 +164,8 @@ public:
                 ), // inMaxContentLength
                 false,                       // inFailAllOpsOnOpTimeoutFlag
                 false,                       // inMaxOneOutstandingOpFlag
-                0                            // inAuthContextPtr
+                0,                           // inAuthContextPtr
+                inParameters.mClientPoolReapIntervalSec
             ) : 0
         ),
         mReadStats(),
@@ -218,6 +228,9 @@ public:
     }
     virtual void Timeout()
     {
+        if (mClientPoolPtr) {
+            mClientPoolPtr->Reap();
+        }
         Request* theWorkQueue[1];
         {
             QCStMutexLocker theLock(mMutex);
@@ -913,7 +926,7 @@ private:
                 inLogPrefixPtr,
                 inOwner.mChunkServerInitialSeqNum,
                 inOwner.mPreAllocateFlag,
-                0 // inClientPoolPtr
+                0 // inClientPoolPtr, appender updates connection key in place
               ),
               mWriteThreshold(inOwner.mWriteAppendThreshold),
               mPending(0),
@@ -1148,7 +1161,10 @@ private:
               ),
               mCurRequestPtr(0),
               mAsyncStatus(0)
-            { WorkQueue::Init(mWorkQueue); }
+        {
+            WorkQueue::Init(mWorkQueue);
+            mWriter.SetWriteAheadChunkCount(inOwner.mWriteAheadChunkCount);
+        }
         virtual ~FileWriter()
         {
             mWriter.Shutdown();
@@ -1464,7 +1480,11 @@ private:
               mCurRequestPtr(0),
               mAsyncReadStatus(0),
               mAsyncReadDoneCount(0)
-            { WorkQueue::Init(mWorkQueue); }
+        {
+            WorkQueue::Init(mWorkQueue);
+            mReader.SetReadHedge(&inOwner.mReadHedge);
+            mReader.SetChunkServerScores(inOwner.mChunkServerScoresPtr);
+        }
         virtual ~FileReader()
         {
             mReader.Shutdown();
@@ -1703,9 +1723,13 @@ private:
     const bool           mPreAllocateFlag;
     const int            mMaxWriteSize;
     const int            mRandomWriteThreshold;
+    const int            mWriteAheadChunkCount;
     const int            mMaxReadSize;
     const int            mReadLeaseRetryTimeout;
     const int            mLeaseWaitTimeout;
+    Reader::ReadHedge    mReadHedge;
+    ChunkServerScores    mChunkServerScores;
+    ChunkServerScores*   mChunkServerScoresPtr;
     int64_t              mChunkServerInitialSeqNum;
     DoNotDeallocate      mDoNotDeallocate;
     StopRequest          mStopRequest;
@@ -1939,6 +1963,7 @@ private:
             mClientPoolPtr->GetStats(theStats);
             theStats.Enumerate(theEnumerator.SetPrefix("ChunkServer.Pool."));
             theEnumerator("Size", mClientPoolPtr->GetSize());
+            theEnumerator("Reaped", mClientPoolPtr->GetReapedCount());
         }
         theEnumerator.SetPrefix("Network.");
         theEnumerator("Sockets",       globals().ctrOpenNetFds.GetValue());
@@ -235,7 +235,13 @@ public:
               mMaxMetaServerContentLength(inMaxMetaServerContentLength),
               mAuthContextPtr(inAuthContextPtr),
               mUseClientPoolFlag(inUseClientPoolFlag),
-              mMetaServerNodes(inMetaServerNodes)
+              mMetaServerNodes(inMetaServerNodes),
+              mReadHedgePercentile(0),
+              mReadHedgeMinDelayMs(10),
+              mReadHedgeMaxDelayMs(1000),
+              mReadServerScoresFlag(false),
+              mClientPoolReapIntervalSec(5 * 60),
+              mWriteAheadChunkCount(0)
             {}
             int                 mMetaMaxRetryCount;
             int                 mMetaTimeSecBetweenRetries;
@@ -263,6 +269,12 @@ public:
             bool                mUseClientPoolFlag;
             string              mMetaServerNodes;
             int                 mClientRackId;
+            int                 mReadHedgePercentile;
+            int                 mReadHedgeMinDelayMs;
+            int                 mReadHedgeMaxDelayMs;
+            bool                mReadServerScoresFlag;
+            int                 mClientPoolReapIntervalSec;
+            int                 mWriteAheadChunkCount;
     };
     KfsProtocolWorker(
         std::string       inMetaHost,
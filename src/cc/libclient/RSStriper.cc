@@ -1799,6 +1799,7 @@ private:
         int       mRecursionCount;
         int       mRecoverySize;
         int       mBadStripeCount;
+        int       mLocalRecoveryIdx;
 
         static Request& Create(
             Outer&    inOuter,
@@ -1852,17 +1853,18 @@ private:
             Offset    inPos,
             int       inSize)
         {
-            mRequestId      = inRequestId;
-            mPos            = inPos;
-            mRecoveryPos    = 0;
-            mSize           = inSize;
-            mPendingCount   = 0;
-            mInFlightCount  = 0;
-            mStatus         = 0;
-            mRecoveryRound  = 0;
-            mRecursionCount = 0;
-            mRecoverySize   = 0;
-            mBadStripeCount = 0;
+            mRequestId        = inRequestId;
+            mPos              = inPos;
+            mRecoveryPos      = 0;
+            mSize             = inSize;
+            mPendingCount     = 0;
+            mInFlightCount    = 0;
+            mStatus           = 0;
+            mRecoveryRound    = 0;
+            mRecursionCount   = 0;
+            mRecoverySize     = 0;
+            mBadStripeCount   = 0;
+            mLocalRecoveryIdx = -1;
             const int theBufCount = inOuter.GetBufferCount();
             for (int i = 0; i < theBufCount; i++) {
                 GetBuffer(i).Clear();
@@ -1898,7 +1900,7 @@ private:
                     " round: "       << mRecoveryRound    <<
                 KFS_LOG_EOM;
                 if (inNewFailureFlag && mRecoveryRound <= 0 &&
-                        Recovery(inOuter)) {
+                        Recovery(inOuter, theStripeIdx)) {
                     return;
                 }
             } else if (mRecoveryRound > 0 &&
@@ -1959,7 +1961,8 @@ private:
         bool IsFailed() const
             { return Outer::IsFailure(mStatus); }
         void InitRecovery(
-            Outer& inOuter)
+            Outer& inOuter,
+            int    inFailedStripeIdx = -1)
         {
             if (mSize <= 0 || mRecoverySize > 0) {
                 return;
@@ -1974,21 +1977,82 @@ private:
                     "failed to start recovery: invalid request");
                 return;
             }
+            // With locally repairable code start with reading only the
+            // failed stripe's local group.
+            mLocalRecoveryIdx =
+                inOuter.GetLocalRecoveryStripeIdx(inFailedStripeIdx) < 0 ?
+                -1 : inFailedStripeIdx;
             KFS_LOG_STREAM_INFO << inOuter.mLogPrefix <<
                 "init recovery:"
-                " req: "  << mPos                 <<
-                ","       << mSize                <<
-                " pos: "  << mRecoveryPos         <<
-                " size: " << mRecoverySize        <<
+                " req: "   << mPos                 <<
+                ","        << mSize                <<
+                " pos: "   << mRecoveryPos         <<
+                " size: "  << mRecoverySize        <<
                 " [" << GetChunkPos(mRecoveryPos) << "," <<
                         (GetChunkPos(mRecoveryPos) + mRecoverySize) << ")" <<
+                " local: " << mLocalRecoveryIdx    <<
+            KFS_LOG_EOM;
+            Offset theOffset = mRecoveryPos;
+            for (int i = 0; i < inOuter.mStripeCount; i++) {
+                if (mLocalRecoveryIdx < 0 || IsLocalRecoveryRead(inOuter, i)) {
+                    mPendingCount += GetBuffer(i).InitRecoveryRead(
+                        inOuter, theOffset, mRecoverySize);
+                }
+                theOffset += (Offset)CHUNKSIZE;
+            }
+        }
+        // Returns true if the data stripe is read by the local recovery.
+        // Client read recovery also reads the data stripe that follows the
+        // stripe being recovered, in order to determine its size.
+        bool IsLocalRecoveryRead(
+            Outer& inOuter,
+            int    inIdx) const
+        {
+            return (0 <= mLocalRecoveryIdx && (
+                inOuter.IsLocalGroupStripe(
+                    inOuter.GetLocalRecoveryStripeIdx(mLocalRecoveryIdx),
+                    inIdx) ||
+                (inOuter.mRecoverStripeIdx < 0 &&
+                    inIdx == mLocalRecoveryIdx + 1)
+            ));
+        }
+        // Switches from the local to the generic recovery by scheduling the
+        // reads of the remaining data stripes.
+        void ExpandLocalRecovery(
+            Outer& inOuter)
+        {
+            if (mLocalRecoveryIdx < 0) {
+                return;
+            }
+            KFS_LOG_STREAM_INFO << inOuter.mLogPrefix <<
+                "local recovery:"
+                " req: "    << mPos              <<
+                ","         << mSize             <<
+                " stripe: " << mLocalRecoveryIdx <<
+                " bad: "    << mBadStripeCount   <<
+                " status: " << mStatus           <<
+                " reading all data stripes"      <<
             KFS_LOG_EOM;
             Offset theOffset = mRecoveryPos;
             for (int i = 0; i < inOuter.mStripeCount; i++) {
-                mPendingCount += GetBuffer(i).InitRecoveryRead(
-                    inOuter, theOffset, mRecoverySize);
+                if (! IsLocalRecoveryRead(inOuter, i)) {
+                    Buffer& theBuf = GetBuffer(i);
+                    if (i == 0 && inOuter.mStripeCount <=
+                            inOuter.mRecoverStripeIdx) {
+                        // Recovery stripe restore requires the first stripe
+                        // read, see InitRecoveryStripeRestore().
+                        theBuf.mBuf.mSize = mRecoverySize;
+                        theBuf.mPos       = theOffset;
+                        mSize            += mRecoverySize;
+                        mPendingCount    += mRecoverySize;
+                    } else {
+                        mPendingCount += theBuf.InitRecoveryRead(
+                            inOuter, theOffset, mRecoverySize);
+                    }
+                }
                 theOffset += (Offset)CHUNKSIZE;
             }
+            mLocalRecoveryIdx = -1;
         }
 
     private:
@@ -2010,34 +2074,88 @@ private:
               mRecoveryRound(0),
               mRecursionCount(0),
               mRecoverySize(0),
-              mBadStripeCount(0)
+              mBadStripeCount(0),
+              mLocalRecoveryIdx(-1)
             { Requests::Init(*this); }
         ~Request()
             {}
         bool Recovery(
-            Outer& inOuter)
+            Outer& inOuter,
+            int    inFailedStripeIdx)
         {
             if (++mBadStripeCount > inOuter.mRecoveryStripeCount) {
                 return false;
             }
             if (mBadStripeCount <= 1 && mRecoverySize <= 0) {
-                InitRecovery(inOuter);
+                InitRecovery(inOuter, inFailedStripeIdx);
+            } else {
+                ExpandLocalRecovery(inOuter);
             }
             if (mRecoverySize <= 0) {
                 return false;
             }
-            const int i = inOuter.mStripeCount + mBadStripeCount - 1;
+            const int i = GetRecoveryStripeToRead(inOuter, inFailedStripeIdx);
+            if (i < 0) {
+                return false;
+            }
             mPendingCount += GetBuffer(i).InitRecoveryRead(
                 inOuter, mRecoveryPos + i * (Offset)CHUNKSIZE, mRecoverySize);
             Read(inOuter);
             return true;
         }
+        int GetRecoveryStripeToRead(
+            Outer& inOuter,
+            int    inFailedStripeIdx)
+        {
+            const int theLocalIdx = inOuter.mDecoderPtr ?
+                inOuter.mDecoderPtr->GetLocalRecoveryStripeIdx(
+                    inOuter.mStripeCount,
+                    inOuter.mRecoveryStripeCount,
+                    inFailedStripeIdx
+                ) : -1;
+            if (theLocalIdx < 0) {
+                return (inOuter.mStripeCount + mBadStripeCount - 1);
+            }
+            // Locally repairable code: read the failed stripe's local group
+            // parity first, then the remaining recovery stripes in order.
+            if (IsRecoveryStripeReadAvailable(inOuter, theLocalIdx)) {
+                return theLocalIdx;
+            }
+            const int theBufCount = inOuter.GetBufferCount();
+            for (int i = inOuter.mStripeCount; i < theBufCount; i++) {
+                if (IsRecoveryStripeReadAvailable(inOuter, i)) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+        bool IsRecoveryStripeReadAvailable(
+            Outer& inOuter,
+            int    inIdx)
+        {
+            if (inIdx == inOuter.mRecoverStripeIdx) {
+                return false;
+            }
+            Buffer& theBuf = GetBuffer(inIdx);
+            return (theBuf.GetSize() <= 0 && ! theBuf.IsFailed());
+        }
         void Done(
             Outer& inOuter)
         {
             if (mPendingCount > 0) {
                 return;
             }
+            if (0 <= mLocalRecoveryIdx) {
+                if (inOuter.FinishLocalRecovery(*this)) {
+                    inOuter.RequestCompletion(*this);
+                    return;
+                }
+                ExpandLocalRecovery(inOuter);
+                if (mPendingCount > 0) {
+                    Read(inOuter);
+                    return;
+                }
+            }
             if (mRecoverySize > 0 ||
                     inOuter.mStripeCount <= inOuter.mRecoverStripeIdx) {
                 inOuter.FinishRecovery(*this);
@@ -2468,6 +2586,7 @@ private:
                 inRequest.mInFlightCount == 0
             );
             const int theBufCount = inOuter.GetBufferCount();
+            int       theFailedIdx = -1;
             int i;
             for (i = 0; ; i++) {
                 const int theIdx = i < mMissingCnt ?
@@ -2481,9 +2600,11 @@ private:
                                 inOuter.mStripeCount)) {
                         break;
                     }
-                    inRequest.InitRecovery(inOuter);
+                    inRequest.InitRecovery(inOuter, GetLocalRecoveryIdx(
+                        inOuter, inRequest, theFailedIdx));
                     if (inRequest.mRecoverySize <= 0 ||
-                            inRequest.mBadStripeCount >= mMissingCnt) {
+                            inRequest.mBadStripeCount >= mMissingCnt ||
+                            0 <= inRequest.mLocalRecoveryIdx) {
                         break;
                     }
                     i = 0;
@@ -2501,6 +2622,7 @@ private:
                 );
                 inRequest.mPendingCount -= theSize;
                 inRequest.mBadStripeCount++;
+                theFailedIdx = theIdx;
                 KFS_LOG_STREAM_DEBUG << inOuter.mLogPrefix <<
                     "get read recovery info:"
                     " req: "     << inRequest.mPos            <<
@@ -2514,6 +2636,18 @@ private:
             if (inRequest.mRecoverySize <= 0) {
                 return;
             }
+            if (0 <= inRequest.mLocalRecoveryIdx) {
+                const int theLocalIdx = inOuter.GetLocalRecoveryStripeIdx(
+                    inRequest.mLocalRecoveryIdx);
+                inRequest.mPendingCount +=
+                    inRequest.GetBuffer(theLocalIdx).InitRecoveryRead(
+                        inOuter,
+                        inRequest.mRecoveryPos +
+                            theLocalIdx * (Offset)CHUNKSIZE,
+                        inRequest.mRecoverySize
+                    );
+                return;
+            }
             for (int l = 0, k = inOuter.mStripeCount;
                     l < inRequest.mBadStripeCount && k < theBufCount;
                     l++, k++) {
@@ -2546,6 +2680,30 @@ private:
             }
         }
     private:
+        // Returns the data stripe to recover with the local group only, if
+        // the only missing stripe is the data stripe, and its local recovery
+        // stripe is not missing, or -1 otherwise.
+        int GetLocalRecoveryIdx(
+            Outer&   inOuter,
+            Request& inRequest,
+            int      inFailedIdx) const
+        {
+            if (inFailedIdx < 0 || 1 != inRequest.mBadStripeCount ||
+                    0 <= inOuter.mRecoverStripeIdx) {
+                return -1;
+            }
+            const int theLocalIdx =
+                inOuter.GetLocalRecoveryStripeIdx(inFailedIdx);
+            if (theLocalIdx < 0) {
+                return -1;
+            }
+            for (int i = 0; i < mMissingCnt; i++) {
+                if (mMissingIdx[i] == theLocalIdx) {
+                    return -1;
+                }
+            }
+            return inFailedIdx;
+        }
         RecoveryInfo(
             const RecoveryInfo& inInfo);
         RecoveryInfo& operator=(
@@ -2665,6 +2823,44 @@ private:
         Request& theRequest = GetRequest(inRequestId, GetPos(), 0);
         theRequest.mRecoverySize = -inLength;
         theRequest.mRecoveryPos  = GetChunkBlockStartFilePos() + inChunkOffset;
+        const int theLocalIdx = GetLocalRecoveryStripeIdx(mRecoverStripeIdx);
+        if (0 <= theLocalIdx) {
+            // Locally repairable code: read only the local group data
+            // stripes, and the local parity stripe, if the chunk being
+            // recovered is data stripe chunk.
+            Buffer& theBuf = theRequest.GetBuffer(mRecoverStripeIdx);
+            theBuf.mBuf.mSize = inLength;
+            theBuf.mPos       = theRequest.mRecoveryPos +
+                mRecoverStripeIdx * (Offset)kChunkSize;
+            theRequest.mSize  = inLength;
+            theBuf.MarkFailed();
+            if (mRecoverStripeIdx < mStripeCount) {
+                theRequest.mBadStripeCount = 1;
+            } else if (IsLocalGroupStripe(theLocalIdx, 0)) {
+                // Recovery stripe restore requires the first stripe read,
+                // see InitRecoveryStripeRestore().
+                Buffer& theFirstBuf = theRequest.GetBuffer(0);
+                theFirstBuf.mBuf.mSize = inLength;
+                theFirstBuf.mPos       = theRequest.mRecoveryPos;
+                theRequest.mSize         += inLength;
+                theRequest.mPendingCount += inLength;
+            }
+            theRequest.InitRecovery(*this, mRecoverStripeIdx);
+            QCASSERT(theRequest.mRecoverySize == inLength &&
+                theRequest.mLocalRecoveryIdx == mRecoverStripeIdx);
+            if (theLocalIdx != mRecoverStripeIdx) {
+                theRequest.mPendingCount +=
+                    theRequest.GetBuffer(theLocalIdx).InitRecoveryRead(
+                        *this,
+                        theRequest.mRecoveryPos +
+                            theLocalIdx * (Offset)kChunkSize,
+                        inLength
+                    );
+            }
+            QueueRequest(theRequest);
+            Read();
+            return inLength;
+        }
         mRecoveryInfo.SetIfEmpty(*this, theRequest.mPos, mRecoverStripeIdx);
         Offset thePos = theRequest.mRecoveryPos;
         if (mStripeSize < inLength) {
@@ -2694,6 +2890,192 @@ private:
         Read();
         return inLength;
     }
+    // Returns the local recovery stripe index if the stripe can be
+    // recovered by reading only its local group, or -1 otherwise.
+    int GetLocalRecoveryStripeIdx(
+        int inIdx) const
+    {
+        if (! mDecoderPtr || inIdx < 0 ||
+                (0 <= mRecoverStripeIdx ?
+                    inIdx != mRecoverStripeIdx :
+                    // Client read recovery determines the recovered stripe
+                    // size from the next data stripe size.
+                    mStripeCount <= inIdx + 1)) {
+            return -1;
+        }
+        return mDecoderPtr->GetLocalRecoveryStripeIdx(
+            mStripeCount, mRecoveryStripeCount, inIdx);
+    }
+    bool IsLocalGroupStripe(
+        int inLocalIdx,
+        int inIdx) const
+    {
+        return (0 <= inLocalIdx && (inIdx == inLocalIdx ||
+            (inIdx < mStripeCount &&
+            mDecoderPtr->GetLocalRecoveryStripeIdx(
+                mStripeCount, mRecoveryStripeCount, inIdx) == inLocalIdx)));
+    }
+    int GetLocalRecoveryReadSize(
+        const Request& inRequest,
+        int            inIdx)
+    {
+        if (mRecoverStripeIdx < 0) {
+            return inRequest.mRecoverySize;
+        }
+        return (int)max(Offset(0), min(Offset(inRequest.mRecoverySize),
+            GetChunkSize(inIdx, mRecoverBlockPos, mFileSize) -
+                GetChunkPos(inRequest.mRecoveryPos)));
+    }
+    // Rebuilds the stripe from its local group. Returns false if the stripe
+    // cannot be rebuilt this way, and the generic recovery has to be used:
+    // any of the local group stripes is missing, or the stripe read sizes do
+    // not match the expected sizes. The generic recovery handles short
+    // stripes, holes, and detects chunks with invalid sizes.
+    bool FinishLocalRecovery(
+        Request& inRequest)
+    {
+        const int theIdx      = inRequest.mLocalRecoveryIdx;
+        const int theLocalIdx = GetLocalRecoveryStripeIdx(theIdx);
+        const int theSize     = inRequest.mRecoverySize;
+        if (theLocalIdx < 0 || inRequest.mStatus != 0 || theSize <= 0 ||
+                inRequest.mBadStripeCount > (theIdx < mStripeCount ? 1 : 0)) {
+            return false;
+        }
+        const int theBufCount = GetBufferCount();
+        if (! mBufIteratorsPtr) {
+            mBufIteratorsPtr = new BufIterator[theBufCount];
+        }
+        for (int i = 0; i < theBufCount; i++) {
+            BufIterator& theIt = mBufIteratorsPtr[i];
+            theIt.Clear();
+            mBufPtr[i] = 0;
+            const bool theGroupFlag = IsLocalGroupStripe(theLocalIdx, i);
+            if (! theGroupFlag && (0 <= mRecoverStripeIdx || i != theIdx + 1)) {
+                continue;
+            }
+            Buffer&   theBuf    = inRequest.GetBuffer(i);
+            int       theRdSize = -1;
+            const int theExpRd  =
+                i == theIdx ? -1 : GetLocalRecoveryReadSize(inRequest, i);
+            const bool theOkFlag = theBuf.GetSize() == theSize &&
+                (i == theIdx ? theBuf.IsFailed() :
+                    theBuf.GetReadSize() == theExpRd) &&
+                (! theGroupFlag ||
+                    theIt.Set(*this, theBuf, theRdSize) == theSize);
+            if (! theOkFlag) {
+                KFS_LOG_STREAM_INFO << mLogPrefix <<
+                    "local recovery:"
+                    " req: "      << inRequest.mPos       <<
+                    ","           << inRequest.mSize      <<
+                    " stripe: "   << theIdx               <<
+                    " local: "    << theLocalIdx          <<
+                    " size: "     << theSize              <<
+                    " stripe: "   << i                    <<
+                    " size: "     << theBuf.GetSize()     <<
+                    " read: "     << theBuf.GetReadSize() <<
+                    " expected: " << theExpRd             <<
+                    " chunk: "    << theBuf.mChunkId      <<
+                    " version: "  << theBuf.mChunkVersion <<
+                    " size: "     << theBuf.mChunkSize    <<
+                KFS_LOG_EOM;
+                for (int k = 0; k <= i; k++) {
+                    mBufIteratorsPtr[k].Clear();
+                }
+                return false;
+            }
+        }
+        KFS_LOG_STREAM_INFO << mLogPrefix       <<
+            "local recovery"
+            " req: "    << inRequest.mPos         <<
+            ","         << inRequest.mSize        <<
+            " pos: "    << inRequest.mRecoveryPos <<
+            " size: "   << theSize                <<
+            " stripe: " << theIdx                 <<
+            " local: "  << theLocalIdx            <<
+        KFS_LOG_EOM;
+        mRecoveriesCount++;
+        int theMissingIdx[2];
+        theMissingIdx[0] = theIdx;
+        theMissingIdx[1] = -1;
+        int thePrevLen   = 0;
+        for (int thePos = 0; thePos < theSize; ) {
+            int theLen = theSize - thePos;
+            if (theLen > kAlign) {
+                theLen -= theLen % kAlign;
+            }
+            for (int i = 0; i < theBufCount; i++) {
+                BufIterator& theIt = mBufIteratorsPtr[i];
+                if (! theIt.IsRequested()) {
+                    continue;
+                }
+                char*     thePtr = theIt.Advance(thePrevLen);
+                const int theRem = theIt.GetCurRemaining();
+                if (! thePtr) {
+                    InternalError("null local recovery buffer");
+                    inRequest.mStatus = kErrorIO;
+                    break;
+                }
+                if (theRem < kAlign || PtrFront(thePtr, kAlign) != 0) {
+                    thePtr = GetTempBufPtr(i);
+                    if (theLen > kTempBufSize) {
+                        theLen = kTempBufSize;
+                    }
+                    if (! theIt.IsFailure()) {
+                        const int theCnt = theIt.CopyOut(thePtr, theLen);
+                        if (theCnt < theLen) {
+                            theLen = theCnt;
+                            if (theLen > kAlign) {
+                                theLen -= theLen % kAlign;
+                            }
+                        }
+                    }
+                } else if (theRem < theLen) {
+                    theLen = theRem - theRem % kAlign;
+                }
+                mBufPtr[i] = thePtr;
+            }
+            if (inRequest.mStatus == 0 && mDecoderPtr->Decode(
+                    mStripeCount,
+                    mRecoveryStripeCount,
+                    max(theLen, (int)kAlign),
+                    mBufPtr,
+                    theMissingIdx) != 0) {
+                KFS_LOG_STREAM_ERROR << mLogPrefix        <<
+                    "local recovery decode failure"
+                    " req: "    << inRequest.mPos         <<
+                    ","         << inRequest.mSize        <<
+                    " pos: "    << inRequest.mRecoveryPos <<
+                    "+"         << thePos                 <<
+                    " size: "   << theLen                 <<
+                    " of: "     << theSize                <<
+                KFS_LOG_EOM;
+                inRequest.mStatus = kErrorIO;
+            }
+            if (inRequest.mStatus != 0) {
+                for (int i = 0; i < theBufCount; i++) {
+                    mBufIteratorsPtr[i].Clear();
+                }
+                return true;
+            }
+            if (mBufIteratorsPtr[theIdx].CopyIn(mBufPtr[theIdx], theLen) !=
+                    theLen) {
+                InternalError("invalid copy size");
+            }
+            thePos += theLen;
+            thePrevLen = theLen;
+        }
+        if (mRecoverStripeIdx < 0) {
+            mRecoveryInfo.Set(*this, inRequest);
+        }
+        for (int i = 0; i < theBufCount; i++) {
+            if (i == theIdx) {
+                mBufIteratorsPtr[i].SetRecoveryResult(inRequest.GetBuffer(i));
+            } else {
+                mBufIteratorsPtr[i].Clear();
+            }
+        }
+        return true;
+    }
     void InvalidChunkSize(
          Request& inRequest,
          Buffer&  inBuf,
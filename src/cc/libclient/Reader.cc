@@ -44,6 +44,7 @@
 #include "KfsClient.h"
 #include "RSStriper.h"
 #include "ClientPool.h"
+#include "ChunkServerScores.h"
 #include "Monitor.h"
 
 #include <sstream>
@@ -64,6 +65,7 @@ using std::string;
 using std::ostream;
 using std::ostringstream;
 using std::random_shuffle;
+using std::swap;
 using std::vector;
 using std::pair;
 using std::make_pair;
@@ -131,7 +133,9 @@ public:
           mNetManager(mMetaServer.GetNetManager()),
           mStriperPtr(0),
           mCompletionDepthCount(0),
-          mReplicaCount(-1)
+          mReplicaCount(-1),
+          mReadHedgePtr(0),
+          mServerScoresPtr(0)
         { Readers::Init(mReaders); }
     int Open(
         kfsFileId_t inFileId,
@@ -290,6 +294,15 @@ public:
         mCompletionPtr = 0;
         return true;
     }
+    void SetReadHedge(
+        ReadHedge* inReadHedgePtr)
+    {
+        mReadHedgePtr = (inReadHedgePtr && inReadHedgePtr->IsEnabled()) ?
+            inReadHedgePtr : 0;
+    }
+    void SetChunkServerScores(
+        ChunkServerScores* inScoresPtr)
+        { mServerScoresPtr = inScoresPtr; }
     void GetStats(
         Stats&               outStats,
         KfsNetClient::Stats& outChunkServersStats) const
@@ -335,14 +348,21 @@ private:
             typedef vector<RequestEntry> Requests;
 
             time_t    mOpStartTime;
+            int64_t   mOpStartTimeUsec;
             IOBuffer  mBuffer;
             IOBuffer  mTmpBuffer;
             RequestId mRequestId;
             RequestId mStriperRequestId;
             Requests  mRequests;
+            // Hedged read op of the original op, or the original op of the
+            // hedged read op.
+            ReadOp*   mHedgePtr;
+            ChunkServerScores::Entry* mServerScorePtr;
             bool      mRetryIfFailsFlag;
             bool      mFailShortReadFlag;
             bool      mCancelFlag;
+            bool      mHedgedFlag;
+            bool      mHedgeWonFlag;
 
             ReadOp(
                 int       inOpSize,
@@ -353,14 +373,19 @@ private:
                 bool      inFailShortReadFlag)
                 : KFS::client::ReadOp(-1, -1, -1),
                   mOpStartTime(0),
+                  mOpStartTimeUsec(0),
                   mBuffer(),
                   mTmpBuffer(),
                   mRequestId(inRequestId),
                   mStriperRequestId(inStriperRequestId),
                   mRequests(),
+                  mHedgePtr(0),
+                  mServerScorePtr(0),
                   mRetryIfFailsFlag(inRetryIfFailsFlag),
                   mFailShortReadFlag(inFailShortReadFlag),
-                  mCancelFlag(false)
+                  mCancelFlag(false),
+                  mHedgedFlag(false),
+                  mHedgeWonFlag(false)
             {
                 Queue::Init(*this);
                 numBytes                   = inOpSize;
@@ -445,11 +470,16 @@ private:
               mLogPrefix(inLogPrefix),
               mOpsNoRetryCount(0),
               mDeletedFlagPtr(0),
-              mRunningCompletionPtr(0)
+              mRunningCompletionPtr(0),
+              mHedgeTimer(*this),
+              mHedgeChunkServerPtr(0),
+              mHedgeServerPtr(0),
+              mHedgeWonOpPtr(0)
         {
             Queue::Init(mPendingQueue);
             Queue::Init(mInFlightQueue);
             Queue::Init(mCompletionQueue);
+            Queue::Init(mHedgeQueue);
             Readers::Init(*this);
             Readers::PushFront(mOuter.mReaders, *this);
             mChunkServer.SetRetryConnectOnly(true);
@@ -464,9 +494,18 @@ private:
         ~ChunkReader()
         {
             ChunkReader::Shutdown();
+            ReleasePooledChunkServer(mChunkServerPtr);
+            ReleasePooledChunkServer(mHedgeServerPtr);
             ChunkServer::Stats theStats;
             mChunkServer.GetStats(theStats);
             mOuter.mChunkServersStats.Add(theStats);
+            if (mHedgeChunkServerPtr) {
+                mHedgeChunkServerPtr->Stop();
+                ChunkServer::Stats theHedgeStats;
+                mHedgeChunkServerPtr->GetStats(theHedgeStats);
+                mOuter.mChunkServersStats.Add(theHedgeStats);
+                delete mHedgeChunkServerPtr;
+            }
             Readers::Remove(mOuter.mReaders, *this);
             if (mDeletedFlagPtr) {
                 *mDeletedFlagPtr = true;
@@ -620,6 +659,8 @@ private:
                 CloseChunk();
             }
             Reset();
+            CancelHedge();
+            StopHedgeTimer();
             QCRTASSERT(Queue::IsEmpty(mInFlightQueue));
             Queue::PushBackList(mCompletionQueue, mPendingQueue);
             while (! Queue::IsEmpty(mCompletionQueue)) {
@@ -767,6 +808,29 @@ private:
                 StRunningCompletion& inCompl);
         };
 
+        class HedgeTimer : public ITimeout
+        {
+        public:
+            HedgeTimer(
+                ChunkReader& inOuter)
+                : ITimeout(),
+                  mOuter(inOuter),
+                  mReadHedgePtr(0)
+                {}
+            virtual void Timeout()
+                { mOuter.HedgeTimeout(); }
+        private:
+            ChunkReader& mOuter;
+        public:
+            // Non null while the timer is registered.
+            ReadHedge*   mReadHedgePtr;
+        private:
+            HedgeTimer(
+                const HedgeTimer& inTimer);
+            HedgeTimer& operator=(
+                const HedgeTimer& inTimer);
+        };
+
         Impl&                mOuter;
         ChunkServer          mChunkServer;
         ChunkServer*         mChunkServerPtr;
@@ -801,9 +865,14 @@ private:
         int                  mOpsNoRetryCount;
         bool*                mDeletedFlagPtr;
         StRunningCompletion* mRunningCompletionPtr;
+        HedgeTimer           mHedgeTimer;
+        ChunkServer*         mHedgeChunkServerPtr;
+        ChunkServer*         mHedgeServerPtr;
+        ReadOp*              mHedgeWonOpPtr;
         ReadOp*              mPendingQueue[1];
         ReadOp*              mInFlightQueue[1];
         ReadOp*              mCompletionQueue[1];
+        ReadOp*              mHedgeQueue[1];
         ChunkReader*         mPrevPtr[1];
         ChunkReader*         mNextPtr[1];
 
@@ -919,31 +988,59 @@ private:
                     ! mLeaseAcquireOp.allowCSClearTextFlag;
                 const ServerLocation& theLocation =
                     mGetAllocOp.chunkServers[mChunkServerIdx];
+                const bool theShutdownSslFlag =
+                    mLeaseAcquireOp.allowCSClearTextFlag &&
+                    theCSClearTextAllowedFlag;
+                // Get access and key first, as pooled connections are
+                // keyed by the key id and authentication context.
+                CryptoKeys::Key                 theKey;
+                const ChunkServerAccess::Entry* thePtr = 0;
+                if (mChunkServerAccess.IsEmpty()) {
+                    mSizeOp.access.clear();
+                } else {
+                    thePtr = mChunkServerAccess.Get(
+                        theLocation,
+                        mGetAllocOp.chunkId,
+                        theKey
+                    );
+                    if (thePtr) {
+                        if (mChunkAccess.IsEmpty()) {
+                            mSizeOp.access.assign(
+                                thePtr->chunkAccess.mPtr,
+                                thePtr->chunkAccess.mLen
+                            );
+                        } else {
+                            mSizeOp.access = mChunkAccess.GetChunkAccess(
+                                theLocation, mGetAllocOp.chunkId);
+                        }
+                        mNoCSAccessFlag = mSizeOp.access.empty();
+                    } else {
+                        mNoCSAccessFlag = true;
+                    }
+                }
+                ReleasePooledChunkServer(mChunkServerPtr);
                 if (mOuter.mClientPoolPtr) {
                     mChunkServerPtr = &mOuter.mClientPoolPtr->Get(
-                        theLocation, mGetAllocOp.allCSShortRpcFlag);
+                        theLocation,
+                        mGetAllocOp.allCSShortRpcFlag,
+                        theShutdownSslFlag,
+                        thePtr ? string(
+                            thePtr->chunkServerAccessId.mPtr,
+                            thePtr->chunkServerAccessId.mLen) : string(),
+                        (thePtr && ! mNoCSAccessFlag) ?
+                            mOuter.mMetaServer.GetAuthContext() : 0
+                    );
                 } else {
                     mChunkServerPtr = &mChunkServer;
                     mChunkServer.SetRpcFormat(mGetAllocOp.allCSShortRpcFlag ?
                         KfsNetClient::kRpcFormatShort :
                         KfsNetClient::kRpcFormatLong);
                 }
-                mChunkServerPtr->SetShutdownSsl(
-                    mLeaseAcquireOp.allowCSClearTextFlag &&
-                    theCSClearTextAllowedFlag
-                );
+                mChunkServerPtr->SetShutdownSsl(theShutdownSslFlag);
                 if (mChunkServerAccess.IsEmpty()) {
                     mChunkServerPtr->SetKey(0, 0, 0, 0);
                     mChunkServerPtr->SetAuthContext(0);
-                    mSizeOp.access.clear();
                 } else {
-                    CryptoKeys::Key theKey;
-                    const ChunkServerAccess::Entry* const thePtr =
-                        mChunkServerAccess.Get(
-                            theLocation,
-                            mGetAllocOp.chunkId,
-                            theKey
-                        );
                     if (thePtr) {
                         mChunkServerPtr->SetKey(
                             thePtr->chunkServerAccessId.mPtr,
@@ -951,18 +1048,6 @@ private:
                             theKey.GetPtr(),
                             theKey.GetSize()
                         );
-                        if (mChunkAccess.IsEmpty()) {
-                            mSizeOp.access.assign(
-                                thePtr->chunkAccess.mPtr,
-                                thePtr->chunkAccess.mLen
-                            );
-                        } else {
-                            mSizeOp.access = mChunkAccess.GetChunkAccess(
-                                theLocation, mGetAllocOp.chunkId);
-                        }
-                        mNoCSAccessFlag = mSizeOp.access.empty();
-                    } else {
-                        mNoCSAccessFlag = true;
                     }
                     if (! mNoCSAccessFlag &&
                             ! mChunkServerPtr->GetAuthContext()) {
@@ -1045,6 +1130,21 @@ private:
                     mGetAllocOp.chunkServers.end()
                 );
             }
+            if (mOuter.mServerScoresPtr &&
+                    2 <= mGetAllocOp.chunkServers.size()) {
+                // Power of two choices: use the first two, random or meta
+                // server ordered, candidates and pick the one with the least
+                // expected completion time.
+                const int64_t theNow = mOuter.mNetManager.NowUsec();
+                if (mOuter.mServerScoresPtr->GetExpectedTimeUsec(
+                            mGetAllocOp.chunkServers[1], theNow) <
+                        mOuter.mServerScoresPtr->GetExpectedTimeUsec(
+                            mGetAllocOp.chunkServers[0], theNow)) {
+                    swap(mGetAllocOp.chunkServers[0],
+                        mGetAllocOp.chunkServers[1]);
+                    mOuter.mStats.mReplicaReorderCount++;
+                }
+            }
             mChunkServerIdx = 0;
             StartRead();
         }
@@ -1286,7 +1386,10 @@ private:
                 &inReadOp.mBuffer, inReadOp.numBytes);
             inReadOp.chunkId      = mGetAllocOp.chunkId;
             inReadOp.chunkVersion = mGetAllocOp.chunkVersion;
-            inReadOp.mOpStartTime = Now();
+            inReadOp.mOpStartTime     = Now();
+            // Zero start time marks the op as not sent to the server, and
+            // excludes it from the latency statistics.
+            inReadOp.mOpStartTimeUsec = 0;
             Queue::Remove(mPendingQueue, inReadOp);
             Queue::PushBack(mInFlightQueue, inReadOp);
             if (inReadOp.offset >= mSizeOp.size) {
@@ -1297,8 +1400,14 @@ private:
                 Done(inReadOp, false, &inReadOp.mTmpBuffer);
                 return;
             }
-            inReadOp.access = mSizeOp.access;
+            inReadOp.mOpStartTimeUsec = mOuter.mNetManager.NowUsec();
+            StartServerScore(inReadOp,
+                mGetAllocOp.chunkServers[mChunkServerIdx]);
+            inReadOp.access           = mSizeOp.access;
+            inReadOp.mHedgedFlag      = false;
+            inReadOp.mHedgeWonFlag    = false;
             mOuter.mStats.mOpsReadCount++;
+            StartHedgeTimer();
             Enqueue(inReadOp, &inReadOp.mTmpBuffer);
         }
         void Done(
@@ -1310,12 +1419,21 @@ private:
                 inBufferPtr == &inOp.mTmpBuffer &&
                 Queue::IsInList(mInFlightQueue, inOp)
             );
+            if (&inOp == mHedgeWonOpPtr) {
+                // The hedged read won, and the original op is being canceled.
+                // HedgeDone() completes the original op.
+                return;
+            }
+            if (inOp.mHedgePtr) {
+                CancelHedge();
+            }
             if (inOp.status == kErrorNoEntry &&
                     mGetAllocOp.status != kErrorNoEntry) {
                 inOp.status = kErrorIO;
             }
             if (inCanceledFlag || inOp.status < 0 || ! VerifyChecksum(inOp) ||
                     ! VerifyRead(inOp)) {
+                UpdateServerScore(inOp, inCanceledFlag, ! inCanceledFlag);
                 Queue::Remove(mInFlightQueue, inOp);
                 Queue::PushBack(mPendingQueue, inOp);
                 inOp.mTmpBuffer.Clear();
@@ -1345,8 +1463,16 @@ private:
                 theDoneCount <= inOp.mTmpBuffer.BytesConsumable() &&
                 inOp.contentLength <= inOp.numBytes
             );
+            UpdateServerScore(inOp, false, false);
             mOuter.mStats.mReadCount++;
             mOuter.mStats.mReadByteCount += theDoneCount;
+            if (mOuter.mReadHedgePtr && ! inOp.mHedgeWonFlag &&
+                    0 < inOp.mOpStartTimeUsec) {
+                // Use only the original op latencies, in order to prevent
+                // the hedged reads from lowering the hedge delay.
+                mOuter.mReadHedgePtr->Update(
+                    mOuter.mNetManager.NowUsec() - inOp.mOpStartTimeUsec);
+            }
             if (theDoneCount < inOp.mTmpBuffer.BytesConsumable()) {
                 // Move available space, if any, to the end of the short read.
                 IOBuffer theBuf;
@@ -1681,7 +1807,10 @@ private:
             if (mLastMetaOpPtr == inOpPtr) {
                 mLastMetaOpPtr = 0;
             }
-            if (&mGetAllocOp == inOpPtr) {
+            if (inOpPtr && inOpPtr == Queue::Front(mHedgeQueue)) {
+                HedgeDone(*static_cast<ReadOp*>(inOpPtr),
+                    inCanceledFlag, inBufferPtr);
+            } else if (&mGetAllocOp == inOpPtr) {
                 Done(mGetAllocOp, inCanceledFlag, inBufferPtr);
             } else if (&mLeaseAcquireOp == inOpPtr) {
                 Done(mLeaseAcquireOp, inCanceledFlag, inBufferPtr);
@@ -2144,6 +2273,17 @@ private:
             }
             return true; // Cancel the original request.
         }
+        // Returns pooled connection reference, if any, to the pool.
+        void ReleasePooledChunkServer(
+            ChunkServer*& ioServerPtr)
+        {
+            if (ioServerPtr && mOuter.mClientPoolPtr &&
+                    ioServerPtr != &mChunkServer &&
+                    ioServerPtr != mHedgeChunkServerPtr) {
+                mOuter.mClientPoolPtr->Release(*ioServerPtr);
+            }
+            ioServerPtr = 0;
+        }
         void StopChunkServer()
         {
             if (&mChunkServer == mChunkServerPtr) {
@@ -2160,6 +2300,311 @@ private:
                 mChunkServerPtr->CancelAllWithOwner(this);
             }
         }
+        void StartServerScore(
+            ReadOp&               inOp,
+            const ServerLocation& inLocation)
+        {
+            if (! mOuter.mServerScoresPtr) {
+                return;
+            }
+            inOp.mServerScorePtr = &mOuter.mServerScoresPtr->Get(inLocation);
+            mOuter.mServerScoresPtr->Start(*inOp.mServerScorePtr);
+        }
+        void UpdateServerScore(
+            ReadOp& inOp,
+            bool    inCanceledFlag,
+            bool    inErrorFlag)
+        {
+            if (! inOp.mServerScorePtr || ! mOuter.mServerScoresPtr) {
+                return;
+            }
+            const int64_t theNow = mOuter.mNetManager.NowUsec();
+            mOuter.mServerScoresPtr->Done(
+                *inOp.mServerScorePtr,
+                inCanceledFlag ? int64_t(-1) : theNow - inOp.mOpStartTimeUsec,
+                inErrorFlag,
+                theNow
+            );
+            inOp.mServerScorePtr = 0;
+        }
+        void StartHedgeTimer()
+        {
+            if (mHedgeTimer.mReadHedgePtr || ! mOuter.mReadHedgePtr ||
+                    mGetAllocOp.chunkServers.size() <= 1) {
+                return;
+            }
+            mHedgeTimer.mReadHedgePtr = mOuter.mReadHedgePtr;
+            mHedgeTimer.mReadHedgePtr->TimerStarted(mOuter.mNetManager);
+            mOuter.mNetManager.RegisterTimeoutHandler(&mHedgeTimer);
+        }
+        void StopHedgeTimer()
+        {
+            if (! mHedgeTimer.mReadHedgePtr) {
+                return;
+            }
+            mOuter.mNetManager.UnRegisterTimeoutHandler(&mHedgeTimer);
+            mHedgeTimer.mReadHedgePtr->TimerStopped(mOuter.mNetManager);
+            mHedgeTimer.mReadHedgePtr = 0;
+        }
+        void HedgeTimeout()
+        {
+            if (Queue::IsEmpty(mInFlightQueue) || ! mOuter.mReadHedgePtr) {
+                StopHedgeTimer();
+                return;
+            }
+            if (! Queue::IsEmpty(mHedgeQueue) || mNoCSAccessFlag ||
+                    ! mChunkServerSetFlag || mSleepingFlag ||
+                    mErrorCode != 0) {
+                return;
+            }
+            const int64_t theStartTime = mOuter.mNetManager.NowUsec() -
+                mOuter.mReadHedgePtr->GetDelayUsec();
+            Queue::Iterator theIt(mInFlightQueue);
+            ReadOp*         theOpPtr;
+            while ((theOpPtr = theIt.Next())) {
+                if (! theOpPtr->mHedgedFlag && ! theOpPtr->mCancelFlag &&
+                        theOpPtr->mOpStartTimeUsec <= theStartTime) {
+                    StartHedge(*theOpPtr);
+                    return;
+                }
+            }
+        }
+        // Issues the same read to the next replica. Only one hedged read per
+        // chunk reader is in flight at a time.
+        void StartHedge(
+            ReadOp& inOp)
+        {
+            const size_t theCount = mGetAllocOp.chunkServers.size();
+            if (theCount <= 1) {
+                return;
+            }
+            inOp.mHedgedFlag = true;
+            size_t theIdx = (mChunkServerIdx + 1) % theCount;
+            if (mOuter.mServerScoresPtr) {
+                const int64_t theNow = mOuter.mNetManager.NowUsec();
+                int64_t theMin = -1;
+                for (size_t i = 0; i < theCount; i++) {
+                    if (i == mChunkServerIdx) {
+                        continue;
+                    }
+                    const int64_t theTime =
+                        mOuter.mServerScoresPtr->GetExpectedTimeUsec(
+                            mGetAllocOp.chunkServers[i], theNow);
+                    if (theMin < 0 || theTime < theMin) {
+                        theMin = theTime;
+                        theIdx = i;
+                    }
+                }
+            }
+            const ServerLocation& theLocation =
+                mGetAllocOp.chunkServers[theIdx];
+            string                          theAccess;
+            CryptoKeys::Key                 theKey;
+            const ChunkServerAccess::Entry* thePtr = 0;
+            if (! mChunkServerAccess.IsEmpty()) {
+                thePtr = mChunkServerAccess.Get(
+                    theLocation,
+                    mGetAllocOp.chunkId,
+                    theKey
+                );
+                if (thePtr) {
+                    if (mChunkAccess.IsEmpty()) {
+                        theAccess.assign(
+                            thePtr->chunkAccess.mPtr,
+                            thePtr->chunkAccess.mLen
+                        );
+                    } else {
+                        theAccess = mChunkAccess.GetChunkAccess(
+                            theLocation, mGetAllocOp.chunkId);
+                    }
+                }
+                if (theAccess.empty()) {
+                    KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                        "no hedged read access:"
+                        " chunk: "  << mGetAllocOp.chunkId <<
+                        " server: " << theLocation <<
+                    KFS_LOG_EOM;
+                    return;
+                }
+            }
+            const bool theShutdownSslFlag = GetChunkServer().IsShutdownSsl();
+            ReleasePooledChunkServer(mHedgeServerPtr);
+            if (mOuter.mClientPoolPtr) {
+                mHedgeServerPtr = &mOuter.mClientPoolPtr->Get(
+                    theLocation,
+                    mGetAllocOp.allCSShortRpcFlag,
+                    theShutdownSslFlag,
+                    thePtr ? string(
+                        thePtr->chunkServerAccessId.mPtr,
+                        thePtr->chunkServerAccessId.mLen) : string(),
+                    thePtr ? mOuter.mMetaServer.GetAuthContext() : 0
+                );
+            } else {
+                if (! mHedgeChunkServerPtr) {
+                    mOuter.mChunkServerInitialSeqNum += 10000;
+                    mHedgeChunkServerPtr = new ChunkServer(
+                        mOuter.mNetManager,
+                        string(), -1, // host, port
+                        0, // inMaxRetryCount
+                        0, // inTimeSecBetweenRetries,
+                        mOuter.mOpTimeoutSec,
+                        mOuter.mIdleTimeoutSec,
+                        mOuter.mChunkServerInitialSeqNum,
+                        mLogPrefix.c_str(),
+                        false, // inResetConnectionOnOpTimeoutFlag
+                        int(min(
+                            int64_t(mOuter.mMaxReadSize) + (64 << 10),
+                            int64_t(std::numeric_limits<int>::max())
+                        ))
+                    );
+                    mHedgeChunkServerPtr->SetRetryConnectOnly(true);
+                }
+                mHedgeServerPtr = mHedgeChunkServerPtr;
+                mHedgeServerPtr->SetRpcFormat(mGetAllocOp.allCSShortRpcFlag ?
+                    KfsNetClient::kRpcFormatShort :
+                    KfsNetClient::kRpcFormatLong);
+            }
+            mHedgeServerPtr->SetShutdownSsl(theShutdownSslFlag);
+            if (! thePtr) {
+                mHedgeServerPtr->SetKey(0, 0, 0, 0);
+                mHedgeServerPtr->SetAuthContext(0);
+            } else {
+                mHedgeServerPtr->SetKey(
+                    thePtr->chunkServerAccessId.mPtr,
+                    thePtr->chunkServerAccessId.mLen,
+                    theKey.GetPtr(),
+                    theKey.GetSize()
+                );
+                if (! mHedgeServerPtr->GetAuthContext()) {
+                    mHedgeServerPtr->SetAuthContext(
+                        mOuter.mMetaServer.GetAuthContext());
+                }
+            }
+            if (mHedgeServerPtr == mHedgeChunkServerPtr) {
+                mHedgeChunkServerPtr->SetServer(theLocation);
+            }
+            ReadOp& theHedgeOp = *(new ReadOp(
+                (int)inOp.numBytes,
+                inOp.offset,
+                RequestId(),
+                RequestId(),
+                false,
+                inOp.mFailShortReadFlag
+            ));
+            theHedgeOp.chunkId          = inOp.chunkId;
+            theHedgeOp.chunkVersion     = inOp.chunkVersion;
+            theHedgeOp.access           = theAccess;
+            theHedgeOp.mOpStartTime     = Now();
+            theHedgeOp.mOpStartTimeUsec = mOuter.mNetManager.NowUsec();
+            theHedgeOp.mHedgePtr        = &inOp;
+            inOp.mHedgePtr              = &theHedgeOp;
+            Queue::PushBack(mHedgeQueue, theHedgeOp);
+            StartServerScore(theHedgeOp, theLocation);
+            mOuter.mStats.mHedgedReadsCount++;
+            mOuter.mStats.mChunkOpsQueuedCount++;
+            KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                "+> hedged " << theHedgeOp.Show() <<
+                " server: "  << theLocation <<
+                " delay: "   << mOuter.mReadHedgePtr->GetDelayUsec() <<
+            KFS_LOG_EOM;
+            if (! mHedgeServerPtr->Enqueue(
+                    &theHedgeOp, this, &theHedgeOp.mTmpBuffer)) {
+                theHedgeOp.status = kErrorFault;
+                HedgeDone(theHedgeOp, false, &theHedgeOp.mTmpBuffer);
+            }
+        }
+        void CancelHedge()
+        {
+            ReadOp* const theOpPtr = Queue::Front(mHedgeQueue);
+            if (! theOpPtr) {
+                return;
+            }
+            if (theOpPtr->mHedgePtr) {
+                theOpPtr->mHedgePtr->mHedgePtr = 0;
+                theOpPtr->mHedgePtr = 0;
+            }
+            // Cancel invokes HedgeDone(), which deletes the op.
+            if (! mHedgeServerPtr || ! mHedgeServerPtr->Cancel(theOpPtr, this) ||
+                    theOpPtr == Queue::Front(mHedgeQueue)) {
+                if (mHedgeServerPtr && mHedgeServerPtr == mHedgeChunkServerPtr) {
+                    mHedgeChunkServerPtr->Stop();
+                }
+                if (theOpPtr == Queue::Front(mHedgeQueue)) {
+                    theOpPtr->Delete(mHedgeQueue);
+                }
+            }
+        }
+        void HedgeDone(
+            ReadOp&   inOp,
+            bool      inCanceledFlag,
+            IOBuffer* inBufferPtr)
+        {
+            QCASSERT(inBufferPtr == &inOp.mTmpBuffer &&
+                &inOp == Queue::Front(mHedgeQueue));
+            ReadOp* const theOrigOpPtr = inOp.mHedgePtr;
+            if (theOrigOpPtr) {
+                theOrigOpPtr->mHedgePtr = 0;
+                inOp.mHedgePtr          = 0;
+            }
+            if (inCanceledFlag || ! theOrigOpPtr || inOp.status < 0 ||
+                    inOp.numBytes < inOp.contentLength ||
+                    inOp.mTmpBuffer.BytesConsumable() !=
+                        (int)inOp.contentLength ||
+                    ! VerifyChecksum(inOp)) {
+                UpdateServerScore(inOp, inCanceledFlag || ! theOrigOpPtr,
+                    ! inCanceledFlag && theOrigOpPtr);
+                KFS_LOG_STREAM(inCanceledFlag || ! theOrigOpPtr ?
+                        MsgLogger::kLogLevelDEBUG :
+                        MsgLogger::kLogLevelINFO) << mLogPrefix <<
+                    "hedged read " << (inCanceledFlag ? "canceled" :
+                        (theOrigOpPtr ? "failed" : "lost")) <<
+                    " status: " << inOp.status <<
+                    " msg: "    << inOp.statusMsg <<
+                    " "         << inOp.Show() <<
+                KFS_LOG_EOM;
+                inOp.Delete(mHedgeQueue);
+                return;
+            }
+            ReadOp& theOrigOp = *theOrigOpPtr;
+            QCASSERT(Queue::IsInList(mInFlightQueue, theOrigOp));
+            UpdateServerScore(inOp, false, false);
+            mOuter.mStats.mHedgedReadWinsCount++;
+            KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                "hedged read won: " << inOp.Show() <<
+                " latency: " << (mOuter.mNetManager.NowUsec() -
+                    theOrigOp.mOpStartTimeUsec) <<
+            KFS_LOG_EOM;
+            // Cancel the original op. Done() ignores the cancellation, and
+            // leaves the op in the in flight queue.
+            mHedgeWonOpPtr = &theOrigOp;
+            GetChunkServer().Cancel(&theOrigOp, this);
+            mHedgeWonOpPtr = 0;
+            if (mLastOpPtr == &theOrigOp) {
+                mLastOpPtr = 0;
+            }
+            // Copy the data into the original op buffers, the same way as
+            // the net client does.
+            const int theLen = (int)inOp.contentLength;
+            if (0 < theLen) {
+                IOBuffer theBuf;
+                theBuf.MoveSpaceAvailable(&theOrigOp.mTmpBuffer, theLen);
+                theBuf.Clear();
+                const int kMaxInt = ~(int(1) << (sizeof(int) * 8 - 1));
+                theBuf.MoveSpaceAvailable(&theOrigOp.mTmpBuffer, kMaxInt);
+                QCVERIFY(theLen ==
+                    theOrigOp.mTmpBuffer.MoveSpace(&inOp.mTmpBuffer, theLen));
+                theOrigOp.mTmpBuffer.Move(&theBuf);
+            }
+            theOrigOp.status        = inOp.status;
+            theOrigOp.statusMsg     = inOp.statusMsg;
+            theOrigOp.lastError     = inOp.lastError;
+            theOrigOp.contentLength = inOp.contentLength;
+            theOrigOp.diskIOTime    = inOp.diskIOTime;
+            theOrigOp.checksums.swap(inOp.checksums);
+            theOrigOp.mHedgeWonFlag = true;
+            inOp.Delete(mHedgeQueue);
+            Done(theOrigOp, false, &theOrigOp.mTmpBuffer);
+        }
         KfsNetClient& GetChunkServer()
         {
             return (mChunkServerPtr ? *mChunkServerPtr : mChunkServer);
@@ -2236,6 +2681,8 @@ private:
     Striper*            mStriperPtr;
     int                 mCompletionDepthCount;
     int                 mReplicaCount;
+    ReadHedge*          mReadHedgePtr;
+    ChunkServerScores*  mServerScoresPtr;
     ChunkReader*        mReaders[1];
 
     void InternalError(
@@ -2850,4 +3297,72 @@ Reader::GetStats(
     mImpl.GetStats(outStats, outChunkServersStats);
 }
 
+void
+Reader::SetReadHedge(
+    Reader::ReadHedge* inReadHedgePtr)
+{
+    Impl::StRef theRef(mImpl);
+    mImpl.SetReadHedge(inReadHedgePtr);
+}
+
+void
+Reader::SetChunkServerScores(
+    ChunkServerScores* inScoresPtr)
+{
+    Impl::StRef theRef(mImpl);
+    mImpl.SetChunkServerScores(inScoresPtr);
+}
+
+Reader::ReadHedge::ReadHedge(
+    int     inPercentile,
+    int64_t inMinDelayUsec,
+    int64_t inMaxDelayUsec)
+    : mPercentile(min(100, max(0, inPercentile))),
+      mMinDelayUsec(max(int64_t(0), inMinDelayUsec)),
+      mMaxDelayUsec(max(mMinDelayUsec, inMaxDelayUsec)),
+      mDelayUsec(mMaxDelayUsec),
+      mCount(0),
+      mTimerCount(0)
+{
+    for (int i = 0; i < kSampleCount; i++) {
+        mSamples[i] = 0;
+    }
+}
+
+void
+Reader::ReadHedge::Update(
+    int64_t inLatencyUsec)
+{
+    mSamples[mCount % kSampleCount] = inLatencyUsec;
+    if (++mCount % kUpdateInterval != 0) {
+        return;
+    }
+    const int theCount = (int)min(mCount, int64_t(kSampleCount));
+    int64_t   theSamples[kSampleCount];
+    memcpy(theSamples, mSamples, theCount * sizeof(theSamples[0]));
+    const int theIdx = min(theCount - 1, theCount * mPercentile / 100);
+    std::nth_element(theSamples, theSamples + theIdx, theSamples + theCount);
+    mDelayUsec = max(mMinDelayUsec, min(mMaxDelayUsec, theSamples[theIdx]));
+}
+
+void
+Reader::ReadHedge::TimerStarted(
+    NetManager& inNetManager)
+{
+    if (mTimerCount++ <= 0) {
+        inNetManager.SetPollTimeoutMs(
+            (int)max(int64_t(1), mMinDelayUsec / 1000));
+    }
+}
+
+void
+Reader::ReadHedge::TimerStopped(
+    NetManager& inNetManager)
+{
+    if (--mTimerCount <= 0) {
+        mTimerCount = 0;
+        inNetManager.SetPollTimeoutMs(-1);
+    }
+}
+
 }}
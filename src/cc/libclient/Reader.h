@@ -42,6 +42,7 @@ using std::string;
 using std::ostream;
 
 class ClientPool;
+class ChunkServerScores;
 
 // Kfs client file read state machine.
 class Reader
@@ -93,7 +94,10 @@ public:
               mReadByteCount(0),
               mReadErrorsCount(0),
               mReadChecksumErrorsCount(0),
-              mReadRecoveriesCount(0)
+              mReadRecoveriesCount(0),
+              mHedgedReadsCount(0),
+              mHedgedReadWinsCount(0),
+              mReplicaReorderCount(0)
             {}
         void Clear()
             { *this = Stats(); }
@@ -113,6 +117,9 @@ public:
             mReadErrorsCount         += inStats.mReadErrorsCount;
             mReadChecksumErrorsCount += inStats.mReadChecksumErrorsCount;
             mReadRecoveriesCount     += inStats.mReadRecoveriesCount;
+            mHedgedReadsCount        += inStats.mHedgedReadsCount;
+            mHedgedReadWinsCount     += inStats.mHedgedReadWinsCount;
+            mReplicaReorderCount     += inStats.mReplicaReorderCount;
             return *this;
         }
         template<typename T>
@@ -131,6 +138,9 @@ public:
             inFunctor("ReadRecoveries",     mReadRecoveriesCount);
             inFunctor("Reads",              mReadCount);
             inFunctor("ReadBytes",          mReadByteCount);
+            inFunctor("HedgedReads",        mHedgedReadsCount);
+            inFunctor("HedgedReadWins",     mHedgedReadWinsCount);
+            inFunctor("ReplicaReorders",    mReplicaReorderCount);
         }
         Counter mMetaOpsQueuedCount;
         Counter mMetaOpsCancelledCount;
@@ -145,6 +155,51 @@ public:
         Counter mReadErrorsCount;
         Counter mReadChecksumErrorsCount;
         Counter mReadRecoveriesCount;
+        Counter mHedgedReadsCount;
+        Counter mHedgedReadWinsCount;
+        Counter mReplicaReorderCount;
+    };
+    // Hedged reads parameters and recent chunk read latencies. Shared by all
+    // readers running in the same thread. When a chunk read does not complete
+    // within the hedge delay, the same range is read from another replica, and
+    // the first successful response is used. The hedge delay is the configured
+    // percentile of the recent chunk read latencies, bounded by min and max.
+    class ReadHedge
+    {
+    public:
+        ReadHedge(
+            int     inPercentile   = 0,
+            int64_t inMinDelayUsec = 10 * 1000,
+            int64_t inMaxDelayUsec = 1000 * 1000);
+        bool IsEnabled() const
+            { return (0 < mPercentile); }
+        int64_t GetDelayUsec() const
+            { return mDelayUsec; }
+        void Update(
+            int64_t inLatencyUsec);
+        // Hedge timers run on every net manager poll iteration. The poll
+        // interval is lowered to the min. hedge delay only while at least
+        // one chunk read is armed for hedging.
+        void TimerStarted(
+            NetManager& inNetManager);
+        void TimerStopped(
+            NetManager& inNetManager);
+    private:
+        enum { kSampleCount    = 256 };
+        enum { kUpdateInterval = 32  };
+
+        const int     mPercentile;
+        const int64_t mMinDelayUsec;
+        const int64_t mMaxDelayUsec;
+        int64_t       mDelayUsec;
+        int64_t       mCount;
+        int           mTimerCount;
+        int64_t       mSamples[kSampleCount];
+    private:
+        ReadHedge(
+            const ReadHedge& inHedge);
+        ReadHedge& operator=(
+            const ReadHedge& inHedge);
     };
     class Striper
     {
@@ -268,6 +323,10 @@ public:
         Completion* inCompletionPtr);
     bool Unregister(
         Completion* inCompletionPtr);
+    void SetReadHedge(
+        ReadHedge* inReadHedgePtr);
+    void SetChunkServerScores(
+        ChunkServerScores* inScoresPtr);
     void GetStats(
         Stats&               outStats,
         KfsNetClient::Stats& outChunkServersStats) const;
@@ -607,9 +607,17 @@ private:
         if (mChunkServerPtr && mChunkServerPtr != &mChunkServer) {
             mChunkServerPtr->Cancel(mCurOpPtr, this);
         }
-        mChunkServerPtr = 0;
+        ReleaseChunkServer();
         mChunkServer.Stop();
     }
+    void ReleaseChunkServer()
+    {
+        if (mChunkServerPtr && mClientPoolPtr &&
+                mChunkServerPtr != &mChunkServer) {
+            mClientPoolPtr->Release(*mChunkServerPtr);
+        }
+        mChunkServerPtr = 0;
+    }
     bool WasChunkServerDisconnected()
     {
         return (mClientPoolPtr ?
@@ -1049,6 +1057,7 @@ private:
         mChunkServerAccess.Clear();
 
         const ServerLocation& theMaster = mAllocOp.chunkServers.front();
+        ReleaseChunkServer();
         if (mClientPoolPtr) {
             mChunkServerPtr = &mClientPoolPtr->Get(
                 theMaster, mAllocOp.allCSShortRpcFlag);
@@ -1487,7 +1496,7 @@ private:
         QCASSERT(mChunkServer.GetMaxRetryCount() <= 1);
         // <= 0 -- infinite timeout
         // For record append status always use separate / dedicated connection.
-        mChunkServerPtr = 0;
+        ReleaseChunkServer();
         // Stop chunk server to avoid possible spurious connects due to
         // possible connection configuration changes that follows, and force
         // connection reset.
@@ -131,6 +131,9 @@ public:
           mOpStartTime(0),
           mCompletionDepthCount(0),
           mStriperProcessCount(0),
+          mWriteAheadChunkCount(0),
+          mChunkPreAllocatedFlag(false),
+          mMaxWriteOffset(0),
           mStriperPtr(0)
         { Writers::Init(mWriters); }
     int Open(
@@ -199,6 +202,8 @@ public:
         mTruncateOp.pathname   = 0;
         mTruncateOp.fileOffset = mFileSize;
         mRetryCount            = 0;
+        mChunkPreAllocatedFlag = false;
+        mMaxWriteOffset        = mFileSize;
         mMaxPendingThreshold   = Offset(mMaxWriteSize) *
             (mStriperPtr ? max(1, inStripeCount) : 1);
         return StartWrite();
@@ -363,6 +368,9 @@ public:
     }
     bool GetErrorCode() const
         { return mErrorCode; }
+    void SetWriteAheadChunkCount(
+        int inCount)
+        { mWriteAheadChunkCount = max(0, inCount); }
 
 private:
     typedef KfsNetClient ChunkServer;
@@ -525,6 +533,7 @@ private:
               mChunkAccessExpireTime(0),
               mCSAccessExpireTime(0),
               mUpdateLeaseOp(0, -1, 0),
+              mPreAllocatedFlag(false),
               mSleepTimer(inOuter.mNetManager, *this)
         {
             SET_HANDLER(this, &ChunkWriter::EventHandler);
@@ -577,6 +586,7 @@ private:
                 QCRTASSERT(mAllocOp.fileOffset == inOffset - theChunkOffset);
             }
             theSize = min(theSize, (Offset)(kChunkSize - theChunkOffset));
+            mPreAllocatedFlag = false;
             mOuter.mStats.mWriteCount++;
             mOuter.mStats.mWriteByteCount += theSize;
             QCASSERT(theSize > 0);
@@ -749,6 +759,21 @@ private:
                 StartWrite();
             }
         }
+        // Allocate chunk and write ids with no data pending.
+        void PreAllocate(
+            Offset inFileOffset)
+        {
+            QCASSERT(
+                0 <= inFileOffset && inFileOffset % (Offset)CHUNKSIZE == 0 &&
+                mAllocOp.fileOffset < 0 && ! mLastOpPtr
+            );
+            mAllocOp.fileOffset       = inFileOffset;
+            mOpenChunkBlockFileOffset = mAllocOp.fileOffset -
+                mAllocOp.fileOffset % mOuter.mOpenChunkBlockSize;
+            mPreAllocatedFlag         = true;
+            Reset();
+            AllocateChunk();
+        }
         void Shutdown()
         {
             Reset();
@@ -827,6 +852,7 @@ private:
         time_t         mChunkAccessExpireTime;
         time_t         mCSAccessExpireTime;
         WritePrepareOp mUpdateLeaseOp;
+        bool           mPreAllocatedFlag;
         Timer          mSleepTimer;
         WriteOp*       mPendingQueue[1];
         WriteOp*       mInFlightQueue[1];
@@ -848,7 +874,7 @@ private:
                 mAllocOp.fileOffset >= 0 &&
                 (! Queue::IsEmpty(mPendingQueue) ||
                     (0 < mCloseOp.chunkId && mCloseOp.chunkVersion < 0) ||
-                    mKeepLeaseFlag)
+                    mKeepLeaseFlag || mPreAllocatedFlag)
             );
             Reset(mAllocOp);
             if (0 == mOuter.mReplicaCount) {
@@ -1531,6 +1557,18 @@ private:
                     "no") << " data sent" <<
                 "\nRequest:\n"            << theOStream.str() <<
             KFS_LOG_EOM;
+            if (mPreAllocatedFlag && Queue::IsEmpty(mPendingQueue) &&
+                    Queue::IsEmpty(mInFlightQueue) && ! mClosingFlag) {
+                // Pre-allocation failure is not fatal, the chunk will be
+                // allocated again when the data arrives.
+                KFS_LOG_STREAM_INFO << mLogPrefix <<
+                    "pre-allocation failure, offset: " << mAllocOp.fileOffset <<
+                KFS_LOG_EOM;
+                mPreAllocatedFlag = false;
+                mErrorCode        = 0;
+                Reset();
+                return;
+            }
             int       theStatus    = inOp.status;
             const int theLastError = inOp.lastError;
             if (&inOp == &mAllocOp) {
@@ -1759,6 +1797,9 @@ private:
     time_t              mOpStartTime;
     int                 mCompletionDepthCount;
     int                 mStriperProcessCount;
+    int                 mWriteAheadChunkCount;
+    bool                mChunkPreAllocatedFlag;
+    Offset              mMaxWriteOffset;
     Striper*            mStriperPtr;
     ChunkWriter*        mWriters[1];
 
@@ -1849,13 +1890,17 @@ private:
     }
     void SetFileSize()
     {
-        if ((! mStriperPtr && 0 != mReplicaCount) ||
+        // With replicated files the size needs to be set only if chunks past
+        // the last written chunk were pre-allocated, in order to remove these.
+        if ((! mStriperPtr && 0 != mReplicaCount && ! mChunkPreAllocatedFlag) ||
                 mErrorCode != 0 || 0 <= mTruncateOp.fid) {
             return;
         }
         const Offset theSize = mStriperPtr ?
             mStriperPtr->GetFileSize() :
-            mOffset + mBuffer.BytesConsumable();
+            (0 != mReplicaCount ?
+                max(mMaxWriteOffset, mOffset + mBuffer.BytesConsumable()) :
+                mOffset + mBuffer.BytesConsumable());
         if (theSize < 0 || theSize <= mTruncateOp.fileOffset) {
             return;
         }
@@ -1971,7 +2016,65 @@ private:
         );
         if (theQueuedCount > 0) {
             mOffset += theQueuedCount;
+            mMaxWriteOffset = max(mMaxWriteOffset, mOffset);
+            const int thePrevRefCount = GetRefCount();
             StartQueuedWrite(theQueuedCount);
+            if (thePrevRefCount <= GetRefCount()) {
+                PreAllocateChunks();
+            }
+        }
+    }
+    // Allocate the chunks that follow the chunk presently being written
+    // ahead of time, in order to hide chunk and write id allocation latency,
+    // and to let the writes that cross chunk boundary proceed concurrently
+    // with the preceding chunk writes, using different replication chains.
+    void PreAllocateChunks()
+    {
+        if (mWriteAheadChunkCount <= 0 || mStriperPtr || mReplicaCount <= 0 ||
+                mErrorCode != 0 || mClosingFlag || mSleepingFlag) {
+            return;
+        }
+        ChunkWriter* const theCurPtr = Writers::Front(mWriters);
+        if (! theCurPtr) {
+            return;
+        }
+        const Offset theChunkOffset = theCurPtr->GetFileOffset();
+        if (theChunkOffset < 0) {
+            return;
+        }
+        for (int i = 1; i <= mWriteAheadChunkCount; i++) {
+            const Offset theFileOffset = theChunkOffset + i * (Offset)CHUNKSIZE;
+            if (theFileOffset < mFileSize) {
+                // Do not pre-allocate existing chunks.
+                continue;
+            }
+            Writers::Iterator theIt(mWriters);
+            const ChunkWriter* thePtr;
+            while ((thePtr = theIt.Next())) {
+                if (thePtr->GetFileOffset() == theFileOffset) {
+                    break;
+                }
+            }
+            if (thePtr) {
+                continue;
+            }
+            mChunkServerInitialSeqNum += 10000;
+            ChunkWriter& theWriter = *(new ChunkWriter(
+                *this, mChunkServerInitialSeqNum, mLogPrefix));
+            // Keep the chunk writer being written the most recently used.
+            Writers::PushFront(mWriters, *theCurPtr);
+            if (! mChunkPreAllocatedFlag) {
+                // Force file size update on close.
+                mChunkPreAllocatedFlag = true;
+                mTruncateOp.fileOffset = -1;
+            }
+            mStats.mChunkPreAllocCount++;
+            const int thePrevRefCount = GetRefCount();
+            theWriter.PreAllocate(theFileOffset);
+            if (thePrevRefCount > GetRefCount() ||
+                    theCurPtr != Writers::Front(mWriters)) {
+                return; // Unwind
+            }
         }
     }
     Offset QueueWrite(
@@ -2052,7 +2155,9 @@ private:
         if (theLeftEdge < 0) {
             return false;
         }
-        const Offset theRightEdge = theLeftEdge + mOpenChunkBlockSize;
+        // Keep pre-allocated chunks that follow the chunk being written.
+        const Offset theRightEdge = theLeftEdge + mOpenChunkBlockSize +
+            (mStriperPtr ? Offset(0) : mWriteAheadChunkCount * (Offset)CHUNKSIZE);
         const Offset theOffset    = inWriter.GetFileOffset();
         return (theOffset < theLeftEdge || theRightEdge <= theOffset);
     }
@@ -2341,6 +2446,14 @@ Writer::Shutdown()
     mImpl.Shutdown();
 }
 
+void
+Writer::SetWriteAheadChunkCount(
+    int inCount)
+{
+    Impl::StRef theRef(mImpl);
+    mImpl.SetWriteAheadChunkCount(inCount);
+}
+
 void
 Writer::Register(
     Writer::Completion* inCompletionPtr)
@@ -85,7 +85,8 @@ public:
               mRetriesCount(0),
               mWriteCount(0),
               mWriteByteCount(0),
-              mBufferCompactionCount(0)
+              mBufferCompactionCount(0),
+              mChunkPreAllocCount(0)
             {}
         void Clear()
             { *this = Stats(); }
@@ -104,6 +105,7 @@ public:
             mWriteCount            += inStats.mWriteCount;
             mWriteByteCount        += inStats.mWriteByteCount;
             mBufferCompactionCount += inStats.mBufferCompactionCount;
+            mChunkPreAllocCount    += inStats.mChunkPreAllocCount;
             return *this;
         }
         template<typename T>
@@ -122,6 +124,7 @@ public:
             inFunctor("Retries",           mRetriesCount);
             inFunctor("Writes" ,           mWriteCount);
             inFunctor("WriteBytes",        mWriteByteCount);
+            inFunctor("ChunkPreAlloc",     mChunkPreAllocCount);
         }
         Counter mMetaOpsQueuedCount;
         Counter mMetaOpsCancelledCount;
@@ -135,6 +138,7 @@ public:
         Counter mWriteCount;
         Counter mWriteByteCount;
         Counter mBufferCompactionCount;
+        Counter mChunkPreAllocCount;
     };
     class Striper
     {
@@ -232,6 +236,10 @@ public:
         Completion* inCompletionPtr);
     bool Unregister(
         Completion* inCompletionPtr);
+    // Number of chunks to allocate ahead of the chunk being written with
+    // sequential writes into replicated (not striped) files.
+    void SetWriteAheadChunkCount(
+        int inCount);
     void GetStats(
         Stats&               outStats,
         KfsNetClient::Stats& outChunkServersStats) const;
@@ -38,6 +38,7 @@
 #include <glob.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fnmatch.h>
 #include <sys/stat.h>
 
 #include <string>
@@ -113,7 +114,10 @@ public:
               mOpenDirs(),
               mError(0),
               mCwd(),
-              mTmpName()
+              mTmpName(),
+              mPatternComps(),
+              mFnmatchFlags(0),
+              mFilter()
         {
             // Insure that the mutex constructor is invoked.
             GetMutexPtr();
@@ -160,6 +164,7 @@ public:
             inResultPtr->gl_opendir  = &Glob::OpenDir;
             inResultPtr->gl_lstat    = &Glob::LStat;
             inResultPtr->gl_stat     = &Glob::Stat;
+            SetPattern(inGlobPtr, inGlobFlags);
             return glob(inGlobPtr, inGlobFlags | GLOB_ALTDIRFUNC,
                 inErrorHandlerPtr, inResultPtr);
         }
@@ -202,6 +207,7 @@ public:
             mError = mClientPtr->ReaddirPlus(
                 theDirNamePtr,
                 theDir.mDirContent,
+                GetFilter(inPathNamePtr),
                 kComputeFileSizeFlag,
                 kUpdateClientCacheFlag,
                 kFileIdAndTypeOnlyFalg
@@ -280,13 +286,17 @@ public:
         }
     private:
         typedef vector<KfsOpenDir*> OpenDirs;
+        typedef vector<string>      PatternComps;
 
-        KfsClient*  mClientPtr;
-        KfsOpenDir* mDirToReusePtr;
-        OpenDirs    mOpenDirs;
-        int         mError;
-        string      mCwd;
-        string      mTmpName;
+        KfsClient*                mClientPtr;
+        KfsOpenDir*               mDirToReusePtr;
+        OpenDirs                  mOpenDirs;
+        int                       mError;
+        string                    mCwd;
+        string                    mTmpName;
+        PatternComps              mPatternComps;
+        int                       mFnmatchFlags;
+        KfsClient::ReaddirFilter  mFilter;
 
 #ifdef KFS_GLOB_USE_THREAD_LOCAL
         static __thread Glob* sInstancePtr;
@@ -312,8 +322,87 @@ public:
             mError = 0;
             mCwd.clear();
             mTmpName.clear();
+            mPatternComps.clear();
             mClientPtr = 0;
         }
+        static void Split(
+            const char*   inPathPtr,
+            PatternComps* outCompsPtr,
+            size_t&       outCount)
+        {
+            outCount = 0;
+            const char* thePtr = inPathPtr;
+            while (*thePtr) {
+                while (*thePtr == '/') {
+                    ++thePtr;
+                }
+                const char* const theStartPtr = thePtr;
+                while (*thePtr && *thePtr != '/') {
+                    ++thePtr;
+                }
+                if (theStartPtr < thePtr) {
+                    if (outCompsPtr) {
+                        outCompsPtr->push_back(
+                            string(theStartPtr, thePtr - theStartPtr));
+                    }
+                    outCount++;
+                }
+            }
+        }
+        // The directories are opened by glob() one pattern path component at
+        // a time, therefore the number of path components of the directory
+        // being opened selects the pattern component, that the meta server can
+        // use to filter the directory entries. The meta server uses the same
+        // fnmatch() flags as glob(), and glob() matches the entries again.
+        // Brace and tilde expansion changes the pattern, and turns off the
+        // filter.
+        void SetPattern(
+            const char* inGlobPtr,
+            int         inGlobFlags)
+        {
+            mPatternComps.clear();
+#ifdef GLOB_BRACE
+            if ((inGlobFlags & GLOB_BRACE) != 0 && strchr(inGlobPtr, '{')) {
+                return;
+            }
+#endif
+#ifdef GLOB_TILDE
+            if ((inGlobFlags & GLOB_TILDE) != 0 && *inGlobPtr == '~') {
+                return;
+            }
+#endif
+            size_t theCount = 0;
+            Split(inGlobPtr, &mPatternComps, theCount);
+            mFnmatchFlags = (inGlobFlags & GLOB_NOESCAPE) != 0 ?
+                FNM_NOESCAPE : 0;
+#ifdef GLOB_PERIOD
+            if ((inGlobFlags & GLOB_PERIOD) == 0)
+#endif
+            {
+                mFnmatchFlags |= FNM_PERIOD;
+            }
+        }
+        const KfsClient::ReaddirFilter& GetFilter(
+            const char* inPathNamePtr)
+        {
+            size_t theIdx = 0;
+            if (strcmp(inPathNamePtr, ".") == 0) {
+                theIdx = (mPatternComps.empty() ||
+                    mPatternComps.front() != ".") ? 0 : 1;
+            } else {
+                Split(inPathNamePtr, 0, theIdx);
+            }
+            if (theIdx < mPatternComps.size()) {
+                mFilter.mNamePattern  = mPatternComps[theIdx];
+                mFilter.mFnmatchFlags = mFnmatchFlags;
+                mFilter.mDirsOnlyFlag = theIdx + 1 < mPatternComps.size();
+            } else {
+                mFilter.mNamePattern.clear();
+                mFilter.mFnmatchFlags = 0;
+                mFilter.mDirsOnlyFlag = false;
+            }
+            return mFilter;
+        }
         const char* GetAbsPathName(
             const char* inPathNamePtr)
         {
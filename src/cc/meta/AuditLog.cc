@@ -24,6 +24,23 @@
 // \file AuditLog.cc
 // \brief Kfs meta server audit log implementation.
 //
+// Binary audit log format.
+//
+// The binary log file is a sequence of independently compressed blocks. Each
+// block starts with 16 bytes header: magic, uncompressed size, compressed
+// size, and the number of records, all 32 bit little endian. The header is
+// followed by zlib compressed records. The records are:
+// string:  type 1, id 32 bit, length 32 bit, and the string bytes;
+// request: type 2, time in microseconds 64 bit, status 32 bit, auth uid 32
+//          bit, op type 32 bit, client ip string id 32 bit, request headers
+//          length 32 bit, and the request headers;
+// dropped: type 3, time in microseconds 64 bit, number of requests not
+//          logged due to the lack of buffer space 64 bit.
+// All integers are little endian. The strings, presently client ips, are
+// interned per block: string record with the new id precedes the first
+// request record that references the string in the block. The status is
+// in the kfs errno space, the same as in the text log.
+//
 //----------------------------------------------------------------------------
 
 #include "AuditLog.h"
@@ -32,9 +49,41 @@
 #include "common/BufferedLogWriter.h"
 #include "common/kfserrno.h"
 #include "common/IntToString.h"
+#include "common/kfsatomic.h"
+#include "common/Properties.h"
+#include "common/time.h"
+#include "common/MsgLogger.h"
+
+#include "qcdio/QCThread.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/QCUtils.h"
+#include "qcdio/qcstutils.h"
+
+#include <zlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <istream>
+#include <ostream>
+#include <algorithm>
 
 namespace KFS
 {
+using std::min;
+using std::max;
+using std::string;
+using std::vector;
+using std::map;
+using std::istream;
+using std::ostream;
 
 class AuditLogWriter : public BufferedLogWriter::Writer
 {
@@ -112,6 +161,617 @@ private:
 
 static const BufferedLogWriter* sBufferedLogWriterForGdbToFindPtr = 0;
 
+const uint32_t kAuditLogBlockMagic      = 0x4c415351; // QSAL
+const size_t   kAuditLogBlockHeaderSize = 4 * sizeof(uint32_t);
+const size_t   kAuditLogMaxBlockSize    = 64 << 20;
+enum
+{
+    kAuditLogRecordString  = 1,
+    kAuditLogRecordRequest = 2,
+    kAuditLogRecordDropped = 3
+};
+
+template<typename T>
+    static inline void
+AuditLogPut(
+    string& inBuf,
+    T       inVal)
+{
+    uint64_t theVal = (uint64_t)inVal;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        inBuf += (char)(theVal & 0xFF);
+        theVal >>= 8;
+    }
+}
+
+template<typename T>
+    static inline bool
+AuditLogGet(
+    const char*& ioPtr,
+    const char*  inEndPtr,
+    T&           outVal)
+{
+    if (inEndPtr < ioPtr + sizeof(T)) {
+        return false;
+    }
+    uint64_t theVal = 0;
+    for (size_t i = sizeof(T); 0 < i; ) {
+        theVal = (theVal << 8) | (uint8_t)ioPtr[--i];
+    }
+    ioPtr += sizeof(T);
+    outVal = (T)theVal;
+    return true;
+}
+
+// Binary audit log writer. The request processing threads append fixed size
+// request fields, client ip, and the request headers into their own single
+// producer single consumer ring buffers, with no locking and no formatting.
+// The writer thread merges the rings in time order, interns the strings,
+// compresses, and writes the blocks.
+class BinaryAuditLog : public QCRunnable
+{
+public:
+    BinaryAuditLog()
+        : QCRunnable(),
+          mMutex(),
+          mCond(),
+          mThread(0, "MetaAuditLogBinWriter"),
+          mEnabledFlag(false),
+          mRunFlag(false),
+          mFileName(),
+          mMaxFileSize(int64_t(256) << 20),
+          mMaxFiles(16),
+          mBlockSize(256 << 10),
+          mCompressionLevel(Z_BEST_SPEED),
+          mRingSize(4 << 20),
+          mFlushInterval(1000000),
+          mMaxWaitTime(-1),
+          mRingsHeadPtr(0),
+          mDroppedCount(0),
+          mReportedDroppedCount(0),
+          mFd(-1),
+          mFileSize(0),
+          mRecordCount(0),
+          mBlock(),
+          mCompressed(),
+          mStringIds()
+        {}
+    virtual ~BinaryAuditLog()
+        { BinaryAuditLog::Stop(); }
+    bool IsEnabled() const
+        { return mEnabledFlag; }
+    // Returns false if the binary log is, or became disabled, and the record
+    // has to be written into the text log.
+    bool Log(
+        const MetaRequest& inOp)
+    {
+        const size_t theIpLength = min(inOp.clientIp.size(), size_t(255));
+        const size_t theHdrsLen  = (size_t)max(
+            IOBuffer::BufPos(0), inOp.reqHeaders.BytesConsumable());
+        ThreadRing* const theRingPtr = GetThreadRing(
+            ThreadRing::RecordSize(theIpLength + theHdrsLen));
+        if (! theRingPtr) {
+            return false;
+        }
+        if (! theRingPtr->Put(inOp, theIpLength, theHdrsLen,
+                mMaxWaitTime, mCond, mEnabledFlag)) {
+            if (! mEnabledFlag) {
+                return false;
+            }
+            SyncAddAndFetch(mDroppedCount, int64_t(1));
+        }
+        return true;
+    }
+    void SetParameters(
+        const Properties& inProps,
+        const char*       inPrefixPtr)
+    {
+        const string thePrefix(inPrefixPtr);
+        QCStMutexLocker theLocker(mMutex);
+        mFileName = inProps.getValue(
+            thePrefix + "binaryFileName", mFileName);
+        mMaxFileSize = inProps.getValue(
+            thePrefix + "binaryMaxFileSize", mMaxFileSize);
+        mMaxFiles = inProps.getValue(
+            thePrefix + "binaryMaxFiles", mMaxFiles);
+        mBlockSize = (int)min(kAuditLogMaxBlockSize, (size_t)max(4 << 10,
+            inProps.getValue(thePrefix + "binaryBlockSize", mBlockSize)));
+        mCompressionLevel = max(Z_NO_COMPRESSION, min(Z_BEST_COMPRESSION,
+            inProps.getValue(thePrefix + "binaryCompressionLevel",
+                mCompressionLevel)));
+        // The ring size only applies to the rings created after the change.
+        const int theRingSize = inProps.getValue(
+            thePrefix + "binaryRingSize", mRingSize);
+        mRingSize = 64 << 10;
+        while (mRingSize < theRingSize && mRingSize < (1 << 28)) {
+            mRingSize <<= 1;
+        }
+        mFlushInterval = max(int64_t(1000), (int64_t)inProps.getValue(
+            thePrefix + "binaryFlushIntervalMicroSec",
+            (double)mFlushInterval));
+        mMaxWaitTime = (int64_t)inProps.getValue(
+            thePrefix + "binaryWaitMicroSec", (double)mMaxWaitTime);
+        if (mFileName.empty()) {
+            // Stop logging, the writer thread writes all pending records,
+            // closes the file, and exits.
+            theLocker.Unlock();
+            Stop();
+            return;
+        }
+        if (! mRunFlag) {
+            mRunFlag = true;
+            const int kStackSize = 64 << 10;
+            mThread.Start(this, kStackSize);
+        }
+        mEnabledFlag = true;
+        mCond.Notify();
+    }
+    void Stop()
+    {
+        QCStMutexLocker theLocker(mMutex);
+        mEnabledFlag = false;
+        if (! mRunFlag) {
+            return;
+        }
+        mRunFlag = false;
+        mCond.Notify();
+        theLocker.Unlock();
+        mThread.Join();
+    }
+    void PrepareToFork()
+        { mMutex.Lock(); }
+    void ForkDone()
+        { mMutex.Unlock(); }
+    void ChildAtFork()
+    {
+        mEnabledFlag = false;
+        mRunFlag     = false;
+        if (0 <= mFd) {
+            close(mFd);
+            mFd = -1;
+        }
+    }
+    virtual void Run()
+    {
+        QCStMutexLocker theLocker(mMutex);
+        int64_t theNextFlushTime = microseconds() + mFlushInterval;
+        while (mRunFlag) {
+            const int64_t kPollIntervalMicroSec = 10000;
+            mCond.Wait(mMutex, QCMutex::Time(kPollIntervalMicroSec) * 1000);
+            DrainRings();
+            const int64_t theNow = microseconds();
+            if (theNextFlushTime <= theNow) {
+                WriteBlock();
+                theNextFlushTime = theNow + mFlushInterval;
+            }
+        }
+        DrainRings();
+        WriteBlock();
+        if (0 <= mFd) {
+            close(mFd);
+            mFd = -1;
+        }
+    }
+private:
+    typedef QCMutex::Time Time;
+    // The same as the message log writer ring, see BufferedLogWriter.
+    class ThreadRing
+    {
+    public:
+        struct Header
+        {
+            int32_t  mLength; // Negative -- skip to the beginning of the ring.
+            int32_t  mStatus;
+            int64_t  mTime;
+            uint32_t mAuthUid;
+            uint32_t mOp;
+            int32_t  mIpLength;
+            int32_t  mReserved;
+        };
+        enum { kAlign = sizeof(int64_t) };
+
+        ThreadRing*      mNextPtr;
+        volatile bool    mThreadExitedFlag;
+
+        ThreadRing(
+            int inSize)
+            : mNextPtr(0),
+              mThreadExitedFlag(false),
+              mRefCount(2),
+              mHead(0),
+              mTail(0),
+              mSize(inSize),
+              mBufPtr(new char[inSize])
+            {}
+        void Release()
+        {
+            if (SyncAddAndFetch(mRefCount, -1) <= 0) {
+                delete this;
+            }
+        }
+        // The record must fit, see CanFit(). Negative max wait time -- wait
+        // until the writer frees enough space, or the log is disabled.
+        bool Put(
+            const MetaRequest&   inOp,
+            size_t               inIpLength,
+            size_t               inHdrsLen,
+            Time                 inMaxWaitTime,
+            QCCondVar&           inWriteCond,
+            const volatile bool& inEnabledFlag)
+        {
+            const size_t  theLength   = inIpLength + inHdrsLen;
+            const size_t  theRecSize  = RecordSize(theLength);
+            QCASSERT(CanFit(theRecSize));
+            const int64_t theHead     = mHead;
+            const size_t  thePos      = (size_t)(theHead & (mSize - 1));
+            const size_t  theTailRoom = mSize - thePos;
+            const size_t  theSize     = theRecSize <= theTailRoom ?
+                theRecSize : theTailRoom + theRecSize;
+            Time          theWaited   = 0;
+            while ((size_t)mSize <
+                    (size_t)(theHead - SyncAddAndFetch(mTail, int64_t(0))) +
+                    theSize) {
+                inWriteCond.Notify();
+                if (! inEnabledFlag ||
+                        (0 <= inMaxWaitTime && inMaxWaitTime <= theWaited)) {
+                    return false;
+                }
+                const Time kSleepMicroSec = 1000;
+                ::usleep(kSleepMicroSec);
+                theWaited += kSleepMicroSec;
+            }
+            char* thePtr = mBufPtr + thePos;
+            if (theTailRoom < theRecSize) {
+                reinterpret_cast<Header*>(thePtr)->mLength = -1;
+                thePtr = mBufPtr;
+            }
+            Header& theHeader = *reinterpret_cast<Header*>(thePtr);
+            theHeader.mLength   = (int32_t)theLength;
+            theHeader.mStatus   = inOp.status < 0 ?
+                -SysToKfsErrno(-inOp.status) : inOp.status;
+            theHeader.mTime     = microseconds();
+            theHeader.mAuthUid  = (uint32_t)inOp.authUid;
+            theHeader.mOp       = (uint32_t)inOp.op;
+            theHeader.mIpLength = (int32_t)inIpLength;
+            theHeader.mReserved = 0;
+            thePtr += sizeof(Header);
+            memcpy(thePtr, inOp.clientIp.data(), inIpLength);
+            inOp.reqHeaders.CopyOut(thePtr + inIpLength, (int)inHdrsLen);
+            // Atomic add is a full barrier, the record is visible to the
+            // writer before the head.
+            SyncAddAndFetch(mHead, (int64_t)theSize);
+            return true;
+        }
+        const Header* Peek()
+        {
+            for (; ;) {
+                const int64_t theTail = mTail;
+                if (SyncAddAndFetch(mHead, int64_t(0)) <= theTail) {
+                    return 0;
+                }
+                const size_t thePos = (size_t)(theTail & (mSize - 1));
+                const Header* const thePtr =
+                    reinterpret_cast<const Header*>(mBufPtr + thePos);
+                if (0 <= thePtr->mLength) {
+                    return thePtr;
+                }
+                SyncAddAndFetch(mTail, (int64_t)(mSize - thePos));
+            }
+        }
+        void Consume(
+            const Header& inHeader)
+            { SyncAddAndFetch(mTail, (int64_t)RecordSize(inHeader.mLength)); }
+        static const char* GetDataPtr(
+            const Header& inHeader)
+            { return reinterpret_cast<const char*>(&inHeader + 1); }
+        // With the wrap around the record might need its size plus the tail
+        // room, which is less than the record size.
+        bool CanFit(
+            size_t inRecSize) const
+            { return (inRecSize <= (size_t)mSize / 2); }
+        static size_t RecordSize(
+            size_t inLength)
+        {
+            return ((sizeof(Header) + inLength + kAlign - 1) /
+                kAlign * kAlign);
+        }
+    private:
+        volatile int     mRefCount;
+        volatile int64_t mHead;
+        volatile int64_t mTail;
+        const int        mSize;
+        char* const      mBufPtr;
+
+        ~ThreadRing()
+            { delete [] mBufPtr; }
+    private:
+        ThreadRing(
+            const ThreadRing&);
+        ThreadRing& operator=(
+            const ThreadRing&);
+    };
+    typedef map<string, uint32_t> StringIds;
+
+    QCMutex          mMutex;
+    QCCondVar        mCond;
+    QCThread         mThread;
+    volatile bool    mEnabledFlag;
+    bool             mRunFlag;
+    string           mFileName;
+    int64_t          mMaxFileSize;
+    int              mMaxFiles;
+    int              mBlockSize;
+    int              mCompressionLevel;
+    int              mRingSize;
+    int64_t          mFlushInterval;
+    Time             mMaxWaitTime;
+    ThreadRing*      mRingsHeadPtr;
+    volatile int64_t mDroppedCount;
+    int64_t          mReportedDroppedCount;
+    int              mFd;
+    int64_t          mFileSize;
+    uint32_t         mRecordCount;
+    string           mBlock;
+    vector<char>     mCompressed;
+    StringIds        mStringIds;
+
+    static __thread ThreadRing* sThreadRingPtr;
+    static pthread_key_t        sThreadRingKey;
+    static pthread_once_t       sThreadRingKeyOnce;
+
+    static void CreateThreadRingKey()
+    {
+        const int theErr = pthread_key_create(&sThreadRingKey, &ThreadExit);
+        if (theErr) {
+            QCUtils::FatalError("pthread_key_create", theErr);
+        }
+    }
+    static void ThreadExit(
+        void* inRingPtr)
+    {
+        ThreadRing* const thePtr = reinterpret_cast<ThreadRing*>(inRingPtr);
+        if (thePtr == sThreadRingPtr) {
+            sThreadRingPtr = 0;
+        }
+        thePtr->mThreadExitedFlag = true;
+        thePtr->Release();
+    }
+    // Returns the calling thread ring large enough to hold the record. The
+    // records are never truncated: if the record does not fit into the
+    // current ring, the ring is retired, and replaced with a larger one. The
+    // writer merges the records from both in time order, and removes the
+    // retired ring once it is drained.
+    ThreadRing* GetThreadRing(
+        size_t inRecSize)
+    {
+        ThreadRing* const theCurPtr = sThreadRingPtr;
+        if (theCurPtr && theCurPtr->CanFit(inRecSize)) {
+            return theCurPtr;
+        }
+        const int kMaxRingSize = 1 << 30;
+        if ((size_t)kMaxRingSize / 2 < inRecSize) {
+            return 0;
+        }
+        pthread_once(&sThreadRingKeyOnce, &CreateThreadRingKey);
+        QCStMutexLocker theLocker(mMutex);
+        if (! mRunFlag) {
+            return 0;
+        }
+        int theSize = mRingSize;
+        while ((size_t)theSize / 2 < inRecSize) {
+            theSize <<= 1;
+        }
+        if (theCurPtr) {
+            theCurPtr->mThreadExitedFlag = true;
+            theCurPtr->Release();
+        }
+        ThreadRing* const thePtr = new ThreadRing(theSize);
+        thePtr->mNextPtr = mRingsHeadPtr;
+        mRingsHeadPtr    = thePtr;
+        sThreadRingPtr   = thePtr;
+        pthread_setspecific(sThreadRingKey, thePtr);
+        return thePtr;
+    }
+    uint32_t GetStringId(
+        const char* inPtr,
+        size_t      inLength)
+    {
+        const string   theStr(inPtr, inLength);
+        const uint32_t theId = (uint32_t)mStringIds.size();
+        std::pair<StringIds::iterator, bool> const theRes =
+            mStringIds.insert(std::make_pair(theStr, theId));
+        if (theRes.second) {
+            mBlock += (char)kAuditLogRecordString;
+            AuditLogPut(mBlock, theId);
+            AuditLogPut(mBlock, (uint32_t)inLength);
+            mBlock.append(inPtr, inLength);
+            mRecordCount++;
+        }
+        return theRes.first->second;
+    }
+    // Merges the available rings records in time order into the block.
+    void DrainRings()
+    {
+        QCASSERT(mMutex.IsOwned());
+        for (; ;) {
+            ThreadRing*                 theMinRingPtr = 0;
+            const ThreadRing::Header*   theMinPtr     = 0;
+            ThreadRing**                thePrevPtr    = &mRingsHeadPtr;
+            while (*thePrevPtr) {
+                ThreadRing&                     theRing = **thePrevPtr;
+                const ThreadRing::Header* const thePtr  = theRing.Peek();
+                if (thePtr) {
+                    if (! theMinPtr || thePtr->mTime < theMinPtr->mTime) {
+                        theMinPtr     = thePtr;
+                        theMinRingPtr = &theRing;
+                    }
+                } else if (theRing.mThreadExitedFlag) {
+                    *thePrevPtr = theRing.mNextPtr;
+                    theRing.Release();
+                    continue;
+                }
+                thePrevPtr = &theRing.mNextPtr;
+            }
+            if (! theMinPtr) {
+                break;
+            }
+            const ThreadRing::Header& theHdr = *theMinPtr;
+            const int64_t theDropped = SyncAddAndFetch(
+                mDroppedCount, int64_t(0));
+            if (theDropped != mReportedDroppedCount) {
+                mBlock += (char)kAuditLogRecordDropped;
+                AuditLogPut(mBlock, theHdr.mTime);
+                AuditLogPut(mBlock, theDropped - mReportedDroppedCount);
+                mRecordCount++;
+                mReportedDroppedCount = theDropped;
+            }
+            const char* const thePtr   = ThreadRing::GetDataPtr(theHdr);
+            const uint32_t    theIpId  = GetStringId(thePtr, theHdr.mIpLength);
+            const uint32_t    theHdrsLen = (uint32_t)(
+                theHdr.mLength - theHdr.mIpLength);
+            mBlock += (char)kAuditLogRecordRequest;
+            AuditLogPut(mBlock, theHdr.mTime);
+            AuditLogPut(mBlock, theHdr.mStatus);
+            AuditLogPut(mBlock, theHdr.mAuthUid);
+            AuditLogPut(mBlock, theHdr.mOp);
+            AuditLogPut(mBlock, theIpId);
+            AuditLogPut(mBlock, theHdrsLen);
+            mBlock.append(thePtr + theHdr.mIpLength, theHdrsLen);
+            mRecordCount++;
+            theMinRingPtr->Consume(theHdr);
+            if ((size_t)mBlockSize <= mBlock.size()) {
+                WriteBlock();
+            }
+        }
+    }
+    void WriteBlock()
+    {
+        QCASSERT(mMutex.IsOwned());
+        if (mBlock.empty()) {
+            return;
+        }
+        const string  theFileName    = mFileName;
+        const int64_t theMaxFileSize = mMaxFileSize;
+        const int     theMaxFiles    = mMaxFiles;
+        const int     theLevel       = mCompressionLevel;
+        const uint32_t theCount      = mRecordCount;
+        mRecordCount = 0;
+        mStringIds.clear();
+        {
+            // Compress and write with no mutex held, in order not to block
+            // the request processing threads creating new rings, and the
+            // parameters update.
+            QCStMutexUnlocker theUnlocker(mMutex);
+            uLongf theLen = compressBound((uLong)mBlock.size());
+            mCompressed.resize(kAuditLogBlockHeaderSize + theLen);
+            const int theStatus = compress2(
+                reinterpret_cast<Bytef*>(
+                    &mCompressed[0] + kAuditLogBlockHeaderSize),
+                &theLen,
+                reinterpret_cast<const Bytef*>(mBlock.data()),
+                (uLong)mBlock.size(),
+                theLevel
+            );
+            if (theStatus != Z_OK) {
+                KFS_LOG_STREAM_ERROR <<
+                    "audit log: compression failure: " << theStatus <<
+                    " discarding " << theCount << " records" <<
+                KFS_LOG_EOM;
+            } else {
+                string theHdr;
+                AuditLogPut(theHdr, kAuditLogBlockMagic);
+                AuditLogPut(theHdr, (uint32_t)mBlock.size());
+                AuditLogPut(theHdr, (uint32_t)theLen);
+                AuditLogPut(theHdr, theCount);
+                memcpy(&mCompressed[0], theHdr.data(), theHdr.size());
+                Write(theFileName, theMaxFileSize, theMaxFiles,
+                    &mCompressed[0], kAuditLogBlockHeaderSize + theLen);
+            }
+        }
+        mBlock.clear();
+    }
+    void Write(
+        const string& inFileName,
+        int64_t       inMaxFileSize,
+        int           inMaxFiles,
+        const char*   inPtr,
+        size_t        inSize)
+    {
+        if (inFileName.empty()) {
+            return;
+        }
+        if (0 <= mFd && 0 < inMaxFileSize &&
+                inMaxFileSize < mFileSize + (int64_t)inSize) {
+            close(mFd);
+            mFd = -1;
+            // Rotate: name -> name.1, name.1 -> name.2, and so on.
+            for (int i = inMaxFiles - 1; 0 < i; i--) {
+                string theFrom = inFileName;
+                if (1 < i) {
+                    AppendDecIntToString(theFrom += '.', i - 1);
+                }
+                string theTo = inFileName;
+                AppendDecIntToString(theTo += '.', i);
+                rename(theFrom.c_str(), theTo.c_str());
+            }
+            if (inMaxFiles <= 1) {
+                unlink(inFileName.c_str());
+            }
+        }
+        if (mFd < 0) {
+            mFd = open(inFileName.c_str(), O_CREAT | O_APPEND | O_WRONLY,
+                0644);
+            if (mFd < 0) {
+                const int theErr = errno;
+                KFS_LOG_STREAM_ERROR <<
+                    "audit log: " << inFileName << ": " <<
+                        QCUtils::SysError(theErr) <<
+                KFS_LOG_EOM;
+                return;
+            }
+            const off_t theSize = lseek(mFd, 0, SEEK_END);
+            mFileSize = theSize < 0 ? int64_t(0) : (int64_t)theSize;
+        }
+        const char*       thePtr    = inPtr;
+        const char* const theEndPtr = inPtr + inSize;
+        while (thePtr < theEndPtr) {
+            const ssize_t theNWr = write(mFd, thePtr, theEndPtr - thePtr);
+            if (theNWr < 0) {
+                const int theErr = errno;
+                if (theErr == EINTR) {
+                    continue;
+                }
+                KFS_LOG_STREAM_ERROR <<
+                    "audit log: " << inFileName << ": " <<
+                        QCUtils::SysError(theErr) <<
+                KFS_LOG_EOM;
+                // Re-open with the next block.
+                close(mFd);
+                mFd = -1;
+                break;
+            }
+            thePtr += theNWr;
+        }
+        mFileSize += thePtr - inPtr;
+    }
+private:
+    BinaryAuditLog(
+        const BinaryAuditLog&);
+    BinaryAuditLog& operator=(
+        const BinaryAuditLog&);
+};
+
+__thread BinaryAuditLog::ThreadRing* BinaryAuditLog::sThreadRingPtr = 0;
+pthread_key_t  BinaryAuditLog::sThreadRingKey;
+pthread_once_t BinaryAuditLog::sThreadRingKeyOnce = PTHREAD_ONCE_INIT;
+
+static BinaryAuditLog&
+GetBinaryAuditLog()
+{
+    static BinaryAuditLog sBinaryAuditLog;
+    return sBinaryAuditLog;
+}
+
 static BufferedLogWriter&
 GetAuditMsgWriter()
 {
@@ -140,6 +800,7 @@ GetAuditMsgWriter()
 AuditLog::Init()
 {
     GetAuditMsgWriter();
+    GetBinaryAuditLog();
     return true;
 }
 
@@ -147,6 +808,10 @@ AuditLog::Init()
 AuditLog::Log(
     const MetaRequest& inOp)
 {
+    BinaryAuditLog& theBinLog = GetBinaryAuditLog();
+    if (theBinLog.IsEnabled() && theBinLog.Log(inOp)) {
+        return;
+    }
     AuditLogWriter theWriter(inOp);
     GetAuditMsgWriter().Append(
         inOp.status >= 0 ?
@@ -162,17 +827,21 @@ AuditLog::SetParameters(
 {
     GetAuditMsgWriter().SetParameters(inProps,
         "metaServer.auditLogWriter.");
+    GetBinaryAuditLog().SetParameters(inProps,
+        "metaServer.auditLogWriter.");
 }
 
 /* static */ void
 AuditLog::Stop()
 {
+    GetBinaryAuditLog().Stop();
     GetAuditMsgWriter().Stop();
 }
 
 /* static */ void
 AuditLog::PrepareToFork()
 {
+    GetBinaryAuditLog().PrepareToFork();
     GetAuditMsgWriter().PrepareToFork();
 }
 
@@ -180,12 +849,164 @@ AuditLog::PrepareToFork()
 AuditLog::ForkDone()
 {
     GetAuditMsgWriter().ForkDone();
+    GetBinaryAuditLog().ForkDone();
 }
 
 /* static */ void
 AuditLog::ChildAtFork()
 {
     GetAuditMsgWriter().ChildAtFork();
+    GetBinaryAuditLog().ChildAtFork();
+}
+
+static const char*
+AuditLogTimeStamp(
+    int64_t inTime,
+    bool    inUseGMTFlag,
+    char*   inBufPtr,
+    size_t  inBufSize)
+{
+    const time_t theSec = (time_t)(inTime / 1000000);
+    struct tm    theTm;
+    if (! (inUseGMTFlag ?
+            gmtime_r(&theSec, &theTm) : localtime_r(&theSec, &theTm))) {
+        memset(&theTm, 0, sizeof(theTm));
+    }
+    const size_t theLen = strftime(
+        inBufPtr, inBufSize, "%m-%d-%Y %H:%M:%S", &theTm);
+    snprintf(inBufPtr + theLen, inBufSize - theLen, ".%03ld",
+        (long)(inTime % 1000000 / 1000));
+    return inBufPtr;
+}
+
+/* static */ int
+AuditLog::Decode(
+    istream& inStream,
+    ostream& inOutStream,
+    bool     inUseGMTFlag,
+    string&  outErrMsg)
+{
+    vector<char>   theCompressed;
+    vector<char>   theBlock;
+    vector<string> theStrings;
+    char           theTime[64];
+    int64_t        theBlockCount = 0;
+    for (; ; theBlockCount++) {
+        char theHdr[kAuditLogBlockHeaderSize];
+        inStream.read(theHdr, sizeof(theHdr));
+        if (inStream.gcount() == 0 && inStream.eof()) {
+            break;
+        }
+        const char* thePtr       = theHdr;
+        const char* theEndPtr    = theHdr + sizeof(theHdr);
+        uint32_t    theMagic     = 0;
+        uint32_t    theSize      = 0;
+        uint32_t    theCompSize  = 0;
+        uint32_t    theCount     = 0;
+        if ((size_t)inStream.gcount() != sizeof(theHdr) ||
+                ! AuditLogGet(thePtr, theEndPtr, theMagic) ||
+                ! AuditLogGet(thePtr, theEndPtr, theSize) ||
+                ! AuditLogGet(thePtr, theEndPtr, theCompSize) ||
+                ! AuditLogGet(thePtr, theEndPtr, theCount) ||
+                theMagic != kAuditLogBlockMagic ||
+                kAuditLogMaxBlockSize < theSize ||
+                compressBound(kAuditLogMaxBlockSize) < theCompSize) {
+            outErrMsg = "invalid block header";
+            return -EINVAL;
+        }
+        theCompressed.resize(max(size_t(1), (size_t)theCompSize));
+        theBlock.resize(max(size_t(1), (size_t)theSize));
+        inStream.read(&theCompressed[0], theCompSize);
+        uLongf theLen = theSize;
+        if ((size_t)inStream.gcount() != theCompSize) {
+            outErrMsg = "truncated block";
+            return -EINVAL;
+        }
+        if (uncompress(
+                reinterpret_cast<Bytef*>(&theBlock[0]), &theLen,
+                reinterpret_cast<const Bytef*>(&theCompressed[0]),
+                theCompSize) != Z_OK || theLen != theSize) {
+            outErrMsg = "block decompression failure";
+            return -EINVAL;
+        }
+        theStrings.clear();
+        thePtr    = &theBlock[0];
+        theEndPtr = thePtr + theSize;
+        for (uint32_t i = 0; i < theCount; i++) {
+            if (theEndPtr <= thePtr) {
+                outErrMsg = "invalid record count";
+                return -EINVAL;
+            }
+            const int theType = *thePtr++ & 0xFF;
+            bool      theOkFlag;
+            if (theType == kAuditLogRecordString) {
+                uint32_t theId     = 0;
+                uint32_t theStrLen = 0;
+                theOkFlag = AuditLogGet(thePtr, theEndPtr, theId) &&
+                    AuditLogGet(thePtr, theEndPtr, theStrLen) &&
+                    theId == theStrings.size() &&
+                    thePtr + theStrLen <= theEndPtr;
+                if (theOkFlag) {
+                    theStrings.push_back(string(thePtr, theStrLen));
+                    thePtr += theStrLen;
+                }
+            } else if (theType == kAuditLogRecordDropped) {
+                int64_t theTm      = 0;
+                int64_t theDropped = 0;
+                theOkFlag = AuditLogGet(thePtr, theEndPtr, theTm) &&
+                    AuditLogGet(thePtr, theEndPtr, theDropped);
+                if (theOkFlag) {
+                    inOutStream <<
+                        AuditLogTimeStamp(theTm, inUseGMTFlag,
+                            theTime, sizeof(theTime)) <<
+                        " INFO - *** log records dropped: " << theDropped <<
+                    "\n";
+                }
+            } else if (theType == kAuditLogRecordRequest) {
+                int64_t  theTm      = 0;
+                int32_t  theStatus  = 0;
+                uint32_t theAuthUid = 0;
+                uint32_t theOp      = 0;
+                uint32_t theIpId    = 0;
+                uint32_t theHdrsLen = 0;
+                theOkFlag = AuditLogGet(thePtr, theEndPtr, theTm) &&
+                    AuditLogGet(thePtr, theEndPtr, theStatus) &&
+                    AuditLogGet(thePtr, theEndPtr, theAuthUid) &&
+                    AuditLogGet(thePtr, theEndPtr, theOp) &&
+                    AuditLogGet(thePtr, theEndPtr, theIpId) &&
+                    AuditLogGet(thePtr, theEndPtr, theHdrsLen) &&
+                    theIpId < theStrings.size() &&
+                    thePtr + theHdrsLen <= theEndPtr;
+                if (theOkFlag) {
+                    // The same as AuditLogWriter and BufferedLogWriter
+                    // message prefix.
+                    inOutStream <<
+                        AuditLogTimeStamp(theTm, inUseGMTFlag,
+                            theTime, sizeof(theTime)) <<
+                        (theStatus >= 0 ? " INFO - " : " ERROR - ");
+                    inOutStream.write(thePtr, theHdrsLen);
+                    thePtr += theHdrsLen;
+                    inOutStream << "Client-ip: " << theStrings[theIpId];
+                    if ((kfsUid_t)theAuthUid != kKfsUserNone) {
+                        inOutStream << "\r\nAuth-uid: " << theAuthUid;
+                    }
+                    inOutStream << "\r\nStatus: " << theStatus;
+                    inOutStream.write("\0\n", 2);
+                }
+            } else {
+                theOkFlag = false;
+            }
+            if (! theOkFlag) {
+                outErrMsg = "invalid record";
+                return -EINVAL;
+            }
+        }
+        if (! inOutStream) {
+            outErrMsg = "output stream write failure";
+            return -EIO;
+        }
+    }
+    return 0;
 }
 
 }
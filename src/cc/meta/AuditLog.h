@@ -30,8 +30,14 @@
 #ifndef AUDIT_LOG_H
 #define AUDIT_LOG_H
 
+#include <string>
+#include <iosfwd>
+
 namespace KFS
 {
+using std::string;
+using std::istream;
+using std::ostream;
 
 struct MetaRequest;
 class Properties;
@@ -46,6 +52,13 @@ public:
     static void ForkDone();
     static void ChildAtFork();
     static bool Init();
+    // Converts binary audit log into the text audit log format. Returns 0 on
+    // success, or negative error code and error message.
+    static int Decode(
+        istream& inStream,
+        ostream& inOutStream,
+        bool     inUseGMTFlag,
+        string&  outErrMsg);
 };
 
 };
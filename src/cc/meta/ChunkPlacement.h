@@ -49,6 +49,7 @@ using std::make_pair;
 using std::find_if;
 using std::iter_swap;
 using std::sort;
+using std::stable_partition;
 using boost::bind;
 
 /*
@@ -97,6 +98,7 @@ public:
         : mLayoutManager(layoutManager),
           mRacks(mLayoutManager.GetRacks()),
           mRackExcludes(),
+          mLocalGroupRacks(),
           mServerExcludes(),
           mCandidateRacks(),
           mCandidates(),
@@ -135,6 +137,7 @@ public:
     {
         Reset();
         mRackExcludes.Clear();
+        mLocalGroupRacks.Clear();
         mServerExcludes.Clear();
     }
     void FindCandidates(
@@ -338,6 +341,9 @@ public:
                     // first, to put the same number of replicas on
                     // each rack.
                     mRackExcludes.SortByCount();
+                    if (! mLocalGroupRacks.IsEmpty()) {
+                        mRackExcludes.MoveToBack(mLocalGroupRacks);
+                    }
                     mCurSTier              = mMinSTier;
                     mRackPos               = 0;
                     mUsingRackExcludesFlag = true;
@@ -494,6 +500,34 @@ public:
             servers.begin(), servers.end(), chunkId);
     }
 
+    // Locally repairable code placement. When no racks without the chunks of
+    // the same chunk block are available, use the racks with no chunks of the
+    // same local group first, in order to keep single rack failure
+    // repairable within each local group.
+    bool ExcludeLocalGroupRack(
+        const ChunkServer& srv)
+    {
+        return mLocalGroupRacks.Insert(srv.GetRack());
+    }
+
+    bool ExcludeLocalGroupRack(
+        const ChunkServerPtr& srv)
+    {
+        return ExcludeLocalGroupRack(*srv);
+    }
+
+    bool ExcludeLocalGroupRack(
+        const Servers& servers)
+    {
+        bool ret = false;
+        for (typename Servers::const_iterator it = servers.begin();
+                it != servers.end();
+                ++it) {
+            ret = ExcludeLocalGroupRack(*it) || ret;
+        }
+        return ret;
+    }
+
     bool IsServerExcluded(
         const ChunkServer& srv) const
     {
@@ -627,6 +661,14 @@ private:
                 bind(&Ids::value_type::second, _2)
             );
         }
+        // Moves the ids present in the argument set to the back, preserving
+        // the relative order.
+        template<typename T>
+        void MoveToBack(
+            const T& ids)
+        {
+            stable_partition(mIds.begin(), mIds.end(), NotFound<T>(ids));
+        }
         size_t GetMaxCount() const
             { return mMaxCount; }
         const IdT& Get(size_t pos) const
@@ -654,6 +696,20 @@ private:
             pair<IdT, CountT>,
             StdFastAllocator<pair<IdT, CountT> >
         > Ids;
+        template<typename T>
+        class NotFound
+        {
+        public:
+            NotFound(
+                const T& ids)
+                : mIds(ids)
+                {}
+            bool operator()(
+                const pair<IdT, CountT>& entry) const
+                { return (! mIds.Find(entry.first)); }
+        private:
+            const T& mIds;
+        };
         Ids    mIds;
         IdT    mMaxId;
         size_t mTotal;
@@ -685,6 +741,9 @@ private:
         }
         void SortByCount()
             { mIds.SortByCount(); }
+        void MoveToBack(
+            const RackIdSet& ids)
+            { mIds.MoveToBack(ids); }
         size_t GetMaxCount() const
             { return mIds.GetMaxCount(); }
         RackId Get(size_t pos) const
@@ -722,6 +781,7 @@ private:
     LayoutManager&   mLayoutManager;
     const RackInfos& mRacks;
     RackIdSet        mRackExcludes;
+    RackIdSet        mLocalGroupRacks;
     ServerExcludes   mServerExcludes;
     CandidateRacks   mCandidateRacks;
     Candidates       mCandidates;
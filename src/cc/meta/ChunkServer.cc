@@ -42,6 +42,7 @@
 #include "common/kfserrno.h"
 #include "common/RequestParser.h"
 #include "common/IntToString.h"
+#include "common/VarIntCodec.h"
 
 #include "kfsio/Globals.h"
 #include "kfsio/DelegationToken.h"
@@ -591,6 +592,152 @@ ChunkServer::RemoveInFlight(MetaChunkRequest& req)
     }
 }
 
+// Incremental delta varint chunk lists decoder. The decoder state is preserved
+// between invocations, in order to decode the chunk inventory as it arrives,
+// instead of parsing the whole inventory at once after it is fully received.
+// This bounds the amount of work per network read, and overlaps the decoding
+// with the network transfer.
+class ChunkServer::HelloChunkListDecoder
+{
+public:
+    HelloChunkListDecoder()
+        : mListIdx(0),
+          mRemaining(0),
+          mPrevId(0),
+          mCur(),
+          mIdFlag(true),
+          mErrorFlag(false),
+          mDecodedByteCount(0),
+          mDecoder()
+        {}
+    void Reset(MetaHello& op)
+    {
+        mListIdx          = 0;
+        mRemaining        = 0;
+        mPrevId           = 0;
+        mIdFlag           = true;
+        mErrorFlag        = false;
+        mDecodedByteCount = 0;
+        mDecoder.Reset();
+        op.chunks.clear();
+        op.notStableAppendChunks.clear();
+        op.notStableChunks.clear();
+        op.missingChunks.clear();
+        op.pendingStaleChunks.clear();
+        op.chunks.reserve((size_t)max(0, op.numChunks));
+        op.notStableAppendChunks.reserve(
+            (size_t)max(0, op.numNotStableAppendChunks));
+        op.notStableChunks.reserve((size_t)max(0, op.numNotStableChunks));
+        op.missingChunks.reserve((size_t)max(0, op.numMissingChunks));
+        op.pendingStaleChunks.reserve(
+            (size_t)max(0, op.numPendingStaleChunks));
+        mRemaining = GetCount(op, mListIdx);
+    }
+    int Decode(MetaHello& op, IOBuffer& buf, int maxLen)
+    {
+        IOBuffer::ByteIterator it(buf);
+        int                    len = 0;
+        const char*            p;
+        while (len < maxLen && ! mErrorFlag && Advance(op) &&
+                (p = it.Next())) {
+            len++;
+            const int ret = mDecoder.Add((unsigned char)*p);
+            if (ret <= 0) {
+                mErrorFlag = ret < 0;
+                continue;
+            }
+            const uint64_t val = mDecoder.Get();
+            if (mIdFlag) {
+                const chunkId_t id = (chunkId_t)(mPrevId + val);
+                if ((uint64_t)numeric_limits<chunkId_t>::max() < val ||
+                        id < mPrevId) {
+                    mErrorFlag = true;
+                    break;
+                }
+                mPrevId = id;
+                if (kMissingList <= mListIdx) {
+                    (kMissingList == mListIdx ?
+                        op.missingChunks : op.pendingStaleChunks
+                    ).push_back(id);
+                    mRemaining--;
+                    continue;
+                }
+                mCur.chunkId = id;
+                mIdFlag      = false;
+                continue;
+            }
+            if ((uint64_t)numeric_limits<seq_t>::max() < val) {
+                mErrorFlag = true;
+                break;
+            }
+            mCur.chunkVersion = (seq_t)val;
+            GetList(op, mListIdx).push_back(mCur);
+            mIdFlag = true;
+            mRemaining--;
+        }
+        buf.Consume(len);
+        mDecodedByteCount += len;
+        return len;
+    }
+    bool IsDone(MetaHello& op)
+        { return (! mErrorFlag && ! Advance(op)); }
+    bool IsError() const
+        { return mErrorFlag; }
+    int GetDecodedByteCount() const
+        { return mDecodedByteCount; }
+private:
+    enum
+    {
+        kStableList          = 0,
+        kNotStableAppendList = 1,
+        kNotStableList       = 2,
+        kMissingList         = 3,
+        kPendingStaleList    = 4,
+        kListCount           = 5
+    };
+    int                    mListIdx;
+    int64_t                mRemaining;
+    chunkId_t              mPrevId;
+    MetaHello::ChunkInfo   mCur;
+    bool                   mIdFlag;
+    bool                   mErrorFlag;
+    int                    mDecodedByteCount;
+    VarIntCodec::Decoder   mDecoder;
+
+    bool Advance(MetaHello& op)
+    {
+        while (mRemaining <= 0) {
+            if (kListCount <= ++mListIdx) {
+                return false;
+            }
+            mRemaining = GetCount(op, mListIdx);
+            mPrevId    = 0;
+        }
+        return true;
+    }
+    static int64_t GetCount(const MetaHello& op, int idx)
+    {
+        switch (idx) {
+            case kStableList:          return op.numChunks;
+            case kNotStableAppendList: return op.numNotStableAppendChunks;
+            case kNotStableList:       return op.numNotStableChunks;
+            case kMissingList:         return op.numMissingChunks;
+            case kPendingStaleList:    return op.numPendingStaleChunks;
+            default: break;
+        }
+        return 0;
+    }
+    static MetaHello::ChunkInfos& GetList(MetaHello& op, int idx)
+    {
+        return (kStableList == idx ? op.chunks :
+            (kNotStableAppendList == idx ?
+                op.notStableAppendChunks : op.notStableChunks));
+    }
+private:
+    HelloChunkListDecoder(const HelloChunkListDecoder&);
+    HelloChunkListDecoder& operator=(const HelloChunkListDecoder&);
+};
+
 ChunkServer::ChunkServer(
     const NetConnectionPtr& conn,
     const string&           peerName,
@@ -662,6 +809,7 @@ ChunkServer::ChunkServer(
       mSessionExpirationTime(TimeNow() + kMaxSessionTimeoutSec),
       mReAuthSentFlag(false),
       mHelloOp(0),
+      mHelloChunkListDecoder(0),
       mSelfPtr(),
       mSrvLoadSampler(sSrvLoadSamplerSampleCount, 0, TimeNow()),
       mLoadAvg(0),
@@ -750,6 +898,7 @@ ChunkServer::~ChunkServer()
     }
     RemoveFromPendingHelloList();
     MetaRequest::Release(mHelloOp);
+    delete mHelloChunkListDecoder;
     MetaRequest::Release(mAuthenticateOp);
     ReleasePendingResponses();
     mRecursionCount = 0xF000DEAD; // To catch double delete.
@@ -1720,7 +1869,7 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
                 return DeclareHelloError(-EINVAL, "file system id mismatch");
             }
         }
-        const int64_t kMinEntrySize = 4;
+        const int64_t kMinEntrySize = 0 == mHelloOp->contentFormat ? 4 : 1;
         if (mHelloOp->status == 0 && mHelloOp->contentLength + (1 << 10) <
                 kMinEntrySize * (
                     (int64_t)max(0, mHelloOp->numChunks) +
@@ -1743,6 +1892,12 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
             MetaRequest::Release(op);
             return -1;
         }
+        if (0 == mHelloOp->status && 0 != mHelloOp->contentFormat) {
+            if (! mHelloChunkListDecoder) {
+                mHelloChunkListDecoder = new HelloChunkListDecoder();
+            }
+            mHelloChunkListDecoder->Reset(*mHelloOp);
+        }
         if (0 == mHelloOp->status &&
                 0 < mHelloOp->bufferBytes &&
                 iobuf->BytesConsumable() < mHelloOp->bufferBytes &&
@@ -1782,7 +1937,17 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
     }
     // make sure we have the chunk ids...
     if (0 < mHelloOp->contentLength) {
-        const int nAvail = iobuf->BytesConsumable();
+        const bool deltaVarIntFlag =
+            0 == mHelloOp->status && 0 != mHelloOp->contentFormat;
+        if (deltaVarIntFlag) {
+            // Decode what is available so far, and discard decoded bytes.
+            mHelloChunkListDecoder->Decode(*mHelloOp, *iobuf,
+                mHelloOp->contentLength -
+                    mHelloChunkListDecoder->GetDecodedByteCount());
+        }
+        const int nDecoded = deltaVarIntFlag ?
+            mHelloChunkListDecoder->GetDecodedByteCount() : 0;
+        const int nAvail   = iobuf->BytesConsumable() + nDecoded;
         if (nAvail < mHelloOp->contentLength) {
             // need to wait for data...
             if (mHelloOp->status != 0) {
@@ -1819,10 +1984,12 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
             " received: "    << sHelloBytesInFlight <<
             " min waiting: " << sMinHelloWaitingBytes <<
         KFS_LOG_EOM;
-        mHelloOp->chunks.clear();
-        mHelloOp->notStableChunks.clear();
-        mHelloOp->notStableAppendChunks.clear();
-        mHelloOp->missingChunks.clear();
+        if (! deltaVarIntFlag) {
+            mHelloOp->chunks.clear();
+            mHelloOp->notStableChunks.clear();
+            mHelloOp->notStableAppendChunks.clear();
+            mHelloOp->missingChunks.clear();
+        }
         if (0 == mHelloOp->status) {
             const size_t numStable(max(0, mHelloOp->numChunks));
             mHelloOp->chunks.reserve(numStable);
@@ -1832,9 +1999,10 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
             const size_t nonStableNum(max(0, mHelloOp->numNotStableChunks));
             mHelloOp->notStableChunks.reserve(nonStableNum);
             // get the chunkids
-            istream& is = mIStream.Set(iobuf, contentLength);
+            istream& is = mIStream.Set(iobuf, contentLength - nDecoded);
             HexChunkInfoParser hexParser(*iobuf, mHelloOp->noFidsFlag);
-            for (int j = 0; j < 3 && ! hexParser.IsError(); ++j) {
+            for (int j = 0; j < 3 && ! hexParser.IsError() &&
+                    ! deltaVarIntFlag; ++j) {
                 MetaHello::ChunkInfos& chunks = j == 0 ?
                     mHelloOp->chunks : (j == 1 ?
                     mHelloOp->notStableAppendChunks :
@@ -1876,7 +2044,8 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
                     }
                 }
             }
-            for (int k = 0; k < 2 && ! hexParser.IsError(); k++) {
+            for (int k = 0; k < 2 && ! hexParser.IsError() &&
+                    ! deltaVarIntFlag; k++) {
                 int count = 0 == k ?
                     mHelloOp->numMissingChunks :
                     mHelloOp->numPendingStaleChunks;
@@ -1901,7 +2070,7 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
                 }
             }
             mIStream.Reset();
-            iobuf->Consume(contentLength);
+            iobuf->Consume(contentLength - nDecoded);
             if (mHelloOp->chunks.size() != numStable ||
                     mHelloOp->notStableAppendChunks.size() !=
                         nonStableAppendNum ||
@@ -1910,7 +2079,9 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
                         mHelloOp->missingChunks.size() ||
                     (size_t)max(0, mHelloOp->numPendingStaleChunks) !=
                         mHelloOp->pendingStaleChunks.size() ||
-                    hexParser.IsError()) {
+                    hexParser.IsError() ||
+                    (deltaVarIntFlag &&
+                        ! mHelloChunkListDecoder->IsDone(*mHelloOp))) {
                 KFS_LOG_STREAM_ERROR << GetPeerName() <<
                     " location: " << mHelloOp->location <<
                     " invalid or short chunk list:"
@@ -2834,6 +3005,14 @@ ChunkServer::GetChunkSize(fid_t fid, chunkId_t chunkId, seq_t chunkVersion,
     return 0;
 }
 
+void
+ChunkServer::GetChunkStorageTier(fid_t fid, chunkId_t chunkId,
+    seq_t chunkVersion)
+{
+    Enqueue(*(new MetaChunkStorageTier(NextSeq(), GetSelfPtr(),
+        fid, chunkId, chunkVersion)));
+}
+
 int
 ChunkServer::BeginMakeChunkStable(fid_t fid, chunkId_t chunkId, seq_t chunkVersion)
 {
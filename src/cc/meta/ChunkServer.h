@@ -524,6 +524,9 @@ public:
     int GetChunkSize(fid_t fid, chunkId_t chunkId,
         seq_t chunkVersion, bool retryFlag = true);
 
+    /// Method to get the chunk replica storage tier from a chunkserver.
+    void GetChunkStorageTier(fid_t fid, chunkId_t chunkId, seq_t chunkVersion);
+
     /// Methods to handle (re) replication of a chunk.  If there are
     /// insufficient copies of a chunk, we replicate it.
     int ReplicateChunk(fid_t fid, chunkId_t chunkId,
@@ -1138,6 +1141,8 @@ protected:
     int64_t mNumObjects;
     int64_t mNumWrObjects;
 
+    class HelloChunkListDecoder;
+
     class DispatchedReqsIterator
     {
     public:
@@ -1273,6 +1278,7 @@ protected:
     time_t                mSessionExpirationTime;
     bool                  mReAuthSentFlag;
     MetaHello*            mHelloOp;
+    HelloChunkListDecoder* mHelloChunkListDecoder;
     ChunkServerPtr        mSelfPtr;
     ValueSampler          mSrvLoadSampler;
     int64_t               mLoadAvg;
@@ -72,6 +72,7 @@ int  ClientSM::sBufCompactionThreshold    = 1 << 10;
 int  ClientSM::sOutBufCompactionThreshold = 8 << 10;
 int  ClientSM::sClientCount               = 0;
 bool ClientSM::sAuditLoggingFlag          = false;
+bool ClientSM::sBinaryRpcFlag             = false;
 int  ClientSM::sAuthMaxTimeSkew           = 2 * 60;
 int  ClientSM::sMinProtocolVersion        = -1;
 ClientSM* ClientSM::sClientSMPtr[1]       = {0};
@@ -110,6 +111,9 @@ ClientSM::SetParameters(const Properties& prop)
     sAuditLoggingFlag = prop.getValue(
         "metaServer.clientSM.auditLogging",
         sAuditLoggingFlag ? 1 : 0) != 0;
+    sBinaryRpcFlag = prop.getValue(
+        "metaServer.clientSM.binaryRpc",
+        sBinaryRpcFlag ? 1 : 0) != 0;
     sAuthMaxTimeSkew = prop.getValue(
         "metaServer.clientSM.authMaxTimeSkew",
         sAuthMaxTimeSkew);
@@ -528,6 +532,9 @@ ClientSM::HandleClientCmd(IOBuffer& iobuf, int cmdLen)
             op->shortRpcFormatFlag = mShortRpcFormatFlag;
         }
     }
+    if (op && ! sBinaryRpcFlag) {
+        op->binaryRpcFlag = false;
+    }
     if (! op) {
         IOBuffer::IStream is(iobuf, cmdLen);
         char buf[128];
@@ -170,6 +170,7 @@ private:
     static int  sMinProtocolVersion;
     static int  sClientCount;
     static bool sAuditLoggingFlag;
+    static bool sBinaryRpcFlag;
     static ClientSM* sClientSMPtr[1];
     static IOBuffer::WOStream sWOStream;
 };
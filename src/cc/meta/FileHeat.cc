@@ -0,0 +1,111 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file FileHeat.cc
+// \brief Per file access heat tracking implementation.
+//
+//----------------------------------------------------------------------------
+
+#include "FileHeat.h"
+
+#include <math.h>
+
+namespace KFS
+{
+
+FileHeat::FileHeat()
+    : mMap(),
+      mCandidates(),
+      mCold(),
+      mHalfLifeUsec(int64_t(3600) * 1000 * 1000),
+      mMaxEntries(size_t(1) << 20)
+{}
+
+FileHeat::~FileHeat()
+{
+    FileHeat::Clear();
+}
+
+    void
+FileHeat::SetParameters(
+    int64_t inHalfLifeUsec,
+    size_t  inMaxEntries)
+{
+    mHalfLifeUsec = inHalfLifeUsec < 1000 ? int64_t(1000) : inHalfLifeUsec;
+    mMaxEntries   = inMaxEntries < 1 ? size_t(1) : inMaxEntries;
+    Evict();
+}
+
+    void
+FileHeat::Clear()
+{
+    mMap.Clear();
+    Entry::List::Remove(mCandidates);
+    Entry::List::Remove(mCold);
+}
+
+    double
+FileHeat::GetHeat(
+    const Entry& inEntry,
+    int64_t      inNow) const
+{
+    if (inNow <= inEntry.mTime) {
+        return inEntry.mHeat;
+    }
+    return (inEntry.mHeat *
+        exp2(-double(inNow - inEntry.mTime) / double(mHalfLifeUsec)));
+}
+
+    FileHeat::Entry&
+FileHeat::Access(
+    fid_t   inFid,
+    int64_t inNow,
+    bool&   outInsertedFlag)
+{
+    outInsertedFlag = false;
+    Entry& theEntry = *mMap.Insert(inFid, Entry(), outInsertedFlag);
+    theEntry.mHeat = GetHeat(theEntry, inNow) + 1;
+    if (theEntry.mTime < inNow) {
+        theEntry.mTime = inNow;
+    }
+    UpdateList(theEntry);
+    if (outInsertedFlag && mMaxEntries < mMap.GetSize()) {
+        Evict();
+    }
+    return theEntry;
+}
+
+    void
+FileHeat::Evict()
+{
+    while (mMaxEntries < mMap.GetSize()) {
+        Entry* thePtr = &Entry::List::GetNext(mCold);
+        if (thePtr == &mCold) {
+            thePtr = &Entry::List::GetNext(mCandidates);
+            if (thePtr == &mCandidates) {
+                break;
+            }
+        }
+        mMap.Erase(thePtr->GetKey());
+    }
+}
+
+} // namespace KFS
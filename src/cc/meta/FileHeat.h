@@ -0,0 +1,209 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file FileHeat.h
+// \brief Per file access "heat" tracking for storage tier migration.
+//
+// File heat is exponentially decaying access count: each access adds one,
+// and the accumulated value halves every "half life" interval. Only the
+// files accessed since the meta server start are tracked, the heat is not
+// persistent.
+// The entries are kept in two lists ordered by the last access time: the
+// migration candidates list, and the list of the files that are already
+// placed in the "cold" storage tiers, or being migrated. The least recently
+// accessed entries are evicted first when the number of entries exceeds the
+// limit, starting from the cold list.
+//
+//----------------------------------------------------------------------------
+
+#ifndef META_FILE_HEAT_H
+#define META_FILE_HEAT_H
+
+#include "common/kfstypes.h"
+#include "common/LinearHash.h"
+#include "common/StdAllocator.h"
+#include "qcdio/QCDLList.h"
+
+#include <stddef.h>
+
+namespace KFS
+{
+
+class FileHeat
+{
+public:
+    enum Placement
+    {
+        kPlacementUnknown = 0,
+        kPlacementHot     = 1,
+        kPlacementCold    = 2
+    };
+    class Entry
+    {
+    public:
+        typedef fid_t                Key;
+        typedef Entry                Val;
+        typedef QCDLListOp<Entry, 0> List;
+
+        Entry(
+            const Key& inKey,
+            const Val& inVal)
+            : mFid(inKey),
+              mHeat(inVal.mHeat),
+              mTime(inVal.mTime),
+              mPlacement(inVal.mPlacement),
+              mMigratingFlag(inVal.mMigratingFlag)
+            { List::Init(*this); }
+        Entry(
+            const Entry& inEntry)
+            : mFid(inEntry.mFid),
+              mHeat(inEntry.mHeat),
+              mTime(inEntry.mTime),
+              mPlacement(inEntry.mPlacement),
+              mMigratingFlag(inEntry.mMigratingFlag)
+            { List::Init(*this); }
+        Entry()
+            : mFid(-1),
+              mHeat(0),
+              mTime(0),
+              mPlacement(kPlacementUnknown),
+              mMigratingFlag(false)
+            { List::Init(*this); }
+        ~Entry()
+            { List::Remove(*this); }
+        const Key& GetKey() const
+            { return mFid; }
+        const Val& GetVal() const
+            { return *this; }
+        Val& GetVal()
+            { return *this; }
+        fid_t GetFid() const
+            { return mFid; }
+        Placement GetPlacement() const
+            { return mPlacement; }
+        bool IsMigrating() const
+            { return mMigratingFlag; }
+    private:
+        Key       mFid;
+        double    mHeat;
+        int64_t   mTime;
+        Placement mPlacement;
+        bool      mMigratingFlag;
+        Entry*    mPrevPtr[1];
+        Entry*    mNextPtr[1];
+
+        friend class QCDLListOp<Entry, 0>;
+        friend class FileHeat;
+    private:
+        Entry& operator=(const Entry&);
+    };
+
+    FileHeat();
+    ~FileHeat();
+    void SetParameters(
+        int64_t inHalfLifeUsec,
+        size_t  inMaxEntries);
+    // Adds one access to the file heat, and moves the entry to the end of
+    // its list. The new entry has unknown placement.
+    Entry& Access(
+        fid_t   inFid,
+        int64_t inNow,
+        bool&   outInsertedFlag);
+    Entry* Find(
+        fid_t inFid)
+        { return mMap.Find(inFid); }
+    void Erase(
+        fid_t inFid)
+        { mMap.Erase(inFid); }
+    void Clear();
+    double GetHeat(
+        const Entry& inEntry,
+        int64_t      inNow) const;
+    void SetPlacement(
+        Entry&    inEntry,
+        Placement inPlacement)
+    {
+        inEntry.mPlacement = inPlacement;
+        UpdateList(inEntry);
+    }
+    void SetMigrating(
+        Entry& inEntry,
+        bool   inFlag)
+    {
+        inEntry.mMigratingFlag = inFlag;
+        UpdateList(inEntry);
+    }
+    // Migration candidates iteration, least recently accessed first.
+    Entry* GetFirstCandidate()
+    {
+        Entry& theEntry = Entry::List::GetNext(mCandidates);
+        return (&theEntry == &mCandidates ? 0 : &theEntry);
+    }
+    Entry* GetNextCandidate(
+        Entry& inEntry)
+    {
+        Entry& theEntry = Entry::List::GetNext(inEntry);
+        return (&theEntry == &mCandidates ? 0 : &theEntry);
+    }
+    size_t GetSize() const
+        { return mMap.GetSize(); }
+    int64_t GetHalfLifeUsec() const
+        { return mHalfLifeUsec; }
+    size_t GetMaxEntries() const
+        { return mMaxEntries; }
+private:
+    typedef LinearHash<
+        Entry,
+        KeyCompare<Entry::Key>,
+        DynamicArray<
+            SingleLinkedList<Entry>*,
+            10 // 2^10
+        >,
+        StdFastAllocator<Entry>
+    > Map;
+
+    Map     mMap;
+    Entry   mCandidates;
+    Entry   mCold;
+    int64_t mHalfLifeUsec;
+    size_t  mMaxEntries;
+
+    bool IsCandidate(
+        const Entry& inEntry) const
+    {
+        return (! inEntry.mMigratingFlag &&
+            inEntry.mPlacement != kPlacementCold);
+    }
+    void UpdateList(
+        Entry& inEntry)
+    {
+        Entry::List::Insert(inEntry, Entry::List::GetPrev(
+            IsCandidate(inEntry) ? mCandidates : mCold));
+    }
+    void Evict();
+private:
+    FileHeat(const FileHeat&);
+    FileHeat& operator=(const FileHeat&);
+};
+
+} // namespace KFS
+
+#endif /* META_FILE_HEAT_H */
@@ -42,6 +42,7 @@
 #include "common/Version.h"
 #include "common/StdAllocator.h"
 #include "common/rusage.h"
+#include "common/LrcStripeLayout.h"
 
 #include "kfsio/Globals.h"
 #include "kfsio/IOBuffer.h"
@@ -164,6 +165,53 @@ IsObjectStoreBlock(fid_t fid, chunkOff_t pos)
         pos <= fa->nextChunkOffset());
 }
 
+// Returns locally repairable code local group of the chunk at the given file
+// offset, or -1 if the file is not lrc file, or chunk is global parity chunk.
+static inline int
+GetLrcLocalGroup(const MetaFattr& fa, chunkOff_t offset)
+{
+    if (KFS_STRIPED_FILE_TYPE_LRC != fa.striperType) {
+        return -1;
+    }
+    const int stripes = fa.numStripes + fa.numRecoveryStripes;
+    return LrcStripeLayout::GetLocalGroup(fa.numStripes,
+        fa.numRecoveryStripes,
+        (int)(offset / (chunkOff_t)CHUNKSIZE % max(1, stripes)));
+}
+
+// Lost stripes flags, indexed by the stripe index in the chunk block.
+typedef char ChunkBlockLostStripes[
+    KFS_MAX_DATA_STRIPE_COUNT + KFS_MAX_RECOVERY_STRIPE_COUNT];
+
+// Returns true if the chunk block with the given number of the good stripes,
+// and the lost stripes can be recovered. With Reed-Solomon any data stripe
+// count good stripes are sufficient, with locally repairable code it depends
+// on the lost stripes positions.
+static inline bool
+CanRecoverChunkBlock(const MetaFattr& fa, int goodCnt,
+    const ChunkBlockLostStripes& lost)
+{
+    if (goodCnt < (int)fa.numStripes) {
+        return false;
+    }
+    return (KFS_STRIPED_FILE_TYPE_LRC != fa.striperType ||
+        LrcStripeLayout::CanRecover(
+            fa.numStripes, fa.numRecoveryStripes, lost));
+}
+
+// Returns the max number of the chunks that the chunk block can always lose.
+static inline int
+GetChunkBlockFailureTolerance(const MetaFattr& fa)
+{
+    if (! fa.HasRecovery()) {
+        return 0;
+    }
+    return (KFS_STRIPED_FILE_TYPE_LRC == fa.striperType ?
+        min((int)fa.numRecoveryStripes,
+            LrcStripeLayout::GetFailureTolerance(fa.numRecoveryStripes)) :
+        (int)fa.numRecoveryStripes);
+}
+
 static inline void
 ResubmitRequest(MetaRequest& req)
 {
@@ -434,6 +482,27 @@ ChunkLeases::IsDeleteScheduled(
     return (entry && ! entry->Get().mName.empty());
 }
 
+inline bool
+ChunkLeases::HasWriteLeaseInSubTree(
+    fid_t dir)
+{
+    mFileLeases.First();
+    const FEntry* entry;
+    while ((entry = mFileLeases.Next())) {
+        if (entry->Get().mCount <= 1) {
+            continue;
+        }
+        for (const MetaFattr* fa = metatree.getFattr(entry->GetKey());
+                fa;
+                fa = fa->parent) {
+            if (fa->id() == dir) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 inline void
 ChunkLeases::Erase(
     ChunkLeases::WEntry& wl,
@@ -1873,6 +1942,9 @@ inline void
 LayoutManager::UpdateATimeSelf(int64_t updateResolutionUsec,
     const MetaFattr* fa, T& req)
 {
+    if (! req.fromChunkServerFlag && KFS_FILE == fa->type) {
+        UpdateFileHeat(fa->id(), req.submitTime);
+    }
     if (req.fromChunkServerFlag || updateResolutionUsec < 0 ||
             req.submitTime <= fa->atime + updateResolutionUsec) {
         return;
@@ -1953,6 +2025,13 @@ LayoutManager::LayoutManager()
       mAssignMasterByIpFlag(false),
       mLeaseOwnerDownExpireDelay(30),
       mMaxDumpsterCleanupInFlight(256),
+      mDumpsterDirs(),
+      mDumpsterDirIds(),
+      mDumpsterDirCleanupInFlightFlag(false),
+      mDumpsterDirCleanupMaxEntries(1024),
+      mDumpsterDirCleanupMaxRetries(8),
+      mDumpsterDirFilesRemovedCount(0),
+      mDumpsterDirsRemovedCount(0),
       mMaxTruncateChunksDeleteCount(36),
       mMaxTruncateChunksQueueCount(1 << 20),
       mMaxTruncatedChunkDeletesInFlight(256),
@@ -2013,6 +2092,20 @@ LayoutManager::LayoutManager()
       mRebalancePlan(),
       mCleanupScheduledFlag(false),
       mPrimaryFlag(true),
+      mTierMigrationEnabledFlag(false),
+      mTierMigrationHotHeat(16),
+      mTierMigrationColdHeat(0.25),
+      mTierMigrationMaxBytesPerSec(int64_t(64) << 20),
+      mTierMigrationBudget(0),
+      mTierMigrationBudgetTime(microseconds()),
+      mTierMigrationMaxFiles(32),
+      mTierMigrationMaxScan(256),
+      mTierMigrationMaxChunkRetries(8),
+      mTierMigrationReplicasCount(0),
+      mTierMigrationFailedCount(0),
+      mTierMigrationTiers(),
+      mFileHeat(),
+      mTierMigrations(),
       mCSCountersUpdateInterval(2),
       mCSCountersUpdateTime(0),
       mCSCountersResponse(),
@@ -2364,6 +2457,62 @@ LayoutManager::SetParameters(const Properties& props, int clientPort)
         "metaServer.rebalancePlanFileName",
         mRebalancePlanFileName));
 
+    mTierMigrationEnabledFlag = props.getValue(
+        "metaServer.tierMigration.enabled",
+        mTierMigrationEnabledFlag ? 1 : 0) != 0;
+    mTierMigrationHotHeat = props.getValue(
+        "metaServer.tierMigration.hotHeat",
+        mTierMigrationHotHeat);
+    mTierMigrationColdHeat = props.getValue(
+        "metaServer.tierMigration.coldHeat",
+        mTierMigrationColdHeat);
+    mTierMigrationMaxBytesPerSec = props.getValue(
+        "metaServer.tierMigration.maxBytesPerSec",
+        mTierMigrationMaxBytesPerSec);
+    mTierMigrationMaxFiles = max(1, props.getValue(
+        "metaServer.tierMigration.maxFiles",
+        mTierMigrationMaxFiles));
+    mTierMigrationMaxScan = max(1, props.getValue(
+        "metaServer.tierMigration.maxScan",
+        mTierMigrationMaxScan));
+    mTierMigrationMaxChunkRetries = max(0, props.getValue(
+        "metaServer.tierMigration.maxChunkRetries",
+        mTierMigrationMaxChunkRetries));
+    {
+        mTierMigrationTiers.clear();
+        istringstream is(props.getValue(
+            "metaServer.tierMigration.tiers", string()));
+        int tier;
+        while ((is >> tier)) {
+            if (kKfsSTierMin <= tier && tier <= kKfsSTierMax &&
+                    find(mTierMigrationTiers.begin(),
+                        mTierMigrationTiers.end(), (kfsSTier_t)tier) ==
+                    mTierMigrationTiers.end()) {
+                mTierMigrationTiers.push_back((kfsSTier_t)tier);
+            }
+        }
+        if (mTierMigrationEnabledFlag && mTierMigrationTiers.size() < 2) {
+            KFS_LOG_STREAM_ERROR <<
+                "tier migration: metaServer.tierMigration.tiers"
+                " has less than two valid tiers, migration is disabled" <<
+            KFS_LOG_EOM;
+            mTierMigrationEnabledFlag = false;
+        }
+    }
+    mFileHeat.SetParameters(
+        (int64_t)(props.getValue(
+            "metaServer.tierMigration.heatHalfLife",
+            mFileHeat.GetHalfLifeUsec() * 1e-6) * 1e6),
+        (size_t)max(int64_t(1), props.getValue(
+            "metaServer.tierMigration.maxTrackedFiles",
+            (int64_t)mFileHeat.GetMaxEntries()))
+    );
+    if (! mTierMigrationEnabledFlag) {
+        // In flight replications, if any, complete normally.
+        mTierMigrations.clear();
+        mFileHeat.Clear();
+    }
+
     mAssignMasterByIpFlag = props.getValue(
         "metaServer.assignMasterByIp",
         mAssignMasterByIpFlag ? 1 : 0) != 0;
@@ -2373,6 +2522,12 @@ LayoutManager::SetParameters(const Properties& props, int clientPort)
     mMaxDumpsterCleanupInFlight = max(2, props.getValue(
         "metaServer.maxDumpsterCleanupInFlight",
         mMaxDumpsterCleanupInFlight));
+    mDumpsterDirCleanupMaxEntries = max(int64_t(1), props.getValue(
+        "metaServer.dumpsterDirCleanupMaxEntries",
+        mDumpsterDirCleanupMaxEntries));
+    mDumpsterDirCleanupMaxRetries = props.getValue(
+        "metaServer.dumpsterDirCleanupMaxRetries",
+        mDumpsterDirCleanupMaxRetries);
     mMaxTruncateChunksDeleteCount = max(1, props.getValue(
         "metaServer.maxTruncateChunksDeleteCount",
         mMaxTruncateChunksDeleteCount));
@@ -5193,10 +5348,12 @@ LayoutManager::CanBeRecovered(
         return false;
     }
     vector<MetaChunkInfo*>::const_iterator it = cblk.begin();
-    unsigned int     stripeIdx = 0;
-    int              localCnt;
-    int&             goodCnt   = outGoodCnt ? *outGoodCnt : localCnt;
-    chunkOff_t const end       = start + fa->ChunkBlkSize();
+    unsigned int          stripeIdx = 0;
+    int                   localCnt;
+    int&                  goodCnt   = outGoodCnt ? *outGoodCnt : localCnt;
+    chunkOff_t const      end       = start + fa->ChunkBlkSize();
+    ChunkBlockLostStripes lost;
+    memset(lost, 0, sizeof(lost));
     goodCnt = 0;
     for (chunkOff_t pos = start;
             pos < end;
@@ -5218,6 +5375,8 @@ LayoutManager::CanBeRecovered(
         }
         if (mChunkToServerMap.HasServers(GetCsEntry(**it))) {
             goodCnt++;
+        } else {
+            lost[stripeIdx] = 1;
         }
         ++it;
     }
@@ -5229,7 +5388,7 @@ LayoutManager::CanBeRecovered(
             }
         }
     }
-    return ((int)fa->numStripes <= goodCnt);
+    return CanRecoverChunkBlock(*fa, goodCnt, lost);
 }
 
 typedef KeyOnly<const MetaFattr*> KeyOnlyFattrPtr;
@@ -5713,6 +5872,8 @@ LayoutManager::CheckFile(
     const chunkOff_t      chunkBlockSize    = (chunkOff_t)CHUNKSIZE *
         (recoveryStripeCnt > 0 ?
             (fa.numStripes + fa.numRecoveryStripes) : 1);
+    const size_t          failureTolerance  =
+        (size_t)GetChunkBlockFailureTolerance(fa);
     ChunkIterator         it                = metatree.getAlloc(fa.id());
     StTmp<Servers>        serversTmp(mServersTmp);
     StTmp<ChunkPlacement> placementTmp(mChunkPlacementTmp);
@@ -5735,10 +5896,13 @@ LayoutManager::CheckFile(
             }
         }
         const chunkOff_t recoveryStartPos = chunkBlockEnd + recoveryPos;
+        const chunkOff_t chunkBlockStart  = chunkBlockEnd;
         chunkBlockEnd += chunkBlockSize;
         placement.clear();
-        size_t missingCnt             = 0;
-        size_t blockRecoveryStripeCnt = 0;
+        size_t                missingCnt             = 0;
+        size_t                blockRecoveryStripeCnt = 0;
+        ChunkBlockLostStripes lost;
+        memset(lost, 0, sizeof(lost));
         if (recoveryStripeCnt > 0) {
             fsck.RecoveryBlock();
         }
@@ -5770,6 +5934,9 @@ LayoutManager::CheckFile(
             if (srvsCnt == 0) {
                 fsck.ChunkLost();
                 missingCnt++;
+                if (recoveryStripeCnt > 0) {
+                    lost[(ci.offset - chunkBlockStart) / CHUNKSIZE] = 1;
+                }
                 continue;
             }
             fsck.ChunkReplicas(srvsCnt);
@@ -5800,17 +5967,22 @@ LayoutManager::CheckFile(
             fsck.PartialRecoveryBlock();
             invalidBlkFlag = true;
         }
-        if (recoveryStripeCnt < missingCnt) {
+        if (recoveryStripeCnt < missingCnt || (0 < missingCnt &&
+                ! CanRecoverChunkBlock(fa,
+                    (int)(fa.numStripes + recoveryStripeCnt - missingCnt),
+                    lost))) {
             status = FilesChecker::kLost;
         }
         if (status == FilesChecker::kLost) {
             continue;
         }
-        if (recoveryStripeCnt < missingCnt +
+        // With LRC not every pattern of more than the failure tolerance
+        // missing chunks is recoverable, use the tolerance to be safe.
+        if (failureTolerance < missingCnt +
                 placement.GetExcludedServersMaxCount()) {
             status = FilesChecker::kLostIfServerDown;
         } else if (status == FilesChecker::kOk &&
-                recoveryStripeCnt < missingCnt +
+                failureTolerance < missingCnt +
                     placement.GetExcludedRacksMaxCount()) {
             status = FilesChecker::kLostIfRackDown;
         }
@@ -6662,13 +6834,22 @@ LayoutManager::AllocateChunk(
             }
         }
         StTmp<Servers> serversTmp(mServersTmp);
+        const int      localGroup = chunkBlock.empty() ? -1 :
+            GetLrcLocalGroup(
+                *GetCsEntry(*chunkBlock.front()).GetFattr(), req.offset);
         for (vector<MetaChunkInfo*>::const_iterator it =
                 chunkBlock.begin();
                 it != chunkBlock.end();
                 ++it) {
-            Servers& srvs = serversTmp.Get();
-            mChunkToServerMap.GetServers(GetCsEntry(**it), srvs);
+            Servers&            srvs = serversTmp.Get();
+            const CSMap::Entry& ce   = GetCsEntry(**it);
+            mChunkToServerMap.GetServers(ce, srvs);
             placement.ExcludeServerAndRack(srvs, (*it)->chunkId);
+            if (0 <= localGroup &&
+                    localGroup == GetLrcLocalGroup(
+                        *ce.GetFattr(), (*it)->offset)) {
+                placement.ExcludeLocalGroupRack(srvs);
+            }
         }
     }
     req.servers.reserve(req.numReplicas);
@@ -6972,6 +7153,7 @@ LayoutManager::AllocateChunk(
     for (size_t i = req.servers.size(); i-- > 0; ) {
         req.servers[i]->AllocateChunk(req, i == 0 ? req.leaseId : -1, tiers[i]);
     }
+    UpdateFileHeat(req.fid, req.submitTime, req.offset);
     return 0;
 }
 
@@ -8067,6 +8249,66 @@ LayoutManager::Handle(MetaRemoveFromDumpster& op)
     }
 }
 
+void
+LayoutManager::ScheduleDumpsterDirCleanup(
+    const MetaFattr& fa,
+    const string&    name)
+{
+    // Both replay and the dumpster scan on startup can schedule the same
+    // directory.
+    if (! mDumpsterDirIds.insert(fa.id()).second) {
+        return;
+    }
+    mDumpsterDirs.push_back(DumpsterDir(fa.id(), name,
+        TimeNow() + mChunkLeases.GetDumpsterCleanupDelaySec()));
+}
+
+void
+LayoutManager::Handle(MetaRemoveDirFromDumpster& op)
+{
+    if (! op.replayFlag) {
+        mDumpsterDirCleanupInFlightFlag = false;
+    }
+    if (0 == op.status) {
+        mDumpsterDirFilesRemovedCount += op.filesCount;
+        mDumpsterDirsRemovedCount     += op.dirsCount;
+    }
+    DumpsterDirs::iterator it = mDumpsterDirs.begin();
+    while (mDumpsterDirs.end() != it && it->mFid != op.fid) {
+        ++it;
+    }
+    if (mDumpsterDirs.end() != it) {
+        if (op.cleanupDoneFlag || -ENOENT == op.status) {
+            mDumpsterDirIds.erase(it->mFid);
+            mDumpsterDirs.erase(it);
+        } else if (0 == op.status) {
+            it->mFailures = 0;
+        } else {
+            // Move to the end of the queue, in order not to block the other
+            // directories cleanup, or give up after too many failures.
+            DumpsterDir dir = *it;
+            mDumpsterDirs.erase(it);
+            if (mDumpsterDirCleanupMaxRetries < ++dir.mFailures) {
+                KFS_LOG_STREAM_ERROR <<
+                    "dumpster directory cleanup: " << dir.mName <<
+                    " fid: "      << dir.mFid <<
+                    " failures: " << dir.mFailures <<
+                    " giving up: " << op.Show() <<
+                KFS_LOG_EOM;
+                mDumpsterDirIds.erase(dir.mFid);
+            } else {
+                dir.mTime = TimeNow() +
+                    mChunkLeases.GetDumpsterCleanupDelaySec();
+                mDumpsterDirs.push_back(dir);
+            }
+        }
+    }
+    if (mPrimaryFlag && ! op.replayFlag && 0 == op.status &&
+            ! mDumpsterDirs.empty()) {
+        mLeaseCleaner.ScheduleNext();
+    }
+}
+
 void
 LayoutManager::Handle(MetaLeaseRenew& req)
 {
@@ -9049,6 +9291,10 @@ LayoutManager::Handle(MetaPing& inReq, bool wormModeFlag)
                 TimeNow() - mObjStoreFilesDeleteQueue.Front()->mTime) << "\t"
         "File count= "            << GetNumFiles() << "\t"
         "Dir count= "             << GetNumDirs() << "\t"
+        "Dumpster dirs= "         << mDumpsterDirs.size() << "\t"
+        "Dumpster dirs files removed= " <<
+            mDumpsterDirFilesRemovedCount << "\t"
+        "Dumpster dirs removed= " << mDumpsterDirsRemovedCount << "\t"
         "Logical Size= "          << (fa ? fa->filesize : chunkOff_t(-1)) << "\t"
         "FS ID= "                 << metatree.GetFsId() << "\t"
         "Primary= "               << mPrimaryFlag << "\t"
@@ -9140,6 +9386,23 @@ LayoutManager::LeaseCleanup(
     const time_t now = (time_t)startTime;
     mChunkLeases.Timer(now, mLeaseOwnerDownExpireDelay,
         mARAChunkCache, mChunkToServerMap, mMaxDumpsterCleanupInFlight);
+    if (! mDumpsterDirCleanupInFlightFlag && ! mDumpsterDirs.empty() &&
+            mDumpsterDirs.front().mTime <= now) {
+        if (mChunkLeases.HasWriteLeaseInSubTree(mDumpsterDirs.front().mFid)) {
+            // Wait for the write leases to be relinquished or to expire,
+            // the same way as with the files moved into the dumpster. The
+            // check is done here, as the leases are not replayed.
+            DumpsterDir dir = mDumpsterDirs.front();
+            mDumpsterDirs.pop_front();
+            dir.mTime = now + mChunkLeases.GetDumpsterCleanupDelaySec();
+            mDumpsterDirs.push_back(dir);
+        } else {
+            const DumpsterDir& dir = mDumpsterDirs.front();
+            mDumpsterDirCleanupInFlightFlag = true;
+            submit_request(new MetaRemoveDirFromDumpster(
+                dir.mName, dir.mFid, mDumpsterDirCleanupMaxEntries));
+        }
+    }
     if (! mWasServicingFlag) {
         mWasServicingFlag = true;
         ScheduleTruncatedChunksDelete();
@@ -10849,6 +11112,62 @@ LayoutManager::Handle(MetaChunkSize& req)
         return;
     }
     chunkOff_t const offset = chunk->offset;
+    MetaChunkInfo*   prev   = 0;
+    if (0 == req.chunkSize && (chunkOff_t)CHUNKSIZE <= offset &&
+            ! mChunkLeases.GetChunkWriteLease(req.chunkId) &&
+            IsChunkStable(req.chunkId) &&
+            0 == metatree.getalloc(
+                fa->id(), offset - (chunkOff_t)CHUNKSIZE, &prev) &&
+            prev &&
+            ! mChunkLeases.GetChunkWriteLease(prev->chunkId) &&
+            IsChunkStable(prev->chunkId)) {
+        // Empty last chunk of the file that is no longer written into, for
+        // example unused chunk pre-allocated by the client ahead of the
+        // write position. Remove it in order not to extend the file past
+        // the preceding chunk, and get the size of the preceding chunk.
+        const chunkOff_t kEndOffset      = -1;
+        const bool       kSetEofHintFlag = false;
+        const int        kMaxDeleteCount = -1;
+        const int        kMaxQueueCount  = -1;
+        const int        status          = metatree.truncate(
+            fa->id(), offset, fa->mtime, kKfsUserRoot, kKfsGroupRoot,
+            kEndOffset, kSetEofHintFlag, kMaxDeleteCount, kMaxQueueCount, 0);
+        if (0 == status) {
+            metatree.invalidateFileSize(fa);
+            KFS_LOG_STREAM_DEBUG <<
+                "file: "       << fa->id() <<
+                " chunk: "     << req.chunkId <<
+                " version: "   << req.chunkVersion <<
+                " empty last chunk removed"
+                " next pos: "  << fa->nextChunkOffset() <<
+                " log: "       << req.logseq <<
+            KFS_LOG_EOM;
+            if (! req.replayFlag) {
+                const CSMap::Entry& pci = GetCsEntry(*prev);
+                StTmp<Servers>      serversTmp(mServers3Tmp);
+                Servers&            srvs = serversTmp.Get();
+                mChunkToServerMap.GetServers(pci, srvs);
+                for (Servers::const_iterator it = srvs.begin();
+                        it != srvs.end();
+                        ++it) {
+                    if (! (*it)->IsDown()) {
+                        (*it)->GetChunkSize(
+                            fa->id(), prev->chunkId, prev->chunkVersion);
+                        break;
+                    }
+                }
+            }
+            return;
+        }
+        KFS_LOG_STREAM_ERROR <<
+            "file: "      << fa->id() <<
+            " chunk: "    << req.chunkId <<
+            " version: "  << req.chunkVersion <<
+            " empty last chunk removal failure:"
+            " status: "   << status <<
+            " log: "      << req.logseq <<
+        KFS_LOG_EOM;
+    }
     metatree.setFileSize(fa, offset + req.chunkSize);
     KFS_LOG_STREAM_DEBUG <<
         "file: "            << fa->id() <<
@@ -11114,6 +11433,7 @@ LayoutManager::GetPlacementExcludes(
         return false;
     }
     StTmp<Servers> serversTmp(mServers3Tmp);
+    const int      localGroup = GetLrcLocalGroup(*fa, chunk->offset);
     for (vector<MetaChunkInfo*>::const_iterator it = cblk.begin();
             it != cblk.end();
             ++it) {
@@ -11139,6 +11459,10 @@ LayoutManager::GetPlacementExcludes(
                     stopIfHasAnyReplicationsInFlight) {
                 return false; // Early termination -- ignore the rest
             }
+            if (0 <= localGroup &&
+                    localGroup == GetLrcLocalGroup(*fa, (*it)->offset)) {
+                placement.ExcludeLocalGroupRack(servers);
+            }
         }
         placement.ExcludeServerAndRack(servers, ce.GetChunkId());
     }
@@ -11259,11 +11583,13 @@ LayoutManager::CanReplicateChunkNow(
             panic("chunk mapping / getalloc mismatch");
             return false;
         }
-        const chunkOff_t end       = start + fa->ChunkBlkSize();
-        int              good      = 0;
-        int              notStable = 0;
-        unsigned int     stripeIdx = 0;
-        bool             holeFlag  = false;
+        const chunkOff_t      end       = start + fa->ChunkBlkSize();
+        int                   good      = 0;
+        int                   notStable = 0;
+        unsigned int          stripeIdx = 0;
+        bool                  holeFlag  = false;
+        ChunkBlockLostStripes lost;
+        memset(lost, 0, sizeof(lost));
         vector<MetaChunkInfo*>::const_iterator it = cblk.begin();
         StTmp<Servers> serversTmp(mServers4Tmp);
         for (chunkOff_t pos = start;
@@ -11301,6 +11627,8 @@ LayoutManager::CanReplicateChunkNow(
             const CSMap::Entry& ce   = GetCsEntry(**it);
             if (mChunkToServerMap.GetConnectedServers(ce, srvs) > 0) {
                 good++;
+            } else {
+                lost[stripeIdx] = 1;
             }
             if (chunkId != curChunkId) {
                 const chunkOff_t kObjStoreBlockPos = -1;
@@ -11311,7 +11639,7 @@ LayoutManager::CanReplicateChunkNow(
             ++it;
         }
         if (notStable > 0 ||
-                (notStable == 0 && good < (int)fa->numStripes)) {
+                (notStable == 0 && ! CanRecoverChunkBlock(*fa, good, lost))) {
             if (! servers.empty()) {
                 // Can not use recovery instead of replication.
                 SetReplicationState(c, CSMap::Entry::kStateNoDestination);
@@ -11833,6 +12161,9 @@ LayoutManager::ChunkReplicationChecker()
         mLastRebalanceRunTime = now;
         RebalanceServers();
     }
+    if (runRebalanceFlag) {
+        TierMigrate();
+    }
     mReplicationTodoStats->Set(mChunkToServerMap.GetCount(
         CSMap::Entry::kStateCheckReplication));
     ScheduleCleanup(mMaxServerCleanupScan);
@@ -12057,6 +12388,7 @@ LayoutManager::Handle(MetaChunkReplicate& req)
     // Replication check is already scheduled by UpdateReplicationState the
     // above. Let the normal path figure out if the any further actions are
     // needed.
+    TierMigrationReplicationDone(req, servers, ci->GetFattr()->numReplicas);
     RemoveRetiring(*ci, servers, ci->GetFattr()->numReplicas);
 }
 
@@ -12758,6 +13090,432 @@ LayoutManager::RebalanceServers()
     }
 }
 
+void
+LayoutManager::UpdateFileHeat(fid_t fid, int64_t now, chunkOff_t allocOffset)
+{
+    if (! mTierMigrationEnabledFlag) {
+        return;
+    }
+    bool             insertedFlag = false;
+    FileHeat::Entry& entry        = mFileHeat.Access(fid, now, insertedFlag);
+    if (0 <= allocOffset) {
+        // The new chunks are placed by the allocation policy, which does not
+        // take the tiers speed into the account, therefore the new file
+        // placement is unknown.
+        if (FileHeat::kPlacementCold == entry.GetPlacement()) {
+            mFileHeat.SetPlacement(entry, FileHeat::kPlacementUnknown);
+        }
+        return;
+    }
+    if (entry.IsMigrating() ||
+            FileHeat::kPlacementHot == entry.GetPlacement() ||
+            mFileHeat.GetHeat(entry, now) < mTierMigrationHotHeat) {
+        return;
+    }
+    StartTierMigration(entry, true);
+}
+
+void
+LayoutManager::StartTierMigration(FileHeat::Entry& entry, bool hotFlag)
+{
+    if (mTierMigrationMaxFiles <= (int)mTierMigrations.size()) {
+        return;
+    }
+    const fid_t fid = entry.GetFid();
+    for (TierMigrations::const_iterator it = mTierMigrations.begin();
+            mTierMigrations.end() != it;
+            ++it) {
+        if (it->mFid == fid) {
+            // Evicted and re-created heat entry.
+            mFileHeat.SetMigrating(entry, true);
+            return;
+        }
+    }
+    const MetaFattr* const fa = metatree.getFattr(fid);
+    if (! fa || KFS_FILE != fa->type) {
+        mFileHeat.Erase(fid);
+        return;
+    }
+    kfsSTier_t minSTier = fa->minSTier;
+    kfsSTier_t maxSTier = fa->maxSTier;
+    if (0 < fa->numReplicas && ! FindStorageTiersRange(minSTier, maxSTier)) {
+        return; // Try again later.
+    }
+    kfsSTier_t fastest = kKfsSTierUndef;
+    kfsSTier_t slowest = kKfsSTierUndef;
+    if (fa->numReplicas <= 0 || minSTier == maxSTier ||
+            ! GetTierMigrationTargets(minSTier, maxSTier, fastest, slowest) ||
+            fastest == slowest) {
+        // Object store files have no chunk replicas to move.
+        mFileHeat.SetPlacement(entry, hotFlag ?
+            FileHeat::kPlacementHot : FileHeat::kPlacementCold);
+        return;
+    }
+    const kfsSTier_t tier = hotFlag ? fastest : slowest;
+    KFS_LOG_STREAM_INFO <<
+        "tier migration start:"
+        " fid: "    << fid <<
+        " heat: "   << mFileHeat.GetHeat(entry, microseconds()) <<
+        " tiers: [" << (int)fa->minSTier <<
+            ","     << (int)fa->maxSTier << "]"
+        " => "      << (int)tier <<
+        " files: "  << mTierMigrations.size() <<
+    KFS_LOG_EOM;
+    mFileHeat.SetMigrating(entry, true);
+    mTierMigrations.push_back(TierMigration(fid, tier, hotFlag));
+}
+
+bool
+LayoutManager::GetTierMigrationTargets(kfsSTier_t minSTier, kfsSTier_t maxSTier,
+    kfsSTier_t& fastest, kfsSTier_t& slowest) const
+{
+    fastest = kKfsSTierUndef;
+    slowest = kKfsSTierUndef;
+    for (TierMigrationTiers::const_iterator it = mTierMigrationTiers.begin();
+            mTierMigrationTiers.end() != it;
+            ++it) {
+        if (*it < minSTier || maxSTier < *it) {
+            continue;
+        }
+        if (kKfsSTierUndef == fastest) {
+            fastest = *it;
+        }
+        slowest = *it;
+    }
+    return (kKfsSTierUndef != fastest);
+}
+
+void
+LayoutManager::TierMigrate()
+{
+    if (! mTierMigrationEnabledFlag || InRecovery()) {
+        return;
+    }
+    const int64_t now = microseconds();
+    if (mTierMigrationBudgetTime < now) {
+        // Token bucket, allow at least one full chunk burst.
+        const int64_t maxBudget =
+            max(mTierMigrationMaxBytesPerSec, (int64_t)CHUNKSIZE);
+        mTierMigrationBudget = (int64_t)min(double(maxBudget),
+            double(mTierMigrationBudget) +
+            double(now - mTierMigrationBudgetTime) * 1e-6 *
+                double(mTierMigrationMaxBytesPerSec));
+        mTierMigrationBudgetTime = now;
+    }
+    // The least recently accessed files are at the candidates list head.
+    FileHeat::Entry* next = mFileHeat.GetFirstCandidate();
+    for (int i = 0;
+            next && i < mTierMigrationMaxScan &&
+                (int)mTierMigrations.size() < mTierMigrationMaxFiles;
+            i++) {
+        FileHeat::Entry& entry = *next;
+        next = mFileHeat.GetNextCandidate(entry);
+        if (mFileHeat.GetHeat(entry, now) <= mTierMigrationColdHeat) {
+            StartTierMigration(entry, false);
+        }
+    }
+    for (size_t i = 0; i < mTierMigrations.size(); ) {
+        TierMigration& migration = mTierMigrations[i];
+        if (! TierMigrationStep(migration)) {
+            i++;
+            continue;
+        }
+        FileHeat::Entry* const entry = mFileHeat.Find(migration.mFid);
+        if (entry) {
+            mFileHeat.SetPlacement(*entry, migration.mHotFlag ?
+                FileHeat::kPlacementHot : FileHeat::kPlacementCold);
+            mFileHeat.SetMigrating(*entry, false);
+        }
+        KFS_LOG_STREAM_INFO <<
+            "tier migration done:"
+            " fid: "    << migration.mFid <<
+            " tier: "   << (int)migration.mTier <<
+            " moved: "  << mTierMigrationReplicasCount <<
+            " failed: " << mTierMigrationFailedCount <<
+        KFS_LOG_EOM;
+        if (i + 1 < mTierMigrations.size()) {
+            swap(migration, mTierMigrations.back());
+        }
+        mTierMigrations.pop_back();
+    }
+}
+
+bool
+LayoutManager::TierMigrationStep(LayoutManager::TierMigration& migration)
+{
+    const MetaFattr* const fa = metatree.getFattr(migration.mFid);
+    if (! fa || KFS_FILE != fa->type) {
+        mFileHeat.Erase(migration.mFid);
+        return true;
+    }
+    if (fa->numReplicas <= 0) {
+        return true;
+    }
+    if (0 <= migration.mChunkId) {
+        if (TierMigration::kStateQuery == migration.mState) {
+            if (0 < migration.mQueriesInFlight) {
+                return false;
+            }
+        } else {
+            // Wait for the replication completion. The source replica is
+            // deleted by TierMigrationReplicationDone() only after the new
+            // replica is added.
+            if (0 < GetInFlightChunkOpsCount(
+                    migration.mChunkId, META_CHUNK_REPLICATE)) {
+                return false;
+            }
+            if (migration.mMovedFlag) {
+                migration.mFailures = 0;
+                mTierMigrationReplicasCount++;
+            } else {
+                migration.mFailures++;
+                mTierMigrationFailedCount++;
+            }
+            // Query the chunk replica tiers again, if any replica remains
+            // outside of the target tier it will be moved next.
+            migration.Reset();
+        }
+    }
+    const ChunkRecoveryInfo        recoveryInfo;
+    StTmp<Servers>                 serversTmp(mServersTmp);
+    StTmp<ChunkPlacement>          placementTmp(mChunkPlacementTmp);
+    StTmp<vector<MetaChunkInfo*> > cinfoTmp(mChunkInfos2Tmp);
+    StTmp<vector<kfsSTier_t> >     tiersTmp(mPlacementTiersTmp);
+    vector<MetaChunkInfo*>&        cinfo = cinfoTmp.Get();
+    Servers&                       srvs  = serversTmp.Get();
+    for (int i = 0; i < mTierMigrationMaxScan; i++) {
+        cinfo.clear();
+        if (metatree.getalloc(migration.mFid, migration.mOffset,
+                cinfo, 1) != 0 || cinfo.empty()) {
+            return true;
+        }
+        const MetaChunkInfo& chunk = *cinfo.front();
+        const chunkId_t      cid   = chunk.chunkId;
+        if (migration.mOffset < chunk.offset) {
+            migration.mOffset   = chunk.offset;
+            migration.mFailures = 0;
+            migration.Reset();
+        }
+        CSMap::Entry* const ce = mChunkToServerMap.Find(cid);
+        if (! ce || mTierMigrationMaxChunkRetries < migration.mFailures ||
+                (0 <= migration.mChunkId && cid != migration.mChunkId)) {
+            if (ce) {
+                KFS_LOG_STREAM_INFO <<
+                    "tier migration:"
+                    " fid: "     << migration.mFid <<
+                    " chunk: "   << cid <<
+                    " retries: " << migration.mFailures <<
+                    " skipped" <<
+                KFS_LOG_EOM;
+            }
+            migration.mOffset   = chunk.offset + (chunkOff_t)CHUNKSIZE;
+            migration.mFailures = 0;
+            migration.Reset();
+            continue;
+        }
+        if (migration.mChunkId < 0) {
+            // Query the storage tiers of all chunk replicas first.
+            if (0 < GetInFlightChunkModificationOpCount(cid)) {
+                // Busy, retry on the next run.
+                migration.mFailures++;
+                return false;
+            }
+            srvs.clear();
+            mChunkToServerMap.GetServers(*ce, srvs);
+            const seq_t chunkVersion = ce->GetChunkInfo()->chunkVersion;
+            for (Servers::const_iterator it = srvs.begin();
+                    srvs.end() != it;
+                    ++it) {
+                if ((*it)->IsDown()) {
+                    continue;
+                }
+                (*it)->GetChunkStorageTier(migration.mFid, cid, chunkVersion);
+                migration.mQueriesInFlight++;
+            }
+            if (migration.mQueriesInFlight <= 0) {
+                migration.mFailures++;
+                return false;
+            }
+            migration.mChunkId = cid;
+            migration.mState   = TierMigration::kStateQuery;
+            return false;
+        }
+        if (mTierMigrationBudget <= 0 ||
+                mRebalanceReplicationsThresholdCount <=
+                    mNumOngoingReplications) {
+            return false;
+        }
+        int             extraReplicas = 0;
+        ChunkPlacement& placement     = placementTmp.Get();
+        if (0 < GetInFlightChunkModificationOpCount(cid) ||
+                ! CanReplicateChunkNow(*ce, extraReplicas, placement) ||
+                0 != extraReplicas) {
+            // Busy, retry on the next run.
+            migration.mFailures++;
+            migration.Reset();
+            return false;
+        }
+        // Use the storage tiers reported by the chunk servers. The replica
+        // with unknown tier, i.e. reported by older chunk server, is moved
+        // only if the server has no target tier devices.
+        srvs.clear();
+        mChunkToServerMap.GetServers(*ce, srvs);
+        ChunkServerPtr src;
+        size_t         inTargetCnt = 0;
+        for (Servers::const_iterator it = srvs.begin();
+                srvs.end() != it;
+                ++it) {
+            ChunkServer&                               srv  = **it;
+            TierMigration::ReplicaTiers::const_iterator rit;
+            for (rit = migration.mReplicaTiers.begin();
+                    migration.mReplicaTiers.end() != rit &&
+                        rit->first != *it;
+                    ++rit)
+                {}
+            const kfsSTier_t tier = migration.mReplicaTiers.end() != rit ?
+                rit->second : kKfsSTierUndef;
+            if (tier == migration.mTier || (kKfsSTierUndef == tier &&
+                    0 < srv.GetDeviceCount(migration.mTier))) {
+                inTargetCnt++;
+                continue;
+            }
+            if (! src && ! srv.IsDown() && ! srv.IsHibernatingOrRetiring() &&
+                    ! srv.IsEvacuationScheduled(cid) &&
+                    srv.IsResponsiveServer()) {
+                src = *it;
+            }
+        }
+        if (srvs.size() <= inTargetCnt) {
+            migration.mOffset   = chunk.offset + (chunkOff_t)CHUNKSIZE;
+            migration.mFailures = 0;
+            migration.Reset();
+            continue;
+        }
+        if (! src) {
+            migration.mFailures++;
+            migration.Reset();
+            return false;
+        }
+        // Replace the source replica, thus the source rack can be used.
+        placement.clear();
+        const bool kIncludeThisChunkFlag = false;
+        GetPlacementExcludes(*ce, placement, kIncludeThisChunkFlag);
+        for (Servers::const_iterator it = srvs.begin();
+                srvs.end() != it;
+                ++it) {
+            if (*it != src) {
+                placement.ExcludeServerAndRack(*it, cid);
+            }
+        }
+        placement.ExcludeServer(src);
+        if (1 < fa->numReplicas &&
+                mRacks.size() <= placement.GetExcludedRacksCount()) {
+            placement.clear();
+            placement.ExcludeServer(srvs);
+        }
+        placement.FindCandidatesForReplication(
+            migration.mTier, migration.mTier);
+        ChunkServerPtr dst;
+        for (; ;) {
+            while ((dst = placement.GetNext(false)) &&
+                    mChunkToServerMap.HasServer(dst, *ce))
+                {}
+            if (dst || placement.IsLastAttempt() || ! placement.NextRack()) {
+                break;
+            }
+        }
+        if (! dst) {
+            migration.mFailures++;
+            migration.Reset();
+            return false;
+        }
+        vector<kfsSTier_t>& tiers = tiersTmp.Get();
+        tiers.assign(1, migration.mTier);
+        srvs.assign(1, dst);
+        if (ReplicateChunk(*ce, 1, srvs, recoveryInfo, tiers, migration.mTier,
+                migration.mHotFlag ? "tier migration: hot" :
+                    "tier migration: cold") <= 0) {
+            migration.mFailures++;
+            migration.Reset();
+            return false;
+        }
+        // The source replica is deleted once the destination replica
+        // is added, see TierMigrationReplicationDone().
+        migration.mState = TierMigration::kStateReplicate;
+        migration.mSrc   = src;
+        migration.mDst   = dst;
+        mTierMigrationBudget -= fa->IsStriped() ? (int64_t)CHUNKSIZE :
+            max(int64_t(1), min((int64_t)CHUNKSIZE,
+                (int64_t)(fa->filesize - chunk.offset)));
+        return false;
+    }
+    return false;
+}
+
+LayoutManager::TierMigration*
+LayoutManager::FindTierMigration(
+    chunkId_t chunkId, LayoutManager::TierMigration::State state)
+{
+    for (TierMigrations::iterator it = mTierMigrations.begin();
+            mTierMigrations.end() != it;
+            ++it) {
+        if (chunkId == it->mChunkId && state == it->mState) {
+            return &*it;
+        }
+    }
+    return 0;
+}
+
+void
+LayoutManager::Handle(MetaChunkStorageTier& req)
+{
+    TierMigration* const migration =
+        FindTierMigration(req.chunkId, TierMigration::kStateQuery);
+    if (! migration || migration->mQueriesInFlight <= 0) {
+        return;
+    }
+    KFS_LOG_STREAM(0 == req.status ?
+            MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelINFO) <<
+        "tier migration: " << req.Show() <<
+        " status: "        << req.status <<
+        " "                << req.statusMsg <<
+    KFS_LOG_EOM;
+    migration->mReplicaTiers.push_back(make_pair(req.server,
+        0 == req.status ? req.storageTier : kKfsSTierUndef));
+    migration->mQueriesInFlight--;
+}
+
+void
+LayoutManager::TierMigrationReplicationDone(
+    const MetaChunkReplicate& req, LayoutManager::Servers& servers,
+    int numReplicas)
+{
+    TierMigration* const migration =
+        FindTierMigration(req.chunkId, TierMigration::kStateReplicate);
+    if (! migration || migration->mDst != req.server) {
+        return;
+    }
+    if (kKfsSTierUndef != req.storageTier &&
+            req.storageTier != migration->mTier) {
+        // Let the normal over replication handling remove the extra replica.
+        KFS_LOG_STREAM_INFO <<
+            "tier migration: " << req.Show() <<
+            " replica tier: "  << (int)req.storageTier <<
+            " expected: "      << (int)migration->mTier <<
+        KFS_LOG_EOM;
+        return;
+    }
+    Servers::iterator const it =
+        find(servers.begin(), servers.end(), migration->mSrc);
+    if (servers.end() == it || migration->mSrc->IsDown() ||
+            (int)servers.size() <= numReplicas) {
+        return;
+    }
+    migration->mMovedFlag = true;
+    migration->mSrc->DeleteChunk(req.chunkId);
+    servers.erase(it);
+}
+
 int
 LayoutManager::LoadRebalancePlan(const string& planFn)
 {
@@ -42,6 +42,7 @@
 #include "ChunkPlacement.h"
 #include "AuthContext.h"
 #include "IdempotentRequestTracker.h"
+#include "FileHeat.h"
 
 #include "common/Properties.h"
 #include "common/StdAllocator.h"
@@ -337,6 +338,8 @@ public:
         fid_t fid) const;
     inline bool IsDeletePending(
         fid_t fid) const;
+    inline bool HasWriteLeaseInSubTree(
+        fid_t dir);
     inline int Handle(
         MetaRemoveFromDumpster& op,
         int                     maxInFlightEntriesCount);
@@ -1124,6 +1127,7 @@ public:
     void CancelPendingMakeStable(fid_t fid, chunkId_t chunkId);
     bool Start(MetaChunkSize& req);
     void Handle(MetaChunkSize& req);
+    void Handle(MetaChunkStorageTier& req);
     bool IsChunkStable(chunkId_t chunkId) const;
     const char* AddNotStableChunk(
         const ChunkServerPtr& server,
@@ -1464,6 +1468,8 @@ public:
         { return mIdempotentRequestTracker; }
     void ScheduleDumpsterCleanup(const MetaFattr& fa, const string& name);
     void Handle(MetaRemoveFromDumpster& op);
+    void ScheduleDumpsterDirCleanup(const MetaFattr& fa, const string& name);
+    void Handle(MetaRemoveDirFromDumpster& op);
     void SetPrimary(bool flag);
     bool IsPrimary() const
         { return mPrimaryFlag; }
@@ -2274,6 +2280,34 @@ protected:
     bool   mAssignMasterByIpFlag;
     int    mLeaseOwnerDownExpireDelay;
     int    mMaxDumpsterCleanupInFlight;
+    // Recursively removed directories in the dumpster, with their content
+    // removed in batches, one batch at a time. The directory with failed
+    // batch is moved to the end of the queue.
+    struct DumpsterDir
+    {
+        DumpsterDir(
+            fid_t         fid  = -1,
+            const string& name = string(),
+            time_t        time = 0)
+            : mFid(fid),
+              mName(name),
+              mTime(time),
+              mFailures(0)
+            {}
+        fid_t  mFid;
+        string mName;
+        time_t mTime;
+        int    mFailures;
+    };
+    typedef deque<DumpsterDir> DumpsterDirs;
+    typedef set<fid_t>         DumpsterDirIds;
+    DumpsterDirs   mDumpsterDirs;
+    DumpsterDirIds mDumpsterDirIds;
+    bool           mDumpsterDirCleanupInFlightFlag;
+    int64_t        mDumpsterDirCleanupMaxEntries;
+    int            mDumpsterDirCleanupMaxRetries;
+    int64_t        mDumpsterDirFilesRemovedCount;
+    int64_t        mDumpsterDirsRemovedCount;
     int    mMaxTruncateChunksDeleteCount;
     int    mMaxTruncateChunksQueueCount;
     int    mMaxTruncatedChunkDeletesInFlight;
@@ -2356,6 +2390,85 @@ protected:
     bool          mCleanupScheduledFlag;
     bool          mPrimaryFlag;
 
+    // Storage tier migration. Files that become "hot" are moved into the
+    // fastest storage tier of the file tiers range, and files that become
+    // "cold" into the slowest one, one chunk replica at a time. The tiers
+    // speed order is configured, the tier number does not imply its speed.
+    // For each chunk the replicas storage tiers are queried from the chunk
+    // servers. Then the chunk is replicated into the target tier, and the
+    // source replica is deleted once the chunk server reports the new replica
+    // in the target tier, thus the chunk redundancy is never reduced.
+    struct TierMigration
+    {
+        enum State
+        {
+            kStateNone      = 0,
+            kStateQuery     = 1,
+            kStateReplicate = 2
+        };
+        typedef vector<pair<ChunkServerPtr, kfsSTier_t> > ReplicaTiers;
+
+        TierMigration(
+            fid_t      fid     = -1,
+            kfsSTier_t tier    = kKfsSTierUndef,
+            bool       hotFlag = false)
+            : mFid(fid),
+              mTier(tier),
+              mHotFlag(hotFlag),
+              mOffset(0),
+              mChunkId(-1),
+              mState(kStateNone),
+              mQueriesInFlight(0),
+              mReplicaTiers(),
+              mSrc(),
+              mDst(),
+              mMovedFlag(false),
+              mFailures(0)
+            {}
+        void Reset()
+        {
+            mChunkId         = -1;
+            mState           = kStateNone;
+            mQueriesInFlight = 0;
+            mReplicaTiers.clear();
+            mSrc.reset();
+            mDst.reset();
+            mMovedFlag       = false;
+        }
+        fid_t          mFid;
+        kfsSTier_t     mTier;
+        bool           mHotFlag;
+        chunkOff_t     mOffset;
+        // Chunk tiers query or replica move in flight, if chunk id is not
+        // negative.
+        chunkId_t      mChunkId;
+        State          mState;
+        int            mQueriesInFlight;
+        // Replica storage tiers reported by the chunk servers.
+        ReplicaTiers   mReplicaTiers;
+        ChunkServerPtr mSrc;
+        ChunkServerPtr mDst;
+        bool           mMovedFlag;
+        int            mFailures;
+    };
+    typedef vector<TierMigration> TierMigrations;
+    typedef vector<kfsSTier_t>    TierMigrationTiers;
+    bool               mTierMigrationEnabledFlag;
+    double             mTierMigrationHotHeat;
+    double             mTierMigrationColdHeat;
+    int64_t            mTierMigrationMaxBytesPerSec;
+    int64_t            mTierMigrationBudget;
+    int64_t            mTierMigrationBudgetTime;
+    int                mTierMigrationMaxFiles;
+    int                mTierMigrationMaxScan;
+    int                mTierMigrationMaxChunkRetries;
+    int64_t            mTierMigrationReplicasCount;
+    int64_t            mTierMigrationFailedCount;
+    // Configured storage tiers, from the fastest to the slowest.
+    TierMigrationTiers mTierMigrationTiers;
+    FileHeat           mFileHeat;
+    TierMigrations     mTierMigrations;
+
     int                mCSCountersUpdateInterval;
     time_t             mCSCountersUpdateTime;
     IOBuffer           mCSCountersResponse;
@@ -2655,6 +2768,23 @@ protected:
     /// "over utilized" servers to "under utilized" servers.
     void RebalanceServers();
     void UpdateReplicationsThreshold();
+    /// Update file access heat, and start "hot" file migration into the
+    /// faster storage tier if needed. Non negative allocation offset means
+    /// that the access is chunk allocation.
+    void UpdateFileHeat(fid_t fid, int64_t now, chunkOff_t allocOffset = -1);
+    void StartTierMigration(FileHeat::Entry& entry, bool hotFlag);
+    void TierMigrate();
+    /// Returns true if the file migration is complete.
+    bool TierMigrationStep(TierMigration& migration);
+    /// Returns false if the file tiers range has no configured tiers.
+    bool GetTierMigrationTargets(kfsSTier_t minSTier, kfsSTier_t maxSTier,
+        kfsSTier_t& fastest, kfsSTier_t& slowest) const;
+    TierMigration* FindTierMigration(chunkId_t chunkId,
+        TierMigration::State state);
+    /// Deletes the source replica once the tier migration replication into
+    /// the target tier is done.
+    void TierMigrationReplicationDone(const MetaChunkReplicate& req,
+        Servers& servers, int numReplicas);
 
     /// For a time period that corresponds to the length of a lease interval,
     /// we are in recovery after a restart.
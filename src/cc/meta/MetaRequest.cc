@@ -60,6 +60,7 @@
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
+#include <fnmatch.h>
 
 #include <map>
 #include <iomanip>
@@ -212,6 +213,10 @@ OkHeader(const MetaRequest* op, ReqOstream &os, bool checkStatus = true)
             "OK\r\n"
             "Cseq: ") << op->opSeqno
     ;
+    if (op->binaryRpcFlag && op->shortRpcFormatFlag) {
+        // Let the client know that binary rpc frames are accepted.
+        os << "\r\nBR:1";
+    }
     if (op->status == 0 && op->statusMsg.empty()) {
         os << (op->shortRpcFormatFlag ?
             "\r\n"
@@ -1183,7 +1188,9 @@ MetaRmdir::handle()
     if ((status = LookupAbsPath(dir, name, euser, egroup)) != 0) {
         return;
     }
-    status = metatree.rmdir(dir, name, pathname, euser, egroup, mtime);
+    status = recursiveFlag ?
+        metatree.rmdirs(dir, name, pathname, euser, egroup, mtime) :
+        metatree.rmdir(dir, name, pathname, euser, egroup, mtime);
 }
 
 static vector<MetaDentry*>&
@@ -1746,6 +1753,43 @@ MetaReaddirPlus::~MetaReaddirPlus()
     }
 }
 
+bool
+MetaReaddirPlus::Validate()
+{
+    if (dir < 0) {
+        return false;
+    }
+    // Limit name pattern length and the number of wildcards, in order to
+    // bound fnmatch() backtracking cost per directory entry.
+    const size_t kMaxNamePatternLength    = 256;
+    const size_t kMaxNamePatternWildcards = 8;
+    if (kMaxNamePatternLength < namePattern.size() ||
+            kMaxNamePatternWildcards < (size_t)count(
+                namePattern.begin(), namePattern.end(), '*')) {
+        status    = -EINVAL;
+        statusMsg = "name pattern exceeds length or wildcard count limit";
+    }
+    return true;
+}
+
+bool
+MetaReaddirPlus::Matches(const MetaFattr& fa, const string& name) const
+{
+    if (! namePattern.empty() && fnmatch(namePattern.c_str(), name.c_str(),
+            (matchPeriodFlag ? FNM_PERIOD : 0) |
+            (matchNoEscapeFlag ? FNM_NOESCAPE : 0)) != 0) {
+        return false;
+    }
+    if (noAttrsFlag) {
+        // Do not disclose attributes, without search permission.
+        return true;
+    }
+    if (KFS_DIR == fa.type) {
+        return true;
+    }
+    return (! dirsOnlyFlag && (minMtime < 0 || minMtime <= fa.mtime));
+}
+
 /* virtual */ void
 MetaReaddirPlus::handle()
 {
@@ -1761,6 +1805,7 @@ MetaReaddirPlus::handle()
     }
     dentries.clear();
     lastChunkInfos.clear();
+    fnameNext.clear();
     if (ioBufPending > 0) {
         gLayoutManager.ChangeIoBufPending(-ioBufPending);
     }
@@ -1817,6 +1862,7 @@ MetaReaddirPlus::handle()
     const size_t avgChunkInfoSize = avgEntrySz[idx++];
     const size_t avgLocationSize  = 22;
     size_t responseSize = 0;
+    const bool filterFlag = HasFilter();
     vector<MetaDentry*>::const_iterator it;
     for (it = res.begin();
             it != res.end() && responseSize <= maxSize;
@@ -1831,6 +1877,9 @@ MetaReaddirPlus::handle()
         if (fa->id() == ROOTFID && name == "/") {
             continue;
         }
+        if (filterFlag && ! Matches(*fa, name)) {
+            continue;
+        }
         responseSize += name.length() + (fa->type == KFS_DIR ?
             avgDirExtraSize : avgFileExtraSize);
         dentries.push_back(DEntry(*fa, name));
@@ -1882,6 +1931,9 @@ MetaReaddirPlus::handle()
             hasMoreEntriesFlag = true;
         }
     }
+    if (filterFlag && hasMoreEntriesFlag && it != res.begin()) {
+        fnameNext = (*(it - 1))->getName();
+    }
     ioBufPending = (int64_t)responseSize;
     if (ioBufPending > 0) {
         gLayoutManager.ChangeIoBufPending(ioBufPending);
@@ -4713,7 +4765,11 @@ MetaReaddirPlus::response(ReqOstream& os, IOBuffer& buf)
         entryCount = writer.Write(dentries, lastChunkInfos,
             noAttrsFlag, GetUserAndGroupNames(*this));
     }
-    hasMoreEntriesFlag = hasMoreEntriesFlag || entryCount < dentries.size();
+    if (entryCount < dentries.size()) {
+        // Resume from the last returned entry.
+        hasMoreEntriesFlag = true;
+        fnameNext.clear();
+    }
     dentries.clear();
     lastChunkInfos.clear();
     if (ioBufPending > 0) {
@@ -4731,7 +4787,12 @@ MetaReaddirPlus::response(ReqOstream& os, IOBuffer& buf)
         (shortRpcFormatFlag ? "EC:" : "Num-Entries: ")
             << entryCount << "\r\n" <<
         (shortRpcFormatFlag ? "EM:" : "Has-more-entries: ") <<
-            (hasMoreEntriesFlag ? 1 : 0) << "\r\n" <<
+            (hasMoreEntriesFlag ? 1 : 0) << "\r\n";
+    if (hasMoreEntriesFlag && ! fnameNext.empty()) {
+        os << (shortRpcFormatFlag ? "FN:" : "Fname-next: ") <<
+            fnameNext << "\r\n";
+    }
+    os <<
         (shortRpcFormatFlag ? "l:" : "Content-length: ")
             << resp.BytesConsumable() << "\r\n"
     "\r\n";
@@ -6048,6 +6109,8 @@ void
 MetaChunkReplicate::handleReply(const Properties& prop)
 {
     if (status == 0) {
+        storageTier = (kfsSTier_t)prop.getValue(
+            shortRpcFormatFlag ? "ST" : "Storage-tier", (int)kKfsSTierUndef);
         const seq_t cVers = prop.getValue(
             shortRpcFormatFlag ? "V" : "Chunk-version", seq_t(0));
         if (numRecoveryStripes <= 0) {
@@ -6118,6 +6181,32 @@ MetaChunkSize::request(ReqOstream& os)
     "\r\n";
 }
 
+void
+MetaChunkStorageTier::request(ReqOstream& os)
+{
+    if (shortRpcFormatFlag) {
+        os << hex;
+    }
+    os <<
+    "SIZE \r\n" <<
+    (shortRpcFormatFlag ? "c:" : "Cseq: ") << opSeqno << "\r\n";
+    if (! shortRpcFormatFlag) {
+        os << "Version: KFS/1.0\r\n";
+    }
+    os <<
+    (shortRpcFormatFlag ? "P:" : "File-handle: ")   << fid     << "\r\n" <<
+    (shortRpcFormatFlag ? "V:" : "Chunk-version: ") <<
+        replicaVersion << "\r\n" <<
+    (shortRpcFormatFlag ? "H:" : "Chunk-handle: ")  << chunkId << "\r\n"
+    "\r\n";
+}
+
+/* virtual */ void
+MetaChunkStorageTier::handle()
+{
+    gLayoutManager.Handle(*this);
+}
+
 void
 MetaChunkSetProperties::request(ReqOstream& os)
 {
@@ -6319,6 +6408,32 @@ MetaRemoveFromDumpster::handle()
     gLayoutManager.Handle(*this);
 }
 
+bool
+MetaRemoveDirFromDumpster::start()
+{
+    MetaFattr* fa = 0;
+    if (metatree.lookup(metatree.getDumpsterDirId(), name,
+                kKfsUserRoot, kKfsGroupRoot, fa) != 0 ||
+            KFS_DIR != fa->type || fa->id() != fid) {
+        statusMsg = "no such dumpster directory";
+        status    = -ENOENT;
+        return false;
+    }
+    mtime = microseconds();
+    return true;
+}
+
+void
+MetaRemoveDirFromDumpster::handle()
+{
+    if (status == 0) {
+        status = metatree.removeDirFromDumpster(fid, name, mtime,
+            entriesCount, filesCount, dirsCount, chunksCount,
+            cleanupDoneFlag);
+    }
+    gLayoutManager.Handle(*this);
+}
+
 bool
 MetaLogClearObjStoreDelete::start()
 {
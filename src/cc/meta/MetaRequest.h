@@ -160,6 +160,7 @@ using std::less;
     f(SET_GROUP_USERS) \
     f(ACK) \
     f(REMOVE_FROM_DUMPSTER) \
+    f(REMOVE_DIR_FROM_DUMPSTER) \
     f(LOG_CHUNK_ALLOCATE) \
     f(LOG_WRITER_CONTROL) \
     f(LOG_CLEAR_OBJ_STORE_DELETE) \
@@ -179,7 +180,8 @@ using std::less;
     f(VR_RECONFIGURATION) \
     f(VR_LOG_START_VIEW) \
     f(VR_GET_STATUS) \
-    f(SETATIME)
+    f(SETATIME) \
+    f(CHUNK_STORAGE_TIER) /* Ask chunkserver for chunk replica storage tier */
 
 enum MetaOp {
 #define KfsMakeMetaOpEnumEntry(name) META_##name,
@@ -282,6 +284,7 @@ struct MetaRequest {
     bool            replayFlag;
     bool            commitPendingFlag;
     bool            replayBypassFlag;
+    bool            binaryRpcFlag;   //!< client can send binary rpc frames
     string          clientIp;
     string          clientReportedIp;
     IOBuffer        reqHeaders;
@@ -315,6 +318,7 @@ struct MetaRequest {
           replayFlag(false),
           commitPendingFlag(false),
           replayBypassFlag(false),
+          binaryRpcFlag(false),
           clientIp(),
           reqHeaders(),
           authUid(kKfsUserNone),
@@ -372,6 +376,7 @@ struct MetaRequest {
         .Def2("UserId",                  "u", &MetaRequest::euser,          kKfsUserNone)
         .Def2("GroupId",                 "g", &MetaRequest::egroup,        kKfsGroupNone)
         .Def2("Max-wait-ms",             "w", &MetaRequest::maxWaitMillisec, int64_t(-1))
+        .Def2("Binary-rpc",             "BR", &MetaRequest::binaryRpcFlag,         false)
         ;
     }
     template<typename T> static T& IoParserDef(T& parser)
@@ -950,12 +955,14 @@ struct MetaRmdir: public MetaIdempotentRequest {
     string  name;     //!< name to remove
     string  pathname; //!< full pathname to remove
     int64_t mtime;
+    bool    recursiveFlag; //!< remove non empty directory sub tree
     MetaRmdir()
         : MetaIdempotentRequest(META_RMDIR, kLogIfOk),
           dir(-1),
           name(),
           pathname(),
-          mtime()
+          mtime(),
+          recursiveFlag(false)
         {}
     virtual bool start();
     virtual void handle();
@@ -966,7 +973,8 @@ struct MetaRmdir: public MetaIdempotentRequest {
             "rmdir:"
             " path: "   << pathname <<
             " name: "   << name <<
-            " parent: " << dir
+            " parent: " << dir <<
+            (recursiveFlag ? " recursive" : "")
         ;
     }
     bool Validate()
@@ -979,6 +987,7 @@ struct MetaRmdir: public MetaIdempotentRequest {
         .Def2("Parent File-handle", "P",  &MetaRmdir::dir, fid_t(-1))
         .Def2("Directory",          "N",  &MetaRmdir::name          )
         .Def2("Pathname",           "PN", &MetaRmdir::pathname      )
+        .Def2("Recursive",          "R",  &MetaRmdir::recursiveFlag, false)
         ;
     }
     template<typename T> static T& IoParserDef(T& parser)
@@ -987,6 +996,7 @@ struct MetaRmdir: public MetaIdempotentRequest {
         return MetaIdempotentRequest::IoParserDef(parser)
         .Def("P", &MetaRmdir::dir, fid_t(-1))
         .Def("N", &MetaRmdir::name)
+        .Def("R", &MetaRmdir::recursiveFlag, false)
         ;
     }
     template<typename T> static T& LogIoDef(T& parser)
@@ -995,6 +1005,7 @@ struct MetaRmdir: public MetaIdempotentRequest {
         .Def("P", &MetaRmdir::dir, fid_t(-1))
         .Def("N", &MetaRmdir::name)
         .Def("T", &MetaRmdir::mtime)
+        .Def("R", &MetaRmdir::recursiveFlag, false)
         ;
     }
 };
@@ -1102,6 +1113,17 @@ struct MetaReaddirPlus: public MetaRequest {
     bool     noAttrsFlag;
     int64_t  ioBufPending;
     string   fnameStart;
+    // Optional entries filter: fnmatch() name pattern, directories only, and
+    // files min. modification time. Directories are not filtered by time in
+    // order to allow to traverse the directory tree. With the filter,
+    // fnameNext is the name of the last scanned entry, to resume the listing
+    // from, as the last returned entry might precede it.
+    string   namePattern;
+    bool     matchPeriodFlag;
+    bool     matchNoEscapeFlag;
+    bool     dirsOnlyFlag;
+    int64_t  minMtime;
+    string   fnameNext;
     DEntries dentries;
     CInfos   lastChunkInfos;
 
@@ -1118,20 +1140,26 @@ struct MetaReaddirPlus: public MetaRequest {
           noAttrsFlag(false),
           ioBufPending(0),
           fnameStart(),
+          namePattern(),
+          matchPeriodFlag(false),
+          matchNoEscapeFlag(false),
+          dirsOnlyFlag(false),
+          minMtime(-1),
+          fnameNext(),
           dentries(),
           lastChunkInfos()
         {}
     ~MetaReaddirPlus();
+    bool HasFilter() const
+        { return (! namePattern.empty() || dirsOnlyFlag || 0 <= minMtime); }
+    bool Matches(const MetaFattr& fa, const string& name) const;
     virtual void handle();
     virtual void response(ReqOstream& os, IOBuffer& buf);
     virtual ostream& ShowSelf(ostream& os) const
     {
         return os << "readdir plus: dir: " << dir;
     }
-    bool Validate()
-    {
-        return (dir >= 0);
-    }
+    bool Validate();
     template<typename T> static T& ParserDef(T& parser)
     {
         return MetaRequest::ParserDef(parser)
@@ -1144,6 +1172,13 @@ struct MetaReaddirPlus: public MetaRequest {
             &MetaReaddirPlus::omitLastChunkInfoFlag, false)
         .Def2("FidT-only", "F",
             &MetaReaddirPlus::fileIdAndTypeOnlyFlag, false)
+        .Def2("Name-pattern", "NP", &MetaReaddirPlus::namePattern)
+        .Def2("Match-period", "PD",
+            &MetaReaddirPlus::matchPeriodFlag, false)
+        .Def2("Match-noescape", "NE",
+            &MetaReaddirPlus::matchNoEscapeFlag, false)
+        .Def2("Dirs-only", "DO", &MetaReaddirPlus::dirsOnlyFlag, false)
+        .Def2("Min-mtime", "MT", &MetaReaddirPlus::minMtime, int64_t(-1))
         ;
     }
 };
@@ -1958,6 +1993,7 @@ struct MetaHello : public MetaRequest, public ServerLocation {
     int                contentLength;            //!< Length of the message body
     int64_t            numAppendsWithWid;
     int                contentIntBase;
+    int                contentFormat;            //!< 0 text, 1 delta varint
     ChunkInfos         chunks;                   //!< Chunks  hosted on this server
     ChunkInfos         notStableChunks;
     ChunkInfos         notStableAppendChunks;
@@ -2012,6 +2048,7 @@ struct MetaHello : public MetaRequest, public ServerLocation {
           contentLength(0),
           numAppendsWithWid(0),
           contentIntBase(10),
+          contentFormat(0),
           chunks(),
           notStableChunks(),
           notStableAppendChunks(),
@@ -2064,7 +2101,8 @@ struct MetaHello : public MetaRequest, public ServerLocation {
     bool Validate()
     {
         return (ServerLocation::IsValid() &&
-            (contentIntBase == 10 || contentIntBase == 16));
+            (contentIntBase == 10 || contentIntBase == 16) &&
+            (contentFormat == 0 || (contentFormat == 1 && noFidsFlag)));
     }
     template<typename T> static T& ParserDef(T& parser)
     {
@@ -2085,6 +2123,7 @@ struct MetaHello : public MetaRequest, public ServerLocation {
         .Def2("Num-appends-with-wids",        "AW", &MetaHello::numAppendsWithWid,    int64_t(0))
         .Def2("Content-length",               "l",  &MetaHello::contentLength,            int(0))
         .Def2("Content-int-base",             "IB", &MetaHello::contentIntBase,          int(10))
+        .Def2("Content-fmt",                  "CF", &MetaHello::contentFormat,            int(0))
         .Def2("Stale-chunks-hex-format",      "SX", &MetaHello::staleChunksHexFormatFlag,  false)
         .Def2("CKeyId",                       "KI", &MetaHello::cryptoKeyId)
         .Def2("CKey",                       "CKey", &MetaHello::cryptoKey)
@@ -2614,6 +2653,7 @@ struct MetaChunkReplicate: public MetaChunkRequest {
     InvalidStripes                      invalidStripes;
     kfsSTier_t                          minSTier;
     kfsSTier_t                          maxSTier;
+    kfsSTier_t                          storageTier; //!< output: replica tier
     TokenSeq                            tokenSeq;
     bool                                clientCSAllowClearTextFlag;
     bool                                longRpcFormatFlag;
@@ -2642,6 +2682,7 @@ struct MetaChunkReplicate: public MetaChunkRequest {
           invalidStripes(),
           minSTier(minTier),
           maxSTier(maxTier),
+          storageTier(kKfsSTierUndef),
           tokenSeq(),
           clientCSAllowClearTextFlag(false),
           longRpcFormatFlag(false),
@@ -2777,6 +2818,46 @@ struct MetaChunkSize: public MetaChunkRequest {
     }
 };
 
+/*!
+ * \brief Chunk replica storage tier query RPC from meta server to chunk server.
+ * Uses chunk server's SIZE command. The query does not change chunk state, and
+ * is not logged, therefore the chunk version is passed in the separate field:
+ * the chunk requests with valid chunk version are logged "in flight".
+ */
+struct MetaChunkStorageTier: public MetaChunkRequest {
+    const fid_t  fid;
+    const seq_t  replicaVersion;
+    kfsSTier_t   storageTier; //!< output: replica storage tier
+    MetaChunkStorageTier(
+            seq_t                 n,
+            const ChunkServerPtr& s,
+            fid_t                 f,
+            chunkId_t             c,
+            seq_t                 v)
+        : MetaChunkRequest(META_CHUNK_STORAGE_TIER, n, kLogNever, s, c),
+          fid(f),
+          replicaVersion(v),
+          storageTier(kKfsSTierUndef)
+        { chunkVersion = -1; }
+    virtual void handle();
+    virtual void request(ReqOstream &os);
+    virtual void handleReply(const Properties& prop)
+    {
+        storageTier = (kfsSTier_t)prop.getValue(
+            shortRpcFormatFlag ? "ST" : "Storage-tier", (int)kKfsSTierUndef);
+    }
+    virtual ostream& ShowSelf(ostream& os) const
+    {
+        return os <<
+            "get-storage-tier:"
+            " fid: "     << fid <<
+            " chunk: "   << chunkId <<
+            " version: " << replicaVersion <<
+            " tier: "    << (int)storageTier
+        ;
+    }
+};
+
 /*!
  * \brief Heartbeat RPC from meta server to chunk server.  We can
  * ask the chunk server for lots of stuff; for now, we ask it
@@ -4359,6 +4440,61 @@ struct MetaRemoveFromDumpster : public MetaRequest {
     }
 };
 
+/*!
+ * \brief remove up to entries count files, chunks, and sub directories of the
+ * recursively removed directory moved into the dumpster, and the directory
+ * itself once it becomes empty.
+ */
+struct MetaRemoveDirFromDumpster : public MetaRequest {
+    string  name;
+    fid_t   fid;
+    int64_t mtime;
+    int64_t entriesCount;
+    bool    cleanupDoneFlag;
+    int64_t filesCount;
+    int64_t dirsCount;
+    int64_t chunksCount;
+
+    MetaRemoveDirFromDumpster(
+        const string& nm    = string(),
+        fid_t         id    = -1,
+        int64_t       count = -1)
+        : MetaRequest(META_REMOVE_DIR_FROM_DUMPSTER, kLogIfOk),
+          name(nm),
+          fid(id),
+          mtime(),
+          entriesCount(count),
+          cleanupDoneFlag(false),
+          filesCount(0),
+          dirsCount(0),
+          chunksCount(0)
+        {}
+    bool Validate()
+        { return (0 <= fid && ! name.empty()); }
+    virtual bool start();
+    virtual void handle();
+    virtual ostream& ShowSelf(ostream& os) const
+    {
+        return os <<
+            "remove-dir-from-dumpster: " << name <<
+            " fid: "                     << fid <<
+            " entries: "                 << entriesCount <<
+            " files: "                   << filesCount <<
+            " dirs: "                    << dirsCount <<
+            " chunks: "                  << chunksCount <<
+            " done: "                    << cleanupDoneFlag;
+    }
+    template<typename T> static T& LogIoDef(T& parser)
+    {
+        return MetaRequest::LogIoDef(parser)
+        .Def("N", &MetaRemoveDirFromDumpster::name)
+        .Def("P", &MetaRemoveDirFromDumpster::fid, fid_t(-1))
+        .Def("T", &MetaRemoveDirFromDumpster::mtime)
+        .Def("C", &MetaRemoveDirFromDumpster::entriesCount, int64_t(-1))
+        ;
+    }
+};
+
 struct MetaLogWriterControl : public MetaRequest {
     enum { kMaxBlockTrailerLen = 255 };
     enum Type
@@ -31,6 +31,7 @@
 #include "util.h"
 
 #include "common/RequestParser.h"
+#include "common/BinaryRpc.h"
 #include "common/CIdChecksum.h"
 #include "kfsio/NetManager.h"
 #include "kfsio/Globals.h"
@@ -873,6 +874,9 @@ MakeLogMetaRequestHandler(
     .MakeParser("XD",
         META_REMOVE_FROM_DUMPSTER,
         static_cast<const MetaRemoveFromDumpster*>(0))
+    .MakeParser("XR",
+        META_REMOVE_DIR_FROM_DUMPSTER,
+        static_cast<const MetaRemoveDirFromDumpster*>(0))
     .MakeParser("LA",
         META_LOG_CHUNK_ALLOCATE,
         static_cast<const MetaLogChunkAllocate*>(0))
@@ -1081,10 +1085,19 @@ ParseCommand(const IOBuffer& ioBuf, int len, MetaRequest **res,
     const char* const buf    = ioBuf.CopyOutOrGetBufPtr(
         threadParseBuffer ? threadParseBuffer : sTempBuf, reqLen);
     assert(reqLen == len);
-    *res = (reqLen == len) ? (shortRpcFmtFlag ?
+    if (reqLen != len) {
+        return -1;
+    }
+    if (BinaryRpc::IsFrame(buf, reqLen)) {
+        // Binary frames use short field names, and require short response
+        // format.
+        *res = shortRpcFmtFlag ?
+            sMetaRequestHandlerShortFmt.HandleBinary(buf, reqLen) : 0;
+        return (*res ? 0 : -1);
+    }
+    *res = shortRpcFmtFlag ?
         sMetaRequestHandlerShortFmt.Handle(buf, reqLen) :
-        sMetaRequestHandler.Handle(buf, reqLen)) :
-        0;
+        sMetaRequestHandler.Handle(buf, reqLen);
     return (*res ? 0 : -1);
 }
 
@@ -1100,10 +1113,19 @@ ParseFirstCommand(const IOBuffer& ioBuf, int len, MetaRequest **res,
     const char* const buf    = ioBuf.CopyOutOrGetBufPtr(
         threadParseBuffer ? threadParseBuffer : sTempBuf, reqLen);
     assert(reqLen == len);
-    *res = (reqLen == len) ? (shortRpcFmtFlag ?
+    if (reqLen != len) {
+        return -1;
+    }
+    if (BinaryRpc::IsFrame(buf, reqLen)) {
+        if (! (*res = sMetaRequestHandlerShortFmt.HandleBinary(buf, reqLen))) {
+            return -1;
+        }
+        shortRpcFmtFlag = true;
+        return 0;
+    }
+    *res = shortRpcFmtFlag ?
         sMetaRequestHandlerShortFmt.Handle(buf, reqLen) :
-        sMetaRequestHandler.Handle(buf, reqLen)) :
-        0;
+        sMetaRequestHandler.Handle(buf, reqLen);
     if (*res && 0 <= (*res)->opSeqno) {
         return 0;
     }
@@ -865,6 +865,13 @@ public:
         mRequest[idx].mCnt++;
         mRequest[idx].mTime     += reqTime;
         mRequest[idx].mProcTime += reqProcTime;
+        const int64_t reqWaitTime = max(int64_t(0), reqTime - reqProcTime);
+        mLatency[  0][kLatencyTotal  ].UpdateTime(reqTime);
+        mLatency[  0][kLatencyProcess].UpdateTime(reqProcTime);
+        mLatency[  0][kLatencyWait   ].UpdateTime(reqWaitTime);
+        mLatency[idx][kLatencyTotal  ].UpdateTime(reqTime);
+        mLatency[idx][kLatencyProcess].UpdateTime(reqProcTime);
+        mLatency[idx][kLatencyWait   ].UpdateTime(reqWaitTime);
         if (op.status < 0) {
             mRequest[  0].mErr++;
             mRequest[idx].mErr++;
@@ -950,7 +957,9 @@ public:
             mRequest[kCpuUser].mProcTime = mUserCpuMicroSec;
             mRequest[kCpuSys ].mProcTime = mSystemCpuMicroSec;
         }
-        os << "Name,Total,%-total,Errors,%-errors,Time-total,Time-CPU\n";
+        os << "Name,Total,%-total,Errors,%-errors,Time-total,Time-CPU,"
+            "Latency-count,Latency-avg,Latency-p50,Latency-p90,Latency-p99,"
+            "Latency-p99.9,Latency-max\n";
         const double ptotal  =
             100. / (double)max(int64_t(1), mRequest[0].mCnt);
         const double perrors =
@@ -965,6 +974,7 @@ public:
                 kDelim << (mRequest[i].mErr * perrors) <<
                 kDelim << mRequest[i].mTime <<
                 kDelim << mRequest[i].mProcTime <<
+                kDelim << mLatency[i][kLatencyTotal].GetHistogram() <<
                 "\n"
             ;
         }
@@ -978,6 +988,7 @@ public:
             kDelim << (logCtrs.mLogErrorOpsCount * perrors) <<
             kDelim << logCtrs.mLogTimeUsec <<
             kDelim << logCtrs.mLogTimeUsec <<
+            kDelim << LatencyHistogram() <<
             "\n"
         ;
     }
@@ -1000,6 +1011,16 @@ private:
         kCpuSys            = kCpuUser + 1,
         kReqTypesCnt       = kCpuSys + 1
     };
+    // Wait is the time the request spent waiting for the log write, or in
+    // suspended state. Process is the time the request was processed by the
+    // main thread.
+    enum
+    {
+        kLatencyTotal     = 0,
+        kLatencyProcess   = 1,
+        kLatencyWait      = 2,
+        kLatencyTypeCount = 3
+    };
     struct Counter
     {
         Counter()
@@ -1020,6 +1041,7 @@ private:
     int64_t             mSystemCpuMicroSec;
     MsgLogger::LogLevel mLogLevel;
     Counter             mRequest[kReqTypesCnt];
+    LatencyCounter      mLatency[kReqTypesCnt][kLatencyTypeCount];
     IOBuffer::WOStream  mWOStream;
 
     RequestStatsGatherer()
@@ -1030,7 +1052,18 @@ private:
           mSystemCpuMicroSec(0),
           mLogLevel(MsgLogger::kLogLevelNOTICE),
           mWOStream()
-        {}
+    {
+        static const char* const kLatencyNames[kLatencyTypeCount] =
+            { " total", " process", " wait" };
+        for (int i = 0; i < kCpuUser; i++) {
+            for (int k = 0; k < kLatencyTypeCount; k++) {
+                const string name =
+                    string("Latency ") + GetRowName(i) + kLatencyNames[k];
+                mLatency[i][k].SetName(name.c_str());
+                globals().counterManager.AddCounter(&mLatency[i][k]);
+            }
+        }
+    }
 
     static const char* GetRowName(
         int idx)
@@ -400,39 +400,10 @@ Tree::removeFromDumpster(fid_t fid, const string& name, int64_t mtime,
         return -EINVAL;
     }
     if (0 < fa->chunkcount()) {
-        StTmp<vector<MetaChunkInfo*> > cinfoTmp(mChunkInfosTmp);
-        vector<MetaChunkInfo*>&        chunkInfo = cinfoTmp.Get();
-        if (0 < entriesCount && entriesCount < fa->chunkcount()) {
-            MetaFattr* ffa = 0;
-            const int  status = getalloc(fid, ffa, chunkInfo, entriesCount);
-            if (0 != status) {
-                return status;
-            }
-            if (ffa != fa) {
-                panic("remove from dumpster get alloc failure");
-                return -EFAULT;
-            }
-        } else {
-            getalloc(fid, chunkInfo);
-            assert(fa->chunkcount() == (int64_t)chunkInfo.size());
-        }
-        const int64_t cnt = (int64_t)chunkInfo.size();
-        fa->chunkcount() -= cnt;
-        UpdateNumChunks(-cnt);
-        // fire-away...
-        for_each(chunkInfo.begin(), chunkInfo.end(),
-             mem_fun(&MetaChunkInfo::DeleteChunk));
-        if (0 < fa->chunkcount()) {
-            // Update modification time and set file size to 0 in order
-            // to signal not to start recovery, not report file as abandoned,
-            // prevent size update attempts. Clear permissions in order to turn
-            // off non root access, and mark file as being deleted.
-            fa->mtime = mtime;
-            fa->mode &= ~kfsMode_t(MetaFattr::kFileModeMask);
-            if (0 < getFileSize(fa)) {
-                setFileSize(fa, 0);
-            }
-            return 0;
+        int64_t   cnt    = 0;
+        const int status = removeChunks(fa, entriesCount, mtime, cnt);
+        if (0 != status || 0 < fa->chunkcount()) {
+            return status;
         }
     } else if (0 == fa->numReplicas) {
         gLayoutManager.DeleteFile(*fa);
@@ -445,6 +416,96 @@ Tree::removeFromDumpster(fid_t fid, const string& name, int64_t mtime,
     return 0;
 }
 
+/*!
+ * \brief remove up to maxCount chunks of the file, or all file chunks if
+ * maxCount is not positive. If some chunks remain, mark the file as being
+ * deleted.
+ */
+int
+Tree::removeChunks(MetaFattr* fa, int64_t maxCount, int64_t mtime,
+    int64_t& outCount)
+{
+    outCount = 0;
+    StTmp<vector<MetaChunkInfo*> > cinfoTmp(mChunkInfosTmp);
+    vector<MetaChunkInfo*>&        chunkInfo = cinfoTmp.Get();
+    if (0 < maxCount && maxCount < fa->chunkcount()) {
+        MetaFattr* ffa = 0;
+        const int  status = getalloc(fa->id(), ffa, chunkInfo, (int)maxCount);
+        if (0 != status) {
+            return status;
+        }
+        if (ffa != fa) {
+            panic("remove chunks get alloc failure");
+            return -EFAULT;
+        }
+    } else {
+        getalloc(fa->id(), chunkInfo);
+        assert(fa->chunkcount() == (int64_t)chunkInfo.size());
+    }
+    outCount = (int64_t)chunkInfo.size();
+    fa->chunkcount() -= outCount;
+    UpdateNumChunks(-outCount);
+    // fire-away...
+    for_each(chunkInfo.begin(), chunkInfo.end(),
+         mem_fun(&MetaChunkInfo::DeleteChunk));
+    if (0 < fa->chunkcount()) {
+        // Update modification time and set file size to 0 in order
+        // to signal not to start recovery, not report file as abandoned,
+        // prevent size update attempts. Clear permissions in order to turn
+        // off non root access, and mark file as being deleted.
+        fa->mtime = mtime;
+        fa->mode &= ~kfsMode_t(MetaFattr::kFileModeMask);
+        if (0 < getFileSize(fa)) {
+            setFileSize(fa, 0);
+        }
+    }
+    return 0;
+}
+
+/*!
+ * \brief remove up to entriesCount files, chunks, and sub directories of the
+ * dumpster directory, starting from the bottom of the directory tree, and
+ * the directory itself once it becomes empty.
+ */
+int
+Tree::removeDirFromDumpster(fid_t fid, const string& name, int64_t mtime,
+    int64_t entriesCount, int64_t& outFilesCount, int64_t& outDirsCount,
+    int64_t& outChunksCount, bool& outCleanupDoneFlag)
+{
+    outCleanupDoneFlag = false;
+    outFilesCount      = 0;
+    outDirsCount       = 0;
+    outChunksCount     = 0;
+    const fid_t dir    = getDumpsterDirId();
+    MetaFattr*  fa     = 0;
+    MetaFattr*  parent = 0;
+    const int   status = lookup(
+        dir, name, kKfsUserRoot, kKfsGroupRoot, fa, &parent);
+    if (0 != status) {
+        return status;
+    }
+    if (KFS_DIR != fa->type || fa->id() != fid) {
+        return -EINVAL;
+    }
+    StTmp<vector<MetaDentry*> > dentriesTmp(mDentriesTmp);
+    vector<MetaDentry*>&        entries    = dentriesTmp.Get();
+    int64_t                     maxEntries = max(int64_t(1), entriesCount);
+    if (! removeSubTree(fid, mtime, maxEntries, entries,
+            outFilesCount, outDirsCount, outChunksCount)) {
+        fa->mtime = mtime;
+        return 0;
+    }
+    UpdateNumDirs(-1);
+    parent->mtime = mtime;
+    setFileSize(fa, 0, 0, -1);
+    unlink(fid, kThisDir, fa, true);
+    unlink(fid, kParentDir, fa, true);
+    unlink(dir, name, fa, false);
+    outDirsCount++;
+    outCleanupDoneFlag = true;
+    return 0;
+}
+
 /*!
  * \brief remove a file
  * \param[in] dir   file id of the parent directory
@@ -668,6 +729,59 @@ Tree::rmdir(fid_t dir, const string& dname, const string& pathname,
     return 0;
 }
 
+/*!
+ * \brief remove a directory along with its content
+ * Non empty directory is moved into the dumpster, and its content is removed
+ * later by the dumpster cleanup in bounded batches, therefore the time it
+ * takes to execute this is independent of the directory tree size. The sub
+ * directories and files permissions are not checked, therefore non empty
+ * directory can only be removed this way by the super user. Other users get
+ * EPERM, and have to remove the directory content entry by entry.
+ * \param[in] dir   file id of the parent directory
+ * \param[in] dname name of directory
+ * \param[in] pathname  fully qualified path to dname
+ * \return      status code (zero on success)
+ */
+int
+Tree::rmdirs(fid_t dir, const string& dname, const string& pathname,
+    kfsUid_t euser, kfsGid_t egroup, int64_t mtime)
+{
+    MetaFattr* fa     = 0;
+    MetaFattr* parent = 0;
+    const int  status = lookup(dir, dname, euser, egroup, fa, &parent);
+    if (status != 0) {
+        return status;
+    }
+    if (! fa || ! parent) {
+        panic("rmdirs: null file or parent attribute");
+        return -EFAULT;
+    }
+    if (fa->type != KFS_DIR) {
+        return -ENOTDIR;
+    }
+    if (emptydir(fa->id())) {
+        return rmdir(dir, dname, pathname, euser, egroup, mtime);
+    }
+    if (euser != kKfsUserRoot) {
+        return -EPERM;
+    }
+    if ((dir == ROOTFID && (dname == DUMPSTERDIR || dname == "/")) ||
+            dir == getDumpsterDirId()) {
+        KFS_LOG_STREAM_DEBUG << "attempt to delete: " <<
+            pathname << KFS_LOG_EOM;
+        return -EPERM;
+    }
+    if (dname == kThisDir || dname == kParentDir) {
+        return -EINVAL;
+    }
+    if (! parent->CanWrite(euser, egroup)) {
+        return -EACCES;
+    }
+    const bool kRemoveDirPrefixFlag = true;
+    invalidatePathCache(pathname, dname, fa, kRemoveDirPrefixFlag);
+    return moveToDumpster(dir, dname, *fa, mtime);
+}
+
 /*!
  * \brief return attributes for the specified object
  * \param[in] fid   the object's file id
@@ -2341,8 +2455,9 @@ Tree::changeFileReplication(MetaFattr* fa, int16_t numReplicas,
 }
 
 /*!
- * \brief  A file that has to be removed is currently busy.  So, rename the
- * file to the dumpster and we'll clean it up later.
+ * \brief  A file that has to be removed is currently busy, or directory has
+ * to be removed along with its content.  So, rename the file or directory to
+ * the dumpster and we'll clean it up later.
  * \param[in] dir   file id of the parent directory
  * \param[in] fname file name
  * \return      status code (zero on success)
@@ -2387,7 +2502,11 @@ Tree::moveToDumpster(fid_t dir, const string& fname, MetaFattr& fa,
         kOverwriteFlag, nodumpster, kKfsUserRoot, kKfsGroupRoot, mtime);
     if (ret == 0) {
         tempname.erase(0, plen);
-        gLayoutManager.ScheduleDumpsterCleanup(fa, tempname);
+        if (KFS_DIR == fa.type) {
+            gLayoutManager.ScheduleDumpsterDirCleanup(fa, tempname);
+        } else {
+            gLayoutManager.ScheduleDumpsterCleanup(fa, tempname);
+        }
     }
     return ret;
 }
@@ -2487,6 +2606,12 @@ Tree::cleanupDumpster()
                 continue;
             }
         }
+        if (KFS_DIR == fa->type) {
+            if (name != kThisDir && name != kParentDir) {
+                gLayoutManager.ScheduleDumpsterDirCleanup(*fa, name);
+            }
+            continue;
+        }
         if (KFS_FILE != fa->type ||
                 mChunksDeleteQueueFattr == fa ||
                 CHUNKDELQUEUE == name) {
@@ -2547,6 +2672,74 @@ Tree::removeSubTree(fid_t dir, vector<MetaDentry*>& entries, MetaFattr** dfa)
     entries.clear();
 }
 
+/*
+ * Budgeted variant of the above: each file costs one plus its chunk count,
+ * and each directory one. Files with more chunks than the remaining budget
+ * are removed in multiple steps, the same way as files in the dumpster.
+ * Returns true if the directory becomes empty.
+ */
+bool
+Tree::removeSubTree(fid_t dir, int64_t mtime, int64_t& maxEntries,
+    vector<MetaDentry*>& entries, int64_t& filesCount, int64_t& dirsCount,
+    int64_t& chunksCount)
+{
+    DentryIterator it        = readDir(dir);
+    MetaDentry*    e;
+    bool           emptyFlag = true;
+    while ((e = it.next())) {
+        MetaFattr* const fa = getFattr(e);
+        if (! fa) {
+            continue;
+        }
+        if (KFS_DIR == fa->type) {
+            const string& name = e->getName();
+            if (kThisDir == name || kParentDir == name) {
+                continue;
+            }
+            if (maxEntries <= 0) {
+                emptyFlag = false;
+                break;
+            }
+            filesCount += (int64_t)entries.size();
+            removeFiles(dir, entries);
+            if (! removeSubTree(e->id(), mtime, maxEntries, entries,
+                    filesCount, dirsCount, chunksCount)) {
+                emptyFlag = false;
+                break;
+            }
+            maxEntries--;
+            dirsCount++;
+            UpdateNumDirs(-1);
+            setFileSize(fa, 0, 0, -1);
+            const fid_t id = fa->id();
+            unlink(id, kThisDir, fa, true);
+            unlink(id, kParentDir, fa, true);
+            unlink(dir, e->getName(), fa, false);
+            // Tree has changed, start over.
+            it = readDir(dir);
+            continue;
+        }
+        if (maxEntries <= 0) {
+            emptyFlag = false;
+            break;
+        }
+        if (maxEntries <= fa->chunkcount()) {
+            int64_t cnt = 0;
+            removeChunks(fa, maxEntries, mtime, cnt);
+            chunksCount += cnt;
+            maxEntries   = 0;
+            emptyFlag    = false;
+            break;
+        }
+        maxEntries  -= 1 + fa->chunkcount();
+        chunksCount += fa->chunkcount();
+        entries.push_back(e);
+    }
+    filesCount += (int64_t)entries.size();
+    removeFiles(dir, entries);
+    return emptyFlag;
+}
+
 void
 Tree::removeFiles(fid_t dir, vector<MetaDentry*>& entries)
 {
@@ -489,6 +489,11 @@ private:
     void removeSubTree(fid_t dir, vector<MetaDentry*>& entries,
         MetaFattr** dfa);
     void removeFiles(fid_t dir, vector<MetaDentry*>& entries);
+    bool removeSubTree(fid_t dir, int64_t mtime, int64_t& maxEntries,
+        vector<MetaDentry*>& entries, int64_t& filesCount,
+        int64_t& dirsCount, int64_t& chunksCount);
+    int removeChunks(MetaFattr* fa, int64_t maxCount, int64_t mtime,
+        int64_t& outCount);
     Tree()
         : root(0),
           first(0),
@@ -602,6 +607,8 @@ public:
         fid_t* newFid, MetaFattr** newFattr, int64_t mtime);
     int rmdir(fid_t dir, const string& dname, const string& pathname,
         kfsUid_t euser, kfsGid_t egroup, int64_t mtime);
+    int rmdirs(fid_t dir, const string& dname, const string& pathname,
+        kfsUid_t euser, kfsGid_t egroup, int64_t mtime);
     int readdir(fid_t dir, vector<MetaDentry*>& result,
         int maxEntries = 0, bool* moreEntriesFlag = 0);
     int readdir(fid_t dir, const string& fnameStart, vector<MetaDentry*>& v,
@@ -770,6 +777,9 @@ public:
     }
     int removeFromDumpster(fid_t fid, const string& name, int64_t mtime,
         int entriesCount, bool& outCleanupDoneFlag);
+    int removeDirFromDumpster(fid_t fid, const string& name, int64_t mtime,
+        int64_t entriesCount, int64_t& outFilesCount, int64_t& outDirsCount,
+        int64_t& outChunksCount, bool& outCleanupDoneFlag);
     const MetaFattr* getChunkDeleteQueue()
     {
         return (mChunksDeleteQueueFattr ?
@@ -0,0 +1,95 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Convert binary audit log files into the text audit log format.
+//
+//----------------------------------------------------------------------------
+
+#include "AuditLog.h"
+
+#include <iostream>
+#include <fstream>
+#include <unistd.h>
+
+namespace KFS
+{
+using std::cout;
+using std::cerr;
+using std::cin;
+using std::ifstream;
+
+static int
+AuditLogDecodeMain(int argc, char **argv)
+{
+    int  optchar;
+    bool help       = false;
+    bool useGMTFlag = false;
+    int  status     = 0;
+
+    while ((optchar = getopt(argc, argv, "hg")) != -1) {
+        switch (optchar) {
+            case 'g':
+                useGMTFlag = true;
+                break;
+            case 'h':
+                help = true;
+                break;
+            default:
+                status = 1;
+                break;
+        }
+    }
+
+    if (help || status != 0) {
+        (status ? cerr : cout) << "Usage: " << argv[0] << "\n"
+            "[-g use GMT time stamps (default local time)]\n"
+            "[binary audit log files (default stdin)]\n"
+        ;
+        return status;
+    }
+
+    string errMsg;
+    if (argc <= optind) {
+        if ((status = AuditLog::Decode(cin, cout, useGMTFlag, errMsg)) != 0) {
+            cerr << "stdin: " << errMsg << "\n";
+        }
+    }
+    for (int i = optind; i < argc && status == 0; i++) {
+        ifstream ifs(argv[i], ifstream::binary);
+        if (! ifs) {
+            cerr << argv[i] << ": failed to open\n";
+            status = 1;
+        } else if ((status = AuditLog::Decode(
+                ifs, cout, useGMTFlag, errMsg)) != 0) {
+            cerr << argv[i] << ": " << errMsg << "\n";
+        }
+    }
+    cout.flush();
+    return (status == 0 ? 0 : 1);
+}
+
+} // namespace KFS
+
+int
+main(int argc, char **argv)
+{
+    return KFS::AuditLogDecodeMain(argc, argv);
+}
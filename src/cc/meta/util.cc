@@ -24,6 +24,7 @@
  */
 
 #include "common/MsgLogger.h"
+#include "common/BinaryRpc.h"
 #include "common/RequestParser.h"
 #include "common/IntToString.h"
 #include "common/time.h"
@@ -171,7 +172,8 @@ file_exists(const string& name)
 }
 
 ///
-/// Return true if there is a sequence of "\r\n\r\n".
+/// Return true if there is a sequence of "\r\n\r\n", or complete binary
+/// rpc frame.
 /// @param[in] iobuf: Buffer with data
 /// @param[out] msgLen: string length of the command in the buffer
 /// @retval true if a command is present; false otherwise.
@@ -179,6 +181,19 @@ file_exists(const string& name)
 bool
 IsMsgAvail(IOBuffer* iobuf, int* msgLen)
 {
+    char hdr[BinaryRpc::kHeaderSize];
+    if (iobuf->CopyOut(hdr, 1) == 1 && BinaryRpc::IsFrame(hdr, 1)) {
+        // Binary frame length is in the fixed header.
+        if (iobuf->CopyOut(hdr, sizeof(hdr)) < (int)sizeof(hdr)) {
+            return false;
+        }
+        const int len = BinaryRpc::GetFrameLength(hdr);
+        if (iobuf->BytesConsumable() < len) {
+            return false;
+        }
+        *msgLen = len;
+        return true;
+    }
     const int idx = iobuf->IndexOf(0, "\r\n\r\n");
     if (idx < 0) {
         return false;
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <dirent.h>
+#include <time.h>
 
 #ifdef QC_OS_NAME_DARWIN
 #include <sys/param.h>
@@ -52,6 +53,8 @@
 // for 0 slot.
 static const unsigned int kPendingCloseListIdxOff = 1;
 static const unsigned int kEndOfPendingCloseList  = ~((unsigned int)0);
+static const int kDefaultPriorityClassWeights[QCDiskQueue::kPriorityClassCount]
+    = { 8, 4, 1 };
 
 class QCDiskQueue::Request
 {};
@@ -71,6 +74,7 @@ public:
           mFilePendingReqCountPtr(0),
           mIoVecPtr(0),
           mFileInfoPtr(0),
+          mIoQueueStatePtr(0),
           mPendingReadBlockCount(0),
           mPendingWriteBlockCount(0),
           mPendingCloseHeadPtr(0),
@@ -97,7 +101,11 @@ public:
           mRequestAffinityFlag(false),
           mSerializeMetaRequestsFlag(true),
           mBarrierFlag(false)
-        {}
+    {
+        for (int i = 0; i < kPriorityClassCount; i++) {
+            mPriorityClassWeights[i] = kDefaultPriorityClassWeights[i];
+        }
+    }
     virtual ~Queue()
         { Queue::Stop(); }
     inline void Done(
@@ -138,7 +146,9 @@ public:
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec,
-        int64_t        inEofHint);
+        int64_t        inEofHint,
+        PriorityClass  inPriorityClass,
+        Time           inDeadlineNanoSec);
     bool Cancel(
         RequestId inRequestId);
     IoCompletion* CancelOrSetCompletionIfInFlight(
@@ -156,6 +166,22 @@ public:
         outReadBlockCount   = mPendingReadBlockCount;
         outWriteBlockCount  = mPendingWriteBlockCount;
     }
+    void SetPriorityClassWeights(
+        const int* inWeightsPtr)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        for (int i = 0; i < kPriorityClassCount; i++) {
+            mPriorityClassWeights[i] = Max(1, inWeightsPtr[i]);
+        }
+    }
+    void GetPriorityClassCounters(
+        PriorityClassCounters* outCountersPtr)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        for (int i = 0; i < kPriorityClassCount; i++) {
+            outCountersPtr[i] = mPriorityClassCounters[i];
+        }
+    }
     OpenFileStatus OpenFile(
         const char* inFileNamePtr,
         int64_t     inMaxFileSize,
@@ -254,9 +280,13 @@ private:
               mReqType(kReqTypeNone),
               mInFlightFlag(false),
               mFreeBuffersIfNoIoCompletionFlag(false),
+              mPriorityClass(kPriorityClassNormal),
               mBufferCount(0),
+              mFenceSeq(0),
               mFileIdx(0),
               mBlockIdx(0),
+              mEnqueueTime(0),
+              mDeadline(-1),
               mIoCompletionPtr(0)
             {}
         ~Request()
@@ -270,9 +300,13 @@ private:
         ReqType       mReqType:8;
         bool          mInFlightFlag:1;
         bool          mFreeBuffersIfNoIoCompletionFlag:1;
+        PriorityClass mPriorityClass:8;
         int           mBufferCount;
+        unsigned int  mFenceSeq;
         uint64_t      mFileIdx:16;
         uint64_t      mBlockIdx:48;
+        Time          mEnqueueTime;
+        Time          mDeadline;
         IoCompletion* mIoCompletionPtr;
     };
 
@@ -438,6 +472,21 @@ private:
         int64_t   mCloseFileSize;
         int       mThreadIdx;
     };
+    // Per io queue scheduler state.
+    struct IoQueueState
+    {
+        IoQueueState()
+            : mFenceSeq(0),
+              mCurClass(0)
+        {
+            for (int i = 0; i < kPriorityClassCount; i++) {
+                mDeficit[i] = 0;
+            }
+        }
+        unsigned int mFenceSeq;
+        int          mCurClass;
+        int64_t      mDeficit[kPriorityClassCount];
+    };
 
     QCMutex            mMutex;
     QCCondVar          mFreeReqCond;
@@ -450,6 +499,7 @@ private:
     unsigned int*      mFilePendingReqCountPtr;
     struct iovec*      mIoVecPtr;
     FileInfo*          mFileInfoPtr;
+    IoQueueState*      mIoQueueStatePtr;
     int64_t            mPendingReadBlockCount;
     int64_t            mPendingWriteBlockCount;
     unsigned int*      mPendingCloseHeadPtr;
@@ -477,12 +527,17 @@ private:
     bool               mSerializeMetaRequestsFlag;
     bool               mBarrierFlag; // New req. can not be processed
                                    // until in flight req. done.
+    int                mPriorityClassWeights[kPriorityClassCount];
+    PriorityClassCounters mPriorityClassCounters[kPriorityClassCount];
 
     enum
     {
         kFreeQueueIdx = 0,
         kIoQueueIdx   = 1,
-        kRequestQueueCount
+        // Each io queue has one list per priority class, followed by the meta
+        // requests list.
+        kIoQueueListCount = kPriorityClassCount + 1,
+        kFenceListIdx     = kPriorityClassCount
     };
     enum
     {
@@ -571,13 +626,30 @@ private:
     bool Empty(
         RequestIdx inIdx) const
         { return (mRequestsPtr[inIdx].mNextIdx == inIdx); }
+    static RequestIdx GetIoQueueIdx(
+        int inThreadIdx,
+        int inListIdx)
+        { return (kIoQueueIdx + inThreadIdx * kIoQueueListCount + inListIdx); }
     bool HasPendingReq(
         int inThreadIdx) const
-        { return (! Empty(kIoQueueIdx + inThreadIdx)); }
+    {
+        for (int i = 0; i < kIoQueueListCount; i++) {
+            if (! Empty(GetIoQueueIdx(inThreadIdx, i))) {
+                return true;
+            }
+        }
+        return false;
+    }
     bool HasPendingNonBarrierReq(
         int inThreadIdx) const
     {
-        const Request* const theReqPtr = Front(kIoQueueIdx + inThreadIdx);
+        for (int i = 0; i < kPriorityClassCount; i++) {
+            if (! Empty(GetIoQueueIdx(inThreadIdx, i))) {
+                return true;
+            }
+        }
+        const Request* const theReqPtr =
+            Front(GetIoQueueIdx(inThreadIdx, kFenceListIdx));
         return (theReqPtr && ! theReqPtr->IsBarrier());
     }
     int GetReqListSize(
@@ -612,6 +684,8 @@ private:
         inReq.mInFlightFlag    = false;
         inReq.mIoCompletionPtr = 0;
         inReq.mBufferCount     = 0;
+        inReq.mPriorityClass   = kPriorityClassNormal;
+        inReq.mDeadline        = -1;
         Insert(mRequestsPtr[kFreeQueueIdx], inReq);
         if (mReqWaitersCount > 0) {
             QCASSERT(mFreeCount > 0);
@@ -663,7 +737,23 @@ private:
         int      inThreadIdx)
     {
         Trace("enqueue", inReq);
-        Insert(mRequestsPtr[kIoQueueIdx + inThreadIdx], inReq);
+        // Meta requests are the scheduling fences: read and write requests
+        // enqueued before meta request are scheduled before it, and the ones
+        // enqueued after are scheduled after it.
+        IoQueueState& theState = mIoQueueStatePtr[inThreadIdx];
+        inReq.mEnqueueTime = Now();
+        if (0 <= inReq.mDeadline) {
+            inReq.mDeadline += inReq.mEnqueueTime;
+        }
+        if (inReq.IsMeta()) {
+            inReq.mFenceSeq = theState.mFenceSeq++;
+            Insert(mRequestsPtr[GetIoQueueIdx(inThreadIdx, kFenceListIdx)],
+                inReq);
+        } else {
+            inReq.mFenceSeq = theState.mFenceSeq;
+            Insert(mRequestsPtr[GetIoQueueIdx(
+                inThreadIdx, inReq.mPriorityClass)], inReq);
+        }
         mPendingCount++;
         mFilePendingReqCountPtr[inReq.mFileIdx]++;
         if (inReq.mReqType == kReqTypeRead) {
@@ -678,12 +768,82 @@ private:
     Request* Dequeue(
         int inThreadIdx)
     {
-        Request* const theReqPtr = Front(kIoQueueIdx + inThreadIdx);
+        const Time     theNow    = Now();
+        Request* const theReqPtr = Schedule(inThreadIdx, theNow);
         if (theReqPtr) {
             RemoveWithSubRequests(*theReqPtr);
+            PriorityClassCounters& theCounters =
+                mPriorityClassCounters[theReqPtr->mPriorityClass];
+            const Time theWait = theNow - theReqPtr->mEnqueueTime;
+            theCounters.mQueueWaitTime += theWait;
+            theCounters.mMaxQueueWaitTime =
+                Max(theCounters.mMaxQueueWaitTime, theWait);
         }
         return theReqPtr;
     }
+    static bool IsBeforeFence(
+        const Request& inReq,
+        const Request& inFence)
+        { return (int(inReq.mFenceSeq - inFence.mFenceSeq) <= 0); }
+    int64_t GetCost(
+        const Request& inReq) const
+        { return Max(1, inReq.mBufferCount); }
+    Request* Schedule(
+        int  inThreadIdx,
+        Time inNow)
+    {
+        IoQueueState&  theState    = mIoQueueStatePtr[inThreadIdx];
+        Request* const theFencePtr =
+            Front(GetIoQueueIdx(inThreadIdx, kFenceListIdx));
+        Request*       theHeads[kPriorityClassCount];
+        Request*       theDeadlinePtr    = 0;
+        bool           theHasPendingFlag = false;
+        for (int i = 0; i < kPriorityClassCount; i++) {
+            Request* const thePtr = Front(GetIoQueueIdx(inThreadIdx, i));
+            theHeads[i] = (thePtr &&
+                (! theFencePtr || IsBeforeFence(*thePtr, *theFencePtr))) ?
+                thePtr : 0;
+            if (! theHeads[i]) {
+                continue;
+            }
+            theHasPendingFlag = true;
+            if (0 <= thePtr->mDeadline && thePtr->mDeadline <= inNow &&
+                    (! theDeadlinePtr ||
+                        thePtr->mDeadline < theDeadlinePtr->mDeadline)) {
+                theDeadlinePtr = thePtr;
+            }
+        }
+        if (! theHasPendingFlag) {
+            return theFencePtr;
+        }
+        if (theDeadlinePtr) {
+            const int theClass = theDeadlinePtr->mPriorityClass;
+            theState.mDeficit[theClass] = Max(int64_t(0),
+                theState.mDeficit[theClass] - GetCost(*theDeadlinePtr));
+            mPriorityClassCounters[theClass].mDeadlineCount++;
+            return theDeadlinePtr;
+        }
+        // Deficit round robin. The quantum is class weight times the max
+        // request size, thus the loop normally terminates in at most one
+        // round.
+        for (; ;) {
+            const int      theClass = theState.mCurClass;
+            Request* const thePtr   = theHeads[theClass];
+            if (thePtr) {
+                const int64_t theCost = GetCost(*thePtr);
+                if (theCost <= theState.mDeficit[theClass]) {
+                    theState.mDeficit[theClass] -= theCost;
+                    return thePtr;
+                }
+            } else {
+                theState.mDeficit[theClass] = 0;
+            }
+            theState.mCurClass = (theClass + 1) % kPriorityClassCount;
+            theState.mDeficit[theState.mCurClass] += int64_t(
+                mPriorityClassWeights[theState.mCurClass]) *
+                mRequestBufferCount;
+        }
+    }
     void RemoveWithSubRequests(
         Request& inReq)
     {
@@ -747,6 +907,17 @@ private:
             int(inReq.mFileIdx) < mFileCount &&
             mFilePendingReqCountPtr[inReq.mFileIdx] > 0
         );
+        PriorityClassCounters& theCounters =
+            mPriorityClassCounters[inReq.mPriorityClass];
+        const Time theNow   = Now();
+        const Time theTotal = theNow - inReq.mEnqueueTime;
+        theCounters.mRequestCount++;
+        theCounters.mBlockCount  += inReq.IsMeta() ? 0 : inReq.mBufferCount;
+        theCounters.mTotalTime   += theTotal;
+        theCounters.mMaxTotalTime = Max(theCounters.mMaxTotalTime, theTotal);
+        if (0 <= inReq.mDeadline && inReq.mDeadline < theNow) {
+            theCounters.mDeadlineMissCount++;
+        }
         if (inReq.mReqType == kReqTypeRead) {
             mPendingReadBlockCount -= inReq.mBufferCount;
         } else if (IsWriteReqType(inReq.mReqType)) {
@@ -877,6 +1048,14 @@ private:
             {}
         return theFd;
     }
+    static Time Now()
+    {
+        struct timespec theTs;
+        if (clock_gettime(CLOCK_MONOTONIC, &theTs)) {
+            return 0;
+        }
+        return (Time(theTs.tv_sec) * 1000 * 1000 * 1000 + theTs.tv_nsec);
+    }
     static off_t GetFileSize(
         int inFd)
     {
@@ -1022,6 +1201,8 @@ QCDiskQueue::Queue::StopSelf()
     mFilePendingReqCountPtr = 0;
     delete [] mFileInfoPtr;
     mFileInfoPtr = 0;
+    delete [] mIoQueueStatePtr;
+    mIoQueueStatePtr = 0;
     delete [] mThreadsPtr;
     mThreadsPtr = 0;
     delete [] mBuffersPtr;
@@ -1176,11 +1357,12 @@ QCDiskQueue::Queue::Start(
     }
     mBuffersPtr = new char*[inMaxQueueDepth * inMaxBuffersPerRequestCount];
     mRequestBufferCount = inMaxBuffersPerRequestCount;
-    mRequestQueueCount  = kRequestQueueCount +
-        (mRequestAffinityFlag ? inThreadCount - 1 : 0);
+    const int theIoQueueCount = mRequestAffinityFlag ? inThreadCount : 1;
+    mIoQueueStatePtr    = new IoQueueState[theIoQueueCount];
+    mRequestQueueCount  = kIoQueueIdx + theIoQueueCount * kIoQueueListCount;
     const int theReqCnt = mRequestQueueCount + inMaxQueueDepth;
     mRequestsPtr = new Request[theReqCnt];
-    // Init list heads: kFreeQueueIdx kIoQueueIdx.
+    // Init list heads: kFreeQueueIdx, and io queues lists.
     for (mTotalCount = 0; mTotalCount < mRequestQueueCount; mTotalCount++) {
         Init(mRequestsPtr[mTotalCount]);
     }
@@ -1214,9 +1396,12 @@ QCDiskQueue::Queue::Enqueue(
     int                         inBufferCount,
     QCDiskQueue::IoCompletion*  inIoCompletionPtr,
     QCDiskQueue::Time           inTimeWaitNanoSec,
-    int64_t                     inEofHint)
+    int64_t                     inEofHint,
+    QCDiskQueue::PriorityClass  inPriorityClass,
+    QCDiskQueue::Time           inDeadlineNanoSec)
 {
     if ((inReqType != kReqTypeRead && ! IsWriteReqType(inReqType)) ||
+            inPriorityClass < 0 || kPriorityClassCount <= inPriorityClass ||
             inBufferCount <= 0 ||
             inBufferCount > (mRequestBufferCount *
                 (mTotalCount - mRequestQueueCount)) ||
@@ -1254,6 +1439,9 @@ QCDiskQueue::Queue::Enqueue(
     theReq.mFileIdx         = inFileIdx;
     theReq.mBlockIdx        = inBlockIdx;
     theReq.mIoCompletionPtr = inIoCompletionPtr;
+    theReq.mPriorityClass   = inPriorityClass;
+    theReq.mDeadline        = inDeadlineNanoSec < 0 ? Time(-1) :
+        inDeadlineNanoSec;
     if (inBufferIteratorPtr) {
         BuffersIterator theItr(*this, theReq, inBufferCount);
         for (int i = 0; i < inBufferCount; i++) {
@@ -2526,7 +2714,9 @@ QCDiskQueue::Enqueue(
     int                         inBufferCount,
     QCDiskQueue::IoCompletion*  inIoCompletionPtr,
     QCDiskQueue::Time           inTimeWaitNanoSec,
-    int64_t                     inEofHint)
+    int64_t                     inEofHint,
+    QCDiskQueue::PriorityClass  inPriorityClass,
+    QCDiskQueue::Time           inDeadlineNanoSec)
 {
     if (! mQueuePtr) {
         return EnqueueStatus(kRequestIdNone, kErrorParameter);
@@ -2539,7 +2729,9 @@ QCDiskQueue::Enqueue(
         inBufferCount,
         inIoCompletionPtr,
         inTimeWaitNanoSec,
-        inEofHint);
+        inEofHint,
+        inPriorityClass,
+        inDeadlineNanoSec);
 }
 
     bool
@@ -2576,6 +2768,28 @@ QCDiskQueue::GetPendingCount(
     }
 }
 
+    void
+QCDiskQueue::SetPriorityClassWeights(
+    const int* inWeightsPtr)
+{
+    if (mQueuePtr && inWeightsPtr) {
+        mQueuePtr->SetPriorityClassWeights(inWeightsPtr);
+    }
+}
+
+    void
+QCDiskQueue::GetPriorityClassCounters(
+    QCDiskQueue::PriorityClassCounters* outCountersPtr)
+{
+    if (mQueuePtr) {
+        mQueuePtr->GetPriorityClassCounters(outCountersPtr);
+    } else {
+        for (int i = 0; i < kPriorityClassCount; i++) {
+            outCountersPtr[i].Clear();
+        }
+    }
+}
+
     QCDiskQueue::CompletionStatus
 QCDiskQueue::SyncIo(
     QCDiskQueue::ReqType         inReqType,
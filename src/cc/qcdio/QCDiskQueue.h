@@ -35,6 +35,13 @@
 // close that is queued after read request will be executed after the read
 // request completes.
 //
+// Read and write requests are assigned priority class. Pending read and write
+// requests of each class are scheduled using deficit round robin weighted by
+// the request block count, with the per class weights. Meta requests are
+// scheduled in the order they were enqueued in respect to the read and write
+// requests of all priority classes, i.e. act as scheduling fence. Request with
+// the deadline that has passed is scheduled ahead of the others.
+//
 //----------------------------------------------------------------------------
 
 #ifndef QCDISKQUEUE_H
@@ -94,6 +101,14 @@ public:
         kErrorCheckDirWritable     = 21
     };
 
+    enum PriorityClass
+    {
+        kPriorityClassHigh       = 0, // Latency sensitive, i.e. client io.
+        kPriorityClassNormal     = 1,
+        kPriorityClassBackground = 2, // Replication, recovery, scrub.
+        kPriorityClassCount
+    };
+
     enum { kRequestIdNone = -1 };
 
     typedef int      RequestId;
@@ -144,6 +159,34 @@ public:
 
     typedef Status CloseFileStatus;
 
+    class PriorityClassCounters
+    {
+    public:
+        typedef int64_t Counter;
+
+        PriorityClassCounters()
+            { PriorityClassCounters::Clear(); }
+        void Clear()
+        {
+            mRequestCount      = 0;
+            mBlockCount        = 0;
+            mQueueWaitTime     = 0;
+            mMaxQueueWaitTime  = 0;
+            mTotalTime         = 0;
+            mMaxTotalTime      = 0;
+            mDeadlineCount     = 0;
+            mDeadlineMissCount = 0;
+        }
+        Counter mRequestCount;      // Completed, including canceled.
+        Counter mBlockCount;
+        Counter mQueueWaitTime;     // Enqueue to io start, nanoseconds.
+        Counter mMaxQueueWaitTime;
+        Counter mTotalTime;         // Enqueue to completion, nanoseconds.
+        Counter mMaxTotalTime;
+        Counter mDeadlineCount;     // Scheduled ahead due to passed deadline.
+        Counter mDeadlineMissCount; // Completed after the deadline.
+    };
+
     class EnqueueStatus
     {
     public:
@@ -320,6 +363,8 @@ public:
 
     void Stop();
 
+    // The deadline is relative to the enqueue time, negative value means no
+    // deadline.
     EnqueueStatus Enqueue(
         ReqType        inReqType,
         FileIdx        inFileIdx,
@@ -328,7 +373,9 @@ public:
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec = -1,
-        int64_t        inEofHint         = -1);
+        int64_t        inEofHint         = -1,
+        PriorityClass  inPriorityClass   = kPriorityClassNormal,
+        Time           inDeadlineNanoSec = -1);
 
     EnqueueStatus Read(
         FileIdx        inFileIdx,
@@ -336,7 +383,9 @@ public:
         InputIterator* inBufferIteratorPtr,
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
-        Time           inTimeWaitNanoSec = -1)
+        Time           inTimeWaitNanoSec = -1,
+        PriorityClass  inPriorityClass   = kPriorityClassNormal,
+        Time           inDeadlineNanoSec = -1)
     {
         return Enqueue(
             kReqTypeRead,
@@ -345,7 +394,10 @@ public:
             inBufferIteratorPtr,
             inBufferCount,
             inIoCompletionPtr,
-            inTimeWaitNanoSec);
+            inTimeWaitNanoSec,
+            -1,
+            inPriorityClass,
+            inDeadlineNanoSec);
     }
 
     EnqueueStatus Write(
@@ -356,7 +408,9 @@ public:
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec = -1,
         bool           inSyncFlag        = false,
-        int64_t        inEofHint         = -1)
+        int64_t        inEofHint         = -1,
+        PriorityClass  inPriorityClass   = kPriorityClassNormal,
+        Time           inDeadlineNanoSec = -1)
     {
         return Enqueue(
             inSyncFlag ? kReqTypeWriteSync : kReqTypeWrite,
@@ -366,7 +420,9 @@ public:
             inBufferCount,
             inIoCompletionPtr,
             inTimeWaitNanoSec,
-            inEofHint);
+            inEofHint,
+            inPriorityClass,
+            inDeadlineNanoSec);
     }
 
     CompletionStatus SyncIo(
@@ -428,6 +484,15 @@ public:
         int64_t& outReadBlockCount,
         int64_t& outWriteBlockCount);
 
+    // Weights array must have kPriorityClassCount entries. The weights less
+    // than 1 are treated as 1.
+    void SetPriorityClassWeights(
+        const int* inWeightsPtr);
+
+    // Counters array must have kPriorityClassCount entries.
+    void GetPriorityClassCounters(
+        PriorityClassCounters* outCountersPtr);
+
     OpenFileStatus OpenFile(
         const char* inFileNamePtr,
         int64_t     inMaxFileSize           = -1,
@@ -29,6 +29,7 @@
 #include "qcdebug.h"
 #include "qcstutils.h"
 #include "QCDLList.h"
+#include "QCNuma.h"
 
 #include <sys/mman.h>
 #include <errno.h>
@@ -55,7 +56,8 @@ public:
           mFreeListPtr(0),
           mTotalCnt(0),
           mFreeCnt(0),
-          mBufSizeShift(0)
+          mBufSizeShift(0),
+          mNode(-1)
         { List::Init(*this); }
 
     ~Partition()
@@ -64,7 +66,8 @@ public:
     int Create(
         int  inNumBuffers,
         int  inBufferSize,
-        bool inLockMemoryFlag)
+        bool inLockMemoryFlag,
+        int  inNode)
     {
         int theBufSizeShift = -1;
         for (int i = inBufferSize; i > 0; i >>= 1, theBufSizeShift++)
@@ -90,6 +93,12 @@ public:
             mAllocPtr = 0;
             return (theRet == 0 ? -1 : theRet);
         }
+        // Set memory policy before locking, as locking faults in the pages.
+        // Failure to set the policy is not fatal, the memory is still usable.
+        if (0 <= inNode &&
+                QCNuma::SetPreferredNode(mAllocPtr, mAllocSize, inNode) == 0) {
+            mNode = inNode;
+        }
         if (inLockMemoryFlag && mlock(mAllocPtr, mAllocSize) != 0) {
             const int theRet = errno;
             Destroy();
@@ -122,6 +131,7 @@ public:
         mTotalCnt     = 0;
         mFreeCnt      = 0;
         mBufSizeShift = 0;
+        mNode         = -1;
     }
 
     char* Get()
@@ -236,6 +246,9 @@ public:
     bool IsFull() const
         { return (mFreeCnt >= mTotalCnt); }
 
+    int GetNode() const
+        { return mNode; }
+
     typedef QCDLList<Partition, 0> List;
 
 private:
@@ -249,6 +262,7 @@ private:
     int          mTotalCnt;
     int          mFreeCnt;
     int          mBufSizeShift;
+    int          mNode;
     Partition*   mPrevPtr[1];
     Partition*   mNextPtr[1];
 };
@@ -271,7 +285,9 @@ QCIoBufferPool::QCIoBufferPool()
     : mMutex(),
       mBufferSize(0),
       mFreeCnt(0),
-      mTotalCnt(0)
+      mTotalCnt(0),
+      mNodeCount(0),
+      mNodeCountersPtr(0)
 {
     QCIoBufferPoolClientList::Init(mClientListPtr);
     Partition::List::Init(mPartitionListPtr);
@@ -294,17 +310,32 @@ QCIoBufferPool::Create(
     int          inPartitionCount,
     int          inPartitionBufferCount,
     int          inBufferSize,
-    bool         inLockMemoryFlag)
+    bool         inLockMemoryFlag,
+    int          inNodeCount /* = 0 */)
 {
     QCStMutexLocker theLock(mMutex);
     Destroy();
     mBufferSize = inBufferSize;
+    int thePartitionCount       = inPartitionCount;
+    int thePartitionBufferCount = inPartitionBufferCount;
+    if (1 < inNodeCount && 0 < inPartitionCount) {
+        // Make partition count multiple of node count, and keep the total
+        // number of buffers the same.
+        mNodeCount = inNodeCount < QCNuma::kMaxNodeCount ?
+            inNodeCount : int(QCNuma::kMaxNodeCount);
+        mNodeCountersPtr = new NodeCounters[mNodeCount];
+        thePartitionCount = (inPartitionCount + mNodeCount - 1) /
+            mNodeCount * mNodeCount;
+        thePartitionBufferCount = (int)(int64_t(inPartitionCount) *
+            inPartitionBufferCount / thePartitionCount);
+    }
     int theErr = 0;
-    for (int i = 0; i < inPartitionCount; i++) {
+    for (int i = 0; i < thePartitionCount; i++) {
         Partition& thePart = *(new Partition());
         Partition::List::PushBack(mPartitionListPtr, thePart);
         theErr = thePart.Create(
-            inPartitionBufferCount, inBufferSize, inLockMemoryFlag);
+            thePartitionBufferCount, inBufferSize, inLockMemoryFlag,
+            0 < mNodeCount ? i % mNodeCount : -1);
         if (theErr) {
             Destroy();
             break;
@@ -323,28 +354,30 @@ QCIoBufferPool::Destroy()
     while ((thePtr = Partition::List::PopBack(mPartitionListPtr))) {
         delete thePtr;
     }
-    mBufferSize = 0;
-    mFreeCnt    = 0;
+    delete [] mNodeCountersPtr;
+    mNodeCountersPtr = 0;
+    mNodeCount       = 0;
+    mBufferSize      = 0;
+    mFreeCnt         = 0;
 }
 
 char*
 QCIoBufferPool::Get(
     QCIoBufferPool::RefillReqId inRefillReqId /* = kRefillReqIdUndefined */)
 {
+    // Get the node before acquiring the mutex, to keep the critical section
+    // short.
+    const int       theNode = 1 < mNodeCount ? QCNuma::GetCurrentNode() : -1;
     QCStMutexLocker theLock(mMutex);
     if (mFreeCnt <= 0 && ! TryToRefill(inRefillReqId, 1)) {
         return 0;
     }
     QCASSERT(mFreeCnt >= 1);
-    // Always start from the first partition, to try to keep next
-    // partitions full, and be able to reclaim these if needed.
-    Partition::List::Iterator theItr(mPartitionListPtr);
-    Partition* thePtr;
-    while ((thePtr = theItr.Next()) && thePtr->IsEmpty())
-        {}
-    char* const theBufPtr = thePtr ? thePtr->Get() : 0;
+    Partition* const thePtr    = GetNonEmptyPartition(theNode);
+    char* const      theBufPtr = thePtr ? thePtr->Get() : 0;
     QCASSERT(theBufPtr && mFreeCnt > 0);
     mFreeCnt--;
+    UpdateNodeCounters(*thePtr, theNode, 1);
     return theBufPtr;
 }
 
@@ -357,21 +390,86 @@ QCIoBufferPool::Get(
     if (inBufCnt <= 0) {
         return true;
     }
+    const int       theNode = 1 < mNodeCount ? QCNuma::GetCurrentNode() : -1;
     QCStMutexLocker theLock(mMutex);
     if (mFreeCnt < inBufCnt && ! TryToRefill(inRefillReqId, inBufCnt)) {
         return false;
     }
     QCASSERT(mFreeCnt >= inBufCnt);
-    Partition::List::Iterator theItr(mPartitionListPtr);
     for (int i = 0; i < inBufCnt; ) {
-        Partition* thePPtr;
-        while ((thePPtr = theItr.Next()) && thePPtr->IsEmpty())
-            {}
+        Partition* const thePPtr = GetNonEmptyPartition(theNode);
         QCASSERT(thePPtr);
+        const int theStart = i;
         for (char* theBPtr; i < inBufCnt && (theBPtr = thePPtr->Get()); i++) {
             mFreeCnt--;
             inIt.Put(theBPtr);
         }
+        UpdateNodeCounters(*thePPtr, theNode, i - theStart);
+    }
+    return true;
+}
+
+QCIoBufferPool::Partition*
+QCIoBufferPool::GetNonEmptyPartition(
+    int inNode)
+{
+    QCASSERT(mMutex.IsOwned());
+    // Always start from the first partition, to try to keep next
+    // partitions full, and be able to reclaim these if needed.
+    Partition::List::Iterator theItr(mPartitionListPtr);
+    Partition* thePtr;
+    Partition* theFirstPtr = 0;
+    while ((thePtr = theItr.Next())) {
+        if (thePtr->IsEmpty()) {
+            continue;
+        }
+        if (inNode < 0 || thePtr->GetNode() == inNode) {
+            return thePtr;
+        }
+        if (! theFirstPtr) {
+            theFirstPtr = thePtr;
+        }
+    }
+    return theFirstPtr;
+}
+
+void
+QCIoBufferPool::UpdateNodeCounters(
+    const Partition& inPartition,
+    int              inNode,
+    int              inBufCnt)
+{
+    const int thePartNode = inPartition.GetNode();
+    if (! mNodeCountersPtr || thePartNode < 0 || mNodeCount <= thePartNode) {
+        return;
+    }
+    NodeCounters& theCounters = mNodeCountersPtr[thePartNode];
+    if (thePartNode == inNode) {
+        theCounters.mLocalGetCount += inBufCnt;
+    } else {
+        theCounters.mRemoteGetCount += inBufCnt;
+    }
+}
+
+bool
+QCIoBufferPool::GetNodeCounters(
+    int                           inNode,
+    QCIoBufferPool::NodeCounters& outCounters)
+{
+    QCStMutexLocker theLock(mMutex);
+    if (! mNodeCountersPtr || inNode < 0 || mNodeCount <= inNode) {
+        return false;
+    }
+    outCounters = mNodeCountersPtr[inNode];
+    outCounters.mTotalCount = 0;
+    outCounters.mFreeCount  = 0;
+    Partition::List::Iterator theItr(mPartitionListPtr);
+    const Partition* thePtr;
+    while ((thePtr = theItr.Next())) {
+        if (thePtr->GetNode() == inNode) {
+            outCounters.mTotalCount += thePtr->GetTotalCount();
+            outCounters.mFreeCount  += thePtr->GetFreeCount();
+        }
     }
     return true;
 }
@@ -30,6 +30,9 @@
 // to satisfy request the "clients" are asked to release the specified number
 // of buffers before declaring allocation failure.
 // All buffer allocations are atomic -- all or nothing.
+// With NUMA node count greater than one, the partitions memory is spread
+// evenly between the nodes, and the allocation first tries the partitions of
+// the node the calling thread runs on.
 //
 //----------------------------------------------------------------------------
 
@@ -105,13 +108,31 @@ public:
             {}
     };
 
+    struct NodeCounters
+    {
+        int     mTotalCount;
+        int     mFreeCount;
+        // Buffers allocated from the node partitions by the threads running
+        // on the same node, and on the other nodes.
+        int64_t mLocalGetCount;
+        int64_t mRemoteGetCount;
+
+        NodeCounters()
+            : mTotalCount(0),
+              mFreeCount(0),
+              mLocalGetCount(0),
+              mRemoteGetCount(0)
+            {}
+    };
+
     QCIoBufferPool();
     ~QCIoBufferPool();
     int Create(
         int          inPartitionCount,
         int          inPartitionBufferCount,
         int          inBufferSize,
-        bool         inLockMemoryFlag);
+        bool         inLockMemoryFlag,
+        int          inNodeCount = 0);
     void Destroy();
     char* Get(
         RefillReqId inRefillReqId = kRefillReqIdUndefined);
@@ -146,15 +167,28 @@ public:
         const char*    inBufPtr,
         PinnedBufferId inId,
         bool           inFlag);
+    int GetNodeCount() const
+        { return mNodeCount; }
+    bool GetNodeCounters(
+        int           inNode,
+        NodeCounters& outCounters);
 private:
     class Partition;
-    QCMutex    mMutex;
-    Client*    mClientListPtr[1];
-    Partition* mPartitionListPtr[1];
-    int        mBufferSize;
-    int        mFreeCnt;
-    int        mTotalCnt;
+    QCMutex       mMutex;
+    Client*       mClientListPtr[1];
+    Partition*    mPartitionListPtr[1];
+    int           mBufferSize;
+    int           mFreeCnt;
+    int           mTotalCnt;
+    int           mNodeCount;
+    NodeCounters* mNodeCountersPtr;
 
+    Partition* GetNonEmptyPartition(
+        int inNode);
+    void UpdateNodeCounters(
+        const Partition& inPartition,
+        int              inNode,
+        int              inBufCnt);
     bool TryToRefill(
         RefillReqId inReqId,
         int         inBufCnt);
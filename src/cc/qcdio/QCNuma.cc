@@ -0,0 +1,346 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// NUMA topology discovery and memory placement implementation.
+//
+//----------------------------------------------------------------------------
+
+#include "QCNuma.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef QC_OS_NAME_LINUX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+#ifdef QC_OS_NAME_LINUX
+
+const char* const kQCNumaSysNodePath = "/sys/devices/system/node";
+
+    static bool
+QCNumaReadLine(
+    const char* inFileNamePtr,
+    char*       inBufPtr,
+    size_t      inBufSize)
+{
+    FILE* const theFilePtr = fopen(inFileNamePtr, "r");
+    if (! theFilePtr) {
+        return false;
+    }
+    const bool theRetFlag = fgets(inBufPtr, (int)inBufSize, theFilePtr) != 0;
+    fclose(theFilePtr);
+    return theRetFlag;
+}
+
+    static int
+QCNumaReadNode(
+    const char* inFileNamePtr)
+{
+    char theBuf[32];
+    if (! QCNumaReadLine(inFileNamePtr, theBuf, sizeof(theBuf))) {
+        return -1;
+    }
+    char*      theEndPtr = 0;
+    const long theNode   = strtol(theBuf, &theEndPtr, 10);
+    if (theEndPtr == theBuf || theNode < 0 ||
+            QCNuma::kMaxNodeCount <= theNode) {
+        return -1;
+    }
+    return (int)theNode;
+}
+
+// Parses sysfs list format, for example "0-3,8-11", and returns max entry
+// plus one, or -1 on parse error. The entries are set in the cpu mask, if
+// the mask is not null.
+    static int
+QCNumaParseList(
+    const char*          inListPtr,
+    QCNuma::CpuAffinity* outMaskPtr)
+{
+    if (outMaskPtr) {
+        outMaskPtr->Clear();
+    }
+    int         theMax = -1;
+    const char* thePtr = inListPtr;
+    for (; ;) {
+        while (*thePtr == ' ' || *thePtr == ',') {
+            ++thePtr;
+        }
+        if (*thePtr < '0' || '9' < *thePtr) {
+            break;
+        }
+        char*      theEndPtr = 0;
+        const long theStart  = strtol(thePtr, &theEndPtr, 10);
+        long       theLast   = theStart;
+        thePtr = theEndPtr;
+        if (*thePtr == '-') {
+            theLast = strtol(thePtr + 1, &theEndPtr, 10);
+            if (theEndPtr == thePtr + 1 || theLast < theStart) {
+                return -1;
+            }
+            thePtr = theEndPtr;
+        }
+        for (long i = theStart; outMaskPtr && i <= theLast &&
+                i < QCNuma::CpuAffinity::kMaxCpuCount; i++) {
+            outMaskPtr->Set((int)i);
+        }
+        if (theMax < theLast) {
+            theMax = (int)(INT_MAX <= theLast ? INT_MAX - 1 : theLast);
+        }
+    }
+    return (theMax + 1);
+}
+
+#endif /* QC_OS_NAME_LINUX */
+
+    /* static */ int
+QCNuma::GetNodeCount()
+{
+#ifdef QC_OS_NAME_LINUX
+    char theBuf[256];
+    snprintf(theBuf, sizeof(theBuf), "%s/possible", kQCNumaSysNodePath);
+    if (! QCNumaReadLine(theBuf, theBuf, sizeof(theBuf))) {
+        return 1;
+    }
+    const int theCount = QCNumaParseList(theBuf, 0);
+    return (theCount <= 0 ? 1 :
+        (kMaxNodeCount < theCount ? (int)kMaxNodeCount : theCount));
+#else
+    return 1;
+#endif
+}
+
+    /* static */ QCNuma::CpuAffinity
+QCNuma::GetNodeCpus(
+    int inNode)
+{
+#ifdef QC_OS_NAME_LINUX
+    if (inNode < 0 || kMaxNodeCount <= inNode) {
+        return CpuAffinity::None();
+    }
+    char theBuf[4 << 10];
+    snprintf(theBuf, sizeof(theBuf), "%s/node%d/cpulist",
+        kQCNumaSysNodePath, inNode);
+    CpuAffinity theRet;
+    if (! QCNumaReadLine(theBuf, theBuf, sizeof(theBuf)) ||
+            QCNumaParseList(theBuf, &theRet) <= 0 ||
+            theRet == CpuAffinity()) {
+        return CpuAffinity::None();
+    }
+    return theRet;
+#else
+    return CpuAffinity::None();
+#endif
+}
+
+#ifdef QC_OS_NAME_LINUX
+
+static signed char    sQCNumaCpuNode[QCNuma::CpuAffinity::kMaxCpuCount];
+static pthread_once_t sQCNumaCpuNodeOnce = PTHREAD_ONCE_INIT;
+
+    static void
+QCNumaInitCpuNode()
+{
+    memset(sQCNumaCpuNode, -1, sizeof(sQCNumaCpuNode));
+    const int theCount = QCNuma::GetNodeCount();
+    for (int theNode = 0; theNode < theCount; theNode++) {
+        const QCNuma::CpuAffinity theCpus = QCNuma::GetNodeCpus(theNode);
+        if (theCpus == QCNuma::CpuAffinity::None()) {
+            continue;
+        }
+        for (int i = 0; i < QCNuma::CpuAffinity::kMaxCpuCount; i++) {
+            if (theCpus.IsSet(i)) {
+                sQCNumaCpuNode[i] = (signed char)theNode;
+            }
+        }
+    }
+}
+
+#endif /* QC_OS_NAME_LINUX */
+
+    /* static */ int
+QCNuma::GetCurrentNode()
+{
+#ifdef QC_OS_NAME_LINUX
+    // Invoked on every buffer pool get and put. sched_getcpu() is serviced
+    // by vDSO with no system call, and the cpu to node map is read from
+    // sysfs once.
+    pthread_once(&sQCNumaCpuNodeOnce, &QCNumaInitCpuNode);
+    const int theCpu = sched_getcpu();
+    if (theCpu < 0 || CpuAffinity::kMaxCpuCount <= theCpu) {
+        return -1;
+    }
+    return sQCNumaCpuNode[theCpu];
+#else
+    return -1;
+#endif
+}
+
+    /* static */ int
+QCNuma::GetPathNode(
+    const char* inPathPtr)
+{
+#ifdef QC_OS_NAME_LINUX
+    struct stat theStat;
+    if (! inPathPtr || stat(inPathPtr, &theStat) != 0) {
+        return -1;
+    }
+    char theBuf[PATH_MAX + 32];
+    snprintf(theBuf, sizeof(theBuf), "/sys/dev/block/%u:%u",
+        (unsigned int)major(theStat.st_dev),
+        (unsigned int)minor(theStat.st_dev));
+    char thePath[PATH_MAX];
+    if (! realpath(theBuf, thePath)) {
+        return -1;
+    }
+    // Walk up the device hierarchy, starting from partition or disk, until
+    // the bus device with known node is found.
+    const char* const kDevicesPtr = "/sys/devices/";
+    const size_t      kDevicesLen = strlen(kDevicesPtr);
+    for (; ;) {
+        const size_t theLen = strlen(thePath);
+        if (theLen <= kDevicesLen ||
+                strncmp(thePath, kDevicesPtr, kDevicesLen) != 0) {
+            break;
+        }
+        snprintf(theBuf, sizeof(theBuf), "%s/numa_node", thePath);
+        const int theNode = QCNumaReadNode(theBuf);
+        if (0 <= theNode) {
+            return theNode;
+        }
+        char* const theSepPtr = strrchr(thePath, '/');
+        if (! theSepPtr) {
+            break;
+        }
+        *theSepPtr = 0;
+    }
+#endif
+    return -1;
+}
+
+    /* static */ int
+QCNuma::GetInterfaceNode(
+    const char* inInterfaceNamePtr)
+{
+#ifdef QC_OS_NAME_LINUX
+    if (! inInterfaceNamePtr || ! *inInterfaceNamePtr ||
+            strchr(inInterfaceNamePtr, '/')) {
+        return -1;
+    }
+    char theBuf[PATH_MAX];
+    snprintf(theBuf, sizeof(theBuf), "/sys/class/net/%s/device/numa_node",
+        inInterfaceNamePtr);
+    return QCNumaReadNode(theBuf);
+#else
+    return -1;
+#endif
+}
+
+    /* static */ int
+QCNuma::GetAddressNode(
+    const char* inIpAddressPtr)
+{
+#ifdef QC_OS_NAME_LINUX
+    if (! inIpAddressPtr || ! *inIpAddressPtr) {
+        return -1;
+    }
+    struct in_addr  theAddr4;
+    struct in6_addr theAddr6;
+    const bool      theV4Flag =
+        inet_pton(AF_INET, inIpAddressPtr, &theAddr4) == 1;
+    if (! theV4Flag && inet_pton(AF_INET6, inIpAddressPtr, &theAddr6) != 1) {
+        return -1;
+    }
+    struct ifaddrs* theListPtr = 0;
+    if (getifaddrs(&theListPtr) != 0) {
+        return -1;
+    }
+    int theNode = -1;
+    for (const struct ifaddrs* thePtr = theListPtr;
+            thePtr;
+            thePtr = thePtr->ifa_next) {
+        if (! thePtr->ifa_addr || ! thePtr->ifa_name) {
+            continue;
+        }
+        if (theV4Flag) {
+            if (thePtr->ifa_addr->sa_family != AF_INET ||
+                    memcmp(&reinterpret_cast<const struct sockaddr_in*>(
+                            thePtr->ifa_addr)->sin_addr,
+                        &theAddr4, sizeof(theAddr4)) != 0) {
+                continue;
+            }
+        } else {
+            if (thePtr->ifa_addr->sa_family != AF_INET6 ||
+                    memcmp(&reinterpret_cast<const struct sockaddr_in6*>(
+                            thePtr->ifa_addr)->sin6_addr,
+                        &theAddr6, sizeof(theAddr6)) != 0) {
+                continue;
+            }
+        }
+        theNode = GetInterfaceNode(thePtr->ifa_name);
+        break;
+    }
+    freeifaddrs(theListPtr);
+    return theNode;
+#else
+    return -1;
+#endif
+}
+
+    /* static */ int
+QCNuma::SetPreferredNode(
+    void*  inPtr,
+    size_t inSize,
+    int    inNode)
+{
+    if (inNode < 0 || kMaxNodeCount <= inNode) {
+        return EINVAL;
+    }
+#if defined(QC_OS_NAME_LINUX) && defined(SYS_mbind)
+    const int     kMpolPreferred = 1;
+    const size_t  kBitsPerLong   = sizeof(unsigned long) * 8;
+    unsigned long theMask[kMaxNodeCount / kBitsPerLong + 1];
+    memset(theMask, 0, sizeof(theMask));
+    theMask[inNode / kBitsPerLong] |= 1UL << (inNode % kBitsPerLong);
+    if (syscall(SYS_mbind, inPtr, inSize, kMpolPreferred, theMask,
+            (unsigned long)kMaxNodeCount + 1, 0u) != 0) {
+        const int theErr = errno;
+        return (theErr == 0 ? -1 : theErr);
+    }
+    return 0;
+#else
+    return ENOSYS;
+#endif
+}
@@ -0,0 +1,74 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// NUMA topology discovery and memory placement.
+//
+// The topology is obtained from linux sysfs, and the memory policy is set with
+// mbind system call, thus no dependency on libnuma. On other platforms, or
+// if sysfs is not available, the host is reported to have a single node, and
+// all node lookups return -1.
+//
+//----------------------------------------------------------------------------
+
+#ifndef QCNUMA_H
+#define QCNUMA_H
+
+#include "QCThread.h"
+
+#include <stddef.h>
+
+class QCNuma
+{
+public:
+    typedef QCThread::CpuAffinity CpuAffinity;
+    enum { kMaxNodeCount = 64 };
+
+    // Returns number of nodes, 1 if the host is not NUMA, or if the topology
+    // is not available.
+    static int GetNodeCount();
+    // Returns node cpus, or CpuAffinity::None() if node is not valid, or the
+    // node cpus are not known.
+    static CpuAffinity GetNodeCpus(
+        int inNode);
+    // Returns node of the cpu the calling thread runs on, or -1 if not known.
+    static int GetCurrentNode();
+    // Returns node the block device containing the path is attached to, or -1
+    // if not known, for example for device mapper or network file systems.
+    static int GetPathNode(
+        const char* inPathPtr);
+    // Returns node the network interface is attached to, or -1.
+    static int GetInterfaceNode(
+        const char* inInterfaceNamePtr);
+    // Returns node of the network interface the ip address is assigned to,
+    // or -1.
+    static int GetAddressNode(
+        const char* inIpAddressPtr);
+    // Sets preferred node memory policy for the address range. The range must
+    // be page aligned. Returns 0 on success, or system error.
+    static int SetPreferredNode(
+        void*  inPtr,
+        size_t inSize,
+        int    inNode);
+private:
+    QCNuma();
+};
+
+#endif /* QCNUMA_H */
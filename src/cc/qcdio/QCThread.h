@@ -53,54 +53,98 @@ public:
     class CpuAffinity
     {
     public:
+        // Same as glibc default CPU_SETSIZE.
+        enum { kMaxCpuCount = 1024 };
+
         CpuAffinity()
-            : mCpus(0)
-            {}
+            { Fill(0); }
         CpuAffinity(
             int inCpuIndex)
-            : mCpus(inCpuIndex >= 0 ? (Cpus(1) << inCpuIndex) : ~Cpus(0))
-            {}
+        {
+            if (inCpuIndex >= 0) {
+                Fill(0);
+                Set(inCpuIndex);
+            } else {
+                Fill(~Cpus(0));
+            }
+        }
         CpuAffinity(
             const CpuAffinity& inAffinity)
-            : mCpus(inAffinity.mCpus)
-            {}
+            { Copy(inAffinity); }
         CpuAffinity& operator=(
             const CpuAffinity& inAffinity)
         {
-            mCpus = inAffinity.mCpus;
+            Copy(inAffinity);
             return *this;
         }
         bool operator==(
             const CpuAffinity& inAffinity) const
-            { return (mCpus == inAffinity.mCpus); }
+        {
+            for (int i = 0; i < kWordCount; i++) {
+                if (mCpus[i] != inAffinity.mCpus[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
         bool operator!=(
             const CpuAffinity& inAffinity) const
-            { return (mCpus != inAffinity.mCpus); }
+            { return (! (*this == inAffinity)); }
         CpuAffinity& Clear()
         {
-            mCpus = 0;
+            Fill(0);
             return *this;
         }
         CpuAffinity& Clear(
             int inCpuIndex)
         {
-            mCpus &= ~(Cpus(1) << inCpuIndex);
+            if (IsValid(inCpuIndex)) {
+                mCpus[inCpuIndex / kWordBits] &=
+                    ~(Cpus(1) << (inCpuIndex % kWordBits));
+            }
             return *this;
         }
         CpuAffinity& Set(
             int inCpuIndex)
         {
-            mCpus |= (Cpus(1) << inCpuIndex);
+            if (IsValid(inCpuIndex)) {
+                mCpus[inCpuIndex / kWordBits] |=
+                    Cpus(1) << (inCpuIndex % kWordBits);
+            }
             return *this;
         }
         bool IsSet(
             int inCpuIndex) const
-            { return (((mCpus >> inCpuIndex) & Cpus(1)) != 0); }
+        {
+            return (IsValid(inCpuIndex) &&
+                ((mCpus[inCpuIndex / kWordBits] >>
+                    (inCpuIndex % kWordBits)) & Cpus(1)) != 0);
+        }
         static CpuAffinity None()
             { return CpuAffinity(-1); }
     private:
         typedef uint64_t Cpus;
-        Cpus mCpus;
+        enum { kWordBits  = 64 };
+        enum { kWordCount = kMaxCpuCount / kWordBits };
+        Cpus mCpus[kWordCount];
+
+        static bool IsValid(
+            int inCpuIndex)
+            { return (0 <= inCpuIndex && inCpuIndex < kMaxCpuCount); }
+        void Fill(
+            Cpus inVal)
+        {
+            for (int i = 0; i < kWordCount; i++) {
+                mCpus[i] = inVal;
+            }
+        }
+        void Copy(
+            const CpuAffinity& inAffinity)
+        {
+            for (int i = 0; i < kWordCount; i++) {
+                mCpus[i] = inAffinity.mCpus[i];
+            }
+        }
     };
 
     QCThread(
@@ -30,6 +30,7 @@
 #include "QCUtils.h"
 #include "qcdebug.h"
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <iomanip>
@@ -393,15 +394,27 @@ public:
         RequestWaiter theWaiter;
         const int theReqBlockCount =
             thePartitionBufferCount * thePartitionCount / theThreadCount;
+        const int theWeights[QCDiskQueue::kPriorityClassCount] = { 4, 2, 1 };
+        theQueue.SetPriorityClassWeights(theWeights);
+        QCDiskQueue::PriorityClassCounters
+            theStartCounters[QCDiskQueue::kPriorityClassCount];
+        theQueue.GetPriorityClassCounters(theStartCounters);
+        int theReqCount = 0;
         for (int i = 0; i < theMaxQueueDepth * 3 / 2; i++) {
             for (theFileIdx = 0; theFileIdx < inFileCount; theFileIdx++) {
+                const QCDiskQueue::PriorityClass thePriorityClass =
+                    QCDiskQueue::PriorityClass(
+                        theReqCount++ % QCDiskQueue::kPriorityClassCount);
                 QCDiskQueue::EnqueueStatus const theStatus =
                     theWaiter.Add(theQueue.Read(
                         theFileIdx,
                         theBlockIdx,
                         0,
                         theReqBlockCount,
-                        &theWaiter
+                        &theWaiter,
+                        -1,
+                        thePriorityClass,
+                        (i & 1) ? QCDiskQueue::Time(0) : QCDiskQueue::Time(-1)
                     ));
                 cout << i << " " << theFileIdx << " Read: " <<
                     ToString(theStatus) << endl;
@@ -413,6 +426,31 @@ public:
         cout << "waiting for completion" << endl;
         theWaiter.Wait();
         cout << "all requests done" << endl;
+        QCDiskQueue::PriorityClassCounters
+            theCounters[QCDiskQueue::kPriorityClassCount];
+        theQueue.GetPriorityClassCounters(theCounters);
+        int64_t theDoneCount = 0;
+        for (int i = 0; i < QCDiskQueue::kPriorityClassCount; i++) {
+            const QCDiskQueue::PriorityClassCounters& theCtrs = theCounters[i];
+            const int64_t theCount =
+                theCtrs.mRequestCount - theStartCounters[i].mRequestCount;
+            cout << "priority class: " << i <<
+                " requests: "       << theCount <<
+                " blocks: "         << theCtrs.mBlockCount <<
+                " wait avg usec: "  << (theCtrs.mQueueWaitTime / 1000 /
+                    max(int64_t(1), theCtrs.mRequestCount)) <<
+                " wait max usec: "  << theCtrs.mMaxQueueWaitTime / 1000 <<
+                " total max usec: " << theCtrs.mMaxTotalTime / 1000 <<
+                " deadline: "       << theCtrs.mDeadlineCount <<
+                " missed: "         << theCtrs.mDeadlineMissCount <<
+            endl;
+            theDoneCount += theCount;
+        }
+        if (theDoneCount != theReqCount) {
+            cerr << "priority class request count mismatch: " <<
+                theDoneCount << " expected: " << theReqCount << endl;
+            return 1;
+        }
         return 0;
     }
 
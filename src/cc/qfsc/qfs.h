@@ -63,7 +63,8 @@ extern "C" {
       KFS_STRIPED_FILE_TYPE_UNKNOWN     = 0,
       KFS_STRIPED_FILE_TYPE_NONE        = 1,
       KFS_STRIPED_FILE_TYPE_RS          = 2,
-      KFS_STRIPED_FILE_TYPE_RS_JERASURE = 3
+      KFS_STRIPED_FILE_TYPE_RS_JERASURE = 3,
+      KFS_STRIPED_FILE_TYPE_LRC         = 4
   };
 
 // From KfsClient.h
@@ -33,6 +33,8 @@
 #include <iostream>
 #include <string>
 
+#include <string.h>
+
 
 using namespace KFS;
 using namespace KFS_MON;
@@ -42,7 +44,8 @@ using std::string;
 using std::cout;
 
 static int
-StatsMetaServer(MonClient& client, bool rpcStats, int numSecs);
+StatsMetaServer(MonClient& client, bool rpcStats, bool latencyStats,
+    int numSecs);
 
 static int
 BasicStatsMetaServer(MonClient& client, int numSecs);
@@ -51,7 +54,11 @@ static int
 RpcStatsMetaServer(MonClient& client, int numSecs);
 
 static int
-StatsChunkServer(MonClient& client, bool rpcStats, int numSecs);
+StatsChunkServer(MonClient& client, bool rpcStats, bool latencyStats,
+    int numSecs);
+
+template<typename T> static int
+LatencyStats(MonClient& client, int numSecs);
 
 static int
 BasicStatsChunkServer(MonClient& client, int numSecs);
@@ -74,6 +81,7 @@ main(int argc, char **argv)
     bool        meta                 = false;
     bool        chunk                = false;
     bool        rpcStats             = false;
+    bool        latencyStats         = false;
     bool        verboseLogging       = false;
     bool        setMetaLocationsFlag = true;
     const char* server               = 0;
@@ -81,7 +89,7 @@ main(int argc, char **argv)
     int         port                 = -1;
     int         numSecs              = 10;
 
-    while ((optchar = getopt(argc, argv, "hcmn:p:s:tvf:N")) != -1) {
+    while ((optchar = getopt(argc, argv, "hcmn:p:s:tlvf:N")) != -1) {
         switch (optchar) {
             case 'm':
                 meta = true;
@@ -101,6 +109,9 @@ main(int argc, char **argv)
             case 't':
                 rpcStats = true;
                 break;
+            case 'l':
+                latencyStats = true;
+                break;
             case 'h':
                 help = true;
                 break;
@@ -123,12 +134,14 @@ main(int argc, char **argv)
 
     if (help || ! server || port < 0) {
         cout << "Usage: " << argv[0] <<
-             " [-m|-c] -s <server name> -p <port> [-n <secs>] [-t] [-v]"
+             " [-m|-c] -s <server name> -p <port> [-n <secs>] [-t|-l] [-v]"
              " [-f <config file>] [-N]\n"
              "Deprecated. Please use qfsadmin instead.\n"
              "Gets the stats from meta/chunk servers at given intervals.\n"
              "        Use -m for metaserver, -c for chunk server.\n"
              "        Use -t for RPC stats.\n"
+             "        Use -l for RPC and disk io latency histograms:\n"
+             "        count,average,p50,p90,p99,p99.9,max microseconds.\n"
              "        Use -n <seconds> to specify interval (default 10s)."
              "\n";
         return -1;
@@ -150,10 +163,10 @@ main(int argc, char **argv)
         }
     }
     if (meta) {
-        return StatsMetaServer(client, rpcStats, numSecs);
+        return StatsMetaServer(client, rpcStats, latencyStats, numSecs);
     }
     if (chunk) {
-        return StatsChunkServer(client, rpcStats, numSecs);
+        return StatsChunkServer(client, rpcStats, latencyStats, numSecs);
     }
     return 0;
 }
@@ -168,8 +181,12 @@ PrintRpcStat(const string &statName, Properties &prop)
 
 
 int
-StatsMetaServer(MonClient& client, bool rpcStats, int numSecs)
+StatsMetaServer(MonClient& client, bool rpcStats, bool latencyStats,
+    int numSecs)
 {
+    if (latencyStats) {
+        return LatencyStats<MetaStatsOp>(client, numSecs);
+    }
     if (rpcStats) {
         return RpcStatsMetaServer(client, numSecs);
     } else {
@@ -264,7 +281,8 @@ PrintMetaBasicStatsHeader()
 }
 
 int
-StatsChunkServer(MonClient& client, bool rpcStats, int numSecs)
+StatsChunkServer(MonClient& client, bool rpcStats, bool latencyStats,
+    int numSecs)
 {
     if (client.GetAuthContext() && client.GetAuthContext()->IsEnabled()) {
         KFS_LOG_STREAM_WARN <<
@@ -272,6 +290,9 @@ StatsChunkServer(MonClient& client, bool rpcStats, int numSecs)
             " with authentication enabled." <<
         KFS_LOG_EOM;
     }
+    if (latencyStats) {
+        return LatencyStats<ChunkStatsOp>(client, numSecs);
+    }
     if (rpcStats) {
         return RpcStatsChunkServer(client, numSecs);
     } else {
@@ -347,6 +368,38 @@ BasicStatsChunkServer(MonClient& client, int numSecs)
     return 0;
 }
 
+template<typename T> int
+LatencyStats(MonClient& client, int numSecs)
+{
+    const char* const kPrefix    = "Latency ";
+    const size_t      kPrefixLen = strlen(kPrefix);
+    for (; ;) {
+        T op(0);
+        const int ret = client.Execute(op);
+        if (ret < 0) {
+            KFS_LOG_STREAM_ERROR << op.statusMsg <<
+                " " << ErrorCodeToStr(ret) <<
+            KFS_LOG_EOM;
+            return 1;
+        }
+        for (Properties::iterator it = op.stats.begin();
+                it != op.stats.end();
+                ++it) {
+            if (kPrefixLen < it->first.GetSize() &&
+                    memcmp(it->first.GetPtr(), kPrefix, kPrefixLen) == 0) {
+                cout << (it->first.GetPtr() + kPrefixLen) <<
+                    " = " << it->second << "\n";
+            }
+        }
+        cout << "----------------------------------" << "\n";
+        if (numSecs == 0) {
+            break;
+        }
+        sleep(numSecs);
+    }
+    return 0;
+}
+
 static void
 PrintChunkBasicStatsHeader()
 {
@@ -474,6 +474,8 @@ echo "Running RS unit test with 6 data stripes"
 mytimecmd='time'
 { $mytimecmd true ; } > /dev/null 2>&1 || mytimecmd=
 $mytimecmd rstest 6 65536 2>&1 || exit
+echo "Running LRC erasure patterns unit test"
+$mytimecmd lrctest 2>&1 || exit
 
 # Cleanup handler
 if [ x"$dontusefuser" = x'yes' ]; then
@@ -1006,15 +1008,20 @@ cppidf="cptest${pidsuf}"
     cptokfsopts='-S -m 2 -l 2 -w -1'"$cptestextraopts" \
     cpfromkfsopts='-r 0 -w 65537'"$cptestextraopts" \
     cptest.sh && \
+    sleep $cptestendsleeptime && \
+    mv cptest.log cptest-rs.log && \
     { \
         [ x"$jerasuretest" = x'no' ] || { \
-            sleep $cptestendsleeptime && \
-            mv cptest.log cptest-rs.log && \
             cptokfsopts='-u 65536 -y 10 -z 4 -r 1 -F 3 -m 2 -l 2 -w -1'"$cptestextraopts" \
             cpfromkfsopts='-r 0 -w 65537'"$cptestextraopts" \
-            cptest.sh ; \
+            cptest.sh && \
+            sleep $cptestendsleeptime && \
+            mv cptest.log cptest-jerasure.log ; \
         } \
-    }
+    } && \
+    cptokfsopts='-u 65536 -y 10 -z 4 -r 1 -F 4 -m 2 -l 2 -w -1'"$cptestextraopts" \
+    cpfromkfsopts='-r 0 -w 65537'"$cptestextraopts" \
+    cptest.sh
 } >> cptest.out 2>&1 &
 cppid=$!
 echo "$cppid" > "$cppidf"
@@ -0,0 +1,249 @@
+#!/bin/sh
+#
+# $Id$
+#
+# Created 2026/10/18
+#
+# Copyright 2026 Quantcast Corporation. All rights reserved.
+#
+# This file is part of Kosmos File System (KFS).
+#
+# Licensed under the Apache License, Version 2.0
+# (the "License"); you may not use this file except in compliance with
+# the License. You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+# implied. See the License for the specific language governing
+# permissions and limitations under the License.
+#
+# Test atomic record append with chunk server group commit enabled. Multiple
+# writers append records to a file with replication 3, while one chunk
+# server is killed, in order to fail a replica with group commits in flight.
+# Once the killed chunk server is restarted and the file is re-replicated,
+# verify that every record is present exactly once with intact payload, and
+# that all chunk replicas are identical.
+
+ulimit -c unlimited
+
+builddir=`pwd`
+toolsdir=${toolsdir-"$builddir"/src/cc/tools}
+metadir=${metadir-"$builddir"/src/cc/meta}
+chunkdir=${chunkdir-"$builddir"/src/cc/chunk}
+devtoolsdir=${devtoolsdir-`dirname "$toolsdir"`/devtools}
+qfstestdir=${qfstestdir-"$builddir"/qfstest}
+clicfg=${clicfg-"$qfstestdir"/client.prp}
+clirootcfg=${clirootcfg-"$qfstestdir"/clientroot.prp}
+metaport=${metaport-20200}
+metahost=${metahost-127.0.0.1}
+csstartport=${csstartport-20400}
+csendport=${csendport-`expr $csstartport + 2`}
+cskillport=${cskillport-`expr $csstartport + 1`}
+cskilldelay=${cskilldelay-3}
+appendwriters=${appendwriters-8}
+appendrecords=${appendrecords-20000}
+appendmaxpayload=${appendmaxpayload-2048}
+gcmaxinflight=${gcmaxinflight-16}
+maxrecovwait=${maxrecovwait-240}
+
+wait_shutdown_complete()
+{
+    pid=$1
+    maxtry=${2-100}
+    k=0
+    while kill -0 $pid 2>/dev/null; do
+        sleep 1
+        k=`expr $k + 1`
+        if [ $k -gt $maxtry ]; then
+            echo "server $pid shutdown failure" 1>&2
+            kill -ABRT $pid
+            sleep 3
+            kill -KILL $pid 2>/dev/null
+            return 1
+        fi
+    done
+    return 0
+}
+
+stop=1
+shutdown()
+{
+    [ $stop -eq 0 ] && return 0
+    stop=0
+    sstatus=0
+    cd "$qfstestdir"/meta || return 1
+    pid=`cat metaserver.pid`
+    kill -QUIT $pid
+    if wait_shutdown_complete $pid; then
+        true;
+    else
+        sstatus=1
+    fi
+    i=$csstartport
+    while [ $i -le $csendport ]; do
+        cd "$qfstestdir"/chunk/$i || return 1
+        pid=`cat chunkserver.pid`
+        kill -QUIT $pid
+        if wait_shutdown_complete $pid; then
+            true;
+        else
+            sstatus=1
+        fi
+        i=`expr $i + 1`
+    done
+    return $sstatus
+}
+
+start_chunk_server()
+{
+    cd "$qfstestdir"/chunk/$1 || return 1
+    "$chunkdir"/chunkserver ChunkServer-recappend.prp \
+        >> chunkserver-recappend.log 2>&1 &
+    echo $! > chunkserver.pid
+}
+
+if [ -d "$qfstestdir" ]; then
+    true
+else
+    echo "Directory $qfstestdir does not exist, execute qfstest.sh first."
+    exit 1
+fi
+[ -f "$clicfg"     ] || clicfg=/dev/null
+[ -f "$clirootcfg" ] || clirootcfg=/dev/null
+
+trap shutdown EXIT INT HUP
+
+cd "$qfstestdir"/meta || exit
+kill -KILL `cat metaserver.pid` 2>/dev/null
+rm -f kfscp/* kfslog/*
+rm -f metaserver-recappend.log
+cp MetaServer.prp MetaServer-recappend.prp || exit
+{
+    echo "metaServer.panicOnInvalidChunk=1"
+    echo "metaServer.csmap.unittest=0"
+    echo "metaServer.rebalancingEnabled=0"
+    echo "metaServer.minChunkservers=2"
+} >> MetaServer-recappend.prp
+"$metadir"/metaserver -c MetaServer-recappend.prp > \
+        metaserver-recappend.log 2>&1 || {
+    status=$?
+    cat metaserver-recappend.log
+    exit $status
+}
+"$metadir"/metaserver MetaServer-recappend.prp \
+    >> metaserver-recappend.log 2>&1 &
+echo $! > metaserver.pid
+i=$csstartport
+while [ $i -le $csendport ]; do
+    cd "$qfstestdir"/chunk/$i || exit
+    kill -KILL `cat chunkserver.pid` 2>/dev/null
+    rm -f chunkserver-recappend.log
+    rm -rf kfschunk*/*
+    sed -e 's/^\(chunkServer.obj.*\)$/# \1/' \
+        ChunkServer.prp > ChunkServer-recappend.prp
+    {
+        echo "chunkServer.recAppender.groupCommitMaxInFlight = $gcmaxinflight"
+        echo "chunkServer.recAppender.groupCommitMaxRecords  = 64"
+        echo "chunkServer.recAppender.groupCommitMaxBytes    = 262144"
+    } >> ChunkServer-recappend.prp
+    start_chunk_server $i || exit
+    i=`expr $i + 1`
+done
+echo "Waiting for chunk servers to connect"
+t=0
+until "$toolsdir"/qfsadmin -s "$metahost" -p "$metaport" \
+            -f "$clirootcfg" upservers 2>/dev/null \
+        | awk -v c=`expr $csendport - $csstartport + 1` \
+            'BEGIN{n=0;}{n++;}END{if(n<c) exit(1); else exit(0);}'; do
+    t=`expr $t + 1`
+    if [ $t -gt 60 ]; then
+        echo "wait for chunk servers to connect timed out"
+        exit 1
+    fi
+    sleep 1
+done
+
+cd "$qfstestdir" || exit
+usr=`id -un`
+testdir="/user/$usr/recappendtest"
+testfile="$testdir/recappendtest.dat"
+status=0
+
+"$toolsdir"/qfs \
+    -D fs.glob=0 \
+    -cfg "$clicfg" \
+    -mkdir "qfs://$metahost:$metaport$testdir" || exit
+
+"$devtoolsdir"/recappendtest \
+    -s "$metahost" -p "$metaport" -f "$clicfg" -k "$testfile" -c -r 3 \
+    || exit
+
+echo "Starting $appendwriters record append writers"
+w=0
+pids=''
+while [ $w -lt $appendwriters ]; do
+    "$devtoolsdir"/recappendtest \
+        -s "$metahost" -p "$metaport" -f "$clicfg" -k "$testfile" \
+        -w $w -n $appendrecords -m $appendmaxpayload \
+        > "recappendtest-$w.log" 2>&1 &
+    pids="$pids $!"
+    w=`expr $w + 1`
+done
+
+sleep $cskilldelay
+echo "Killing chunk server $cskillport"
+kill -KILL `cat "$qfstestdir"/chunk/$cskillport/chunkserver.pid` || status=1
+
+w=0
+for pid in $pids; do
+    if wait $pid; then
+        true
+    else
+        echo "record append writer $w failed"
+        cat "recappendtest-$w.log"
+        status=1
+    fi
+    w=`expr $w + 1`
+done
+
+echo "Restarting chunk server $cskillport"
+start_chunk_server $cskillport || status=1
+cd "$qfstestdir" || exit
+
+if [ $status -eq 0 ]; then
+    "$devtoolsdir"/recappendtest \
+        -s "$metahost" -p "$metaport" -f "$clicfg" -k "$testfile" \
+        -V $appendwriters -n $appendrecords -m $appendmaxpayload \
+        || status=1
+fi
+
+if [ $status -eq 0 ]; then
+    # Wait for re-replication to complete, and all replicas to match.
+    t=0
+    until "$toolsdir"/qfsdataverify \
+                -s "$metahost" -p "$metaport" -f "$clicfg" -d -k \
+                "$testfile" > recappendtest-verify.log 2>&1 && \
+            "$toolsdir"/qfsdataverify \
+                -s "$metahost" -p "$metaport" -f "$clicfg" -c -k \
+                "$testfile" >> recappendtest-verify.log 2>&1; do
+        t=`expr $t + 1`
+        if [ $t -gt $maxrecovwait ]; then
+            echo "wait for replicas to match timed out" 1>&2
+            cat recappendtest-verify.log
+            status=1
+            break
+        fi
+        sleep 1
+    done
+fi
+
+if shutdown; then
+    if [ $status -eq 0 ]; then
+        echo "Passed all tests"
+        exit 0
+    fi
+fi
+exit 1
@@ -24,6 +24,9 @@
 # Test RS recovery with sparse files by creating sparse file and forcing
 # recovery by deleting chunk files and running file verification, and
 # using admin tool to force recovery of existing chunks.
+# With locally repairable code (striper type 4) the test uses 6 data and 4
+# recovery stripes, and the chunk loss patterns that exercise both local
+# group and global recovery.
 
 ulimit -c unlimited
 
@@ -164,6 +167,35 @@ if [ $stop -ne 0 ]; then
 fi
 
 datastripes=`echo "$filecreateparams" | cut -d , -f 2`
+stripertype=`echo "$filecreateparams" | cut -d , -f 5`
+
+# Format:
+# <stripe to force recovery> <stripe to delete> <stripe to delete> <stripe to delete>
+# negative stripe / chunk numbers except the first column means restore the
+# "original" chunk.
+if [ x"$stripertype" = x4 ]; then
+    # Locally repairable code 6+4: global parity stripes 6 and 7, local
+    # parity stripe 8 for data stripes 0-2, and 9 for data stripes 3-5.
+    teststripes=${teststripes-'-1 0
+1 1
+8 8
+6 6
+4 4 9
+-1 0 3 7
+2 2 0 1
+-1 -4 -9
+-1 10 14 19'}
+else
+    teststripes=${teststripes-'-1 0 1 5
+6 3 7 8
+0 0 1 2
+5 5 6
+-1 4 5
+-1 10 11
+-1 10 11 12
+-1 -3 -5
+-1 0 -1 5'}
+fi
 
 if [ $start -ne 0 ]; then
     if [ -d "$qfstestdir" ]; then
@@ -491,22 +523,10 @@ for testblocksize in $testblocksizes ; do
         echo "============== $testblocksize = $k == $stripes =================="
         k=`expr $k + 1`
     done << EOF
-    -1 0 1 5
-    6 3 7 8
-    0 0 1 2
-    5 5 6
-    -1 4 5
-    -1 10 11
-    -1 10 11 12
-    -1 -3 -5
-    -1 0 -1 5
+$teststripes
 EOF
     [ $status -eq 0 ] || break;
 done
-# Format:
-# <stripe to force recovery> <stripe to delete> <stripe to delete> <stripe to delete>
-# negative stripe / chunk numbers except the first column means restore the
-# "original" chunk.
 
 if [ $stop -eq 0 ] || shutdown; then
     stop=0